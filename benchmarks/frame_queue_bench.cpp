@@ -0,0 +1,193 @@
+// Copyright (c) 2020 Intel Corporation.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM,OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+/**
+ * @file
+ * @brief Microbenchmark of the mutex based ThreadSafeQueue against the
+ *        lock-free LockFreeQueue, using the push/pop patterns of the
+ *        ingestors and the UDF manager.
+ */
+
+#include <getopt.h>
+#include <time.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+#include <eii/utils/thread_safe_queue.h>
+#include "eii/vi/lockfree_queue.h"
+
+using namespace eii::utils;
+using namespace eii::vi;
+
+// Queued item, carries its enqueue time to measure the queue latency and
+// its position to check that no item is lost or reordered
+struct Item {
+    uint64_t enqueue_ns;
+    int producer;
+    size_t seq;
+};
+
+struct Result {
+    double seconds;
+    double cpu_ns_per_item;
+    std::vector<uint64_t> latency_ns;
+    // Items received out of the order of their producer, or missing
+    size_t reordered;
+    size_t lost;
+};
+
+static uint64_t now_ns(clockid_t clock) {
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/**
+ * Ingestor side: try to push and block only if the queue is full.
+ */
+template <typename Queue>
+static void produce(Queue* queue, Item* items, int producer, size_t count,
+                    std::atomic<int>* finished) {
+    for (size_t i = 0; i < count; i++) {
+        items[i].producer = producer;
+        items[i].seq = i;
+        items[i].enqueue_ns = now_ns(CLOCK_MONOTONIC);
+        if (queue->push(&items[i]) == QueueRetCode::QUEUE_FULL) {
+            queue->push_wait(&items[i]);
+        }
+    }
+    finished->fetch_add(1);
+}
+
+static bool consume(ThreadSafeQueue<Item*>* queue, Item*& item) {
+    // Same sequence as the UDF manager and the publisher
+    if (!queue->wait_for(std::chrono::milliseconds(250))) {
+        return false;
+    }
+    item = queue->front();
+    queue->pop();
+    return true;
+}
+
+static bool consume(LockFreeQueue<Item*>* queue, Item*& item) {
+    return queue->pop_wait(item, std::chrono::milliseconds(250));
+}
+
+template <typename Queue>
+static Result run(Queue* queue, int producers, size_t count) {
+    Result res;
+    std::vector<Item> items(producers * count);
+    // Next item expected from every producer
+    std::vector<size_t> expected(producers, 0);
+    std::atomic<int> finished(0);
+    std::vector<std::thread> threads;
+    size_t total = items.size();
+
+    res.latency_ns.reserve(total);
+    uint64_t cpu_start = now_ns(CLOCK_PROCESS_CPUTIME_ID);
+    auto start = std::chrono::steady_clock::now();
+
+    for (int p = 0; p < producers; p++) {
+        threads.push_back(std::thread(produce<Queue>, queue,
+                                      &items[p * count], p, count,
+                                      &finished));
+    }
+    res.reordered = 0;
+    while (res.latency_ns.size() < total) {
+        Item* item = NULL;
+        if (consume(queue, item)) {
+            res.latency_ns.push_back(
+                    now_ns(CLOCK_MONOTONIC) - item->enqueue_ns);
+            if (item->seq != expected[item->producer])
+                res.reordered++;
+            expected[item->producer] = item->seq + 1;
+        } else if (finished.load() == producers) {
+            // Nothing left in the queue, the missing items are lost
+            break;
+        }
+    }
+    res.lost = total - res.latency_ns.size();
+    for (auto& th : threads) {
+        th.join();
+    }
+
+    res.seconds = std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - start).count();
+    res.cpu_ns_per_item = (double) (now_ns(CLOCK_PROCESS_CPUTIME_ID) -
+                                    cpu_start) / total;
+    std::sort(res.latency_ns.begin(), res.latency_ns.end());
+    return res;
+}
+
+static bool print_result(const char* name, const Result& res) {
+    const std::vector<uint64_t>& lat = res.latency_ns;
+    if (res.lost > 0 || res.reordered > 0) {
+        printf("%-22s FAILED: %zu items lost, %zu reordered\n", name,
+               res.lost, res.reordered);
+        return false;
+    }
+    printf("%-22s %12.0f items/s  cpu/item: %8.1f ns  "
+           "latency p50: %8lu ns  p99: %8lu ns  p999: %8lu ns\n",
+           name, lat.size() / res.seconds, res.cpu_ns_per_item,
+           (unsigned long) lat[lat.size() / 2],
+           (unsigned long) lat[lat.size() * 99 / 100],
+           (unsigned long) lat[lat.size() * 999 / 1000]);
+    return true;
+}
+
+static void usage(const char* name) {
+    fprintf(stderr,
+            "Usage: %s [-p producers] [-n items per producer] "
+            "[-q queue size]\n", name);
+}
+
+int main(int argc, char** argv) {
+    int producers = 1;
+    size_t count = 1000000;
+    size_t queue_size = 10;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "p:n:q:h")) != -1) {
+        switch (opt) {
+            case 'p': producers = std::max(1, atoi(optarg)); break;
+            case 'n': count = std::max(1L, atol(optarg)); break;
+            case 'q': queue_size = std::max(1L, atol(optarg)); break;
+            default: usage(argv[0]); return 1;
+        }
+    }
+
+    printf("producers: %d  items/producer: %zu  queue_size: %zu\n",
+           producers, count, queue_size);
+
+    bool ok = true;
+    ThreadSafeQueue<Item*> mutex_queue(queue_size);
+    ok &= print_result("ThreadSafeQueue", run(&mutex_queue, producers, count));
+
+    QueueProducers mode = (producers == 1) ? SINGLE_PRODUCER : MULTI_PRODUCER;
+    LockFreeQueue<Item*> lockfree_queue(queue_size, mode);
+    ok &= print_result((mode == SINGLE_PRODUCER) ? "LockFreeQueue (spsc)" :
+                                                   "LockFreeQueue (mpsc)",
+                       run(&lockfree_queue, producers, count));
+    return ok ? 0 : 1;
+}
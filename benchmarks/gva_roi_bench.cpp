@@ -0,0 +1,180 @@
+// Copyright (c) 2020 Intel Corporation.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM,OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+/**
+ * @file
+ * @brief Microbenchmark of the GVA regions of interest serialization: the
+ *        "gva_meta" msgbus objects against the binary encoding, with 0, 10
+ *        and 100 regions of interest per frame.
+ */
+
+#include <getopt.h>
+#include <time.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <gst/gst.h>
+#include <gst/video/video.h>
+#include "eii/vi/gva_roi_codec.h"
+
+using namespace eii::vi;
+
+// Heap allocations of the whole process
+static std::atomic<uint64_t> g_allocs(0);
+
+extern "C" {
+    void* __libc_malloc(size_t size);
+    void* __libc_calloc(size_t nmemb, size_t size);
+    void* __libc_realloc(void* ptr, size_t size);
+
+    void* malloc(size_t size) noexcept {
+        g_allocs.fetch_add(1, std::memory_order_relaxed);
+        return __libc_malloc(size);
+    }
+
+    void* calloc(size_t nmemb, size_t size) noexcept {
+        g_allocs.fetch_add(1, std::memory_order_relaxed);
+        return __libc_calloc(nmemb, size);
+    }
+
+    void* realloc(void* ptr, size_t size) noexcept {
+        if (ptr == NULL)
+            g_allocs.fetch_add(1, std::memory_order_relaxed);
+        return __libc_realloc(ptr, size);
+    }
+}
+
+struct Result {
+    double ns_per_frame;
+    double allocs_per_frame;
+    size_t bytes;
+};
+
+static uint64_t now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/**
+ * Buffer with the given number of regions of interest, each one with a
+ * detection tensor and a classification tensor like gvadetect followed by
+ * gvaclassify.
+ */
+static GstBuffer* make_buffer(int rois) {
+    GstBuffer* buf = gst_buffer_new();
+    for (int i = 0; i < rois; i++) {
+        GstVideoRegionOfInterestMeta* meta = gst_buffer_add_video_region_of_interest_meta(
+                buf, "person", 10 * i, 20 * i, 64, 128);
+        gst_video_region_of_interest_meta_add_param(meta, gst_structure_new(
+                "detection", "label", G_TYPE_STRING, "person",
+                "confidence", G_TYPE_DOUBLE, 0.75, "label_id", G_TYPE_INT, 1, NULL));
+        gst_video_region_of_interest_meta_add_param(meta, gst_structure_new(
+                "age", "label", G_TYPE_STRING, "35",
+                "confidence", G_TYPE_DOUBLE, 0.5, "label_id", G_TYPE_INT, 35, NULL));
+    }
+    return buf;
+}
+
+static Result run_envelope(GstBuffer* buf, int frames) {
+    Result res = {0, 0, 0};
+    uint64_t allocs = g_allocs.load();
+    uint64_t start = now_ns();
+    for (int i = 0; i < frames; i++) {
+        msg_envelope_elem_body_t* arr = gva_roi_to_envelope(buf);
+        msgbus_msg_envelope_elem_destroy(arr);
+    }
+    res.ns_per_frame = (double) (now_ns() - start) / frames;
+    res.allocs_per_frame = (double) (g_allocs.load() - allocs) / frames;
+    return res;
+}
+
+static Result run_binary(GstBuffer* buf, int frames) {
+    Result res = {0, 0, 0};
+    size_t size = 0;
+    uint64_t allocs = g_allocs.load();
+    uint64_t start = now_ns();
+    for (int i = 0; i < frames; i++) {
+        // As the ingestor does, each frame blob owns its encoding
+        std::vector<uint8_t>* roi = new std::vector<uint8_t>();
+        roi->reserve(size);
+        gva_roi_encode(buf, *roi);
+        size = roi->size();
+        msg_envelope_elem_body_t* elem = msgbus_msg_envelope_new_integer(1);
+        msgbus_msg_envelope_elem_destroy(elem);
+        delete roi;
+    }
+    res.ns_per_frame = (double) (now_ns() - start) / frames;
+    res.allocs_per_frame = (double) (g_allocs.load() - allocs) / frames;
+    res.bytes = size;
+    return res;
+}
+
+static Result run_json_view(GstBuffer* buf, int frames) {
+    Result res = {0, 0, 0};
+    std::vector<uint8_t> arena;
+    std::string json;
+    gva_roi_encode(buf, arena);
+    uint64_t allocs = g_allocs.load();
+    uint64_t start = now_ns();
+    for (int i = 0; i < frames; i++) {
+        gva_roi_to_json(arena.data(), arena.size(), json);
+    }
+    res.ns_per_frame = (double) (now_ns() - start) / frames;
+    res.allocs_per_frame = (double) (g_allocs.load() - allocs) / frames;
+    res.bytes = json.size();
+    return res;
+}
+
+static void print_result(const char* name, int rois, const Result& res) {
+    printf("%-16s rois: %4d  %10.0f ns/frame  allocs/frame: %8.1f  bytes: %6zu\n",
+           name, rois, res.ns_per_frame, res.allocs_per_frame, res.bytes);
+}
+
+static void usage(const char* name) {
+    fprintf(stderr, "Usage: %s [-n frames]\n", name);
+}
+
+int main(int argc, char** argv) {
+    int frames = 100000;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:h")) != -1) {
+        switch (opt) {
+            case 'n': frames = std::max(1, atoi(optarg)); break;
+            default: usage(argv[0]); return 1;
+        }
+    }
+
+    gst_init(&argc, &argv);
+    printf("frames: %d\n", frames);
+    const int roi_counts[] = {0, 10, 100};
+    for (int rois : roi_counts) {
+        GstBuffer* buf = make_buffer(rois);
+        print_result("gva_meta", rois, run_envelope(buf, frames));
+        print_result("gva_meta_bin", rois, run_binary(buf, frames));
+        print_result("json view", rois, run_json_view(buf, frames));
+        gst_buffer_unref(buf);
+    }
+    return 0;
+}
@@ -0,0 +1,174 @@
+// Copyright (c) 2020 Intel Corporation.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM,OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+/**
+ * @file
+ * @brief Benchmark of the batch decode of a video file: decode rate of the
+ *        SegmentDecoder against its number of threads, next to the
+ *        sequential decode of the OpenCV ingestor.
+ */
+
+#include <getopt.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <opencv2/opencv.hpp>
+#include "eii/vi/frame_pool.h"
+#include "eii/vi/segment_decoder.h"
+
+using namespace eii::vi;
+
+struct Result {
+    uint64_t frames;
+    size_t segments;
+    double seconds;
+    // Frames which differ from the sequential decode at the same position
+    uint64_t mismatches;
+};
+
+/**
+ * Cheap frame signature, to check the frames come out in file order.
+ */
+static uint64_t signature(const cv::Mat& mat) {
+    uint64_t sig = mat.rows * 31 + mat.cols;
+    if (mat.empty())
+        return sig;
+    size_t size = (size_t) mat.rows * mat.cols * mat.channels();
+    size_t step = std::max<size_t>(size / 64, 1);
+    for (size_t i = 0; i < size; i += step)
+        sig = sig * 131 + mat.data[i];
+    return sig;
+}
+
+static Result run_sequential(const std::string& file, std::vector<uint64_t>& signatures) {
+    Result res = {0, 1, 0.0, 0};
+    auto start = std::chrono::steady_clock::now();
+    cv::VideoCapture cap(file);
+    cv::Mat mat;
+    while (cap.read(mat)) {
+        signatures.push_back(signature(mat));
+        res.frames++;
+    }
+    cap.release();
+    res.seconds = std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - start).count();
+    return res;
+}
+
+static Result run_segments(const std::string& file, size_t threads, size_t window,
+                           const std::vector<uint64_t>& signatures) {
+    Result res = {0, 0, 0.0, 0};
+    std::atomic<bool> cancel(false);
+    // Same buffer count as the OpenCV ingestor in batch mode
+    std::shared_ptr<MatPool> pool = std::make_shared<MatPool>(window + threads + 2);
+    SegmentDecoder decoder(file, threads, window, pool);
+
+    auto start = std::chrono::steady_clock::now();
+    if (!decoder.start())
+        return res;
+    PooledMat* pooled = NULL;
+    while ((pooled = decoder.next(cancel)) != NULL) {
+        if (res.frames >= signatures.size() ||
+                signature(pooled->mat) != signatures[res.frames])
+            res.mismatches++;
+        MatPool::free_pooled_mat(pooled);
+        res.frames++;
+    }
+    res.seconds = std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - start).count();
+    decoder.stop();
+    res.segments = decoder.get_segments();
+    pool->close();
+    return res;
+}
+
+static void print_result(const char* name, size_t threads, const Result& res, double base_fps) {
+    double fps = (res.seconds > 0) ? res.frames / res.seconds : 0.0;
+    printf("%-10s %7zu %8lu %8zu %9.2f %9.1f %7.2fx %10lu\n", name, threads,
+           (unsigned long) res.frames, res.segments, res.seconds, fps,
+           (base_fps > 0) ? fps / base_fps : 0.0, (unsigned long) res.mismatches);
+}
+
+static void usage(const char* name) {
+    fprintf(stderr,
+            "Usage: %s -f video file [-t threads[,threads...]] "
+            "[-w window frames]\n", name);
+}
+
+int main(int argc, char** argv) {
+    std::string file;
+    std::vector<size_t> thread_counts;
+    size_t window = 256;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "f:t:w:h")) != -1) {
+        switch (opt) {
+            case 'f': file = optarg; break;
+            case 't': {
+                char* next = optarg;
+                while (*next != '\0') {
+                    thread_counts.push_back(std::max(1L, strtol(next, &next, 10)));
+                    if (*next == ',')
+                        next++;
+                    else if (*next != '\0')
+                        break;
+                }
+                break;
+            }
+            case 'w': window = std::max(1L, atol(optarg)); break;
+            default: usage(argv[0]); return 1;
+        }
+    }
+    if (file.empty()) {
+        usage(argv[0]);
+        return 1;
+    }
+    if (thread_counts.empty()) {
+        // Powers of two up to the number of cores, and the number of cores
+        size_t cores = std::max(1U, std::thread::hardware_concurrency());
+        for (size_t threads = 1; threads < cores; threads *= 2)
+            thread_counts.push_back(threads);
+        thread_counts.push_back(cores);
+    }
+
+    printf("file: %s  window: %zu frames\n", file.c_str(), window);
+    printf("%-10s %7s %8s %8s %9s %9s %8s %10s\n", "mode", "threads",
+           "frames", "segments", "seconds", "fps", "speedup", "mismatches");
+
+    std::vector<uint64_t> signatures;
+    Result base = run_sequential(file, signatures);
+    if (base.frames == 0) {
+        fprintf(stderr, "Failed to read %s\n", file.c_str());
+        return 1;
+    }
+    double base_fps = base.frames / base.seconds;
+    print_result("sequential", 1, base, base_fps);
+
+    for (auto threads : thread_counts)
+        print_result("segments", threads,
+                     run_segments(file, threads, window, signatures), base_fps);
+    return 0;
+}
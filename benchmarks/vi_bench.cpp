@@ -0,0 +1,317 @@
+// Copyright (c) 2020 Intel Corporation.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM,OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+/**
+ * @file
+ * @brief End-to-end benchmark of the VideoIngestion pipeline. The frames are
+ *        published through an in-process stand-in of the msgbus publisher,
+ *        so the numbers do not depend on the transport.
+ */
+
+#include <errno.h>
+#include <getopt.h>
+#include <time.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+#include <eii/utils/logger.h>
+#include <eii/utils/json_config.h>
+#include <eii/msgbus/msgbus.h>
+#include "eii/vi/video_ingestion.h"
+
+using namespace eii::vi;
+
+// Frames published by the stand-in publisher
+static std::atomic<uint64_t> g_published(0);
+
+// Heap allocations of the whole process
+static std::atomic<uint64_t> g_allocs(0);
+
+/*
+ * Allocation counting. The definitions take precedence over the libc ones for
+ * the whole process, including the EII libraries, OpenCV and GStreamer.
+ */
+extern "C" {
+    void* __libc_malloc(size_t size);
+    void* __libc_calloc(size_t nmemb, size_t size);
+    void* __libc_realloc(void* ptr, size_t size);
+    void* __libc_memalign(size_t alignment, size_t size);
+
+    void* malloc(size_t size) noexcept {
+        g_allocs.fetch_add(1, std::memory_order_relaxed);
+        return __libc_malloc(size);
+    }
+
+    void* calloc(size_t nmemb, size_t size) noexcept {
+        g_allocs.fetch_add(1, std::memory_order_relaxed);
+        return __libc_calloc(nmemb, size);
+    }
+
+    void* realloc(void* ptr, size_t size) noexcept {
+        if (ptr == NULL)
+            g_allocs.fetch_add(1, std::memory_order_relaxed);
+        return __libc_realloc(ptr, size);
+    }
+
+    int posix_memalign(void** ptr, size_t alignment, size_t size) noexcept {
+        g_allocs.fetch_add(1, std::memory_order_relaxed);
+        void* mem = __libc_memalign(alignment, size);
+        if (mem == NULL)
+            return ENOMEM;
+        *ptr = mem;
+        return 0;
+    }
+}
+
+/*
+ * Stand-in msgbus publisher, overriding the message bus library: published
+ * messages are only counted. FramePublisher still serializes every frame.
+ */
+struct StandInPublisher {
+    std::string topic;
+};
+
+void* msgbus_initialize(config_t* config) {
+    static int ctx;
+    return &ctx;
+}
+
+msgbus_ret_t msgbus_publisher_new(void* ctx, const char* topic, publisher_ctx_t** pub_ctx) {
+    *pub_ctx = (publisher_ctx_t*) new StandInPublisher{topic};
+    return MSG_SUCCESS;
+}
+
+msgbus_ret_t msgbus_publisher_publish(void* ctx, publisher_ctx_t* pub_ctx, msg_envelope_t* message) {
+    g_published.fetch_add(1, std::memory_order_relaxed);
+    return MSG_SUCCESS;
+}
+
+void msgbus_publisher_destroy(void* ctx, publisher_ctx_t* pub_ctx) {
+    delete (StandInPublisher*) pub_ctx;
+}
+
+void msgbus_destroy(void* ctx) {
+}
+
+struct BenchConfig {
+    int width;
+    int height;
+    int queue_size;
+    int workers;
+    double warmup;
+    double duration;
+    double clip_seconds;
+    std::string video_file;
+    int read_ahead;
+    double poll_interval;
+};
+
+static uint64_t now_ns(clockid_t clock) {
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static std::string ingestor_config(const std::string& type, const BenchConfig& cfg) {
+    char buf[512];
+    if (type == "opencv") {
+        snprintf(buf, sizeof(buf),
+                 "{\"type\": \"opencv\", \"pipeline\": \"%s\", "
+                 "\"loop_video\": true, \"queue_size\": %d, \"read_ahead\": %d, "
+                 "\"poll_interval\": %f}",
+                 cfg.video_file.c_str(), cfg.queue_size, cfg.read_ahead, cfg.poll_interval);
+    } else if (type == "gstreamer") {
+        snprintf(buf, sizeof(buf),
+                 "{\"type\": \"gstreamer\", \"pipeline\": \"videotestsrc ! "
+                 "video/x-raw,format=BGR,width=%d,height=%d ! appsink\", "
+                 "\"queue_size\": %d}",
+                 cfg.width, cfg.height, cfg.queue_size);
+    } else {
+        snprintf(buf, sizeof(buf),
+                 "{\"type\": \"synthetic\", \"width\": %d, \"height\": %d, "
+                 "\"pattern\": \"gradient\", \"queue_size\": %d}",
+                 cfg.width, cfg.height, cfg.queue_size);
+    }
+    std::string config = "{\"ingestor\": ";
+    config += buf;
+    // Pre-trigger ring, to measure its footprint and its cost
+    if (cfg.clip_seconds > 0) {
+        config.pop_back();
+        config += ", \"clip_buffer_seconds\": " + std::to_string(cfg.clip_seconds) + "}";
+    }
+    // Without UDFs the ingestors feed the publisher directly
+    if (cfg.workers > 0) {
+        config += ", \"udfs\": [], \"max_workers\": " + std::to_string(cfg.workers);
+    }
+    config += "}";
+    return config;
+}
+
+static void print_latency(FILE* out, VideoIngestion* vi) {
+    fprintf(out, "      \"latency_us\": {\n");
+    for (int stage = 0; stage < STAGE_COUNT; stage++) {
+        LatencySummary s = vi->get_latency((LatencyStage) stage);
+        fprintf(out, "        \"%s\": {\"count\": %lu, \"mean\": %.1f, "
+                "\"p50\": %.1f, \"p99\": %.1f, \"p999\": %.1f, \"max\": %.1f}%s\n",
+                LATENCY_STAGE_NAMES[stage], (unsigned long) s.count,
+                s.mean / 1000.0, s.p50 / 1000.0, s.p99 / 1000.0,
+                s.p999 / 1000.0, s.max / 1000.0,
+                (stage + 1 < STAGE_COUNT) ? "," : "");
+    }
+    fprintf(out, "      }\n");
+}
+
+/**
+ * Run the pipeline with one ingestor type and print its JSON result.
+ */
+static bool run(FILE* out, const std::string& type, const BenchConfig& cfg, bool first) {
+    std::string vi_config = ingestor_config(type, cfg);
+    char empty[] = "{}";
+    config_t* pub_config = json_config_new_from_buffer(empty);
+    std::vector<std::string> topics = {"bench"};
+    std::condition_variable err_cv;
+    VideoIngestion* vi = NULL;
+
+    try {
+        vi = new VideoIngestion("vi_bench", err_cv, &vi_config[0], pub_config,
+                                topics, NULL);
+        vi->start();
+    } catch (const char* err) {
+        fprintf(stderr, "%s: failed to start the pipeline: %s\n", type.c_str(), err);
+        delete vi;
+        config_destroy(pub_config);
+        return false;
+    }
+
+    std::this_thread::sleep_for(std::chrono::duration<double>(cfg.warmup));
+    uint64_t frames_start = g_published.load();
+    uint64_t allocs_start = g_allocs.load();
+    uint64_t cpu_start = now_ns(CLOCK_PROCESS_CPUTIME_ID);
+    uint64_t wall_start = now_ns(CLOCK_MONOTONIC);
+
+    std::this_thread::sleep_for(std::chrono::duration<double>(cfg.duration));
+    uint64_t frames = g_published.load() - frames_start;
+    uint64_t allocs = g_allocs.load() - allocs_start;
+    uint64_t cpu_ns = now_ns(CLOCK_PROCESS_CPUTIME_ID) - cpu_start;
+    double seconds = (now_ns(CLOCK_MONOTONIC) - wall_start) / 1e9;
+
+    ClipStats clip;
+    bool clip_enabled = vi->get_clip_stats(clip);
+    int64_t first_frame_ns = vi->get_time_to_first_frame();
+    vi->stop();
+    double per_frame = (frames > 0) ? 1.0 / frames : 0.0;
+    fprintf(out, "%s    {\n", first ? "" : ",\n");
+    fprintf(out, "      \"ingestor\": \"%s\",\n", type.c_str());
+    fprintf(out, "      \"frames\": %lu,\n", (unsigned long) frames);
+    fprintf(out, "      \"fps\": %.1f,\n", frames / seconds);
+    fprintf(out, "      \"cpu_us_per_frame\": %.1f,\n", cpu_ns / 1000.0 * per_frame);
+    fprintf(out, "      \"allocs_per_frame\": %.1f,\n", allocs * per_frame);
+    if (first_frame_ns >= 0) {
+        fprintf(out, "      \"time_to_first_frame_ms\": %.1f,\n", first_frame_ns / 1e6);
+    }
+    if (clip_enabled) {
+        fprintf(out, "      \"clip_buffer\": {\"frames\": %lu, \"bytes\": %lu, "
+                "\"seconds\": %.1f},\n", (unsigned long) clip.frames,
+                (unsigned long) clip.bytes, clip.seconds);
+    }
+    print_latency(out, vi);
+    fprintf(out, "    }");
+
+    delete vi;
+    config_destroy(pub_config);
+    return true;
+}
+
+static void usage(const char* name) {
+    fprintf(stderr,
+            "Usage: %s [-i opencv|gstreamer|synthetic] [-f video file] "
+            "[-W width] [-H height] [-q queue size] [-w workers] "
+            "[-t warmup seconds] [-d seconds] [-c clip buffer seconds] "
+            "[-r read ahead frames] [-p poll interval] [-o output file]\n", name);
+}
+
+int main(int argc, char** argv) {
+    BenchConfig cfg = {1920, 1080, 10, 0, 2.0, 10.0, 0.0, "", 0, 0.0};
+    std::vector<std::string> types;
+    const char* output = NULL;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "i:f:W:H:q:w:t:d:c:r:p:o:h")) != -1) {
+        switch (opt) {
+            case 'i': types.push_back(optarg); break;
+            case 'f': cfg.video_file = optarg; break;
+            case 'W': cfg.width = std::max(1, atoi(optarg)); break;
+            case 'H': cfg.height = std::max(1, atoi(optarg)); break;
+            case 'q': cfg.queue_size = std::max(1, atoi(optarg)); break;
+            case 'w': cfg.workers = std::max(0, atoi(optarg)); break;
+            case 't': cfg.warmup = std::max(0.0, atof(optarg)); break;
+            case 'd': cfg.duration = std::max(0.1, atof(optarg)); break;
+            case 'c': cfg.clip_seconds = std::max(0.0, atof(optarg)); break;
+            case 'r': cfg.read_ahead = std::max(0, atoi(optarg)); break;
+            case 'p': cfg.poll_interval = std::max(0.0, atof(optarg)); break;
+            case 'o': output = optarg; break;
+            default: usage(argv[0]); return 1;
+        }
+    }
+    if (types.empty()) {
+        types = {"opencv", "gstreamer", "synthetic"};
+    }
+
+    // The pipeline logs would be mixed with the results
+    set_log_level(LOG_LVL_ERROR);
+
+    FILE* out = (output != NULL) ? fopen(output, "w") : stdout;
+    if (out == NULL) {
+        fprintf(stderr, "Failed to open %s\n", output);
+        return 1;
+    }
+
+    fprintf(out, "{\n");
+    fprintf(out, "  \"config\": {\"width\": %d, \"height\": %d, \"queue_size\": %d, "
+            "\"workers\": %d, \"warmup_s\": %.1f, \"duration_s\": %.1f, "
+            "\"clip_buffer_s\": %.1f, \"video_file\": \"%s\", \"read_ahead\": %d, "
+            "\"poll_interval_s\": %.3f},\n", cfg.width, cfg.height, cfg.queue_size,
+            cfg.workers, cfg.warmup, cfg.duration, cfg.clip_seconds,
+            cfg.video_file.c_str(), cfg.read_ahead, cfg.poll_interval);
+    fprintf(out, "  \"results\": [\n");
+    bool first = true;
+    int ret = 0;
+    for (auto& type : types) {
+        if (type == "opencv" && cfg.video_file.empty()) {
+            fprintf(stderr, "Skipping the opencv ingestor, no video file (-f)\n");
+            continue;
+        }
+        if (run(out, type, cfg, first)) {
+            first = false;
+        } else {
+            ret = 1;
+        }
+    }
+    fprintf(out, "\n  ]\n}\n");
+    if (out != stdout)
+        fclose(out);
+    return ret;
+}
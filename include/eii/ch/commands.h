@@ -40,6 +40,8 @@ namespace eii {
         START_INGESTION,
         STOP_INGESTION,
         SNAPSHOT,
+        GET_STATS,
+        DUMP_CLIP,
         COMMAND_INVALID
         // MORE COMMANDS TO BE ADDED BASED ON THE NEED
     };
@@ -0,0 +1,124 @@
+// Copyright (c) 2020 Intel Corporation.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM,OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+
+/**
+ * @file
+ * @brief Pixel formats and plane layout of the ingested frames
+ */
+
+#ifndef _EII_VI_FRAME_FORMAT_H
+#define _EII_VI_FRAME_FORMAT_H
+
+#include <stddef.h>
+#include <opencv2/opencv.hpp>
+#include <eii/udf/frame.h>
+
+#define PIXEL_FORMAT_META "pixel_format"
+#define IMAGE_WIDTH_META "image_width"
+#define IMAGE_HEIGHT_META "image_height"
+#define PLANE_OFFSETS_META "plane_offsets"
+#define PLANE_STRIDES_META "plane_strides"
+
+#define FRAME_FORMAT_MAX_PLANES 3
+
+namespace eii {
+    namespace vi {
+
+        /**
+         * Supported pixel formats, named after their GStreamer formats
+         */
+        enum PixelFormat {
+            PIXEL_FORMAT_UNKNOWN,
+            // Packed 8 bit BGR
+            PIXEL_FORMAT_BGR,
+            // 8 bit luma only
+            PIXEL_FORMAT_GRAY8,
+            // Luma plane followed by an interleaved UV plane, 2x2 subsampled
+            PIXEL_FORMAT_NV12,
+            // Luma, U and V planes, 2x2 subsampled
+            PIXEL_FORMAT_I420,
+        };
+
+        /**
+         * Layout of a frame buffer
+         */
+        struct FrameFormat {
+            PixelFormat format;
+
+            // Image size in pixels
+            int width;
+            int height;
+
+            // Planes, offsets and strides are in bytes
+            int n_planes;
+            size_t offset[FRAME_FORMAT_MAX_PLANES];
+            int stride[FRAME_FORMAT_MAX_PLANES];
+
+            // Buffer size in bytes
+            size_t size;
+        };
+
+        /**
+         * Name of a pixel format, NULL if unknown
+         */
+        const char* pixel_format_name(PixelFormat format);
+
+        /**
+         * Pixel format from its name, PIXEL_FORMAT_UNKNOWN if unsupported
+         */
+        PixelFormat pixel_format_from_name(const char* name);
+
+        /**
+         * Whether the buffer is a tightly packed BGR image, which consumers
+         * read without the format meta-data
+         */
+        bool is_packed_bgr(const FrameFormat& fmt);
+
+        /**
+         * Frame geometry describing a buffer: packed BGR and GRAY8 images
+         * keep their size, other layouts are a single channel image of
+         * stride x rows bytes covering all the planes.
+         *
+         * @param fmt      - buffer layout
+         * @param width    - frame width
+         * @param height   - frame height
+         * @param channels - frame channels
+         */
+        void frame_geometry(const FrameFormat& fmt, int& width, int& height, int& channels);
+
+        /**
+         * Add the pixel format, image size and plane layout to the frame
+         * meta-data, so consumers can read buffers published as-is.
+         * @return false if the meta-data could not be added
+         */
+        bool put_format_meta(udf::Frame* frame, const FrameFormat& fmt);
+
+        /**
+         * Convert a buffer to packed BGR with the vectorized OpenCV color
+         * converters.
+         * @param data - buffer of the given layout
+         * @param fmt  - buffer layout
+         * @param bgr  - converted image, reused if its geometry matches
+         */
+        void convert_to_bgr(const void* data, const FrameFormat& fmt, cv::Mat& bgr);
+    }
+}
+#endif // _EII_VI_FRAME_FORMAT_H
@@ -0,0 +1,123 @@
+// Copyright (c) 2020 Intel Corporation.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM,OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+/**
+ * @file
+ * @brief Round robin merge of the per ingestor queues into the UDF input
+ * queue
+ */
+
+#ifndef _EII_VI_FRAME_MERGER_H
+#define _EII_VI_FRAME_MERGER_H
+
+#include <stdint.h>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include "eii/vi/ingestor.h"
+
+namespace eii {
+    namespace vi {
+
+        /**
+         * Moves the frames of several ingestors, each with its own bounded
+         * queue, into the shared UDF input queue, taking them in turn from
+         * each queue.
+         *
+         * The overflow policy of an ingestor applies to its own queue, so a
+         * slow or bursty camera only fills its own queue instead of stalling
+         * the others. The ingestors call notify() after every frame they
+         * push, the merger thread is the only consumer of their queues and
+         * pops them with pop_front(), so that an ingestor may evict its
+         * oldest frames.
+         */
+        class FrameMerger {
+            private:
+                // Queues of the ingestors, owned by the merger
+                std::vector<FrameQueue*> m_inputs;
+
+                // UDF input queue
+                FrameQueue* m_output;
+
+                // Set when a frame is pushed to the inputs after the merger
+                // last looked at them, guarded by m_mtx and signaled on m_cv
+                std::mutex m_mtx;
+                std::condition_variable m_cv;
+                bool m_pending;
+                std::atomic<bool> m_stop;
+
+                std::thread* m_th;
+
+                /**
+                 * Merger thread run method
+                 */
+                void run();
+
+                FrameMerger(const FrameMerger& src);
+                FrameMerger& operator=(const FrameMerger& src);
+
+            public:
+                /**
+                 * Constructor
+                 * @param output - UDF input queue
+                 */
+                explicit FrameMerger(FrameQueue* output);
+
+                /**
+                 * Destructor, deletes the input queues, which must be
+                 * drained
+                 */
+                ~FrameMerger();
+
+                /**
+                 * Add the queue of an ingestor, before start().
+                 * @param queue_size    - Size of the queue
+                 * @param lockfree      - Lock-free queue, the merger is its
+                 *                        only consumer
+                 * @return FrameQueue*  - Queue, owned by the merger
+                 */
+                FrameQueue* add_input(size_t queue_size, bool lockfree);
+
+                /**
+                 * Queues of the ingestors.
+                 */
+                const std::vector<FrameQueue*>& get_inputs() const;
+
+                /**
+                 * Signal a frame pushed to one of the inputs.
+                 */
+                void notify();
+
+                /**
+                 * Start the merger thread.
+                 */
+                void start();
+
+                /**
+                 * Stop the merger thread. The frames left in the inputs stay
+                 * there.
+                 */
+                void stop();
+        };
+    }
+}
+#endif // _EII_VI_FRAME_MERGER_H
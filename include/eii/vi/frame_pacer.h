@@ -0,0 +1,130 @@
+// Copyright (c) 2020 Intel Corporation.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM,OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+
+/**
+ * @file
+ * @brief Absolute deadline frame pacer
+ */
+
+#ifndef _EII_VI_FRAME_PACER_H
+#define _EII_VI_FRAME_PACER_H
+
+#include <stdint.h>
+#include <time.h>
+#include <mutex>
+
+namespace eii {
+    namespace vi {
+
+        /**
+         * What the pacer does with the deadlines missed while a frame took
+         * longer than the period.
+         */
+        enum PacingPolicy {
+            // Release the following frames without waiting until the
+            // schedule is met again, keeping the average rate
+            PACING_CATCH_UP,
+            // Move the schedule to the next deadline after now, the missed
+            // periods are lost
+            PACING_SKIP,
+        };
+
+        /**
+         * Pacing statistics, in nanoseconds.
+         */
+        struct PacingStats {
+            // Number of paced frames
+            uint64_t frames;
+            // Frames released after their deadline had already passed
+            uint64_t late_frames;
+            // Periods skipped with PACING_SKIP or dropped catching up
+            uint64_t skipped_periods;
+            // Wake up delay past the deadline, for the frames which slept
+            int64_t jitter_avg_ns;
+            int64_t jitter_max_ns;
+        };
+
+        /**
+         * Paces frames at a fixed period against absolute deadlines of the
+         * monotonic clock, so the time spent producing a frame does not add
+         * up to the period.
+         */
+        class FramePacer {
+            private:
+                // Period between frames, 0 disables pacing
+                int64_t m_period_ns;
+
+                // Handling of missed deadlines
+                PacingPolicy m_policy;
+
+                // Deadline of the next frame, 0 until the first frame
+                int64_t m_next_ns;
+
+                // Lock on the statistics, read from other threads
+                std::mutex m_mtx;
+                PacingStats m_stats;
+                int64_t m_jitter_sum_ns;
+                uint64_t m_slept;
+
+            public:
+                /**
+                 * Constructor
+                 * @param period_s - Period between frames in seconds, 0 disables pacing
+                 * @param policy   - Handling of missed deadlines
+                 */
+                FramePacer(double period_s=0.0, PacingPolicy policy=PACING_CATCH_UP);
+
+                /**
+                 * Change the period and the policy, the schedule restarts with
+                 * the next frame.
+                 */
+                void configure(double period_s, PacingPolicy policy);
+
+                /**
+                 * Change the period, keeping the policy.
+                 */
+                void set_period(double period_s);
+
+                /**
+                 * Whether pacing is enabled.
+                 */
+                bool enabled() const;
+
+                /**
+                 * Restart the schedule, the next frame is released at once.
+                 * Statistics are kept.
+                 */
+                void reset();
+
+                /**
+                 * Wait for the deadline of the next frame. The first call
+                 * after reset() returns at once and starts the schedule.
+                 */
+                void wait();
+
+                /**
+                 * Current statistics.
+                 */
+                PacingStats get_stats();
+        };
+    }
+}
+#endif
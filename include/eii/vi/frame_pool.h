@@ -0,0 +1,144 @@
+// Copyright (c) 2020 Intel Corporation.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM,OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+
+/**
+ * @file
+ * @brief Pool of recycled cv::Mat frame buffers
+ */
+
+#ifndef _EII_VI_FRAME_POOL_H
+#define _EII_VI_FRAME_POOL_H
+
+#include <mutex>
+#include <memory>
+#include <vector>
+#include <atomic>
+#include <opencv2/opencv.hpp>
+
+namespace eii {
+    namespace vi {
+
+        class MatPool;
+
+        /**
+         * cv::Mat wrapping a page aligned buffer owned by a MatPool
+         */
+        struct PooledMat {
+            // Mat wrapping buf, decoders write into it in place as long as
+            // the frame geometry does not change
+            cv::Mat mat;
+
+            // Page aligned pixel buffer
+            void* buf;
+
+            // Pool the Mat returns to, set while the Mat is in use
+            std::shared_ptr<MatPool> pool;
+        };
+
+        /**
+         * Pool of pre-sized, page aligned cv::Mat buffers.
+         *
+         * Buffers get the geometry of the last frame returned to the pool,
+         * so a decoder writing into an acquired Mat does not allocate once
+         * the resolution is known. The pool is shared with the frames in
+         * flight, which release their Mat through free_pooled_mat().
+         */
+        class MatPool : public std::enable_shared_from_this<MatPool> {
+            private:
+                // Lock on the free list and the frame geometry
+                std::mutex m_mtx;
+
+                // Mats ready for reuse
+                std::vector<PooledMat*> m_free;
+
+                // Maximum number of Mats kept for reuse
+                size_t m_capacity;
+
+                // Set once the owner is gone, Mats are not recycled anymore
+                bool m_closed;
+
+                // Geometry of the last frame returned to the pool
+                int m_rows;
+                int m_cols;
+                int m_type;
+
+                // Pool statistics
+                std::atomic<uint64_t> m_hits;
+                std::atomic<uint64_t> m_misses;
+
+                /**
+                 * Wrap a new page aligned buffer of the given geometry.
+                 */
+                static void wrap(PooledMat* pm, int rows, int cols, int type);
+
+                /**
+                 * Free the Mat and its buffer.
+                 */
+                static void destroy(PooledMat* pm);
+
+                /**
+                 * Return a Mat to the pool.
+                 */
+                void release(PooledMat* pm);
+
+            public:
+                /**
+                 * Constructor
+                 * @param capacity - Maximum number of Mats kept for reuse
+                 */
+                explicit MatPool(size_t capacity);
+
+                /**
+                 * Destructor
+                 */
+                ~MatPool();
+
+                /**
+                 * Get a Mat from the pool, or a new one if the pool is empty.
+                 *
+                 * \note Must be called on a pool owned by a std::shared_ptr.
+                 */
+                PooledMat* acquire();
+
+                /**
+                 * Free the Mats in the pool, Mats in use are freed instead of
+                 * recycled from now on.
+                 */
+                void close();
+
+                /**
+                 * Number of acquire() calls served from the pool.
+                 */
+                uint64_t get_hits() const;
+
+                /**
+                 * Number of acquire() calls which had to allocate a Mat.
+                 */
+                uint64_t get_misses() const;
+
+                /**
+                 * Frame free callback returning a PooledMat to its pool.
+                 */
+                static void free_pooled_mat(void* obj);
+        };
+    }
+}
+#endif
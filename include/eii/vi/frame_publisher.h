@@ -0,0 +1,166 @@
+// Copyright (c) 2020 Intel Corporation.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM,OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+
+/**
+ * @file
+ * @brief Publisher routing frames of several ingestors to their own topics
+ */
+
+#ifndef _EII_VI_FRAME_PUBLISHER_H
+#define _EII_VI_FRAME_PUBLISHER_H
+
+#include <map>
+#include <string>
+#include <thread>
+#include <atomic>
+#include <condition_variable>
+#include <eii/udf/frame.h>
+#include <eii/utils/config.h>
+#include <eii/msgbus/msgbus.h>
+#include "eii/vi/ingestor.h"
+#include "eii/vi/latency_stats.h"
+
+namespace eii {
+    namespace vi {
+
+        /**
+         * Topic and statistics of one ingestor
+         */
+        struct PublisherRoute {
+            publisher_ctx_t* pub_ctx;
+
+            // Written by the publishing thread
+            LatencyHistogram udf_latency;
+            LatencyHistogram publish_latency;
+        };
+
+        /**
+         * Publishes the frames of all the ingestors of a VideoIngestion
+         * instance over a single msgbus context. Every frame is published on
+         * the topic registered for the "ingestor_name" in its meta-data, frames
+         * without one on the topic registered for an empty name.
+         */
+        class FramePublisher {
+            private:
+                // Msgbus context shared by all topics
+                void* m_msgbus_ctx;
+
+                // Route per ingestor name
+                std::map<std::string, PublisherRoute*> m_routes;
+
+                // Push time of the frames to the UDF input queue
+                FrameStamps* m_frame_stamps;
+
+                // Queue of frames to publish
+                FrameQueue* m_queue;
+
+                // Publishing thread
+                std::thread* m_th;
+
+                // Flag to stop the publishing thread
+                std::atomic<bool> m_stop;
+
+                // Error condition variable
+                std::condition_variable& m_err_cv;
+
+                // Origin of the time to first frame, 0 if not set
+                int64_t m_startup_ns;
+
+                // latency_now_ns() time of the first published frame, 0
+                // before
+                std::atomic<int64_t> m_first_frame_ns;
+
+                /**
+                 * Publishing thread run method
+                 */
+                void run();
+
+                /**
+                 * Private @c FramePublisher copy constructor.
+                 */
+                FramePublisher(const FramePublisher& src);
+
+                /**
+                 * Private @c FramePublisher assignment operator.
+                 */
+                FramePublisher& operator=(const FramePublisher& src);
+
+            public:
+                /**
+                 * Constructor
+                 *
+                 * \note The msgbus configuration is not owned by this object.
+                 *
+                 * @param msgbus_config - Publisher msgbus configuration
+                 * @param err_cv        - Error condition variable
+                 * @param queue         - Queue of frames to publish
+                 * @param frame_stamps  - Push time of the frames, may be NULL
+                 */
+                FramePublisher(config_t* msgbus_config, std::condition_variable& err_cv, FrameQueue* queue, FrameStamps* frame_stamps);
+
+                /**
+                 * Destructor
+                 */
+                ~FramePublisher();
+
+                /**
+                 * Publish the frames of the given ingestor on the given topic.
+                 * Must be called before start().
+                 *
+                 * @param name  - Ingestor name
+                 * @param topic - Topic to publish on
+                 */
+                void add_topic(const std::string& name, const std::string& topic);
+
+                /**
+                 * Set the origin of the time to first frame, logged with the
+                 * first published frame. Must be called before start().
+                 *
+                 * @param startup_ns - latency_now_ns() time of the startup
+                 */
+                void set_startup_ns(int64_t startup_ns);
+
+                /**
+                 * Time from the startup to the first published frame
+                 * @return int64_t - nanoseconds, -1 before the first frame
+                 */
+                int64_t get_time_to_first_frame() const;
+
+                /**
+                 * Start the publishing thread
+                 */
+                void start();
+
+                /**
+                 * Stop the publishing thread
+                 */
+                void stop();
+
+                /**
+                 * Latency histogram of a stage measured by the publisher.
+                 * @return NULL for unknown ingestors and the stages measured
+                 *         by the ingestors
+                 */
+                const LatencyHistogram* get_latency(const std::string& name, LatencyStage stage) const;
+        };
+    }
+}
+#endif
@@ -0,0 +1,151 @@
+// Copyright (c) 2020 Intel Corporation.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM,OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+/**
+ * @file
+ * @brief Frame queue between two pipeline threads
+ */
+
+#ifndef _EII_VI_FRAME_QUEUE_H
+#define _EII_VI_FRAME_QUEUE_H
+
+#include <chrono>
+#include <mutex>
+#include <vector>
+#include <eii/utils/thread_safe_queue.h>
+#include <eii/udf/frame.h>
+#include "eii/vi/lockfree_queue.h"
+
+namespace eii {
+    namespace vi {
+
+        /**
+         * Bounded frame queue, the mutex based ThreadSafeQueue of EII or the
+         * lock-free LockFreeQueue.
+         *
+         * The UDF manager is built against ThreadSafeQueue and calls its
+         * methods directly, so a queue handed to it must be mutex based. A
+         * queue whose producers and consumer are all in VideoIngestion may
+         * be lock-free: the methods below hide the ones of ThreadSafeQueue
+         * and use the lock-free ring instead. Any number of threads may push
+         * to a lock-free queue, only one at a time may pop.
+         *
+         * A producer may evict the oldest frames with push_evict() if the
+         * consumer pops with pop_front(), which take the same lock.
+         */
+        class FrameQueue : public utils::ThreadSafeQueue<udf::Frame*> {
+            private:
+                // Lock-free ring, NULL for a mutex based queue
+                LockFreeQueue<udf::Frame*>* m_lockfree;
+
+                // Serializes pop_front() with the evictions of push_evict()
+                std::mutex m_evict_mtx;
+
+                /**
+                 * Pop the next frame without taking m_evict_mtx
+                 * @return false if the queue is empty
+                 */
+                bool pop_head(udf::Frame*& frame);
+
+                /**
+                 * Private @c FrameQueue copy constructor.
+                 */
+                FrameQueue(const FrameQueue& src);
+
+                /**
+                 * Private @c FrameQueue assignment operator.
+                 */
+                FrameQueue& operator=(const FrameQueue& src);
+
+            public:
+                /**
+                 * Constructor
+                 * @param max_size - Maximum number of frames in the queue
+                 * @param lockfree - Use the lock-free ring, which rounds
+                 *                   max_size up to a power of two
+                 */
+                FrameQueue(size_t max_size, bool lockfree=false);
+
+                /**
+                 * Destructor
+                 */
+                ~FrameQueue();
+
+                /**
+                 * Whether the queue uses the lock-free ring
+                 */
+                bool is_lockfree() const;
+
+                /**
+                 * Push a frame without blocking.
+                 * @return QUEUE_FULL if the queue is full
+                 */
+                utils::QueueRetCode push(udf::Frame* frame);
+
+                /**
+                 * Push a frame, sleeping while the queue is full.
+                 */
+                utils::QueueRetCode push_wait(udf::Frame* frame);
+
+                /**
+                 * Next frame, NULL if the queue is empty
+                 */
+                udf::Frame* front();
+
+                /**
+                 * Remove the next frame
+                 */
+                void pop();
+
+                /**
+                 * Whether no frame can be popped
+                 */
+                bool empty();
+
+                /**
+                 * Number of queued frames, approximate for a lock-free queue
+                 */
+                size_t size();
+
+                /**
+                 * Push a frame, removing the oldest frames while the queue is
+                 * full. The consumer must pop with pop_front().
+                 * @param frame   - Frame to push
+                 * @param evicted - Frames removed from the queue, or @p frame
+                 *                  itself if no frame could be removed
+                 * @return false if @p frame was not pushed
+                 */
+                bool push_evict(udf::Frame* frame, std::vector<udf::Frame*>& evicted);
+
+                /**
+                 * Pop the next frame, serialized with push_evict()
+                 * @return false if the queue is empty
+                 */
+                bool pop_front(udf::Frame*& frame);
+
+                /**
+                 * Sleep up to @p timeout until a frame can be popped
+                 * @return false if the timeout expired
+                 */
+                bool wait_for(std::chrono::milliseconds timeout);
+        };
+    }
+}
+#endif // _EII_VI_FRAME_QUEUE_H
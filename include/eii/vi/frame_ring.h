@@ -0,0 +1,137 @@
+// Copyright (c) 2020 Intel Corporation.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM,OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+/**
+ * @file
+ * @brief Pre-trigger ring of the recent frames of an ingestor
+ */
+
+#ifndef _EII_VI_FRAME_RING_H
+#define _EII_VI_FRAME_RING_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "eii/vi/frame_format.h"
+
+namespace eii {
+    namespace vi {
+
+        /**
+         * Frame kept in a FrameRing. The pixels are shared with the frame
+         * published live, not copied.
+         */
+        struct ClipFrame {
+            // Owner of the pixels, released with the last reference
+            std::shared_ptr<void> buffer;
+
+            // Frame geometry, as given to the live frame
+            void* data;
+            int width;
+            int height;
+            int channels;
+
+            // Buffer layout, for the frames which are not packed BGR
+            bool has_format;
+            FrameFormat format;
+
+            // Capture time, in nanoseconds since the epoch
+            int64_t time_ns;
+
+            // Size of the pixels in bytes
+            size_t size;
+        };
+
+        /**
+         * Memory footprint of a FrameRing
+         */
+        struct ClipStats {
+            // Frames and bytes held
+            uint64_t frames;
+            uint64_t bytes;
+            // Time between the oldest and the newest frame, in seconds
+            double seconds;
+            // Frames dropped from the ring to stay within its limits
+            uint64_t evicted;
+        };
+
+        /**
+         * Bounded ring of the recent frames of an ingestor, limited by
+         * duration and by size, from which clips are extracted when an
+         * event fires.
+         *
+         * The ingestion thread pushes frames, any thread can extract a
+         * window. Extracting only takes references on the frames.
+         */
+        class FrameRing {
+            private:
+                std::mutex m_mtx;
+                std::deque<ClipFrame> m_frames;
+
+                // Limits, 0 for none
+                int64_t m_max_ns;
+                size_t m_max_bytes;
+
+                size_t m_bytes;
+                uint64_t m_evicted;
+
+                FrameRing(const FrameRing& src);
+                FrameRing& operator=(const FrameRing& src);
+
+            public:
+                /**
+                 * Constructor
+                 * @param seconds   - Duration kept, 0 for no limit
+                 * @param max_bytes - Size kept, 0 for no limit
+                 */
+                FrameRing(double seconds, size_t max_bytes);
+
+                /**
+                 * Add the newest frame, evicting the frames beyond the
+                 * limits.
+                 */
+                void push(const ClipFrame& frame);
+
+                /**
+                 * Frames captured in a time window.
+                 * @param start_ns - Start of the window, since the epoch
+                 * @param end_ns   - End of the window, since the epoch
+                 * @param frames   - Frames of the window, oldest first
+                 * @return size_t  - Number of frames
+                 */
+                size_t get_window(int64_t start_ns, int64_t end_ns, std::vector<ClipFrame>& frames);
+
+                /**
+                 * Drop all the frames, releasing the references on their
+                 * buffers.
+                 */
+                void clear();
+
+                /**
+                 * Current memory footprint.
+                 */
+                ClipStats get_stats();
+        };
+    }
+}
+#endif
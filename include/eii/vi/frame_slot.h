@@ -0,0 +1,98 @@
+// Copyright (c) 2020 Intel Corporation.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM,OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+/**
+ * @file
+ * @brief Latest frame slot serving the snapshots of a running ingestor
+ */
+
+#ifndef _EII_VI_FRAME_SLOT_H
+#define _EII_VI_FRAME_SLOT_H
+
+#include <stdint.h>
+#include <mutex>
+#include <condition_variable>
+#include <eii/udf/frame.h>
+
+namespace eii {
+    namespace vi {
+
+        /**
+         * Holds the newest frame of an ingestor running in snapshot
+         * standby. Every new frame replaces the previous one, so the slot
+         * never holds more than one frame and never blocks the ingestor.
+         */
+        class LatestFrameSlot {
+            private:
+                std::mutex m_mtx;
+                std::condition_variable m_cv;
+
+                // Newest frame, NULL once taken or cleared
+                udf::Frame* m_frame;
+
+                // Capture time of m_frame, in latency_now_ns() time
+                int64_t m_capture_ns;
+
+                // Frames replaced before being taken
+                uint64_t m_overwritten;
+
+                LatestFrameSlot(const LatestFrameSlot& src);
+                LatestFrameSlot& operator=(const LatestFrameSlot& src);
+
+            public:
+                LatestFrameSlot();
+
+                /**
+                 * Destructor, deletes the frame left in the slot.
+                 */
+                ~LatestFrameSlot();
+
+                /**
+                 * Store a frame, deleting the one it replaces.
+                 * @param frame      - Frame, owned by the slot
+                 * @param capture_ns - latency_now_ns() at capture
+                 */
+                void put(udf::Frame* frame, int64_t capture_ns);
+
+                /**
+                 * Take the frame out of the slot, waiting for one captured
+                 * after a given time.
+                 * @param after_ns   - Only take a frame captured after this
+                 *                     latency_now_ns() time, 0 for any
+                 * @param timeout_ns - Maximum wait
+                 * @param capture_ns - Set to the capture time of the frame
+                 * @return udf::Frame* - Frame owned by the caller, NULL on
+                 *                       timeout
+                 */
+                udf::Frame* take(int64_t after_ns, int64_t timeout_ns, int64_t& capture_ns);
+
+                /**
+                 * Delete the frame in the slot, if any.
+                 */
+                void clear();
+
+                /**
+                 * Number of frames replaced before being taken.
+                 */
+                uint64_t get_overwritten();
+        };
+    }
+}
+#endif
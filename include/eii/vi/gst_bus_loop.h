@@ -0,0 +1,102 @@
+// Copyright (c) 2020 Intel Corporation.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM,OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+
+/**
+ * @file
+ * @brief GLib main loop shared by the GStreamer ingestors of the process
+ */
+
+#ifndef _EII_VI_GST_BUS_LOOP_H
+#define _EII_VI_GST_BUS_LOOP_H
+
+#include <memory>
+#include <thread>
+#include <gst/gst.h>
+
+namespace eii {
+    namespace vi {
+
+        /**
+         * GLib main context and thread dispatching the bus messages of every
+         * GStreamer pipeline of the process.
+         *
+         * The instance is created with the first ingestor which gets it and
+         * destroyed with the last one releasing it. GStreamer is initialized
+         * once per process, so all the pipelines share one plugin registry.
+         */
+        class GstBusLoop {
+            private:
+                // Context the bus watches are attached to
+                GMainContext* m_ctx;
+
+                // Loop dispatching the context
+                GMainLoop* m_loop;
+
+                // Thread running the loop
+                std::thread m_th;
+
+                /**
+                 * Constructor, use get()
+                 */
+                GstBusLoop();
+
+                /**
+                 * Loop thread run method
+                 */
+                void run();
+
+                /**
+                 * Private @c GstBusLoop copy constructor.
+                 */
+                GstBusLoop(const GstBusLoop& src);
+
+                /**
+                 * Private @c GstBusLoop assignment operator.
+                 */
+                GstBusLoop& operator=(const GstBusLoop& src);
+
+            public:
+                /**
+                 * Get the loop of the process, starting it if needed
+                 */
+                static std::shared_ptr<GstBusLoop> get();
+
+                /**
+                 * Destructor, stops the loop thread
+                 */
+                ~GstBusLoop();
+
+                /**
+                 * Watch a bus, func is called on the loop thread for every
+                 * message of the bus
+                 * @return GSource* - watch, to be passed to remove_watch()
+                 */
+                GSource* add_watch(GstBus* bus, GstBusFunc func, gpointer data);
+
+                /**
+                 * Remove a watch. When this returns the callback is not
+                 * running and will not be called anymore.
+                 */
+                void remove_watch(GSource* watch);
+        };
+    }
+}
+#endif // _EII_VI_GST_BUS_LOOP_H
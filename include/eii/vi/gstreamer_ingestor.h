@@ -28,15 +28,77 @@
 #define _EII_VI_GSTREAMER_H
 
 #include <gst/gst.h>
+#include <gst/app/gstappsink.h>
 #include <glib.h>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
 #include <eii/utils/thread_safe_queue.h>
 #include <eii/utils/json_config.h>
 #include <eii/udf/frame.h>
 #include "eii/vi/ingestor.h"
+#include "eii/vi/frame_format.h"
+#include "eii/vi/frame_pool.h"
+#include "eii/vi/gva_roi_codec.h"
+#include "eii/vi/gst_bus_loop.h"
 
 namespace eii {
     namespace vi {
 
+        /**
+         * appsink of the pipeline and the frames it produces
+         */
+        struct AppsinkBranch {
+            // Name of the appsink element
+            std::string sink_name;
+
+            // "ingestor_name" meta-data of the frames of the branch
+            std::string route;
+
+            // Topic of the branch, empty for the ingestor topic
+            std::string topic;
+
+            // appsink element, set while the pipeline exists
+            GstElement* sink;
+
+            // Encoding details
+            EncodeType enc_type;
+            int enc_lvl;
+
+            // Caps of the last sample and the frame layout they describe
+            GstCaps* caps;
+            FrameFormat format;
+
+            // Frame period from the caps, 0 if the frame rate is variable
+            int64_t frame_period_ns;
+
+            // Buffer pool of the last sample, and whether it has a maximum
+            // number of buffers
+            GstBufferPool* pool;
+            bool pool_bounded;
+
+            // Frame number of the last frame
+            int64_t frame_count;
+
+            // Frames ingested, before the overflow policy of the UDF input queue
+            std::atomic<uint64_t> frames;
+        };
+
+        /**
+         * Reason a run of the pipeline ended
+         */
+        enum PipelineEnd {
+            // The ingestor was stopped
+            PIPELINE_STOPPED,
+            // Every appsink reached the end of stream
+            PIPELINE_EOS,
+            // The pipeline posted an error or could not start
+            PIPELINE_ERROR,
+            // No sample arrived within the stall timeout
+            PIPELINE_STALLED,
+        };
+
         /**
          * GStreamer Ingestor
          */
@@ -45,25 +107,142 @@ namespace eii {
             private:
                 // Gstreamer state/elements
                 GstElement* m_gst_pipeline;
-                GstElement* m_sink;
-                guint m_bus_watch_id;
 
-                // Glib main loop
-                GMainLoop* m_loop;
+                // appsinks of the pipeline, the first one publishes on the
+                // ingestor topic
+                std::vector<AppsinkBranch*> m_branches;
+
+                // Main loop shared by the pipelines of the process and the
+                // watch of the pipeline bus on it
+                std::shared_ptr<GstBusLoop> m_bus_loop;
+                GSource* m_bus_watch;
 
-                // Frame count
-                int64_t m_frame_count;
+                // appsink settings from the config, -1 if not set
+                int m_max_buffers;
+                int m_drop;
+                int m_sync;
+
+                // Set by the bus watch on error
+                std::atomic<bool> m_pipeline_done;
+
+                // Restart the pipeline when it ends, with an exponential
+                // backoff between the attempts, in seconds
+                bool m_reconnect;
+                double m_reconnect_min_delay;
+                double m_reconnect_max_delay;
+
+                // Restart the pipeline when no sample arrived for this many
+                // frame periods, or for the connect timeout (seconds) before
+                // the first sample and with a variable frame rate
+                int64_t m_stall_frames;
+                double m_connect_timeout;
+
+                // Reconnection statistics
+                std::atomic<uint64_t> m_reconnects;
+                std::atomic<uint64_t> m_stalls;
+                std::atomic<int64_t> m_downtime_ns;
+
+                // Start of the current outage, 0 while samples arrive
+                std::atomic<int64_t> m_down_since_ns;
+
+                // Signaled by the appsinks when a sample or the end of
+                // stream is ready to pull
+                std::mutex m_pull_mtx;
+                std::condition_variable m_pull_cv;
+                bool m_samples_pending;
+
+                // Buffers of the converted frames
+                std::shared_ptr<MatPool> m_pool;
+
+                // Encoding of the GVA meta-data
+                GvaMetaFormat m_gva_meta_format;
+
+                // Size of the last binary GVA meta-data, reserved up front
+                // for the next frame
+                size_t m_roi_size;
+
+                // Publish the raw tensor outputs as additional frame blobs
+                bool m_gva_tensor_data;
+
+                // Tensors of the current frame
+                std::vector<GvaTensorData> m_tensors;
 
                 /**
                  * Gstreamer initialization function
                  */
                 void gstreamer_init(bool snapshot_mode=false);
 
-                static GstFlowReturn new_sample(GstElement* sink, GstreamerIngestor* ctx);
+                /**
+                 * Stop watching the bus and release the pipeline
+                 */
+                void gstreamer_release();
+
+                /**
+                 * Pause the pipeline for a warm standby, keeping the sources
+                 * open, and discard the samples queued in the appsinks
+                 */
+                void gstreamer_pause();
+
+                /**
+                 * Pull the appsinks of the playing pipeline until it ends
+                 * @param last_sample_ns - latency_now_ns() of the last sample,
+                 *                         0 if none arrived
+                 */
+                PipelineEnd pull_samples(int64_t& last_sample_ns);
+
+                /**
+                 * Gstreamer bus event callback, called on the bus loop thread
+                 */
+                static gboolean bus_call(GstBus* bus, GstMessage* msg, gpointer data);
+
+                /**
+                 * appsink callbacks, called on the streaming threads when a
+                 * sample or the end of stream is ready to pull
+                 */
+                static void samples_pending(GstAppSink* sink, gpointer data);
+                static GstFlowReturn new_sample(GstAppSink* sink, gpointer data);
+
+                /**
+                 * Parse the "appsinks" config, or use the single appsink
+                 * ending the pipeline if it is missing
+                 */
+                void parse_branches(config_t* config);
+
+                /**
+                 * Read the frame layout from new caps
+                 * @return false if the format is not supported
+                 */
+                bool update_format(AppsinkBranch* branch, GstCaps* caps);
+
+                /**
+                 * Turn a sample into a frame and enqueue it
+                 * @param branch - appsink the sample was pulled from
+                 * @param sample - pulled sample, owned by this method
+                 */
+                GstFlowReturn process_sample(AppsinkBranch* branch, GstSample* sample);
+
+                /**
+                 * Add the raw outputs of the GVA tensors as blobs of the
+                 * frame, described by the "gva_tensors" meta-data. The blobs
+                 * point into the sample, which they keep a reference on.
+                 * @return false on failure
+                 */
+                bool add_tensor_blobs(udf::Frame* frame, GstSample* sample, GstBuffer* buf);
+
+                /**
+                 * Add the binary encoding of the regions of interest as a
+                 * blob of the frame, whose index is the "gva_meta_bin"
+                 * meta-data. The blob owns its bytes.
+                 * @return false on failure
+                 */
+                bool add_roi_blob(udf::Frame* frame, GstBuffer* buf);
 
             protected:
                 /**
-                 * Overridden run thread method.
+                 * Overridden run thread method, pulls the samples from the
+                 * appsink until the end of stream or a stop request. The
+                 * streaming thread only waits on the appsink queue, never on
+                 * the ingestor queue.
                  */
                 void run(bool snapshot_mode=false) override;
 
@@ -72,6 +251,11 @@ namespace eii {
                  */
                 void read(udf::Frame*& frame) override;
 
+                /**
+                 * Whether the pipeline is paused in warm standby.
+                 */
+                bool is_capture_open() const override;
+
             public:
                 /**
                  * Constructor
@@ -94,6 +278,21 @@ namespace eii {
                  */
                 void stop() override;
 
+                /**
+                 * One output per appsink when the "appsinks" config is set.
+                 */
+                std::vector<IngestorOutput> get_outputs() const override;
+
+                /**
+                 * Reconnection statistics, when "reconnect" is set.
+                 */
+                bool get_reconnect_stats(ReconnectStats& stats) const override;
+
+                /**
+                 * Frames converted into a recycled buffer or a new one.
+                 */
+                bool get_pool_stats(PoolStats& stats) const override;
+
         };
 
     } // vi
@@ -0,0 +1,127 @@
+// Copyright (c) 2020 Intel Corporation.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM,OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+
+/**
+ * @file
+ * @brief Serialization of the GVA regions of interest attached to the
+ *        GStreamer buffers
+ *
+ * The binary encoding is little-endian and versioned:
+ *
+ *  header: u32 magic "GVAR", u16 version, u16 header size, u32 ROI count,
+ *          u32 total size
+ *  ROI:    u32 x, u32 y, u32 width, u32 height, u32 tensor count
+ *  tensor: f64 confidence, i32 label_id, u16 attribute length,
+ *          u16 label length, attribute bytes, label bytes
+ *
+ * Readers skip the header bytes beyond the ones they know, so fields can be
+ * appended to the header in later versions.
+ */
+
+#ifndef _EII_VI_GVA_ROI_CODEC_H
+#define _EII_VI_GVA_ROI_CODEC_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <gst/gst.h>
+#include <eii/msgbus/msg_envelope.h>
+
+#define GVA_META "gva_meta"
+#define GVA_META_BIN "gva_meta_bin"
+#define GVA_TENSORS "gva_tensors"
+
+#define GVA_ROI_MAGIC 0x52415647
+#define GVA_ROI_VERSION 1
+
+namespace eii {
+    namespace vi {
+
+        /**
+         * Encodings of the GVA meta-data published with the frames
+         */
+        enum GvaMetaFormat {
+            // Array of objects in the "gva_meta" key
+            GVA_META_FORMAT_JSON,
+            // Binary encoding in a frame blob, whose index is in the
+            // "gva_meta_bin" key
+            GVA_META_FORMAT_BINARY,
+            // Both keys
+            GVA_META_FORMAT_BOTH,
+        };
+
+        /**
+         * Raw output of a GVA tensor, the data points into the meta-data of
+         * the buffer and stays valid as long as the buffer
+         */
+        struct GvaTensorData {
+            // Index of the region of interest in the buffer
+            int roi;
+
+            // Index of the tensor in the region of interest
+            int tensor;
+
+            // Tensor structure
+            GstStructure* s;
+
+            // Tensor "data_buffer" bytes
+            const void* data;
+            size_t size;
+        };
+
+        /**
+         * Build the "gva_meta" array of objects of a buffer.
+         * @return NULL on failure
+         */
+        msg_envelope_elem_body_t* gva_roi_to_envelope(GstBuffer* buf);
+
+        /**
+         * Encode the regions of interest of a buffer. The arena is cleared
+         * first, reusing it for every frame does not allocate once it has
+         * grown to the frame size.
+         * @param buf   - buffer with GstVideoRegionOfInterestMeta
+         * @param arena - encoded regions of interest
+         */
+        void gva_roi_encode(GstBuffer* buf, std::vector<uint8_t>& arena);
+
+        /**
+         * JSON view of an encoding, with the structure of the "gva_meta"
+         * array, for subscribers expecting it.
+         * @return false if the encoding is malformed or of a newer version
+         */
+        bool gva_roi_to_json(const uint8_t* data, size_t len, std::string& json);
+
+        /**
+         * Collect the tensors of a buffer holding a "data_buffer", without
+         * copying it. The vector is cleared first.
+         */
+        void gva_tensor_data(GstBuffer* buf, std::vector<GvaTensorData>& tensors);
+
+        /**
+         * Describe a tensor payload published as an additional frame blob:
+         * ROI and tensor indices, attribute, precision, layout, dims and
+         * index of the blob in the frame
+         * @return NULL on failure
+         */
+        msg_envelope_elem_body_t* gva_tensor_to_envelope(const GvaTensorData& tensor, int blob);
+    }
+}
+#endif // _EII_VI_GVA_ROI_CODEC_H
@@ -28,17 +28,32 @@
 #define _EII_VI_INGESTOR_H
 
 #include <string>
+#include <vector>
 #include <thread>
 #include <atomic>
 #include <eii/utils/thread_safe_queue.h>
 #include <eii/udf/frame.h>
 #include <eii/utils/config.h>
-#include <eii/utils/profiling.h>
+#include "eii/vi/frame_pacer.h"
+#include "eii/vi/latency_stats.h"
+#include "eii/vi/frame_slot.h"
+#include "eii/vi/frame_ring.h"
+#include "eii/vi/frame_queue.h"
 #include <chrono>
 
 #define TYPE1 "type"
 #define PIPELINE "pipeline"
 #define POLL_INTERVAL "poll_interval"
+#define PACING_POLICY "pacing_policy"
+#define OVERFLOW_POLICY "overflow_policy"
+#define KEEP_EVERY_NTH "keep_every_nth"
+#define WARM_STANDBY "warm_standby"
+#define SNAPSHOT_STANDBY "snapshot_standby"
+#define CLIP_BUFFER_SECONDS "clip_buffer_seconds"
+#define CLIP_BUFFER_BYTES "clip_buffer_bytes"
+#define CLIP_TOPIC "clip_topic"
+#define INGESTOR_NAME "name"
+#define INGESTOR_NAME_META "ingestor_name"
 
 
 using namespace eii::utils;
@@ -97,9 +112,68 @@ namespace eii {
         };
 
         /**
-         * Thread safe frame queue.
+         * Policy applied when the UDF input queue is full.
          */
-        typedef ThreadSafeQueue<udf::Frame*> FrameQueue;
+        enum OverflowPolicy {
+            // Wait until the queue has space (default)
+            OVERFLOW_BLOCK,
+            // Drop the frame which does not fit
+            OVERFLOW_DROP_NEWEST,
+            // Evict the oldest queued frames to make room for the new one
+            OVERFLOW_DROP_OLDEST,
+            // Wait for every Nth frame of an overflow, drop the others
+            OVERFLOW_KEEP_EVERY_NTH,
+        };
+
+        /**
+         * Output of an ingestor producing several streams, published on its
+         * own topic
+         */
+        struct IngestorOutput {
+            // Output name, unique in the ingestor
+            std::string name;
+
+            // "ingestor_name" meta-data of the frames of the output, the
+            // publisher routes them with it
+            std::string route;
+
+            // Topic of the output, empty for the ingestor topic
+            std::string topic;
+
+            // Frames ingested, before the overflow policy of the UDF input queue
+            uint64_t frames;
+        };
+
+        /**
+         * Reconnections of an ingestor to its source
+         */
+        struct ReconnectStats {
+            // Restarts of the source after an error, end of stream or stall
+            uint64_t reconnects;
+
+            // Restarts caused by a stall, no frame arriving in time
+            uint64_t stalls;
+
+            // Time without frames since the ingestor started, in seconds,
+            // including the current outage
+            double downtime;
+
+            // False during an outage
+            bool connected;
+        };
+
+        /**
+         * Recycled frame buffers of an ingestor
+         */
+        struct PoolStats {
+            // Frames decoded into a recycled buffer
+            uint64_t hits;
+
+            // Frames which needed a new buffer
+            uint64_t misses;
+        };
+
+        class FrameMerger;
 
         /**
          * Base ingestor interface.
@@ -109,6 +183,13 @@ namespace eii {
                 // Caller's AppName
                 std::string m_service_name;
 
+                // Ingestor name, set when several ingestors run in one
+                // process and added to the meta-data of every frame
+                std::string m_name;
+
+                // Topic of the clips, empty to publish them with the frames
+                std::string m_clip_topic;
+
             protected:
                 // Underlying ingestion thread
                 std::thread* m_th;
@@ -125,9 +206,6 @@ namespace eii {
                 // UDF input queue
                 FrameQueue* m_udf_input_queue;
 
-                // Queue blocked variable
-                std::string m_ingestor_block_key;
-
                 // Snapshot condition variable
                 std::condition_variable& m_snapshot_cv;
 
@@ -141,16 +219,128 @@ namespace eii {
                 // poll interval
                 double m_poll_interval;
 
-                // profiling
-                Profiling* m_profile = NULL;
+                // Paces the frames at poll_interval
+                FramePacer m_pacer;
 
                 // Flag for snapshot mode
                 bool m_snapshot;
 
+                // Queue overflow handling
+                OverflowPolicy m_overflow_policy;
+                int64_t m_keep_every_nth;
+                int64_t m_overflow_count;
+                std::atomic<uint64_t> m_dropped_frames;
+
+                // Latency statistics, written by the ingestion thread
+                LatencyHistogram m_capture_latency;
+                LatencyHistogram m_queue_wait_latency;
+
+                // Push time of the frames, shared with the publisher
+                FrameStamps* m_frame_stamps;
+
+                // Merger taking the frames of m_udf_input_queue when it is
+                // the queue of this ingestor only, NULL otherwise
+                FrameMerger* m_frame_merger;
+
+                // Keep the capture open when the ingestor is stopped, so that
+                // it resumes without reopening it
+                bool m_warm_standby;
+
+                // Time to the first frame after start(), m_start_ns is reset
+                // once the first frame is enqueued
+                std::atomic<int64_t> m_start_ns;
+                bool m_start_warm;
+                LatencyHistogram m_first_frame_cold_latency;
+                LatencyHistogram m_first_frame_warm_latency;
+
+                // Time between the successive frames of the main output,
+                // m_last_frame_ns is reset by start()
+                int64_t m_last_frame_ns;
+                LatencyHistogram m_inter_frame_latency;
+
+                // Keep the ingestor running while the ingestion is stopped,
+                // its frames replacing each other in m_latest_frame until a
+                // snapshot takes one
+                bool m_snapshot_standby;
+                std::atomic<bool> m_standby;
+                LatestFrameSlot m_latest_frame;
+
+                // Snapshots taken by runs started in snapshot mode, guarded
+                // by m_snapshot_mtx and signaled on m_snapshot_cv
+                std::mutex m_snapshot_mtx;
+                uint64_t m_snapshot_count;
+
+                // Pre-trigger ring of the recent frames, NULL if disabled,
+                // and the buffer of the last frame created by new_frame()
+                FrameRing* m_clip_ring;
+                udf::Frame* m_clip_frame;
+                ClipFrame m_clip_pending;
+
+                // Buffers created by new_frame() and not released yet, the
+                // ingestor must outlive them
+                std::atomic<uint64_t> m_buffers_in_use;
+
+                // Whether a UDF or the publisher requests packed BGR frames
+                std::atomic<bool> m_convert_to_bgr;
+
+                /**
+                 * Hand a frame over to the UDF input queue, applying the
+                 * configured overflow policy. The frame is owned by the queue
+                 * or deleted afterwards, so it must not be used anymore.
+                 * @param frame         - Frame to enqueue
+                 * @param snapshot_mode - Always wait for space if true
+                 * @param capture_ns    - latency_now_ns() when the frame was
+                 *                        captured, 0 if unknown
+                 */
+                void enqueue_frame(udf::Frame* frame, bool snapshot_mode=false, int64_t capture_ns=0);
+
                 /**
-                 * Ingestion thread run method
+                 * Hand a frame of one of the outputs of the ingestor over to
+                 * the UDF input queue, see enqueue_frame().
+                 * @param route - "ingestor_name" meta-data of the frame, empty
+                 *                for none
                  */
-                virtual void run(bool snapshot_mode=false) = 0;
+                void enqueue_output_frame(udf::Frame* frame, const std::string& route, bool snapshot_mode=false, int64_t capture_ns=0);
+
+                /**
+                 * Push a frame to the UDF input queue, recording its push time.
+                 * @param frame - Frame to push
+                 * @param wait  - Wait for space in the queue
+                 */
+                QueueRetCode push_frame(udf::Frame* frame, bool wait);
+
+                /**
+                 * Delete a frame which could not be queued and count it.
+                 */
+                void drop_frame(udf::Frame* frame);
+
+                /**
+                 * Delete a frame created by new_frame() before it is
+                 * enqueued, so that its buffer does not go to the pre-trigger
+                 * ring.
+                 */
+                void delete_frame(udf::Frame* frame);
+
+                /**
+                 * Create a frame from a buffer, see the udf::Frame
+                 * constructor. With the pre-trigger ring enabled, the buffer
+                 * is shared with the ring once the frame is enqueued.
+                 * @param fmt - buffer layout, NULL for packed BGR
+                 */
+                udf::Frame* new_frame(void* obj, void (*free_frame)(void*), void* data, int width, int height, int channels, const FrameFormat* fmt=NULL);
+
+                /**
+                 * Signal that the frame of a run started in snapshot mode has
+                 * been enqueued.
+                 */
+                void snapshot_done();
+
+                /**
+                 * Ingestion thread run method. The default implementation
+                 * reads frames with read(), numbers them and enqueues them
+                 * until the ingestor is stopped.
+                 */
+                virtual void run(bool snapshot_mode=false);
 
                 /**
                  * Read method implemented by subclasses to retrieve the next frame from
@@ -158,6 +348,12 @@ namespace eii {
                  */
                 virtual void read(udf::Frame*& frame) = 0;
 
+                /**
+                 * Whether the capture is still open from a previous run, in
+                 * which case start() resumes it instead of opening it.
+                 */
+                virtual bool is_capture_open() const;
+
                 /**
                  * Private @c Ingestor assignment operator.
                  */
@@ -189,6 +385,139 @@ namespace eii {
                  * Stop the ingestor.
                  */
                 virtual void stop() = 0;
+
+                /**
+                 * Release the frames kept by a stopped ingestor, in snapshot
+                 * standby and in the pre-trigger ring.
+                 */
+                void release_frames();
+
+                /**
+                 * Number of buffers of the frames of the ingestor still in
+                 * use, in the queues or in the clips. The ingestor can only
+                 * be deleted once it is 0.
+                 */
+                uint64_t get_buffers_in_use() const;
+
+                /**
+                 * Whether the ingestor is configured to run in snapshot
+                 * standby while the ingestion is stopped.
+                 */
+                bool get_snapshot_standby() const;
+
+                /**
+                 * Switch between publishing the frames and keeping the newest
+                 * one for the snapshots, without stopping the ingestor.
+                 */
+                void set_standby(bool standby);
+
+                /**
+                 * Enqueue the newest frame of an ingestor in snapshot standby.
+                 * @param after_ns   - Only take a frame captured after this
+                 *                     latency_now_ns() time, 0 for any
+                 * @param timeout_ns - Maximum wait for the frame
+                 * @param capture_ns - Set to the capture time of the frame
+                 * @return bool      - false on timeout
+                 */
+                bool take_snapshot(int64_t after_ns, int64_t timeout_ns, int64_t& capture_ns);
+
+                /**
+                 * Number of snapshots taken by runs started in snapshot mode.
+                 */
+                uint64_t get_snapshot_count();
+
+                /**
+                 * Wait for the snapshot of a run started in snapshot mode.
+                 * @param count      - get_snapshot_count() before the start
+                 * @param timeout_ns - Maximum wait
+                 * @return bool      - false on timeout
+                 */
+                bool wait_snapshot(uint64_t count, int64_t timeout_ns);
+
+                /**
+                 * Frames of the pre-trigger ring captured in a time window.
+                 * @param start_ns - Start of the window, since the epoch
+                 * @param end_ns   - End of the window, since the epoch
+                 * @param frames   - Frames of the window, oldest first
+                 * @return bool    - false if the ring is disabled
+                 */
+                bool get_clip(int64_t start_ns, int64_t end_ns, std::vector<ClipFrame>& frames);
+
+                /**
+                 * Memory footprint of the pre-trigger ring.
+                 * @return bool - false if the ring is disabled
+                 */
+                bool get_clip_stats(ClipStats& stats) const;
+
+                /**
+                 * "ingestor_name" meta-data routing the clips to their topic.
+                 */
+                std::string get_clip_route() const;
+
+                /**
+                 * Topic of the clips, empty if they go to the ingestor topic.
+                 */
+                std::string get_clip_topic() const;
+
+                /**
+                 * Number of frames dropped because the UDF input queue was
+                 * full.
+                 */
+                uint64_t get_dropped_frames() const;
+
+                /**
+                 * Ingestor name, empty unless configured.
+                 */
+                std::string get_name() const;
+
+                /**
+                 * Outputs of the ingestor, empty unless it produces several
+                 * streams.
+                 */
+                virtual std::vector<IngestorOutput> get_outputs() const;
+
+                /**
+                 * Reconnection statistics.
+                 * @return false if the ingestor does not reconnect
+                 */
+                virtual bool get_reconnect_stats(ReconnectStats& stats) const;
+
+                /**
+                 * Frame buffer pool statistics.
+                 * @return false if the ingestor has no buffer pool
+                 */
+                virtual bool get_pool_stats(PoolStats& stats) const;
+
+                /**
+                 * Frame pacing statistics.
+                 * @return false if the ingestor does not pace its frames
+                 */
+                bool get_pacing_stats(PacingStats& stats);
+
+                /**
+                 * Latency histogram of a stage measured by the ingestor.
+                 * @return NULL for the stages measured by the publisher
+                 */
+                const LatencyHistogram* get_latency(LatencyStage stage) const;
+
+                /**
+                 * Share the table of frame push times with the publisher.
+                 * Must be called before start().
+                 */
+                void set_frame_stamps(FrameStamps* frame_stamps);
+
+                /**
+                 * Signal the frames pushed to the queue of the ingestor to
+                 * the merger taking them. Must be called before start().
+                 */
+                void set_frame_merger(FrameMerger* frame_merger);
+
+                /**
+                 * Convert the frames to packed BGR, for the UDFs or the
+                 * subscribers which request it. May be called while the
+                 * ingestor runs.
+                 */
+                void set_convert_to_bgr(bool convert);
         };
         /**
          * Method to get the ingestor object based on the ingestor type
@@ -199,8 +528,10 @@ namespace eii {
          * @param snapshot_cv       - Snapshot condition variable
          * @param enc_type          - Frame encoding type(Optional)
          * @param enc_lvl           - Frame encoding level(Optional)
+         * @param pipeline_from_env - Override the pipeline with the PIPELINE
+         *                            environment variable if it is set
          */
-        Ingestor* get_ingestor(config_t* ingestor_cfg, FrameQueue* udf_input_queue, const char* type, std::string service_name, std::condition_variable& snapshot_cv, EncodeType enc_type, int enc_lvl);
+        Ingestor* get_ingestor(config_t* ingestor_cfg, FrameQueue* udf_input_queue, const char* type, std::string service_name, std::condition_variable& snapshot_cv, EncodeType enc_type, int enc_lvl, bool pipeline_from_env=true);
 
     } // vi
 } // eii
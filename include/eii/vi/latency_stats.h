@@ -0,0 +1,169 @@
+// Copyright (c) 2020 Intel Corporation.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM,OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+
+/**
+ * @file
+ * @brief Per stage frame latency histograms
+ */
+
+#ifndef _EII_VI_LATENCY_STATS_H
+#define _EII_VI_LATENCY_STATS_H
+
+#include <stdint.h>
+#include <time.h>
+#include <atomic>
+#include <vector>
+
+namespace eii {
+    namespace vi {
+
+        /**
+         * Stages of the frame latency
+         */
+        enum LatencyStage {
+            // From the capture of the frame to its UDF input queue push
+            STAGE_CAPTURE_TO_ENQUEUE,
+            // Time the ingestor waited on a full UDF input queue
+            STAGE_QUEUE_WAIT,
+            // From the UDF input queue push to the publisher, which covers
+            // the UDFs and both UDF queues
+            STAGE_UDF,
+            // Serialization and publication of the frame
+            STAGE_PUBLISH,
+            // From the start of the ingestor to its first frame, when the
+            // capture had to be opened
+            STAGE_FIRST_FRAME_COLD,
+            // From the start of the ingestor to its first frame, when the
+            // capture was kept open in warm standby
+            STAGE_FIRST_FRAME_WARM,
+            // Time between two successive frames of the ingestor, the
+            // steadiness of the frame rate
+            STAGE_INTER_FRAME,
+            STAGE_COUNT
+        };
+
+        /**
+         * Stage names used in the statistics
+         */
+        extern const char* const LATENCY_STAGE_NAMES[STAGE_COUNT];
+
+        /**
+         * Monotonic clock in nanoseconds
+         */
+        inline int64_t latency_now_ns() {
+            struct timespec ts;
+            clock_gettime(CLOCK_MONOTONIC, &ts);
+            return (int64_t) ts.tv_sec * 1000000000LL + ts.tv_nsec;
+        }
+
+        /**
+         * Summary of one or more histograms, in nanoseconds
+         */
+        struct LatencySummary {
+            uint64_t count;
+            int64_t mean;
+            int64_t p50;
+            int64_t p99;
+            int64_t p999;
+            int64_t max;
+        };
+
+        /**
+         * Log-linear latency histogram with 32 sub-buckets per power of two,
+         * i.e. about 3% relative error, up to 2^40 ns.
+         *
+         * A histogram has a single writing thread, which updates it without
+         * atomic read-modify-write operations. Any thread can read it.
+         */
+        class LatencyHistogram {
+            public:
+                static const int SUB_BUCKET_BITS = 5;
+                static const int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+                static const int MAX_EXPONENT = 40;
+                static const int BUCKETS = SUB_BUCKETS * (MAX_EXPONENT - SUB_BUCKET_BITS + 2);
+
+                LatencyHistogram();
+
+                /**
+                 * Record a latency, from the writing thread only.
+                 * @param ns - latency in nanoseconds, negative values count as 0
+                 */
+                void record(int64_t ns);
+
+                /**
+                 * Summarize histograms together.
+                 */
+                static LatencySummary summarize(const std::vector<const LatencyHistogram*>& histograms);
+
+            private:
+                std::atomic<uint64_t> m_buckets[BUCKETS];
+                std::atomic<uint64_t> m_count;
+                std::atomic<int64_t> m_sum;
+                std::atomic<int64_t> m_max;
+
+                static int bucket_index(int64_t ns);
+                static int64_t bucket_value(int index);
+
+                LatencyHistogram(const LatencyHistogram& src);
+                LatencyHistogram& operator=(const LatencyHistogram& src);
+        };
+
+        /**
+         * Fixed size table of the UDF input queue push time of the frames in
+         * flight, keyed by frame address, so the publisher can measure the UDF
+         * stage without adding meta-data to the frames. Lookups may miss when
+         * two frames share a slot, which only loses the sample.
+         */
+        class FrameStamps {
+            public:
+                FrameStamps();
+
+                /**
+                 * Record the time of a frame, from any thread.
+                 */
+                void put(const void* frame, int64_t ns);
+
+                /**
+                 * Get the time recorded for a frame.
+                 * @return bool - false if the time of the frame is not known
+                 */
+                bool get(const void* frame, int64_t& ns);
+
+            private:
+                static const int SLOT_BITS = 12;
+                static const int SLOTS = 1 << SLOT_BITS;
+
+                // Odd sequence numbers mark a slot being written
+                struct Slot {
+                    std::atomic<uint32_t> seq;
+                    std::atomic<uintptr_t> key;
+                    std::atomic<int64_t> ns;
+                };
+                Slot m_slots[SLOTS];
+
+                static int slot_index(const void* frame);
+
+                FrameStamps(const FrameStamps& src);
+                FrameStamps& operator=(const FrameStamps& src);
+        };
+    }
+}
+#endif
@@ -0,0 +1,361 @@
+// Copyright (c) 2020 Intel Corporation.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM,OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+/**
+ * @file
+ * @brief Bounded lock-free frame queue
+ */
+
+#ifndef _EII_VI_LOCKFREE_QUEUE_H
+#define _EII_VI_LOCKFREE_QUEUE_H
+
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <eii/utils/thread_safe_queue.h>
+
+namespace eii {
+    namespace vi {
+
+        /**
+         * Producer side of a @c LockFreeQueue.
+         */
+        enum QueueProducers {
+            // Exactly one thread pushes, e.g. ingestor -> UDF
+            SINGLE_PRODUCER,
+            // Several threads push, e.g. UDF workers -> publisher
+            MULTI_PRODUCER,
+        };
+
+        /**
+         * Bounded lock-free queue with a single consumer, meant to carry
+         * @c udf::Frame pointers between pipeline threads.
+         *
+         * Each slot carries a sequence number (Vyukov's bounded queue), so
+         * producers and the consumer never share a lock. The producer mode
+         * is chosen at construction time: with a single producer the tail is
+         * advanced with a plain store, with multiple producers it is claimed
+         * with a CAS. Blocking calls sleep on a futex and are only woken up
+         * when the other side has registered itself as waiting, so the fast
+         * path of push() and pop() never enters the kernel.
+         *
+         * \note The capacity is rounded up to the next power of two.
+         */
+        template <typename T>
+        class LockFreeQueue {
+            private:
+                // Cache line size, used to keep hot fields apart. Plain
+                // padding instead of alignas, since over-aligned new needs
+                // C++17
+                static const size_t CACHE_LINE = 64;
+
+                // Polls of the other side before going to sleep
+                static const int SPIN_COUNT = 128;
+
+                struct Slot {
+                    std::atomic<size_t> seq;
+                    T value;
+                };
+
+                Slot* m_slots;
+                size_t m_capacity;
+                size_t m_mask;
+                bool m_multi_producer;
+
+                // Producer and consumer positions on separate cache lines
+                char m_pad0[CACHE_LINE];
+                std::atomic<size_t> m_tail;
+                char m_pad1[CACHE_LINE];
+                std::atomic<size_t> m_head;
+                char m_pad2[CACHE_LINE];
+
+                // Futex words bumped after every push/pop, with the number
+                // of threads sleeping on them
+                std::atomic<uint32_t> m_pushed;
+                std::atomic<uint32_t> m_pop_waiters;
+                char m_pad3[CACHE_LINE];
+                std::atomic<uint32_t> m_popped;
+                std::atomic<uint32_t> m_push_waiters;
+                char m_pad4[CACHE_LINE];
+
+                static inline void cpu_relax() {
+#if defined(__x86_64__) || defined(__i386__)
+                    __builtin_ia32_pause();
+#endif
+                }
+
+                static size_t round_up(size_t n) {
+                    size_t ret = 2;
+                    while (ret < n) {
+                        ret <<= 1;
+                    }
+                    return ret;
+                }
+
+                /**
+                 * Sleep until @p word no longer holds @p val, or until the
+                 * timeout expires (a negative timeout waits forever).
+                 */
+                static void futex_wait(std::atomic<uint32_t>* word,
+                                       uint32_t val,
+                                       std::chrono::nanoseconds timeout) {
+                    struct timespec ts;
+                    struct timespec* pts = NULL;
+                    if (timeout.count() >= 0) {
+                        ts.tv_sec = timeout.count() / 1000000000;
+                        ts.tv_nsec = timeout.count() % 1000000000;
+                        pts = &ts;
+                    }
+                    syscall(SYS_futex, reinterpret_cast<uint32_t*>(word),
+                            FUTEX_WAIT_PRIVATE, val, pts, NULL, 0);
+                }
+
+                static void futex_wake(std::atomic<uint32_t>* word) {
+                    syscall(SYS_futex, reinterpret_cast<uint32_t*>(word),
+                            FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+                }
+
+                static void notify(std::atomic<uint32_t>& word,
+                                   std::atomic<uint32_t>& waiters) {
+                    word.fetch_add(1, std::memory_order_release);
+                    // Pairs with the fence in wait(), either the waiter sees
+                    // the new element or we see the waiter
+                    std::atomic_thread_fence(std::memory_order_seq_cst);
+                    if (waiters.load(std::memory_order_relaxed) > 0) {
+                        futex_wake(&word);
+                    }
+                }
+
+                /**
+                 * Block until @p ready returns true or the deadline expires.
+                 */
+                template <typename Ready>
+                bool wait(std::atomic<uint32_t>& word,
+                          std::atomic<uint32_t>& waiters, Ready ready,
+                          std::chrono::nanoseconds timeout) {
+                    for (int i = 0; i < SPIN_COUNT; i++) {
+                        if (ready()) {
+                            return true;
+                        }
+                        cpu_relax();
+                    }
+
+                    auto deadline = std::chrono::steady_clock::now() + timeout;
+                    while (true) {
+                        uint32_t val = word.load(std::memory_order_acquire);
+                        if (ready()) {
+                            return true;
+                        }
+                        waiters.fetch_add(1, std::memory_order_relaxed);
+                        std::atomic_thread_fence(std::memory_order_seq_cst);
+                        if (ready()) {
+                            waiters.fetch_sub(1, std::memory_order_relaxed);
+                            return true;
+                        }
+                        std::chrono::nanoseconds left(-1);
+                        if (timeout.count() >= 0) {
+                            left = deadline - std::chrono::steady_clock::now();
+                            if (left.count() <= 0) {
+                                waiters.fetch_sub(1, std::memory_order_relaxed);
+                                return false;
+                            }
+                        }
+                        futex_wait(&word, val, left);
+                        waiters.fetch_sub(1, std::memory_order_relaxed);
+                    }
+                }
+
+                /**
+                 * Private @c LockFreeQueue copy constructor.
+                 */
+                LockFreeQueue(const LockFreeQueue& src);
+
+                /**
+                 * Private @c LockFreeQueue assignment operator.
+                 */
+                LockFreeQueue& operator=(const LockFreeQueue& src);
+
+            public:
+                /**
+                 * Constructor
+                 * @param max_size  - Minimum number of elements the queue holds
+                 * @param producers - Single or multiple producer threads
+                 */
+                LockFreeQueue(size_t max_size, QueueProducers producers) :
+                    m_capacity(round_up(max_size)), m_mask(m_capacity - 1),
+                    m_multi_producer(producers == MULTI_PRODUCER),
+                    m_tail(0), m_head(0), m_pushed(0), m_pop_waiters(0),
+                    m_popped(0), m_push_waiters(0)
+                {
+                    m_slots = new Slot[m_capacity];
+                    for (size_t i = 0; i < m_capacity; i++) {
+                        m_slots[i].seq.store(i, std::memory_order_relaxed);
+                    }
+                }
+
+                /**
+                 * Destructor
+                 */
+                ~LockFreeQueue() {
+                    delete[] m_slots;
+                }
+
+                /**
+                 * Push a value without blocking.
+                 * @return QUEUE_FULL if there is no free slot
+                 */
+                utils::QueueRetCode push(T value) {
+                    size_t pos = m_tail.load(std::memory_order_relaxed);
+                    Slot* slot;
+                    while (true) {
+                        slot = &m_slots[pos & m_mask];
+                        size_t seq = slot->seq.load(std::memory_order_acquire);
+                        intptr_t diff = (intptr_t) seq - (intptr_t) pos;
+                        if (diff == 0) {
+                            if (!m_multi_producer) {
+                                m_tail.store(pos + 1, std::memory_order_relaxed);
+                                break;
+                            }
+                            if (m_tail.compare_exchange_weak(
+                                        pos, pos + 1,
+                                        std::memory_order_relaxed)) {
+                                break;
+                            }
+                        } else if (diff < 0) {
+                            return utils::QueueRetCode::QUEUE_FULL;
+                        } else {
+                            pos = m_tail.load(std::memory_order_relaxed);
+                        }
+                    }
+                    slot->value = value;
+                    slot->seq.store(pos + 1, std::memory_order_release);
+                    notify(m_pushed, m_pop_waiters);
+                    return utils::QueueRetCode::SUCCESS;
+                }
+
+                /**
+                 * Push a value, sleeping while the queue is full.
+                 */
+                utils::QueueRetCode push_wait(T value) {
+                    utils::QueueRetCode ret;
+                    wait(m_popped, m_push_waiters, [&] {
+                            ret = push(value);
+                            return ret == utils::QueueRetCode::SUCCESS;
+                        }, std::chrono::nanoseconds(-1));
+                    return ret;
+                }
+
+                /**
+                 * Push a value, sleeping up to @p timeout while the queue is
+                 * full.
+                 * @return QUEUE_FULL if the timeout expired
+                 */
+                utils::QueueRetCode push_wait(T value, std::chrono::milliseconds timeout) {
+                    utils::QueueRetCode ret = utils::QueueRetCode::QUEUE_FULL;
+                    wait(m_popped, m_push_waiters, [&] {
+                            ret = push(value);
+                            return ret == utils::QueueRetCode::SUCCESS;
+                        }, timeout);
+                    return ret;
+                }
+
+                /**
+                 * Pop a value without blocking. Must only be called from the
+                 * consumer thread.
+                 * @return false if the queue is empty
+                 */
+                bool pop(T& value) {
+                    size_t pos = m_head.load(std::memory_order_relaxed);
+                    Slot* slot = &m_slots[pos & m_mask];
+                    size_t seq = slot->seq.load(std::memory_order_acquire);
+                    if ((intptr_t) seq - (intptr_t) (pos + 1) < 0) {
+                        return false;
+                    }
+                    value = slot->value;
+                    slot->seq.store(pos + m_capacity, std::memory_order_release);
+                    m_head.store(pos + 1, std::memory_order_relaxed);
+                    notify(m_popped, m_push_waiters);
+                    return true;
+                }
+
+                /**
+                 * Read the next value without removing it. Must only be
+                 * called from the consumer thread.
+                 * @return false if the queue is empty
+                 */
+                bool peek(T& value) {
+                    size_t pos = m_head.load(std::memory_order_relaxed);
+                    Slot* slot = &m_slots[pos & m_mask];
+                    size_t seq = slot->seq.load(std::memory_order_acquire);
+                    if ((intptr_t) seq - (intptr_t) (pos + 1) < 0) {
+                        return false;
+                    }
+                    value = slot->value;
+                    return true;
+                }
+
+                /**
+                 * Sleep up to @p timeout until the next value can be popped.
+                 * Must only be called from the consumer thread.
+                 * @return false if the timeout expired
+                 */
+                bool wait_for(std::chrono::milliseconds timeout) {
+                    T value;
+                    return wait(m_pushed, m_pop_waiters, [&] {
+                            return peek(value);
+                        }, timeout);
+                }
+
+                /**
+                 * Pop a value, sleeping up to @p timeout while the queue is
+                 * empty.
+                 * @return false if the timeout expired
+                 */
+                bool pop_wait(T& value, std::chrono::milliseconds timeout) {
+                    return wait(m_pushed, m_pop_waiters, [&] {
+                            return pop(value);
+                        }, timeout);
+                }
+
+                /**
+                 * Approximate number of queued elements.
+                 */
+                size_t size() {
+                    size_t tail = m_tail.load(std::memory_order_acquire);
+                    size_t head = m_head.load(std::memory_order_acquire);
+                    return (tail > head) ? tail - head : 0;
+                }
+
+                bool empty() {
+                    return size() == 0;
+                }
+
+                size_t capacity() const {
+                    return m_capacity;
+                }
+        };
+    } // vi
+} // eii
+#endif // _EII_VI_LOCKFREE_QUEUE_H
@@ -29,7 +29,13 @@
 #include <opencv2/opencv.hpp>
 #include <eii/utils/thread_safe_queue.h>
 #include "eii/vi/ingestor.h"
+#include "eii/vi/frame_pool.h"
+#include "eii/vi/lockfree_queue.h"
+#include "eii/vi/segment_decoder.h"
 #include <string>
+#include <memory>
+#include <atomic>
+#include <thread>
 
 namespace eii {
     namespace vi {
@@ -60,6 +66,67 @@ namespace eii {
             // Flag for enabling the Image ingestion
             bool m_img_flag;
 
+            // Recycled buffers the video frames are decoded into
+            std::shared_ptr<MatPool> m_pool;
+
+            // Number of video frames decoded ahead by the decoder thread, 0
+            // to decode on the ingestor thread
+            size_t m_read_ahead;
+
+            // Decoder thread, running while the ingestor runs
+            std::thread* m_decode_th;
+
+            // Frames decoded ahead, the decoder thread is the only
+            // producer and the ingestor thread the only consumer
+            LockFreeQueue<PooledMat*>* m_prefetch;
+            std::atomic<bool> m_decode_stop;
+
+            // Set by the decoder thread at the end of the video
+            std::atomic<bool> m_decode_end;
+
+            // Number of threads decoding the video file in segments, as
+            // fast as possible, 0 to decode it at the ingestion rate
+            size_t m_batch_threads;
+
+            // Parallel decoder of the video file in batch mode
+            SegmentDecoder* m_batch;
+
+            // Set while run() reads the frames from m_batch
+            bool m_batch_running;
+
+            /**
+             * Decode the next video frame, opening or looping the video
+             * capture as needed
+             * @param cv_frame - Mat the frame is decoded into
+             * @return bool    - false at the end of the video
+             */
+            bool decode(cv::Mat* cv_frame);
+
+            /**
+             * Decoder thread run method
+             */
+            void decode_run();
+
+            /**
+             * Wait for the next frame decoded ahead
+             * @return PooledMat* - NULL at the end of the video or when the
+             *                      ingestor is stopped
+             */
+            PooledMat* next_decoded();
+
+            /**
+             * Wait for the next frame of the batch decoder, restarting it
+             * at the end of the file if the video loops
+             * @return PooledMat* - NULL at the end of the video or when the
+             *                      ingestor is stopped
+             */
+            PooledMat* next_batch();
+
+            /**
+             * Stop the decoder threads and release the frames decoded ahead
+             */
+            void stop_decoder();
+
         protected:
             /**
              * Overridden run method.
@@ -71,6 +138,11 @@ namespace eii {
              */
             void read(udf::Frame*& frame) override;
 
+            /**
+             * Whether the video capture was kept open in warm standby.
+             */
+            bool is_capture_open() const override;
+
             /**
             imread method implemented to read the image for image ingestion feature
             **/
@@ -98,6 +170,11 @@ namespace eii {
             */
            void stop() override;
 
+           /**
+            * Video frames decoded into a recycled buffer or a new one.
+            */
+           bool get_pool_stats(PoolStats& stats) const override;
+
         };
 
     } // vi
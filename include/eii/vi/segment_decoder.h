@@ -0,0 +1,183 @@
+// Copyright (c) 2020 Intel Corporation.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM,OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+/**
+ * @file
+ * @brief Parallel decoding of a video file split into key frame segments
+ */
+
+#ifndef _EII_VI_SEGMENT_DECODER_H
+#define _EII_VI_SEGMENT_DECODER_H
+
+#include <stdint.h>
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <condition_variable>
+#include "eii/vi/frame_pool.h"
+
+namespace eii {
+    namespace vi {
+
+        /**
+         * Decodes a video file as fast as possible on several threads.
+         *
+         * The file is split at key frames into segments of consecutive
+         * frames. Each decoder thread seeks its own video capture to the
+         * next segment left and decodes it. next() returns the frames in
+         * file order: a frame decoded ahead of the frame expected next is
+         * held back, and decoders wait once their frame is a window of
+         * frames ahead of it. The window bounds the memory used, it must
+         * hold a segment per thread for all the threads to decode at once.
+         */
+        class SegmentDecoder {
+            private:
+                // Frames [start, start + count) of the file, count -1 up
+                // to the end of the file
+                struct Segment {
+                    int64_t start;
+                    int64_t count;
+                    // Frames decoded and not returned by next() yet
+                    std::deque<PooledMat*> frames;
+                    // Set once the decoder is done with the segment
+                    bool done;
+                };
+
+                // Video file
+                std::string m_pipeline;
+
+                // Number of decoder threads
+                size_t m_threads;
+
+                // Maximum distance, in frames, between a decoded frame and
+                // the frame expected next
+                size_t m_window;
+
+                // Buffers the frames are decoded into
+                std::shared_ptr<MatPool> m_pool;
+
+                std::vector<std::thread*> m_decoders;
+
+                // Lock on the segments and the read position
+                std::mutex m_mtx;
+                std::condition_variable m_cv;
+
+                std::vector<Segment> m_segments;
+
+                // Next segment without a decoder
+                size_t m_next_segment;
+
+                // Segment and frame next() returns next
+                size_t m_head;
+                int64_t m_head_pos;
+
+                bool m_stop;
+
+                // Whether the segments start on key frames
+                bool m_key_frames;
+
+                // Frames returned by next() and decode time, in
+                // latency_now_ns() time
+                uint64_t m_frames;
+                int64_t m_start_ns;
+                int64_t m_end_ns;
+
+                /**
+                 * Split the file into segments.
+                 * @return bool - false if the file cannot be read
+                 */
+                bool plan();
+
+                /**
+                 * Decoder thread run method
+                 */
+                void decode_run();
+
+                SegmentDecoder(const SegmentDecoder& src);
+                SegmentDecoder& operator=(const SegmentDecoder& src);
+
+            public:
+                /**
+                 * Constructor
+                 * @param pipeline - Video file
+                 * @param threads  - Number of decoder threads
+                 * @param window   - Frames decoded ahead of the frame
+                 *                   expected next at most
+                 * @param pool     - Buffers the frames are decoded into,
+                 *                   needs window + threads of them
+                 */
+                SegmentDecoder(const std::string& pipeline, size_t threads, size_t window,
+                               std::shared_ptr<MatPool> pool);
+
+                /**
+                 * Destructor, stops the decoder threads.
+                 */
+                ~SegmentDecoder();
+
+                /**
+                 * Split the file into segments and start the decoder
+                 * threads, from the first frame of the file.
+                 * @return bool - false if the file cannot be read
+                 */
+                bool start();
+
+                /**
+                 * Wait for the next frame of the file.
+                 * @param cancel - Polled while waiting, returns NULL once set
+                 * @return PooledMat* - Frame owned by the caller, NULL at the
+                 *                      end of the file or when cancelled
+                 */
+                PooledMat* next(const std::atomic<bool>& cancel);
+
+                /**
+                 * Stop the decoder threads and release the frames decoded
+                 * ahead.
+                 */
+                void stop();
+
+                /**
+                 * Number of segments the file was split into.
+                 */
+                size_t get_segments();
+
+                /**
+                 * Whether the segments start on key frames, they start on
+                 * evenly spaced frames if the key frames are unknown.
+                 */
+                bool get_key_frames();
+
+                /**
+                 * Number of frames returned by next() since start().
+                 */
+                uint64_t get_frames();
+
+                /**
+                 * Frames returned per second, from start() to the end of
+                 * the file.
+                 */
+                double get_fps();
+        };
+    }
+}
+#endif
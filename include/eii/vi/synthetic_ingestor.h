@@ -0,0 +1,143 @@
+// Copyright (c) 2020 Intel Corporation.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM,OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+
+/**
+ * @file
+ * @brief Synthetic frame source ingestor interface
+ */
+
+#ifndef _EII_VI_SYNTHETIC_H
+#define _EII_VI_SYNTHETIC_H
+
+#include <string>
+#include <atomic>
+#include <eii/utils/thread_safe_queue.h>
+#include "eii/vi/ingestor.h"
+
+namespace eii {
+    namespace vi {
+
+        /**
+         * Content of the synthetic frames
+         */
+        enum SyntheticPattern {
+            // Same frame over and over
+            PATTERN_STATIC,
+            // Random pixels
+            PATTERN_NOISE,
+            // Diagonal gradient moving with every frame
+            PATTERN_GRADIENT,
+        };
+
+        /**
+         * Pre-rendered pixels the synthetic frames point into. It is
+         * reference counted since frames in flight can outlive the ingestor.
+         */
+        class SyntheticFrames {
+            private:
+                // Owner reference plus one per frame in flight
+                std::atomic<int64_t> m_refs;
+
+                // Rendered pixels, with room for the frame offsets
+                uint8_t* m_pixels;
+
+                // Offset between two consecutive frames in bytes
+                size_t m_frame_offset;
+
+                // Number of distinct frames
+                int m_frames;
+
+                ~SyntheticFrames();
+
+            public:
+                /**
+                 * Render the frames.
+                 * @param width    - Frame width
+                 * @param height   - Frame height
+                 * @param channels - Bytes per pixel
+                 * @param pattern  - Frame content
+                 */
+                SyntheticFrames(int width, int height, int channels, SyntheticPattern pattern);
+
+                /**
+                 * Pixels of the given frame, taking a reference.
+                 */
+                void* acquire(int64_t index);
+
+                /**
+                 * Release a reference, the last one frees the pixels.
+                 */
+                void release();
+
+                /**
+                 * Frame free callback releasing the reference of the frame.
+                 */
+                static void free_frame(void* obj);
+        };
+
+        /**
+         * Synthetic frame source, for load testing without camera or video
+         * file. Frames are not copied, they point into pre-rendered pixels.
+         */
+        class SyntheticIngestor : public Ingestor {
+            private:
+                // Frame geometry
+                int m_width;
+                int m_height;
+                int m_channels;
+
+                // Pre-rendered frames
+                SyntheticFrames* m_frames;
+
+                // Index of the next frame
+                int64_t m_index;
+
+            protected:
+                /**
+                 * Overridden read method.
+                 */
+                void read(udf::Frame*& frame) override;
+
+            public:
+                /**
+                 * Constructor
+                 * @param config        - Ingestion config
+                 * @param frame_queue   - Frame Queue context
+                 * @param service_name  - Service Name env variable
+                 * @param snapshot_cv   - Snapshot condition variable
+                 * @param enc_type      - Frame encoding type(Optional)
+                 * @param enc_lvl       - Frame encoding level(Optional)
+                 */
+                SyntheticIngestor(config_t* config, FrameQueue* frame_queue, std::string service_name, std::condition_variable& snapshot_cv, EncodeType enc_type, int enc_lvl);
+
+                /**
+                 * Destructor
+                 */
+                ~SyntheticIngestor();
+
+                /**
+                 * Overridden stop method.
+                 */
+                void stop() override;
+        };
+    }
+}
+#endif // _EII_VI_SYNTHETIC_H
@@ -28,9 +28,13 @@
 #define _EII_VI_VIDEOINGESTION_H
 
 #include <thread>
+#include <vector>
+#include <deque>
+#include <mutex>
 #include <functional>
 #include <atomic>
 #include <condition_variable>
+#include <future>
 #include <eii/udf/frame.h>
 #include <string.h>
 #include <eii/utils/config.h>
@@ -41,6 +45,8 @@
 #include <eii/msgbus/msg_envelope.h>
 #include <eii/udf/udf_manager.h>
 #include "eii/vi/ingestor.h"
+#include "eii/vi/frame_merger.h"
+#include "eii/vi/frame_publisher.h"
 #include "eii/config_manager/config_mgr.hpp"
 #include "eii/ch/command_handler.h"
 
@@ -52,6 +58,78 @@ using namespace eii::config_manager;
 namespace eii {
     namespace vi {
 
+        /**
+         * State of one configured ingestor (camera)
+         */
+        struct IngestorCtx {
+            // Ingestor name, empty if a single ingestor is configured
+            std::string name;
+
+            // Topic the frames of the ingestor are published on
+            std::string topic;
+
+            // Ingestor type - opencv or gstreamer
+            std::string type;
+
+            // Ingestor config, owned by the context
+            config_t* cfg;
+
+            // Ingestor object
+            Ingestor* ingestor;
+
+            // Queue the ingestor pushes its frames to, its own queue when
+            // several ingestors are configured, and its size
+            FrameQueue* queue;
+            size_t queue_size;
+
+            // Whether the overflow policy evicts the oldest queued frames,
+            // which requires a queue of the frame merger
+            bool drop_oldest;
+
+            // Ingestion state when the software trigger is enabled
+            std::atomic<bool> running;
+
+            // Snapshot condition variable
+            std::condition_variable snapshot_cv;
+
+            IngestorCtx() : cfg(NULL), ingestor(NULL), queue(NULL), queue_size(0), drop_oldest(false), running(false) {}
+
+            /**
+             * Destructor, releases the config. The ingestor is deleted by
+             * VideoIngestion, after the frames it produced.
+             */
+            ~IngestorCtx() {
+                if (cfg != NULL)
+                    config_destroy(cfg);
+            }
+        };
+
+        /**
+         * Clip requested by DUMP_CLIP
+         */
+        struct ClipJob {
+            // Clip number, returned to the client
+            uint64_t id;
+
+            // Ingestor the clip is extracted from
+            IngestorCtx* ictx;
+
+            // Time window, in nanoseconds since the epoch
+            int64_t start_ns;
+            int64_t end_ns;
+        };
+
+        /**
+         * Phase of the startup timeline
+         */
+        struct StartupPhase {
+            std::string name;
+
+            // Start since the construction and duration, in milliseconds
+            double start_ms;
+            double duration_ms;
+        };
+
         /**
          * VideoIngestion class
          */
@@ -61,48 +139,182 @@ namespace eii {
                 // App name
                 std::string m_app_name;
 
-                // Ingestor type - opencv or gstreamer
-                std::string m_ingestor_type;
+                // VideoIngestion/config currently applied
+                std::string m_config;
+
+                // Serializes the commands with the reconfigurations
+                std::mutex m_cmd_mtx;
+
+                // Wakes the snapshot bursts sleeping between two shots, and
+                // the destructor waiting for them to return
+                std::condition_variable m_cmd_cv;
+                bool m_cmd_stop;
+                int m_snapshot_bursts;
+
+                // Configured ingestors, one per camera
+                std::vector<IngestorCtx*> m_ingestors;
 
-                // Ingestor object
-                Ingestor* m_ingestor;
+                // Ingestors replaced by a reconfiguration, deleted once the
+                // frames they produced are released, guarded by m_cmd_mtx
+                std::vector<Ingestor*> m_retired_ingestors;
 
                 // CommandHandler object
                 CommandHandler* m_commandhandler;
 
-                // EII MsgBus Publisher
-                msgbus::PublisherThread* m_publisher;
+                // Publisher routing frames to per ingestor topics
+                FramePublisher* m_frame_publisher;
+
+                // Push time of the frames, shared by ingestors and publisher
+                FrameStamps m_frame_stamps;
+
+                // Period of the statistics dump in seconds, 0 if disabled
+                double m_stats_interval;
+
+                // Statistics dump thread
+                std::thread* m_stats_th;
+                std::mutex m_stats_mtx;
+                std::condition_variable m_stats_cv;
+                bool m_stats_stop;
+
+                // Clip thread publishing the DUMP_CLIP windows, so the
+                // command returns at once
+                std::thread* m_clip_th;
+                std::mutex m_clip_mtx;
+                std::condition_variable m_clip_cv;
+                std::deque<ClipJob> m_clip_jobs;
+                std::atomic<bool> m_clip_stop;
+                uint64_t m_clip_id;
+
+                // Startup timeline, the phases run on several threads
+                int64_t m_startup_ns;
+                bool m_startup_done;
+                std::mutex m_startup_mtx;
+                std::vector<StartupPhase> m_startup_phases;
 
                 // EII UDFManager
                 UdfManager* m_udf_manager;
 
+                // Thread creating the UDFManager of init(), loading the models
+                // while the ingestors and the publisher are created. It keeps
+                // running until that manager is deleted, so that the UDFs are
+                // unloaded on the thread that loaded them
+                std::thread* m_udf_th;
+                std::future<UdfManager*> m_udf_future;
+                std::promise<void> m_udf_release;
+                UdfManager* m_udf_owned;
+
                 // UDF input queue
                 FrameQueue* m_udf_input_queue;
 
+                // Merger of the queues of the ingestors into the UDF input
+                // queue, NULL with a single ingestor pushing to it directly
+                FrameMerger* m_frame_merger;
+
                 // UDF output queue
                 FrameQueue* m_udf_output_queue;
 
                 // Error condition variable
                 std::condition_variable& m_err_cv;
 
-                // ingestor config
-                config_t* m_ingestor_cfg;
-
                 // Encoding details
                 EncodeType m_enc_type;
                 int m_enc_lvl;
 
+                // Whether the publisher interface or one of the UDFs requests
+                // packed BGR frames
+                bool m_publish_bgr;
+                bool m_udf_bgr;
+
                 // Software trigger enabled flag
                 bool m_sw_trgr_en;
 
                 // bool value of the init_state - true - if init_state = running ; false - if init state = stopped
                 bool m_init_state_start;
 
-                // variable to store the current Ingestion_state i.e. if Ingestion is going on or stopped
-                std::atomic<bool> m_ingestion_running;
+                /**
+                 * Parse one entry of the ingestor config
+                 * @param ingestor_value - ingestor config object
+                 * @param queue_size     - incremented by the queue size of the entry
+                 * @return IngestorCtx*  - ingestor state, the ingestor itself is not created yet
+                 */
+                IngestorCtx* parse_ingestor(config_value_t* ingestor_value, size_t& queue_size);
+
+                /**
+                 * Parse the encoding config
+                 * @param config   - VideoIngestion config
+                 * @param enc_type - encoding type, NONE if not configured
+                 * @param enc_lvl  - encoding level
+                 */
+                void parse_encoding(config_t* config, EncodeType& enc_type, int& enc_lvl);
+
+                /**
+                 * Create the UDF manager, run in the background by init()
+                 * @return UdfManager* - UDF manager, not started
+                 */
+                UdfManager* create_udf_manager();
+
+                /**
+                 * Body of the UDF thread of init(), creates the UDF manager
+                 * and deletes it once released
+                 * @param created - set to the UDF manager or to the error
+                 * @param release - ready once the UDF manager can be deleted
+                 */
+                void run_udf_manager(std::promise<UdfManager*> created,
+                                     std::future<void> release);
+
+                /**
+                 * Wait for the UDF manager created in the background, if any
+                 */
+                void wait_udf_manager();
+
+                /**
+                 * Delete a UDF manager, on the UDF thread if it created it
+                 * @param udf_manager - stopped UDF manager, may be NULL
+                 */
+                void delete_udf_manager(UdfManager* udf_manager);
+
+                /**
+                 * Free the state built by init() when it throws, since the
+                 * destructor does not run for a failed constructor
+                 */
+                void free_init_state();
+
+                /**
+                 * Start the ingestor of a context in the state the ingestion
+                 * is in, running, in snapshot standby or stopped
+                 */
+                void resume_ingestor(IngestorCtx* ictx);
+
+                /**
+                 * Delete the retired ingestors whose frames are all released
+                 * @param timeout_ns - Maximum wait for the frames still in
+                 *                     the queues, the UDFs or the clips
+                 */
+                void reap_ingestors(int64_t timeout_ns);
+
+                /**
+                 * Record a phase of the startup timeline, ending now
+                 * @param name     - phase name
+                 * @param start_ns - latency_now_ns() time the phase started
+                 */
+                void startup_phase(const std::string& name, int64_t start_ns);
+
+                /**
+                 * Parse the VideoIngestion config and create the ingestors,
+                 * the UDF manager and the publisher
+                 * @param vi_config  - VideoIngestion/config
+                 * @param pub_config - Publisher msgbus configuration
+                 * @param topics     - Publisher topics
+                 */
+                void init(char* vi_config, config_t* pub_config, const std::vector<std::string>& topics);
 
-                // Snapshot condition variable
-                std::condition_variable m_snapshot_cv;
+                /**
+                 * Select the ingestors a command applies to
+                 * @param arg_payload - command arguments, may contain the ingestor "name"
+                 * @param selected    - ingestors addressed by the command
+                 * @return bool       - false if the name does not match any ingestor
+                 */
+                bool select_ingestors(msg_envelope_elem_body_t* arg_payload, std::vector<IngestorCtx*>& selected);
 
                 /**
 	         * Process the start ingestion software trigger and control the ingestor
@@ -125,6 +337,67 @@ namespace eii {
                  */
                 msg_envelope_elem_body_t* process_snapshot(msg_envelope_elem_body_t *arg_payload);
 
+                /**
+                 * Take one snapshot of an ingestor, from its latest frame slot
+                 * in snapshot standby or by running it for one frame
+                 * @param ictx     - ingestor
+                 * @param after_ns - only take a frame captured after this
+                 *                   latency_now_ns() time, 0 for any
+                 * @param last_ns  - capture time of the previous snapshot of
+                 *                   a burst, updated with the new one
+                 * @return bool    - false if no frame was enqueued in time
+                 */
+                bool snapshot(IngestorCtx* ictx, int64_t after_ns, int64_t& last_ns);
+
+                /**
+                 * Process the dump clip command, queuing the publication of
+                 * the frames of the pre-trigger ring in a time window
+                 * @param arg_payload -- Argument Payload object received (in the main payload) from client
+                 * @return reply_payload - return values payload JSON buffer to be returned back to the client
+                 */
+                msg_envelope_elem_body_t* process_dump_clip(msg_envelope_elem_body_t *arg_payload);
+
+                /**
+                 * Clip thread run method
+                 */
+                void clip_run();
+
+                /**
+                 * Publish the frames of a clip, after the live frames
+                 * @param job      - clip to publish
+                 * @param frames   - frames of the clip window
+                 * @param route    - publisher route of the clip
+                 * @param enc_type - encoding of the raw frames
+                 * @param enc_lvl  - encoding level
+                 */
+                void publish_clip(const ClipJob& job, std::vector<ClipFrame>& frames,
+                                  const std::string& route, EncodeType enc_type, int enc_lvl);
+
+                /**
+                 * Process the get stats command, replying with the latency
+                 * percentiles of every stage
+                 * @param arg_payload -- Argument Payload object received (in the main payload) from client
+                 * @return reply_payload - return values payload JSON buffer to be returned back to the client
+                 */
+                msg_envelope_elem_body_t* process_get_stats(msg_envelope_elem_body_t *arg_payload);
+
+                /**
+                 * Latency summary of a stage
+                 * @param ictx  - ingestor, NULL to merge all the ingestors
+                 * @param stage - latency stage
+                 */
+                LatencySummary get_latency_summary(IngestorCtx* ictx, LatencyStage stage);
+
+                /**
+                 * Statistics dump thread run method
+                 */
+                void stats_dump_run();
+
+                /**
+                 * Stop the statistics dump thread
+                 */
+                void stop_stats();
+
                 /**
                  * Private @c VideoIngestion assignment operator.
                  *
@@ -147,13 +420,28 @@ namespace eii {
                  */
                 VideoIngestion(std::string app_name, std::condition_variable& err_cv, char* vi_config, ConfigMgr* ctx, CommandHandler* commandhandler);
 
+                /**
+                 * Constructor taking the publisher configuration directly,
+                 * without ConfigManager
+                 *
+                 * \note The publisher configuration is not owned by this object.
+                 *
+                 * @param app_name          - App_name env variable for App_Name
+                 * @param err_cv            - Error condition variable
+                 * @param vi_config         - VideoIngestion/config
+                 * @param pub_config        - Publisher msgbus configuration
+                 * @param topics            - Publisher topics
+                 * @param commandhandler    - Command Handler context, may be NULL
+                 */
+                VideoIngestion(std::string app_name, std::condition_variable& err_cv, char* vi_config, config_t* pub_config, const std::vector<std::string>& topics, CommandHandler* commandhandler);
+
                 /*
                  * Destructor
                  */
                 ~VideoIngestion();
 
                 /**
-                 * Start the VI pipeline in order of MsgBusPublisher, UDFManager and Ingestor
+                 * Start the VI pipeline in order of MsgBusPublisher, UDFManager and Ingestors
                  */
                 void start();
 
@@ -161,6 +449,41 @@ namespace eii {
                  * Stop the VI pipeline in reverse order
                  */
                 void stop();
+
+                /**
+                 * Apply a new config, rebuilding only the changed ingestors,
+                 * the UDF chain and the statistics dump while the other
+                 * components keep running
+                 * @param vi_config - new VideoIngestion/config
+                 * @return bool     - false if the change needs a new
+                 *                    VideoIngestion, the current one is
+                 *                    left untouched then
+                 */
+                bool reconfigure(char* vi_config);
+
+                /**
+                 * Latency summary of a stage, merged over all the ingestors
+                 * @param stage - latency stage
+                 */
+                LatencySummary get_latency(LatencyStage stage);
+
+                /**
+                 * Memory footprint of the pre-trigger rings, summed over all
+                 * the ingestors
+                 * @return bool - false if no ingestor has a ring
+                 */
+                bool get_clip_stats(ClipStats& stats);
+
+                /**
+                 * Phases of the startup, logged at the end of the first start()
+                 */
+                std::vector<StartupPhase> get_startup_phases();
+
+                /**
+                 * Time from the construction to the first published frame
+                 * @return int64_t - nanoseconds, -1 before the first frame
+                 */
+                int64_t get_time_to_first_frame() const;
         };
     }
 }
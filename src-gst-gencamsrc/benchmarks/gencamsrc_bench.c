@@ -0,0 +1,265 @@
+/*
+ * GStreamer Generic Camera Plugin - benchmark
+ * Copyright (c) 2020, Intel Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Measures the frame rate, CPU time per frame and grab latency of gencamsrc.
+ * All the remaining command line arguments are passed to gencamsrc as
+ * properties, e.g.
+ *
+ *   gencamsrc-bench -n 1000 serial=<deviceSerialNumber> width=1280
+ *
+ * With --mock the cameras of the mock GenTL producer from the build tree are
+ * used, see GENTL_MOCK_DEVICES in mockgentl/mock_gentl.cc. The mock stamps
+ * frames with CLOCK_MONOTONIC, which allows to report the grab latency.
+ *
+ * With --triggers the rate at which triggered frames are delivered is
+ * compared with persistent streaming enabled and disabled, e.g.
+ *
+ *   gencamsrc-bench -t -n 200 serial=<deviceSerialNumber>
+ *       acquisition-mode=singleframe trigger-source=Software
+ */
+
+#include <gst/gst.h>
+#include <stdlib.h>
+#include <sys/resource.h>
+
+typedef struct
+{
+  guint64 frames;               /* Frames received by the sink */
+  gint64 firstUs;               /* Monotonic time of the first frame */
+  gint64 lastUs;                /* Monotonic time of the last frame */
+  gint64 firstCpuUs;            /* Process CPU time at the first frame */
+  gint64 lastCpuUs;             /* Process CPU time at the last frame */
+  GArray *latencyUs;            /* Capture to sink latencies, if measured */
+} BenchStats;
+
+static gint64
+cpu_time_us (void)
+{
+  struct rusage usage;
+
+  getrusage (RUSAGE_SELF, &usage);
+  return (gint64) (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) *
+      G_USEC_PER_SEC + usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+}
+
+static void
+on_handoff (GstElement * sink, GstBuffer * buf, GstPad * pad,
+    gpointer user_data)
+{
+  BenchStats *stats = (BenchStats *) user_data;
+  gint64 now = g_get_monotonic_time ();
+  gint64 cpu = cpu_time_us ();
+
+  if (stats->frames == 0) {
+    stats->firstUs = now;
+    stats->firstCpuUs = cpu;
+  }
+  stats->lastUs = now;
+  stats->lastCpuUs = cpu;
+  stats->frames++;
+
+  // PTS is the camera timestamp, only comparable with the mock producer
+  if (stats->latencyUs && GST_BUFFER_PTS_IS_VALID (buf)) {
+    gint64 latency = now - (gint64) (GST_BUFFER_PTS (buf) / GST_USECOND);
+    g_array_append_val (stats->latencyUs, latency);
+  }
+}
+
+static gboolean
+run_bench (const gchar * props, gint numBuffers, BenchStats * stats)
+{
+  GError *error = NULL;
+  GstElement *pipeline, *sink;
+  GstBus *bus;
+  GstMessage *msg;
+  gboolean ret = TRUE;
+  gchar *desc;
+
+  desc = g_strdup_printf ("gencamsrc %s num-buffers=%d ! "
+      "fakesink name=sink sync=false signal-handoffs=true", props,
+      numBuffers);
+  pipeline = gst_parse_launch (desc, &error);
+  g_free (desc);
+  if (pipeline == NULL || error != NULL) {
+    g_printerr ("Failed to create pipeline: %s\n",
+        error ? error->message : "unknown error");
+    g_clear_error (&error);
+    if (pipeline) {
+      gst_object_unref (pipeline);
+    }
+    return FALSE;
+  }
+
+  sink = gst_bin_get_by_name (GST_BIN (pipeline), "sink");
+  g_signal_connect (sink, "handoff", G_CALLBACK (on_handoff), stats);
+  gst_object_unref (sink);
+
+  gst_element_set_state (pipeline, GST_STATE_PLAYING);
+
+  bus = gst_element_get_bus (pipeline);
+  msg = gst_bus_timed_pop_filtered (bus, GST_CLOCK_TIME_NONE,
+      GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+  if (GST_MESSAGE_TYPE (msg) == GST_MESSAGE_ERROR) {
+    gst_message_parse_error (msg, &error, NULL);
+    g_printerr ("Pipeline error: %s\n", error->message);
+    g_clear_error (&error);
+    ret = FALSE;
+  }
+  gst_message_unref (msg);
+  gst_object_unref (bus);
+
+  gst_element_set_state (pipeline, GST_STATE_NULL);
+  gst_object_unref (pipeline);
+  return ret;
+}
+
+static gint
+compare_int64 (gconstpointer a, gconstpointer b)
+{
+  gint64 x = *(const gint64 *) a;
+  gint64 y = *(const gint64 *) b;
+
+  return (x > y) - (x < y);
+}
+
+static gint64
+percentile (GArray * sorted, gdouble p)
+{
+  guint index = (guint) (p * (sorted->len - 1) + 0.5);
+
+  return g_array_index (sorted, gint64, index);
+}
+
+static void
+print_stats (const gchar * label, BenchStats * stats, gboolean triggers)
+{
+  gdouble elapsed = (stats->lastUs - stats->firstUs) / 1e6;
+  gdouble rate = 0;
+  gdouble cpu = 0;
+
+  // The first frame only marks the start, the rate is over the intervals
+  if (stats->frames > 1 && elapsed > 0) {
+    rate = (stats->frames - 1) / elapsed;
+    cpu = (gdouble) (stats->lastCpuUs - stats->firstCpuUs) /
+        (stats->frames - 1);
+  }
+  g_print ("%-24s frames: %" G_GUINT64_FORMAT "  elapsed: %.3f s  "
+      "%s: %.2f  cpu/frame: %.1f us\n", label, stats->frames, elapsed,
+      triggers ? "triggers/sec" : "fps", rate, cpu);
+
+  if (stats->latencyUs && stats->latencyUs->len > 0) {
+    g_array_sort (stats->latencyUs, compare_int64);
+    g_print ("%-24s latency p50: %" G_GINT64_FORMAT " us  p99: %"
+        G_GINT64_FORMAT " us  max: %" G_GINT64_FORMAT " us\n", "",
+        percentile (stats->latencyUs, 0.5),
+        percentile (stats->latencyUs, 0.99),
+        g_array_index (stats->latencyUs, gint64, stats->latencyUs->len - 1));
+  }
+}
+
+int
+main (int argc, char *argv[])
+{
+  gint numBuffers = 100;
+  gboolean triggers = FALSE;
+  gboolean mock = FALSE;
+  gchar **props = NULL;
+  gchar *joined, *persistentProps, *restartProps;
+  GError *error = NULL;
+  GOptionContext *ctx;
+  BenchStats stats = { 0 };
+  BenchStats restart = { 0 };
+  gboolean ok;
+
+  GOptionEntry entries[] = {
+    {"num-buffers", 'n', 0, G_OPTION_ARG_INT, &numBuffers,
+        "Frames to acquire in each run (default 100)", "N"},
+    {"triggers", 't', 0, G_OPTION_ARG_NONE, &triggers,
+        "Compare triggered acquisition with and without persistent "
+          "streaming", NULL},
+    {"mock", 'm', 0, G_OPTION_ARG_NONE, &mock,
+        "Use the mock GenTL producer of the build tree", NULL},
+    {G_OPTION_REMAINING, 0, 0, G_OPTION_ARG_STRING_ARRAY, &props,
+        NULL, "[PROPERTY=VALUE...]"},
+    {NULL}
+  };
+
+  ctx = g_option_context_new ("- gencamsrc acquisition benchmark");
+  g_option_context_add_main_entries (ctx, entries, NULL);
+  g_option_context_add_group (ctx, gst_init_get_option_group ());
+  if (!g_option_context_parse (ctx, &argc, &argv, &error)) {
+    g_printerr ("%s\n", error->message);
+    g_clear_error (&error);
+    g_option_context_free (ctx);
+    return EXIT_FAILURE;
+  }
+  g_option_context_free (ctx);
+
+  // Prefer the plugin of the build tree over an installed one
+  gst_registry_scan_path (gst_registry_get (), GENCAMSRC_PLUGIN_DIR);
+
+  if (mock) {
+    g_setenv ("GENICAM_GENTL64_PATH", MOCK_GENTL_PATH, TRUE);
+    stats.latencyUs = g_array_new (FALSE, FALSE, sizeof (gint64));
+    restart.latencyUs = g_array_new (FALSE, FALSE, sizeof (gint64));
+  }
+
+  joined = props ? g_strjoinv (" ", props) : g_strdup ("");
+
+  if (triggers) {
+    persistentProps = g_strdup_printf ("%s persistent-streaming=true",
+        joined);
+    restartProps = g_strdup_printf ("%s persistent-streaming=false", joined);
+    ok = run_bench (persistentProps, numBuffers, &stats)
+        && run_bench (restartProps, numBuffers, &restart);
+    if (ok) {
+      print_stats ("persistent-streaming", &stats, TRUE);
+      print_stats ("restart-streaming", &restart, TRUE);
+    }
+    g_free (persistentProps);
+    g_free (restartProps);
+  } else {
+    ok = run_bench (joined, numBuffers, &stats);
+    if (ok) {
+      print_stats ("gencamsrc", &stats, FALSE);
+    }
+  }
+
+  if (mock) {
+    g_array_free (stats.latencyUs, TRUE);
+    g_array_free (restart.latencyUs, TRUE);
+  }
+  g_free (joined);
+  g_strfreev (props);
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
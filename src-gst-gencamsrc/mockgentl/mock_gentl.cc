@@ -0,0 +1,2198 @@
+/*
+ * GStreamer Generic Camera Plugin - mock GenTL producer
+ * Copyright (c) 2020, Intel Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Software GenTL producer exposing virtual cameras, so that gencamsrc and
+ * rc_genicam_api can be exercised and benchmarked without any hardware.
+ *
+ * Devices are configured through the GENTL_MOCK_DEVICES environment variable,
+ * a ';' separated list of devices each given as ',' separated key=value
+ * pairs, e.g.
+ *
+ *   GENTL_MOCK_DEVICES="serial=CAM0,width=1920,height=1080,fps=60;serial=CAM1"
+ *
+ * Keys: serial, width, height (maximum resolution), format (PFNC name),
+ * fps (default frame rate), loss (ratio of frames delivered incomplete) and
+ * chunk (1 to enable chunk data by default). Without the variable a single
+ * 1920x1080 Mono8 camera "MOCK0" running at 30 fps is exposed.
+ */
+
+#include <GenTL/GenTL_v1_5.h>
+
+#include <dlfcn.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "mock_gentl_xml.h"
+
+using namespace GenTL;
+
+namespace
+{
+
+const uint32_t MOCK_MAGIC = 0x4d4f434b;
+const char *MOCK_TL_ID = "MockGenTL";
+const char *MOCK_IF_ID = "MockIF0";
+const char *MOCK_STREAM_ID = "Stream0";
+const char *MOCK_VENDOR = "Open Edge Insights";
+const char *MOCK_MODEL = "Mock Camera";
+const size_t MOCK_BUF_ALIGNMENT = 64;
+const size_t MOCK_BUF_ANNOUNCE_MIN = 1;
+const size_t MOCK_PACKET_SIZE = 8192;
+
+enum MockKind
+{
+  KIND_TL,
+  KIND_IF,
+  KIND_DEV,
+  KIND_PORT,
+  KIND_DS,
+  KIND_BUF,
+  KIND_EVENT
+};
+
+/* Common header of all handles given out, used to validate them */
+struct MockHandle
+{
+  explicit MockHandle (MockKind k):magic (MOCK_MAGIC), kind (k)
+  {
+  }
+  uint32_t magic;
+  MockKind kind;
+};
+
+struct MockPixelFormat
+{
+  const char *name;
+  uint32_t pfnc;
+};
+
+const MockPixelFormat mockPixelFormats[] = {
+  {"Mono8", 0x01080001},
+  {"BayerGR8", 0x01080008},
+  {"BayerRG8", 0x01080009},
+  {"BayerGB8", 0x0108000A},
+  {"BayerBG8", 0x0108000B},
+  {"RGB8", 0x02180014},
+  {"BGR8", 0x02180015},
+  {"YCbCr411_8", 0x020C005A},
+  {"YCbCr422_8", 0x0210003B}
+};
+
+struct MockDeviceConfig
+{
+  std::string serial;
+  uint32_t widthMax = 1920;
+  uint32_t heightMax = 1080;
+  uint32_t pixelFormat = 0x01080001;
+  double frameRate = 30.0;
+  double lossRatio = 0.0;
+  bool chunk = false;
+};
+
+struct MockDevice;
+struct MockStream;
+
+struct MockBuffer:MockHandle
+{
+  MockBuffer ():MockHandle (KIND_BUF)
+  {
+  }
+  MockStream *stream = NULL;
+  uint8_t *base = NULL;
+  size_t size = 0;
+  void *userPtr = NULL;
+  bool allocated = false;       /* Memory owned by the producer */
+  bool queued = false;          /* In the input pool or output queue */
+  bool acquiring = false;       /* Being filled by the acquisition thread */
+  bool newData = false;
+  bool incomplete = false;
+  bool hasChunk = false;
+  size_t sizeFilled = 0;
+  size_t imageSize = 0;
+  uint64_t frameId = 0;
+  uint64_t timestampNs = 0;
+  uint32_t width = 0;
+  uint32_t height = 0;
+  uint32_t pixelFormat = 0;
+};
+
+struct MockEvent:MockHandle
+{
+  MockEvent ():MockHandle (KIND_EVENT)
+  {
+  }
+  MockStream *stream = NULL;
+  bool registered = false;
+  bool killed = false;          /* Abort the current or next wait */
+  int waiters = 0;
+  uint64_t numFired = 0;
+};
+
+struct MockStream:MockHandle
+{
+  MockStream ():MockHandle (KIND_DS)
+  {
+  }
+  MockDevice *dev = NULL;
+  std::vector < MockBuffer * >announced;
+  std::deque < MockBuffer * >input;
+  std::deque < MockBuffer * >output;
+  MockEvent event;
+  std::thread thread;
+  std::condition_variable eventCv;
+  bool acquiring = false;
+  uint64_t numToAcquire = GENTL_INFINITE;
+  uint64_t numDelivered = 0;
+  uint64_t numUnderrun = 0;
+  uint64_t numStarted = 0;
+  uint64_t frameId = 0;
+  /* Geometry latched when the acquisition starts */
+  uint32_t width = 0;
+  uint32_t height = 0;
+  uint32_t pixelFormat = 0;
+  size_t rowBytes = 0;
+  size_t imageSize = 0;
+  bool chunk = false;
+  /* Two frames worth of rows, frame n is copied starting at row n */
+  std::vector < uint8_t > pattern;
+  std::mt19937 rng;
+};
+
+struct MockPort:MockHandle
+{
+  MockPort ():MockHandle (KIND_PORT)
+  {
+  }
+  MockDevice *dev = NULL;
+};
+
+struct MockDevice:MockHandle
+{
+  MockDevice ():MockHandle (KIND_DEV)
+  {
+  }
+  MockDeviceConfig config;
+  MockPort port;
+  MockStream *stream = NULL;
+  bool opened = false;
+
+  /* Guards the registers and the stream of this device */
+  std::mutex mtx;
+  std::condition_variable cv;
+
+  /* Registers */
+  uint32_t width = 0;
+  uint32_t height = 0;
+  uint32_t offsetX = 0;
+  uint32_t offsetY = 0;
+  uint32_t pixelFormat = 0;
+  uint32_t acquisitionMode = MOCK_ACQUISITION_CONTINUOUS;
+  uint32_t acquisitionFrameCount = 1;
+  uint32_t frameRateEnable = 1;
+  uint32_t statusSelector = MOCK_STATUS_ACQUISITION_ACTIVE;
+  uint32_t triggerSelector = 0;
+  uint32_t triggerMode = 0;
+  uint32_t triggerSource = MOCK_TRIGGER_SOURCE_SOFTWARE;
+  uint32_t chunkModeActive = 0;
+  uint32_t paramsLocked = 0;
+  double frameRate = 0;
+  double lossRatio = 0;
+
+  /* Acquisition state of the remote device */
+  bool armed = false;
+  uint64_t framesLeft = 0;
+  uint64_t pendingTriggers = 0;
+};
+
+struct MockInterface:MockHandle
+{
+  MockInterface ():MockHandle (KIND_IF)
+  {
+  }
+  bool opened = false;
+};
+
+struct MockSystem:MockHandle
+{
+  MockSystem ():MockHandle (KIND_TL)
+  {
+  }
+  bool opened = false;
+  MockInterface interface;
+  std::vector < std::unique_ptr < MockDevice > >devices;
+};
+
+std::mutex libMutex;
+std::unique_ptr < MockSystem > mockSystem;
+
+std::mutex errorMutex;
+GC_ERROR lastError = GC_ERR_SUCCESS;
+std::string lastErrorText;
+
+GC_ERROR
+fail (GC_ERROR err, const char *text)
+{
+  std::lock_guard < std::mutex > lock (errorMutex);
+  lastError = err;
+  lastErrorText = text;
+  return err;
+}
+
+template < class T > T * toHandle (void *h, MockKind kind)
+{
+  MockHandle *p = static_cast < MockHandle * >(h);
+  if (p == NULL || p->magic != MOCK_MAGIC || p->kind != kind) {
+    return NULL;
+  }
+  return static_cast < T * >(p);
+}
+
+uint64_t
+monotonicNs (void)
+{
+  struct timespec ts;
+  // Same clock as g_get_monotonic_time, so consumers can compute latencies
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return static_cast < uint64_t > (ts.tv_sec) * 1000000000ull + ts.tv_nsec;
+}
+
+/* Info helpers following the GenTL size negotiation rules */
+GC_ERROR
+copyInfo (INFO_DATATYPE type, const void *value, size_t size,
+    INFO_DATATYPE * piType, void *pBuffer, size_t * piSize)
+{
+  if (piSize == NULL) {
+    return fail (GC_ERR_INVALID_PARAMETER, "Size pointer is NULL");
+  }
+  if (piType != NULL) {
+    *piType = type;
+  }
+  if (pBuffer == NULL) {
+    *piSize = size;
+    return GC_ERR_SUCCESS;
+  }
+  if (*piSize < size) {
+    *piSize = size;
+    return fail (GC_ERR_BUFFER_TOO_SMALL, "Buffer too small");
+  }
+  memcpy (pBuffer, value, size);
+  *piSize = size;
+  return GC_ERR_SUCCESS;
+}
+
+GC_ERROR
+stringInfo (const std::string & value, INFO_DATATYPE * piType, void *pBuffer,
+    size_t * piSize)
+{
+  return copyInfo (INFO_DATATYPE_STRING, value.c_str (), value.size () + 1,
+      piType, pBuffer, piSize);
+}
+
+template < class T > GC_ERROR valueInfo (INFO_DATATYPE type, T value,
+    INFO_DATATYPE * piType, void *pBuffer, size_t * piSize)
+{
+  return copyInfo (type, &value, sizeof (T), piType, pBuffer, piSize);
+}
+
+GC_ERROR
+notAvailable (void)
+{
+  return fail (GC_ERR_NOT_AVAILABLE, "Info command not available");
+}
+
+uint32_t
+bitsPerPixel (uint32_t pfnc)
+{
+  return (pfnc >> 16) & 0xff;
+}
+
+bool
+pixelFormatFromName (const std::string & name, uint32_t * pfnc)
+{
+  for (const MockPixelFormat & f:mockPixelFormats) {
+    if (strcasecmp (f.name, name.c_str ()) == 0) {
+      *pfnc = f.pfnc;
+      return true;
+    }
+  }
+  return false;
+}
+
+/* Parses GENTL_MOCK_DEVICES, see the top of this file */
+std::vector < MockDeviceConfig > parseConfig (const char *env)
+{
+  std::vector < MockDeviceConfig > ret;
+  std::string spec = (env != NULL && *env != '\0') ? env : "serial=MOCK0";
+  std::stringstream devices (spec);
+  std::string device;
+
+  while (std::getline (devices, device, ';')) {
+    MockDeviceConfig config;
+    std::stringstream pairs (device);
+    std::string pair;
+
+    config.serial = "MOCK" + std::to_string (ret.size ());
+    while (std::getline (pairs, pair, ',')) {
+      size_t eq = pair.find ('=');
+      if (eq == std::string::npos) {
+        continue;
+      }
+      std::string key = pair.substr (0, eq);
+      std::string value = pair.substr (eq + 1);
+      try {
+        if (key == "serial") {
+          config.serial = value;
+        } else if (key == "width") {
+          config.widthMax = std::max (16ul, std::stoul (value));
+        } else if (key == "height") {
+          config.heightMax = std::max (16ul, std::stoul (value));
+        } else if (key == "format") {
+          pixelFormatFromName (value, &config.pixelFormat);
+        } else if (key == "fps") {
+          config.frameRate = std::max (1.0, std::stod (value));
+        } else if (key == "loss") {
+          config.lossRatio = std::min (1.0, std::max (0.0, std::stod (value)));
+        } else if (key == "chunk") {
+          config.chunk = std::stoi (value) != 0;
+        }
+      }
+      catch (const std::exception &) {
+        // keep the default of malformed values
+      }
+    }
+    ret.push_back (config);
+  }
+
+  return ret;
+}
+
+void
+resetRegisters (MockDevice * dev)
+{
+  dev->width = dev->config.widthMax;
+  dev->height = dev->config.heightMax;
+  dev->offsetX = 0;
+  dev->offsetY = 0;
+  dev->pixelFormat = dev->config.pixelFormat;
+  dev->acquisitionMode = MOCK_ACQUISITION_CONTINUOUS;
+  dev->acquisitionFrameCount = 1;
+  dev->frameRateEnable = 1;
+  dev->statusSelector = MOCK_STATUS_ACQUISITION_ACTIVE;
+  dev->triggerSelector = 0;
+  dev->triggerMode = 0;
+  dev->triggerSource = MOCK_TRIGGER_SOURCE_SOFTWARE;
+  dev->chunkModeActive = dev->config.chunk ? 1 : 0;
+  dev->paramsLocked = 0;
+  dev->frameRate = dev->config.frameRate;
+  dev->lossRatio = dev->config.lossRatio;
+  dev->armed = false;
+  dev->framesLeft = 0;
+  dev->pendingTriggers = 0;
+}
+
+size_t
+imageSize (const MockDevice * dev)
+{
+  return static_cast < size_t > (dev->width) * dev->height *
+      bitsPerPixel (dev->pixelFormat) / 8;
+}
+
+size_t
+payloadSize (const MockDevice * dev)
+{
+  return imageSize (dev) + (dev->chunkModeActive ? MOCK_CHUNK_SIZE : 0);
+}
+
+MockDevice *
+findDevice (const char *id)
+{
+  if (!mockSystem || id == NULL) {
+    return NULL;
+  }
+  for (auto & d:mockSystem->devices) {
+    if (d->config.serial == id) {
+      return d.get ();
+    }
+  }
+  return NULL;
+}
+
+/* Remote device state machine, called with dev->mtx held */
+
+bool
+frameReady (const MockDevice * dev)
+{
+  if (!dev->armed) {
+    return false;
+  }
+  // Line0 is simulated as an external pulse at the configured frame rate
+  return dev->triggerMode == 0
+      || dev->triggerSource == MOCK_TRIGGER_SOURCE_LINE0
+      || dev->pendingTriggers > 0;
+}
+
+bool
+freeRunning (const MockDevice * dev)
+{
+  return dev->triggerMode == 0
+      || dev->triggerSource == MOCK_TRIGGER_SOURCE_LINE0;
+}
+
+void
+acquisitionStart (MockDevice * dev)
+{
+  dev->armed = true;
+  dev->pendingTriggers = 0;
+  switch (dev->acquisitionMode) {
+    case MOCK_ACQUISITION_SINGLEFRAME:
+      dev->framesLeft = 1;
+      break;
+    case MOCK_ACQUISITION_MULTIFRAME:
+      dev->framesLeft = std::max (1u, dev->acquisitionFrameCount);
+      break;
+    default:
+      dev->framesLeft = UINT64_MAX;
+      break;
+  }
+  dev->cv.notify_all ();
+}
+
+void
+acquisitionStop (MockDevice * dev)
+{
+  dev->armed = false;
+  dev->pendingTriggers = 0;
+  dev->cv.notify_all ();
+}
+
+void
+frameDone (MockDevice * dev)
+{
+  if (dev->pendingTriggers > 0 && !freeRunning (dev)) {
+    dev->pendingTriggers--;
+  }
+  if (dev->framesLeft != UINT64_MAX && --dev->framesLeft == 0) {
+    dev->armed = false;
+  }
+}
+
+uint32_t
+acquisitionStatus (const MockDevice * dev)
+{
+  if (dev->statusSelector == MOCK_STATUS_FRAME_TRIGGER_WAIT) {
+    return dev->armed && dev->triggerMode != 0 && dev->pendingTriggers == 0;
+  }
+  return dev->armed;
+}
+
+/* Register access of the remote device port, called with dev->mtx held */
+
+GC_ERROR
+readRegister (MockDevice * dev, uint64_t address, void *pBuffer, size_t size)
+{
+  const size_t xmlSize = sizeof (mockDeviceXml) - 1;
+
+  if (address >= MOCK_REG_XML && address + size <= MOCK_REG_XML + xmlSize) {
+    memcpy (pBuffer, mockDeviceXml + (address - MOCK_REG_XML), size);
+    return GC_ERR_SUCCESS;
+  }
+
+  if (address + size <= MOCK_REG_STRINGS_END) {
+    char strings[MOCK_REG_STRINGS_END];
+    memset (strings, 0, sizeof (strings));
+    strncpy (strings + MOCK_REG_VENDOR_NAME, MOCK_VENDOR, 31);
+    strncpy (strings + MOCK_REG_MODEL_NAME, MOCK_MODEL, 31);
+    strncpy (strings + MOCK_REG_SERIAL_NUMBER, dev->config.serial.c_str (), 31);
+    memcpy (pBuffer, strings + address, size);
+    return GC_ERR_SUCCESS;
+  }
+
+  if (size == 8) {
+    double value;
+    switch (address) {
+      case MOCK_REG_FRAMERATE:
+        value = dev->frameRate;
+        break;
+      case MOCK_REG_PACKET_LOSS_RATIO:
+        value = dev->lossRatio;
+        break;
+      default:
+        return fail (GC_ERR_INVALID_ADDRESS, "Invalid register address");
+    }
+    memcpy (pBuffer, &value, size);
+    return GC_ERR_SUCCESS;
+  }
+
+  if (size != 4) {
+    return fail (GC_ERR_INVALID_ADDRESS, "Invalid register size");
+  }
+
+  uint32_t value;
+  switch (address) {
+    case MOCK_REG_WIDTH_MAX:
+      value = dev->config.widthMax;
+      break;
+    case MOCK_REG_HEIGHT_MAX:
+      value = dev->config.heightMax;
+      break;
+    case MOCK_REG_WIDTH:
+      value = dev->width;
+      break;
+    case MOCK_REG_HEIGHT:
+      value = dev->height;
+      break;
+    case MOCK_REG_OFFSET_X:
+      value = dev->offsetX;
+      break;
+    case MOCK_REG_OFFSET_Y:
+      value = dev->offsetY;
+      break;
+    case MOCK_REG_PIXEL_FORMAT:
+      value = dev->pixelFormat;
+      break;
+    case MOCK_REG_PAYLOAD_SIZE:
+      value = static_cast < uint32_t > (payloadSize (dev));
+      break;
+    case MOCK_REG_ACQUISITION_MODE:
+      value = dev->acquisitionMode;
+      break;
+    case MOCK_REG_ACQUISITION_FRAMECOUNT:
+      value = dev->acquisitionFrameCount;
+      break;
+    case MOCK_REG_ACQUISITION_START:
+    case MOCK_REG_ACQUISITION_STOP:
+    case MOCK_REG_TRIGGER_SOFTWARE:
+      // commands complete immediately
+      value = 0;
+      break;
+    case MOCK_REG_FRAMERATE_ENABLE:
+      value = dev->frameRateEnable;
+      break;
+    case MOCK_REG_STATUS_SELECTOR:
+      value = dev->statusSelector;
+      break;
+    case MOCK_REG_STATUS:
+      value = acquisitionStatus (dev);
+      break;
+    case MOCK_REG_TRIGGER_SELECTOR:
+      value = dev->triggerSelector;
+      break;
+    case MOCK_REG_TRIGGER_MODE:
+      value = dev->triggerMode;
+      break;
+    case MOCK_REG_TRIGGER_SOURCE:
+      value = dev->triggerSource;
+      break;
+    case MOCK_REG_CHUNK_MODE_ACTIVE:
+      value = dev->chunkModeActive;
+      break;
+    case MOCK_REG_TL_PARAMS_LOCKED:
+      value = dev->paramsLocked;
+      break;
+    default:
+      return fail (GC_ERR_INVALID_ADDRESS, "Invalid register address");
+  }
+  memcpy (pBuffer, &value, size);
+  return GC_ERR_SUCCESS;
+}
+
+GC_ERROR
+writeRegister (MockDevice * dev, uint64_t address, const void *pBuffer,
+    size_t size)
+{
+  if (size == 8) {
+    double value;
+    memcpy (&value, pBuffer, size);
+    switch (address) {
+      case MOCK_REG_FRAMERATE:
+        dev->frameRate = std::max (1.0, value);
+        break;
+      case MOCK_REG_PACKET_LOSS_RATIO:
+        dev->lossRatio = std::min (1.0, std::max (0.0, value));
+        break;
+      default:
+        return fail (GC_ERR_INVALID_ADDRESS, "Invalid register address");
+    }
+    dev->cv.notify_all ();
+    return GC_ERR_SUCCESS;
+  }
+
+  if (size != 4) {
+    return fail (GC_ERR_INVALID_ADDRESS, "Invalid register size");
+  }
+
+  uint32_t value;
+  memcpy (&value, pBuffer, size);
+  switch (address) {
+    case MOCK_REG_WIDTH:
+      dev->width = std::min (std::max (16u, value), dev->config.widthMax);
+      break;
+    case MOCK_REG_HEIGHT:
+      dev->height = std::min (std::max (16u, value), dev->config.heightMax);
+      break;
+    case MOCK_REG_OFFSET_X:
+      dev->offsetX = value;
+      break;
+    case MOCK_REG_OFFSET_Y:
+      dev->offsetY = value;
+      break;
+    case MOCK_REG_PIXEL_FORMAT:
+      dev->pixelFormat = value;
+      break;
+    case MOCK_REG_ACQUISITION_MODE:
+      dev->acquisitionMode = value;
+      break;
+    case MOCK_REG_ACQUISITION_FRAMECOUNT:
+      dev->acquisitionFrameCount = value;
+      break;
+    case MOCK_REG_ACQUISITION_START:
+      acquisitionStart (dev);
+      break;
+    case MOCK_REG_ACQUISITION_STOP:
+      acquisitionStop (dev);
+      break;
+    case MOCK_REG_FRAMERATE_ENABLE:
+      dev->frameRateEnable = value;
+      break;
+    case MOCK_REG_STATUS_SELECTOR:
+      dev->statusSelector = value;
+      break;
+    case MOCK_REG_TRIGGER_SELECTOR:
+      dev->triggerSelector = value;
+      break;
+    case MOCK_REG_TRIGGER_MODE:
+      dev->triggerMode = value;
+      break;
+    case MOCK_REG_TRIGGER_SOURCE:
+      dev->triggerSource = value;
+      break;
+    case MOCK_REG_TRIGGER_SOFTWARE:
+      // triggers are only accepted while the acquisition is armed
+      if (dev->armed && dev->triggerMode != 0
+          && dev->triggerSource == MOCK_TRIGGER_SOURCE_SOFTWARE) {
+        dev->pendingTriggers++;
+      }
+      break;
+    case MOCK_REG_CHUNK_MODE_ACTIVE:
+      dev->chunkModeActive = value;
+      break;
+    case MOCK_REG_TL_PARAMS_LOCKED:
+      dev->paramsLocked = value;
+      break;
+    default:
+      return fail (GC_ERR_INVALID_ADDRESS, "Invalid register address");
+  }
+  dev->cv.notify_all ();
+  return GC_ERR_SUCCESS;
+}
+
+/* Acquisition engine */
+
+void
+renderPattern (MockStream * s)
+{
+  s->rowBytes = static_cast < size_t > (s->width) *
+      bitsPerPixel (s->pixelFormat) / 8;
+  s->pattern.resize (s->rowBytes * s->height * 2);
+  // Diagonal gradient, every frame starts one row further down
+  for (size_t y = 0; y < 2 * static_cast < size_t > (s->height); y++) {
+    uint8_t *row = s->pattern.data () + y * s->rowBytes;
+    for (size_t x = 0; x < s->rowBytes; x++) {
+      row[x] = static_cast < uint8_t > (x + y);
+    }
+  }
+}
+
+void
+fillBuffer (MockStream * s, MockBuffer * buf, uint64_t frameId,
+    double lossRatio)
+{
+  size_t row = static_cast < size_t > (frameId % s->height);
+  size_t size = std::min (s->imageSize, buf->size);
+
+  memcpy (buf->base, s->pattern.data () + row * s->rowBytes, size);
+
+  buf->incomplete = false;
+  buf->sizeFilled = size;
+  if (lossRatio > 0
+      && std::uniform_real_distribution < double >(0, 1) (s->rng) <
+      lossRatio) {
+    // Drop a random run of packets, which leave stale data behind
+    size_t packets = (size + MOCK_PACKET_SIZE - 1) / MOCK_PACKET_SIZE;
+    size_t first = std::uniform_int_distribution < size_t > (0,
+        packets - 1) (s->rng);
+    size_t count = std::uniform_int_distribution < size_t > (1,
+        std::min < size_t > (packets - first, 8)) (s->rng);
+    size_t begin = first * MOCK_PACKET_SIZE;
+    size_t end = std::min (size, (first + count) * MOCK_PACKET_SIZE);
+    memset (buf->base + begin, 0, end - begin);
+    buf->incomplete = true;
+    buf->sizeFilled = size - (end - begin);
+  }
+
+  buf->hasChunk = s->chunk && buf->size >= s->imageSize + MOCK_CHUNK_SIZE;
+  buf->timestampNs = monotonicNs ();
+  if (buf->hasChunk) {
+    memcpy (buf->base + s->imageSize, &buf->timestampNs, 8);
+    memcpy (buf->base + s->imageSize + 8, &frameId, 8);
+    buf->sizeFilled += MOCK_CHUNK_SIZE;
+  }
+
+  buf->frameId = frameId;
+  buf->imageSize = size;
+  buf->width = s->width;
+  buf->height = s->height;
+  buf->pixelFormat = s->pixelFormat;
+  buf->newData = true;
+}
+
+void
+acquisitionThread (MockStream * s)
+{
+  MockDevice *dev = s->dev;
+  std::unique_lock < std::mutex > lock (dev->mtx);
+  std::chrono::steady_clock::time_point next =
+      std::chrono::steady_clock::now ();
+
+  while (s->acquiring) {
+    dev->cv.wait (lock,[s, dev] {
+          return !s->acquiring || frameReady (dev);
+        });
+    if (!s->acquiring) {
+      break;
+    }
+
+    bool paced = freeRunning (dev) && dev->frameRateEnable;
+    if (paced) {
+      // Pace on absolute deadlines, without bursting after a stall
+      std::chrono::steady_clock::duration period =
+          std::chrono::duration_cast < std::chrono::steady_clock::duration >
+          (std::chrono::duration < double >(1.0 / dev->frameRate));
+      std::chrono::steady_clock::time_point now =
+          std::chrono::steady_clock::now ();
+      if (next < now - period) {
+        next = now;
+      }
+      if (dev->cv.wait_until (lock, next,[s] {
+                return !s->acquiring;
+              })) {
+        break;
+      }
+      next += period;
+      if (!frameReady (dev)) {
+        continue;
+      }
+    }
+
+    if (!paced && s->input.empty ()) {
+      // Without a frame rate the sensor runs as fast as buffers come back
+      dev->cv.wait (lock,[s, dev] {
+            return !s->acquiring || !s->input.empty () || !frameReady (dev);
+          });
+      continue;
+    }
+
+    uint64_t frameId = ++s->frameId;
+    s->numStarted++;
+    if (s->input.empty ()) {
+      // No buffer available, the frame is lost
+      s->numUnderrun++;
+      frameDone (dev);
+      continue;
+    }
+
+    MockBuffer *buf = s->input.front ();
+    s->input.pop_front ();
+    buf->acquiring = true;
+    double lossRatio = dev->lossRatio;
+
+    lock.unlock ();
+    fillBuffer (s, buf, frameId, lossRatio);
+    lock.lock ();
+
+    buf->acquiring = false;
+    s->output.push_back (buf);
+    s->numDelivered++;
+    s->event.numFired++;
+    s->eventCv.notify_all ();
+    frameDone (dev);
+
+    if (s->numToAcquire != GENTL_INFINITE
+        && s->numDelivered >= s->numToAcquire) {
+      s->acquiring = false;
+    }
+  }
+}
+
+/* Called with dev->mtx held, returns with it held */
+void
+stopAcquisition (MockStream * s, std::unique_lock < std::mutex > &lock)
+{
+  s->acquiring = false;
+  s->dev->cv.notify_all ();
+  if (s->thread.joinable ()) {
+    lock.unlock ();
+    s->thread.join ();
+    lock.lock ();
+  }
+}
+
+void
+closeStream (MockStream * s, std::unique_lock < std::mutex > &lock)
+{
+  stopAcquisition (s, lock);
+
+  // wake up and wait for consumers blocked in EventGetData
+  s->event.registered = false;
+  s->event.killed = true;
+  s->eventCv.notify_all ();
+  s->eventCv.wait (lock,[s] {
+        return s->event.waiters == 0;
+      });
+
+  for (MockBuffer * b:s->announced) {
+    if (b->allocated) {
+      free (b->base);
+    }
+    delete b;
+  }
+  s->dev->stream = NULL;
+  delete s;
+}
+
+MockDevice *
+portDevice (PORT_HANDLE hPort)
+{
+  MockPort *port = toHandle < MockPort > (hPort, KIND_PORT);
+  return port ? port->dev : NULL;
+}
+
+std::string
+portUrl (void)
+{
+  std::stringstream url;
+  url << "Local:mock_gentl.xml;" << std::hex << MOCK_REG_XML << ";" <<
+      (sizeof (mockDeviceXml) - 1);
+  return url.str ();
+}
+
+std::string
+libraryPath (void)
+{
+  Dl_info info;
+  if (dladdr (reinterpret_cast < void *>(&parseConfig), &info) != 0
+      && info.dli_fname != NULL) {
+    return info.dli_fname;
+  }
+  return "mock_gentl.cti";
+}
+
+GC_ERROR
+deviceInfo (MockDevice * dev, DEVICE_INFO_CMD iInfoCmd,
+    INFO_DATATYPE * piType, void *pBuffer, size_t * piSize)
+{
+  switch (iInfoCmd) {
+    case DEVICE_INFO_ID:
+    case DEVICE_INFO_SERIAL_NUMBER:
+      return stringInfo (dev->config.serial, piType, pBuffer, piSize);
+    case DEVICE_INFO_VENDOR:
+      return stringInfo (MOCK_VENDOR, piType, pBuffer, piSize);
+    case DEVICE_INFO_MODEL:
+      return stringInfo (MOCK_MODEL, piType, pBuffer, piSize);
+    case DEVICE_INFO_TLTYPE:
+      return stringInfo (TLTypeCustomName, piType, pBuffer, piSize);
+    case DEVICE_INFO_DISPLAYNAME:
+      return stringInfo (std::string (MOCK_MODEL) + " (" +
+          dev->config.serial + ")", piType, pBuffer, piSize);
+    case DEVICE_INFO_USER_DEFINED_NAME:
+      return stringInfo ("", piType, pBuffer, piSize);
+    case DEVICE_INFO_VERSION:
+      return stringInfo ("1.0", piType, pBuffer, piSize);
+    case DEVICE_INFO_ACCESS_STATUS:
+      return valueInfo < int32_t > (INFO_DATATYPE_INT32,
+          dev->opened ? DEVICE_ACCESS_STATUS_OPEN_READWRITE :
+          DEVICE_ACCESS_STATUS_READWRITE, piType, pBuffer, piSize);
+    case DEVICE_INFO_TIMESTAMP_FREQUENCY:
+      return valueInfo < uint64_t > (INFO_DATATYPE_UINT64, 1000000000ull,
+          piType, pBuffer, piSize);
+    default:
+      return notAvailable ();
+  }
+}
+
+GC_ERROR
+systemInfo (TL_INFO_CMD iInfoCmd, INFO_DATATYPE * piType, void *pBuffer,
+    size_t * piSize)
+{
+  switch (iInfoCmd) {
+    case TL_INFO_ID:
+      return stringInfo (MOCK_TL_ID, piType, pBuffer, piSize);
+    case TL_INFO_VENDOR:
+      return stringInfo (MOCK_VENDOR, piType, pBuffer, piSize);
+    case TL_INFO_MODEL:
+      return stringInfo ("Mock GenTL Producer", piType, pBuffer, piSize);
+    case TL_INFO_VERSION:
+      return stringInfo ("1.0", piType, pBuffer, piSize);
+    case TL_INFO_TLTYPE:
+      return stringInfo (TLTypeCustomName, piType, pBuffer, piSize);
+    case TL_INFO_NAME:{
+      std::string path = libraryPath ();
+      size_t slash = path.rfind ('/');
+      return stringInfo (slash == std::string::npos ? path :
+          path.substr (slash + 1), piType, pBuffer, piSize);
+    }
+    case TL_INFO_PATHNAME:
+      return stringInfo (libraryPath (), piType, pBuffer, piSize);
+    case TL_INFO_DISPLAYNAME:
+      return stringInfo ("Mock GenTL Producer", piType, pBuffer, piSize);
+    case TL_INFO_CHAR_ENCODING:
+      return valueInfo < int32_t > (INFO_DATATYPE_INT32, TL_CHAR_ENCODING_ASCII,
+          piType, pBuffer, piSize);
+    case TL_INFO_GENTL_VER_MAJOR:
+      return valueInfo < uint32_t > (INFO_DATATYPE_UINT32, GenTLMajorVersion,
+          piType, pBuffer, piSize);
+    case TL_INFO_GENTL_VER_MINOR:
+      return valueInfo < uint32_t > (INFO_DATATYPE_UINT32, GenTLMinorVersion,
+          piType, pBuffer, piSize);
+    default:
+      return notAvailable ();
+  }
+}
+
+GC_ERROR
+interfaceInfo (INTERFACE_INFO_CMD iInfoCmd, INFO_DATATYPE * piType,
+    void *pBuffer, size_t * piSize)
+{
+  switch (iInfoCmd) {
+    case INTERFACE_INFO_ID:
+      return stringInfo (MOCK_IF_ID, piType, pBuffer, piSize);
+    case INTERFACE_INFO_DISPLAYNAME:
+      return stringInfo ("Mock Interface", piType, pBuffer, piSize);
+    case INTERFACE_INFO_TLTYPE:
+      return stringInfo (TLTypeCustomName, piType, pBuffer, piSize);
+    default:
+      return notAvailable ();
+  }
+}
+
+#define MOCK_CHECK_INIT() \
+  if (!mockSystem) { \
+    return fail (GC_ERR_NOT_INITIALIZED, "Library not initialized"); \
+  }
+
+}
+
+namespace GenTL
+{
+
+/* Library */
+
+GC_API
+GCGetInfo (TL_INFO_CMD iInfoCmd, INFO_DATATYPE * piType, void *pBuffer,
+    size_t * piSize)
+{
+  return systemInfo (iInfoCmd, piType, pBuffer, piSize);
+}
+
+GC_API
+GCGetLastError (GC_ERROR * piErrorCode, char *sErrText, size_t * piSize)
+{
+  std::lock_guard < std::mutex > lock (errorMutex);
+  if (piErrorCode != NULL) {
+    *piErrorCode = lastError;
+  }
+  if (piSize == NULL) {
+    return GC_ERR_INVALID_PARAMETER;
+  }
+  if (sErrText == NULL) {
+    *piSize = lastErrorText.size () + 1;
+    return GC_ERR_SUCCESS;
+  }
+  if (*piSize < lastErrorText.size () + 1) {
+    *piSize = lastErrorText.size () + 1;
+    return GC_ERR_BUFFER_TOO_SMALL;
+  }
+  memcpy (sErrText, lastErrorText.c_str (), lastErrorText.size () + 1);
+  *piSize = lastErrorText.size () + 1;
+  return GC_ERR_SUCCESS;
+}
+
+GC_API
+GCInitLib (void)
+{
+  std::lock_guard < std::mutex > lock (libMutex);
+  if (mockSystem) {
+    return fail (GC_ERR_RESOURCE_IN_USE, "Library already initialized");
+  }
+
+  mockSystem.reset (new MockSystem);
+  for (const MockDeviceConfig & config:parseConfig (getenv
+          ("GENTL_MOCK_DEVICES"))) {
+    std::unique_ptr < MockDevice > dev (new MockDevice);
+    dev->config = config;
+    dev->port.dev = dev.get ();
+    resetRegisters (dev.get ());
+    mockSystem->devices.push_back (std::move (dev));
+  }
+  return GC_ERR_SUCCESS;
+}
+
+GC_API
+GCCloseLib (void)
+{
+  std::lock_guard < std::mutex > lock (libMutex);
+  MOCK_CHECK_INIT ();
+
+  for (auto & dev:mockSystem->devices) {
+    std::unique_lock < std::mutex > devLock (dev->mtx);
+    if (dev->stream) {
+      closeStream (dev->stream, devLock);
+    }
+  }
+  mockSystem.reset ();
+  return GC_ERR_SUCCESS;
+}
+
+/* Ports, only the remote device port has registers */
+
+GC_API
+GCReadPort (PORT_HANDLE hPort, uint64_t iAddress, void *pBuffer,
+    size_t * piSize)
+{
+  MockDevice *dev = portDevice (hPort);
+  if (dev == NULL) {
+    return fail (GC_ERR_NOT_IMPLEMENTED, "Module has no registers");
+  }
+  if (pBuffer == NULL || piSize == NULL) {
+    return fail (GC_ERR_INVALID_PARAMETER, "Invalid parameter");
+  }
+  std::lock_guard < std::mutex > lock (dev->mtx);
+  return readRegister (dev, iAddress, pBuffer, *piSize);
+}
+
+GC_API
+GCWritePort (PORT_HANDLE hPort, uint64_t iAddress, const void *pBuffer,
+    size_t * piSize)
+{
+  MockDevice *dev = portDevice (hPort);
+  if (dev == NULL) {
+    return fail (GC_ERR_NOT_IMPLEMENTED, "Module has no registers");
+  }
+  if (pBuffer == NULL || piSize == NULL) {
+    return fail (GC_ERR_INVALID_PARAMETER, "Invalid parameter");
+  }
+  std::lock_guard < std::mutex > lock (dev->mtx);
+  return writeRegister (dev, iAddress, pBuffer, *piSize);
+}
+
+GC_API
+GCReadPortStacked (PORT_HANDLE hPort, PORT_REGISTER_STACK_ENTRY * pEntries,
+    size_t * piNumEntries)
+{
+  if (pEntries == NULL || piNumEntries == NULL) {
+    return fail (GC_ERR_INVALID_PARAMETER, "Invalid parameter");
+  }
+  for (size_t i = 0; i < *piNumEntries; i++) {
+    size_t size = pEntries[i].Size;
+    GC_ERROR err = GCReadPort (hPort, pEntries[i].Address, pEntries[i].pBuffer,
+        &size);
+    if (err != GC_ERR_SUCCESS) {
+      *piNumEntries = i;
+      return err;
+    }
+  }
+  return GC_ERR_SUCCESS;
+}
+
+GC_API
+GCWritePortStacked (PORT_HANDLE hPort, PORT_REGISTER_STACK_ENTRY * pEntries,
+    size_t * piNumEntries)
+{
+  if (pEntries == NULL || piNumEntries == NULL) {
+    return fail (GC_ERR_INVALID_PARAMETER, "Invalid parameter");
+  }
+  for (size_t i = 0; i < *piNumEntries; i++) {
+    size_t size = pEntries[i].Size;
+    GC_ERROR err = GCWritePort (hPort, pEntries[i].Address,
+        pEntries[i].pBuffer, &size);
+    if (err != GC_ERR_SUCCESS) {
+      *piNumEntries = i;
+      return err;
+    }
+  }
+  return GC_ERR_SUCCESS;
+}
+
+GC_API
+GCGetPortURL (PORT_HANDLE hPort, char *sURL, size_t * piSize)
+{
+  if (portDevice (hPort) == NULL) {
+    return fail (GC_ERR_NOT_AVAILABLE, "Module has no URL");
+  }
+  std::string url = portUrl ();
+  return copyInfo (INFO_DATATYPE_STRING, url.c_str (), url.size () + 1, NULL,
+      sURL, piSize);
+}
+
+GC_API
+GCGetNumPortURLs (PORT_HANDLE hPort, uint32_t * piNumURLs)
+{
+  if (piNumURLs == NULL) {
+    return fail (GC_ERR_INVALID_PARAMETER, "Invalid parameter");
+  }
+  *piNumURLs = portDevice (hPort) ? 1 : 0;
+  return GC_ERR_SUCCESS;
+}
+
+GC_API
+GCGetPortURLInfo (PORT_HANDLE hPort, uint32_t iURLIndex,
+    URL_INFO_CMD iInfoCmd, INFO_DATATYPE * piType, void *pBuffer,
+    size_t * piSize)
+{
+  if (portDevice (hPort) == NULL || iURLIndex != 0) {
+    return fail (GC_ERR_INVALID_INDEX, "Invalid URL index");
+  }
+  switch (iInfoCmd) {
+    case URL_INFO_URL:
+      return stringInfo (portUrl (), piType, pBuffer, piSize);
+    case URL_INFO_SCHEMA_VER_MAJOR:
+    case URL_INFO_SCHEMA_VER_MINOR:
+    case URL_INFO_FILE_VER_MAJOR:
+      return valueInfo < int32_t > (INFO_DATATYPE_INT32, 1, piType, pBuffer,
+          piSize);
+    case URL_INFO_FILE_VER_MINOR:
+    case URL_INFO_FILE_VER_SUBMINOR:
+      return valueInfo < int32_t > (INFO_DATATYPE_INT32, 0, piType, pBuffer,
+          piSize);
+    case URL_INFO_FILE_REGISTER_ADDRESS:
+      return valueInfo < uint64_t > (INFO_DATATYPE_UINT64, MOCK_REG_XML,
+          piType, pBuffer, piSize);
+    case URL_INFO_FILE_SIZE:
+      return valueInfo < uint64_t > (INFO_DATATYPE_UINT64,
+          sizeof (mockDeviceXml) - 1, piType, pBuffer, piSize);
+    case URL_INFO_SCHEME:
+      return valueInfo < int32_t > (INFO_DATATYPE_INT32, URL_SCHEME_LOCAL,
+          piType, pBuffer, piSize);
+    default:
+      return notAvailable ();
+  }
+}
+
+GC_API
+GCGetPortInfo (PORT_HANDLE hPort, PORT_INFO_CMD iInfoCmd,
+    INFO_DATATYPE * piType, void *pBuffer, size_t * piSize)
+{
+  MockDevice *dev = portDevice (hPort);
+  if (dev == NULL) {
+    return fail (GC_ERR_NOT_IMPLEMENTED, "Module has no port");
+  }
+  switch (iInfoCmd) {
+    case PORT_INFO_ID:
+      return stringInfo (dev->config.serial + "_Port", piType, pBuffer, piSize);
+    case PORT_INFO_VENDOR:
+      return stringInfo (MOCK_VENDOR, piType, pBuffer, piSize);
+    case PORT_INFO_MODEL:
+      return stringInfo (MOCK_MODEL, piType, pBuffer, piSize);
+    case PORT_INFO_TLTYPE:
+      return stringInfo (TLTypeCustomName, piType, pBuffer, piSize);
+    case PORT_INFO_MODULE:
+    case PORT_INFO_PORTNAME:
+      return stringInfo (TLRemoteDeviceModuleName, piType, pBuffer, piSize);
+    case PORT_INFO_VERSION:
+      return stringInfo ("1.0", piType, pBuffer, piSize);
+    case PORT_INFO_LITTLE_ENDIAN:
+    case PORT_INFO_ACCESS_READ:
+    case PORT_INFO_ACCESS_WRITE:
+      return valueInfo < bool8_t > (INFO_DATATYPE_BOOL8, true, piType,
+          pBuffer, piSize);
+    case PORT_INFO_BIG_ENDIAN:
+    case PORT_INFO_ACCESS_NA:
+    case PORT_INFO_ACCESS_NI:
+      return valueInfo < bool8_t > (INFO_DATATYPE_BOOL8, false, piType,
+          pBuffer, piSize);
+    default:
+      return notAvailable ();
+  }
+}
+
+/* Events, only new buffer events of data streams are supported */
+
+GC_API
+GCRegisterEvent (EVENTSRC_HANDLE hEventSrc, EVENT_TYPE iEventID,
+    EVENT_HANDLE * phEvent)
+{
+  MockStream *s = toHandle < MockStream > (hEventSrc, KIND_DS);
+  if (s == NULL || iEventID != EVENT_NEW_BUFFER) {
+    return fail (GC_ERR_NOT_IMPLEMENTED, "Event not supported");
+  }
+  if (phEvent == NULL) {
+    return fail (GC_ERR_INVALID_PARAMETER, "Invalid parameter");
+  }
+  std::lock_guard < std::mutex > lock (s->dev->mtx);
+  if (s->event.registered) {
+    return fail (GC_ERR_RESOURCE_IN_USE, "Event already registered");
+  }
+  s->event.registered = true;
+  s->event.killed = false;
+  *phEvent = &s->event;
+  return GC_ERR_SUCCESS;
+}
+
+GC_API
+GCUnregisterEvent (EVENTSRC_HANDLE hEventSrc, EVENT_TYPE iEventID)
+{
+  MockStream *s = toHandle < MockStream > (hEventSrc, KIND_DS);
+  if (s == NULL || iEventID != EVENT_NEW_BUFFER) {
+    return fail (GC_ERR_NOT_IMPLEMENTED, "Event not supported");
+  }
+  std::lock_guard < std::mutex > lock (s->dev->mtx);
+  if (!s->event.registered) {
+    return fail (GC_ERR_NOT_AVAILABLE, "Event not registered");
+  }
+  // pending waits return with GC_ERR_ABORT
+  s->event.registered = false;
+  s->event.killed = true;
+  s->eventCv.notify_all ();
+  return GC_ERR_SUCCESS;
+}
+
+GC_API
+EventGetData (EVENT_HANDLE hEvent, void *pBuffer, size_t * piSize,
+    uint64_t iTimeout)
+{
+  MockEvent *ev = toHandle < MockEvent > (hEvent, KIND_EVENT);
+  if (ev == NULL) {
+    return fail (GC_ERR_INVALID_HANDLE, "Invalid event handle");
+  }
+  if (pBuffer == NULL || piSize == NULL
+      || *piSize < sizeof (EVENT_NEW_BUFFER_DATA)) {
+    return fail (GC_ERR_BUFFER_TOO_SMALL, "Buffer too small");
+  }
+
+  MockStream *s = ev->stream;
+  std::unique_lock < std::mutex > lock (s->dev->mtx);
+  if (!ev->registered) {
+    return fail (GC_ERR_ABORT, "Event not registered");
+  }
+
+  auto ready =[s, ev] {
+    return !s->output.empty () || ev->killed;
+  };
+  ev->waiters++;
+  if (iTimeout == GENTL_INFINITE) {
+    s->eventCv.wait (lock, ready);
+  } else {
+    s->eventCv.wait_for (lock, std::chrono::milliseconds (iTimeout), ready);
+  }
+  ev->waiters--;
+  s->eventCv.notify_all ();
+
+  if (ev->killed) {
+    // EventKill only aborts a single wait
+    if (ev->registered) {
+      ev->killed = false;
+    }
+    return fail (GC_ERR_ABORT, "Wait aborted");
+  }
+  if (s->output.empty ()) {
+    return fail (GC_ERR_TIMEOUT, "Timeout");
+  }
+
+  MockBuffer *buf = s->output.front ();
+  s->output.pop_front ();
+  buf->queued = false;
+
+  EVENT_NEW_BUFFER_DATA data;
+  data.BufferHandle = buf;
+  data.pUserPointer = buf->userPtr;
+  memcpy (pBuffer, &data, sizeof (data));
+  *piSize = sizeof (data);
+  return GC_ERR_SUCCESS;
+}
+
+GC_API
+EventGetDataInfo (EVENT_HANDLE hEvent, const void *pInBuffer, size_t iInSize,
+    EVENT_DATA_INFO_CMD iInfoCmd, INFO_DATATYPE * piType, void *pOutBuffer,
+    size_t * piOutSize)
+{
+  if (toHandle < MockEvent > (hEvent, KIND_EVENT) == NULL) {
+    return fail (GC_ERR_INVALID_HANDLE, "Invalid event handle");
+  }
+  if (pInBuffer == NULL || iInSize < sizeof (EVENT_NEW_BUFFER_DATA)) {
+    return fail (GC_ERR_INVALID_PARAMETER, "Invalid parameter");
+  }
+  EVENT_NEW_BUFFER_DATA data;
+  memcpy (&data, pInBuffer, sizeof (data));
+  switch (iInfoCmd) {
+    case EVENT_DATA_ID:
+      return valueInfo < BUFFER_HANDLE > (INFO_DATATYPE_PTR,
+          data.BufferHandle, piType, pOutBuffer, piOutSize);
+    case EVENT_DATA_VALUE:
+      return valueInfo < void *>(INFO_DATATYPE_PTR, data.pUserPointer, piType,
+          pOutBuffer, piOutSize);
+    default:
+      return notAvailable ();
+  }
+}
+
+GC_API
+EventGetInfo (EVENT_HANDLE hEvent, EVENT_INFO_CMD iInfoCmd,
+    INFO_DATATYPE * piType, void *pBuffer, size_t * piSize)
+{
+  MockEvent *ev = toHandle < MockEvent > (hEvent, KIND_EVENT);
+  if (ev == NULL) {
+    return fail (GC_ERR_INVALID_HANDLE, "Invalid event handle");
+  }
+  std::lock_guard < std::mutex > lock (ev->stream->dev->mtx);
+  switch (iInfoCmd) {
+    case EVENT_EVENT_TYPE:
+      return valueInfo < int32_t > (INFO_DATATYPE_INT32, EVENT_NEW_BUFFER,
+          piType, pBuffer, piSize);
+    case EVENT_NUM_IN_QUEUE:
+      return valueInfo < size_t > (INFO_DATATYPE_SIZET,
+          ev->stream->output.size (), piType, pBuffer, piSize);
+    case EVENT_NUM_FIRED:
+      return valueInfo < uint64_t > (INFO_DATATYPE_UINT64, ev->numFired,
+          piType, pBuffer, piSize);
+    case EVENT_SIZE_MAX:
+      return valueInfo < size_t > (INFO_DATATYPE_SIZET,
+          sizeof (EVENT_NEW_BUFFER_DATA), piType, pBuffer, piSize);
+    default:
+      return notAvailable ();
+  }
+}
+
+GC_API
+EventFlush (EVENT_HANDLE hEvent)
+{
+  MockEvent *ev = toHandle < MockEvent > (hEvent, KIND_EVENT);
+  if (ev == NULL) {
+    return fail (GC_ERR_INVALID_HANDLE, "Invalid event handle");
+  }
+  std::lock_guard < std::mutex > lock (ev->stream->dev->mtx);
+  for (MockBuffer * b:ev->stream->output) {
+    b->queued = false;
+  }
+  ev->stream->output.clear ();
+  return GC_ERR_SUCCESS;
+}
+
+GC_API
+EventKill (EVENT_HANDLE hEvent)
+{
+  MockEvent *ev = toHandle < MockEvent > (hEvent, KIND_EVENT);
+  if (ev == NULL) {
+    return fail (GC_ERR_INVALID_HANDLE, "Invalid event handle");
+  }
+  std::lock_guard < std::mutex > lock (ev->stream->dev->mtx);
+  ev->killed = true;
+  ev->stream->eventCv.notify_all ();
+  return GC_ERR_SUCCESS;
+}
+
+/* System module */
+
+GC_API
+TLOpen (TL_HANDLE * phTL)
+{
+  std::lock_guard < std::mutex > lock (libMutex);
+  MOCK_CHECK_INIT ();
+  if (phTL == NULL) {
+    return fail (GC_ERR_INVALID_PARAMETER, "Invalid parameter");
+  }
+  if (mockSystem->opened) {
+    return fail (GC_ERR_RESOURCE_IN_USE, "System already open");
+  }
+  mockSystem->opened = true;
+  *phTL = mockSystem.get ();
+  return GC_ERR_SUCCESS;
+}
+
+GC_API
+TLClose (TL_HANDLE hTL)
+{
+  std::lock_guard < std::mutex > lock (libMutex);
+  MockSystem *tl = toHandle < MockSystem > (hTL, KIND_TL);
+  if (tl == NULL) {
+    return fail (GC_ERR_INVALID_HANDLE, "Invalid system handle");
+  }
+  tl->opened = false;
+  return GC_ERR_SUCCESS;
+}
+
+GC_API
+TLGetInfo (TL_HANDLE hTL, TL_INFO_CMD iInfoCmd, INFO_DATATYPE * piType,
+    void *pBuffer, size_t * piSize)
+{
+  if (toHandle < MockSystem > (hTL, KIND_TL) == NULL) {
+    return fail (GC_ERR_INVALID_HANDLE, "Invalid system handle");
+  }
+  return systemInfo (iInfoCmd, piType, pBuffer, piSize);
+}
+
+GC_API
+TLGetNumInterfaces (TL_HANDLE hTL, uint32_t * piNumIfaces)
+{
+  if (toHandle < MockSystem > (hTL, KIND_TL) == NULL) {
+    return fail (GC_ERR_INVALID_HANDLE, "Invalid system handle");
+  }
+  if (piNumIfaces == NULL) {
+    return fail (GC_ERR_INVALID_PARAMETER, "Invalid parameter");
+  }
+  *piNumIfaces = 1;
+  return GC_ERR_SUCCESS;
+}
+
+GC_API
+TLGetInterfaceID (TL_HANDLE hTL, uint32_t iIndex, char *sID, size_t * piSize)
+{
+  if (toHandle < MockSystem > (hTL, KIND_TL) == NULL) {
+    return fail (GC_ERR_INVALID_HANDLE, "Invalid system handle");
+  }
+  if (iIndex != 0) {
+    return fail (GC_ERR_INVALID_INDEX, "Invalid interface index");
+  }
+  return copyInfo (INFO_DATATYPE_STRING, MOCK_IF_ID, strlen (MOCK_IF_ID) + 1,
+      NULL, sID, piSize);
+}
+
+GC_API
+TLGetInterfaceInfo (TL_HANDLE hTL, const char *sIfaceID,
+    INTERFACE_INFO_CMD iInfoCmd, INFO_DATATYPE * piType, void *pBuffer,
+    size_t * piSize)
+{
+  if (toHandle < MockSystem > (hTL, KIND_TL) == NULL) {
+    return fail (GC_ERR_INVALID_HANDLE, "Invalid system handle");
+  }
+  if (sIfaceID == NULL || strcmp (sIfaceID, MOCK_IF_ID) != 0) {
+    return fail (GC_ERR_INVALID_ID, "Unknown interface");
+  }
+  return interfaceInfo (iInfoCmd, piType, pBuffer, piSize);
+}
+
+GC_API
+TLOpenInterface (TL_HANDLE hTL, const char *sIfaceID, IF_HANDLE * phIface)
+{
+  std::lock_guard < std::mutex > lock (libMutex);
+  MockSystem *tl = toHandle < MockSystem > (hTL, KIND_TL);
+  if (tl == NULL) {
+    return fail (GC_ERR_INVALID_HANDLE, "Invalid system handle");
+  }
+  if (sIfaceID == NULL || strcmp (sIfaceID, MOCK_IF_ID) != 0
+      || phIface == NULL) {
+    return fail (GC_ERR_INVALID_ID, "Unknown interface");
+  }
+  tl->interface.opened = true;
+  *phIface = &tl->interface;
+  return GC_ERR_SUCCESS;
+}
+
+GC_API
+TLUpdateInterfaceList (TL_HANDLE hTL, bool8_t * pbChanged, uint64_t iTimeout)
+{
+  if (toHandle < MockSystem > (hTL, KIND_TL) == NULL) {
+    return fail (GC_ERR_INVALID_HANDLE, "Invalid system handle");
+  }
+  if (pbChanged != NULL) {
+    *pbChanged = false;
+  }
+  return GC_ERR_SUCCESS;
+}
+
+/* Interface module */
+
+GC_API
+IFClose (IF_HANDLE hIface)
+{
+  std::lock_guard < std::mutex > lock (libMutex);
+  MockInterface *iface = toHandle < MockInterface > (hIface, KIND_IF);
+  if (iface == NULL) {
+    return fail (GC_ERR_INVALID_HANDLE, "Invalid interface handle");
+  }
+  iface->opened = false;
+  return GC_ERR_SUCCESS;
+}
+
+GC_API
+IFGetInfo (IF_HANDLE hIface, INTERFACE_INFO_CMD iInfoCmd,
+    INFO_DATATYPE * piType, void *pBuffer, size_t * piSize)
+{
+  if (toHandle < MockInterface > (hIface, KIND_IF) == NULL) {
+    return fail (GC_ERR_INVALID_HANDLE, "Invalid interface handle");
+  }
+  return interfaceInfo (iInfoCmd, piType, pBuffer, piSize);
+}
+
+GC_API
+IFGetNumDevices (IF_HANDLE hIface, uint32_t * piNumDevices)
+{
+  if (toHandle < MockInterface > (hIface, KIND_IF) == NULL) {
+    return fail (GC_ERR_INVALID_HANDLE, "Invalid interface handle");
+  }
+  if (piNumDevices == NULL) {
+    return fail (GC_ERR_INVALID_PARAMETER, "Invalid parameter");
+  }
+  *piNumDevices = static_cast < uint32_t > (mockSystem->devices.size ());
+  return GC_ERR_SUCCESS;
+}
+
+GC_API
+IFGetDeviceID (IF_HANDLE hIface, uint32_t iIndex, char *sIDeviceID,
+    size_t * piSize)
+{
+  if (toHandle < MockInterface > (hIface, KIND_IF) == NULL) {
+    return fail (GC_ERR_INVALID_HANDLE, "Invalid interface handle");
+  }
+  if (iIndex >= mockSystem->devices.size ()) {
+    return fail (GC_ERR_INVALID_INDEX, "Invalid device index");
+  }
+  const std::string & id = mockSystem->devices[iIndex]->config.serial;
+  return copyInfo (INFO_DATATYPE_STRING, id.c_str (), id.size () + 1, NULL,
+      sIDeviceID, piSize);
+}
+
+GC_API
+IFUpdateDeviceList (IF_HANDLE hIface, bool8_t * pbChanged, uint64_t iTimeout)
+{
+  if (toHandle < MockInterface > (hIface, KIND_IF) == NULL) {
+    return fail (GC_ERR_INVALID_HANDLE, "Invalid interface handle");
+  }
+  if (pbChanged != NULL) {
+    *pbChanged = false;
+  }
+  return GC_ERR_SUCCESS;
+}
+
+GC_API
+IFGetDeviceInfo (IF_HANDLE hIface, const char *sDeviceID,
+    DEVICE_INFO_CMD iInfoCmd, INFO_DATATYPE * piType, void *pBuffer,
+    size_t * piSize)
+{
+  if (toHandle < MockInterface > (hIface, KIND_IF) == NULL) {
+    return fail (GC_ERR_INVALID_HANDLE, "Invalid interface handle");
+  }
+  MockDevice *dev = findDevice (sDeviceID);
+  if (dev == NULL) {
+    return fail (GC_ERR_INVALID_ID, "Unknown device");
+  }
+  return deviceInfo (dev, iInfoCmd, piType, pBuffer, piSize);
+}
+
+GC_API
+IFOpenDevice (IF_HANDLE hIface, const char *sDeviceID,
+    DEVICE_ACCESS_FLAGS iOpenFlags, DEV_HANDLE * phDevice)
+{
+  std::lock_guard < std::mutex > lock (libMutex);
+  if (toHandle < MockInterface > (hIface, KIND_IF) == NULL) {
+    return fail (GC_ERR_INVALID_HANDLE, "Invalid interface handle");
+  }
+  MockDevice *dev = findDevice (sDeviceID);
+  if (dev == NULL || phDevice == NULL) {
+    return fail (GC_ERR_INVALID_ID, "Unknown device");
+  }
+  if (dev->opened) {
+    return fail (GC_ERR_RESOURCE_IN_USE, "Device already open");
+  }
+  {
+    std::lock_guard < std::mutex > devLock (dev->mtx);
+    resetRegisters (dev);
+  }
+  dev->opened = true;
+  *phDevice = dev;
+  return GC_ERR_SUCCESS;
+}
+
+GC_API
+IFGetParentTL (IF_HANDLE hIface, TL_HANDLE * phSystem)
+{
+  if (toHandle < MockInterface > (hIface, KIND_IF) == NULL
+      || phSystem == NULL) {
+    return fail (GC_ERR_INVALID_HANDLE, "Invalid interface handle");
+  }
+  *phSystem = mockSystem.get ();
+  return GC_ERR_SUCCESS;
+}
+
+/* Device module */
+
+GC_API
+DevGetPort (DEV_HANDLE hDevice, PORT_HANDLE * phRemoteDevice)
+{
+  MockDevice *dev = toHandle < MockDevice > (hDevice, KIND_DEV);
+  if (dev == NULL || phRemoteDevice == NULL) {
+    return fail (GC_ERR_INVALID_HANDLE, "Invalid device handle");
+  }
+  *phRemoteDevice = &dev->port;
+  return GC_ERR_SUCCESS;
+}
+
+GC_API
+DevGetNumDataStreams (DEV_HANDLE hDevice, uint32_t * piNumDataStreams)
+{
+  if (toHandle < MockDevice > (hDevice, KIND_DEV) == NULL
+      || piNumDataStreams == NULL) {
+    return fail (GC_ERR_INVALID_HANDLE, "Invalid device handle");
+  }
+  *piNumDataStreams = 1;
+  return GC_ERR_SUCCESS;
+}
+
+GC_API
+DevGetDataStreamID (DEV_HANDLE hDevice, uint32_t iIndex, char *sDataStreamID,
+    size_t * piSize)
+{
+  if (toHandle < MockDevice > (hDevice, KIND_DEV) == NULL) {
+    return fail (GC_ERR_INVALID_HANDLE, "Invalid device handle");
+  }
+  if (iIndex != 0) {
+    return fail (GC_ERR_INVALID_INDEX, "Invalid stream index");
+  }
+  return copyInfo (INFO_DATATYPE_STRING, MOCK_STREAM_ID,
+      strlen (MOCK_STREAM_ID) + 1, NULL, sDataStreamID, piSize);
+}
+
+GC_API
+DevOpenDataStream (DEV_HANDLE hDevice, const char *sDataStreamID,
+    DS_HANDLE * phDataStream)
+{
+  MockDevice *dev = toHandle < MockDevice > (hDevice, KIND_DEV);
+  if (dev == NULL) {
+    return fail (GC_ERR_INVALID_HANDLE, "Invalid device handle");
+  }
+  if (sDataStreamID == NULL || strcmp (sDataStreamID, MOCK_STREAM_ID) != 0
+      || phDataStream == NULL) {
+    return fail (GC_ERR_INVALID_ID, "Unknown stream");
+  }
+  std::lock_guard < std::mutex > lock (dev->mtx);
+  if (dev->stream) {
+    return fail (GC_ERR_RESOURCE_IN_USE, "Stream already open");
+  }
+  MockStream *s = new MockStream;
+  s->dev = dev;
+  s->event.stream = s;
+  s->rng.seed (std::hash < std::string > ()(dev->config.serial));
+  dev->stream = s;
+  *phDataStream = s;
+  return GC_ERR_SUCCESS;
+}
+
+GC_API
+DevGetInfo (DEV_HANDLE hDevice, DEVICE_INFO_CMD iInfoCmd,
+    INFO_DATATYPE * piType, void *pBuffer, size_t * piSize)
+{
+  MockDevice *dev = toHandle < MockDevice > (hDevice, KIND_DEV);
+  if (dev == NULL) {
+    return fail (GC_ERR_INVALID_HANDLE, "Invalid device handle");
+  }
+  return deviceInfo (dev, iInfoCmd, piType, pBuffer, piSize);
+}
+
+GC_API
+DevClose (DEV_HANDLE hDevice)
+{
+  std::lock_guard < std::mutex > lock (libMutex);
+  MockDevice *dev = toHandle < MockDevice > (hDevice, KIND_DEV);
+  if (dev == NULL) {
+    return fail (GC_ERR_INVALID_HANDLE, "Invalid device handle");
+  }
+  std::unique_lock < std::mutex > devLock (dev->mtx);
+  if (dev->stream) {
+    closeStream (dev->stream, devLock);
+  }
+  acquisitionStop (dev);
+  dev->opened = false;
+  return GC_ERR_SUCCESS;
+}
+
+GC_API
+DevGetParentIF (DEV_HANDLE hDevice, IF_HANDLE * phIface)
+{
+  if (toHandle < MockDevice > (hDevice, KIND_DEV) == NULL || phIface == NULL) {
+    return fail (GC_ERR_INVALID_HANDLE, "Invalid device handle");
+  }
+  *phIface = &mockSystem->interface;
+  return GC_ERR_SUCCESS;
+}
+
+/* Data stream module */
+
+GC_API
+DSAnnounceBuffer (DS_HANDLE hDataStream, void *pBuffer, size_t iSize,
+    void *pPrivate, BUFFER_HANDLE * phBuffer)
+{
+  MockStream *s = toHandle < MockStream > (hDataStream, KIND_DS);
+  if (s == NULL) {
+    return fail (GC_ERR_INVALID_HANDLE, "Invalid stream handle");
+  }
+  if (pBuffer == NULL || iSize == 0 || phBuffer == NULL) {
+    return fail (GC_ERR_INVALID_PARAMETER, "Invalid parameter");
+  }
+  std::lock_guard < std::mutex > lock (s->dev->mtx);
+  MockBuffer *buf = new MockBuffer;
+  buf->stream = s;
+  buf->base = static_cast < uint8_t * >(pBuffer);
+  buf->size = iSize;
+  buf->userPtr = pPrivate;
+  s->announced.push_back (buf);
+  *phBuffer = buf;
+  return GC_ERR_SUCCESS;
+}
+
+GC_API
+DSAllocAndAnnounceBuffer (DS_HANDLE hDataStream, size_t iSize, void *pPrivate,
+    BUFFER_HANDLE * phBuffer)
+{
+  MockStream *s = toHandle < MockStream > (hDataStream, KIND_DS);
+  if (s == NULL) {
+    return fail (GC_ERR_INVALID_HANDLE, "Invalid stream handle");
+  }
+  if (iSize == 0 || phBuffer == NULL) {
+    return fail (GC_ERR_INVALID_PARAMETER, "Invalid parameter");
+  }
+  void *mem = NULL;
+  if (posix_memalign (&mem, MOCK_BUF_ALIGNMENT, iSize) != 0) {
+    return fail (GC_ERR_OUT_OF_MEMORY, "Buffer allocation failed");
+  }
+  std::lock_guard < std::mutex > lock (s->dev->mtx);
+  MockBuffer *buf = new MockBuffer;
+  buf->stream = s;
+  buf->base = static_cast < uint8_t * >(mem);
+  buf->size = iSize;
+  buf->userPtr = pPrivate;
+  buf->allocated = true;
+  s->announced.push_back (buf);
+  *phBuffer = buf;
+  return GC_ERR_SUCCESS;
+}
+
+GC_API
+DSFlushQueue (DS_HANDLE hDataStream, ACQ_QUEUE_TYPE iOperation)
+{
+  MockStream *s = toHandle < MockStream > (hDataStream, KIND_DS);
+  if (s == NULL) {
+    return fail (GC_ERR_INVALID_HANDLE, "Invalid stream handle");
+  }
+  std::lock_guard < std::mutex > lock (s->dev->mtx);
+  switch (iOperation) {
+    case ACQ_QUEUE_INPUT_TO_OUTPUT:
+      s->output.insert (s->output.end (), s->input.begin (), s->input.end ());
+      s->input.clear ();
+      s->eventCv.notify_all ();
+      break;
+    case ACQ_QUEUE_OUTPUT_DISCARD:
+      for (MockBuffer * b:s->output) {
+        b->queued = false;
+      }
+      s->output.clear ();
+      break;
+    case ACQ_QUEUE_ALL_TO_INPUT:
+    case ACQ_QUEUE_UNQUEUED_TO_INPUT:
+      if (iOperation == ACQ_QUEUE_ALL_TO_INPUT) {
+        for (MockBuffer * b:s->output) {
+          b->queued = false;
+        }
+        s->output.clear ();
+      }
+      for (MockBuffer * b:s->announced) {
+        if (!b->queued && !b->acquiring) {
+          b->queued = true;
+          b->newData = false;
+          s->input.push_back (b);
+        }
+      }
+      s->dev->cv.notify_all ();
+      break;
+    case ACQ_QUEUE_ALL_DISCARD:
+      for (MockBuffer * b:s->input) {
+        b->queued = false;
+      }
+      for (MockBuffer * b:s->output) {
+        b->queued = false;
+      }
+      s->input.clear ();
+      s->output.clear ();
+      break;
+    default:
+      return fail (GC_ERR_INVALID_PARAMETER, "Invalid flush operation");
+  }
+  return GC_ERR_SUCCESS;
+}
+
+GC_API
+DSStartAcquisition (DS_HANDLE hDataStream, ACQ_START_FLAGS iStartFlags,
+    uint64_t iNumToAcquire)
+{
+  MockStream *s = toHandle < MockStream > (hDataStream, KIND_DS);
+  if (s == NULL) {
+    return fail (GC_ERR_INVALID_HANDLE, "Invalid stream handle");
+  }
+  std::unique_lock < std::mutex > lock (s->dev->mtx);
+  if (s->acquiring || s->thread.joinable ()) {
+    // the engine may have stopped by itself after iNumToAcquire frames
+    stopAcquisition (s, lock);
+  }
+
+  MockDevice *dev = s->dev;
+  s->width = dev->width;
+  s->height = dev->height;
+  s->pixelFormat = dev->pixelFormat;
+  s->imageSize = imageSize (dev);
+  s->chunk = dev->chunkModeActive != 0;
+  renderPattern (s);
+
+  s->numToAcquire = (iNumToAcquire == 0) ? GENTL_INFINITE : iNumToAcquire;
+  s->numDelivered = 0;
+  s->numUnderrun = 0;
+  s->numStarted = 0;
+  s->acquiring = true;
+  s->thread = std::thread (acquisitionThread, s);
+  return GC_ERR_SUCCESS;
+}
+
+GC_API
+DSStopAcquisition (DS_HANDLE hDataStream, ACQ_STOP_FLAGS iStopFlags)
+{
+  MockStream *s = toHandle < MockStream > (hDataStream, KIND_DS);
+  if (s == NULL) {
+    return fail (GC_ERR_INVALID_HANDLE, "Invalid stream handle");
+  }
+  std::unique_lock < std::mutex > lock (s->dev->mtx);
+  if (!s->acquiring && !s->thread.joinable ()) {
+    return fail (GC_ERR_RESOURCE_IN_USE, "Acquisition not started");
+  }
+  stopAcquisition (s, lock);
+  return GC_ERR_SUCCESS;
+}
+
+GC_API
+DSGetInfo (DS_HANDLE hDataStream, STREAM_INFO_CMD iInfoCmd,
+    INFO_DATATYPE * piType, void *pBuffer, size_t * piSize)
+{
+  MockStream *s = toHandle < MockStream > (hDataStream, KIND_DS);
+  if (s == NULL) {
+    return fail (GC_ERR_INVALID_HANDLE, "Invalid stream handle");
+  }
+  std::lock_guard < std::mutex > lock (s->dev->mtx);
+  switch (iInfoCmd) {
+    case STREAM_INFO_ID:
+      return stringInfo (MOCK_STREAM_ID, piType, pBuffer, piSize);
+    case STREAM_INFO_NUM_DELIVERED:
+      return valueInfo < uint64_t > (INFO_DATATYPE_UINT64, s->numDelivered,
+          piType, pBuffer, piSize);
+    case STREAM_INFO_NUM_UNDERRUN:
+      return valueInfo < uint64_t > (INFO_DATATYPE_UINT64, s->numUnderrun,
+          piType, pBuffer, piSize);
+    case STREAM_INFO_NUM_ANNOUNCED:
+      return valueInfo < size_t > (INFO_DATATYPE_SIZET, s->announced.size (),
+          piType, pBuffer, piSize);
+    case STREAM_INFO_NUM_QUEUED:
+      return valueInfo < size_t > (INFO_DATATYPE_SIZET, s->input.size (),
+          piType, pBuffer, piSize);
+    case STREAM_INFO_NUM_AWAIT_DELIVERY:
+      return valueInfo < size_t > (INFO_DATATYPE_SIZET, s->output.size (),
+          piType, pBuffer, piSize);
+    case STREAM_INFO_NUM_STARTED:
+      return valueInfo < uint64_t > (INFO_DATATYPE_UINT64, s->numStarted,
+          piType, pBuffer, piSize);
+    case STREAM_INFO_PAYLOAD_SIZE:
+      return valueInfo < size_t > (INFO_DATATYPE_SIZET, payloadSize (s->dev),
+          piType, pBuffer, piSize);
+    case STREAM_INFO_IS_GRABBING:
+      return valueInfo < bool8_t > (INFO_DATATYPE_BOOL8, s->acquiring, piType,
+          pBuffer, piSize);
+    case STREAM_INFO_DEFINES_PAYLOADSIZE:
+      return valueInfo < bool8_t > (INFO_DATATYPE_BOOL8, true, piType,
+          pBuffer, piSize);
+    case STREAM_INFO_TLTYPE:
+      return stringInfo (TLTypeCustomName, piType, pBuffer, piSize);
+    case STREAM_INFO_NUM_CHUNKS_MAX:
+      return valueInfo < size_t > (INFO_DATATYPE_SIZET, 1, piType, pBuffer,
+          piSize);
+    case STREAM_INFO_BUF_ANNOUNCE_MIN:
+      return valueInfo < size_t > (INFO_DATATYPE_SIZET, MOCK_BUF_ANNOUNCE_MIN,
+          piType, pBuffer, piSize);
+    case STREAM_INFO_BUF_ALIGNMENT:
+      return valueInfo < size_t > (INFO_DATATYPE_SIZET, MOCK_BUF_ALIGNMENT,
+          piType, pBuffer, piSize);
+    default:
+      return notAvailable ();
+  }
+}
+
+GC_API
+DSGetBufferID (DS_HANDLE hDataStream, uint32_t iIndex,
+    BUFFER_HANDLE * phBuffer)
+{
+  MockStream *s = toHandle < MockStream > (hDataStream, KIND_DS);
+  if (s == NULL || phBuffer == NULL) {
+    return fail (GC_ERR_INVALID_HANDLE, "Invalid stream handle");
+  }
+  std::lock_guard < std::mutex > lock (s->dev->mtx);
+  if (iIndex >= s->announced.size ()) {
+    return fail (GC_ERR_INVALID_INDEX, "Invalid buffer index");
+  }
+  *phBuffer = s->announced[iIndex];
+  return GC_ERR_SUCCESS;
+}
+
+GC_API
+DSClose (DS_HANDLE hDataStream)
+{
+  MockStream *s = toHandle < MockStream > (hDataStream, KIND_DS);
+  if (s == NULL) {
+    return fail (GC_ERR_INVALID_HANDLE, "Invalid stream handle");
+  }
+  std::unique_lock < std::mutex > lock (s->dev->mtx);
+  closeStream (s, lock);
+  return GC_ERR_SUCCESS;
+}
+
+GC_API
+DSRevokeBuffer (DS_HANDLE hDataStream, BUFFER_HANDLE hBuffer, void **pBuffer,
+    void **pPrivate)
+{
+  MockStream *s = toHandle < MockStream > (hDataStream, KIND_DS);
+  MockBuffer *buf = toHandle < MockBuffer > (hBuffer, KIND_BUF);
+  if (s == NULL || buf == NULL || buf->stream != s) {
+    return fail (GC_ERR_INVALID_HANDLE, "Invalid buffer handle");
+  }
+  std::lock_guard < std::mutex > lock (s->dev->mtx);
+  if (buf->queued || buf->acquiring) {
+    return fail (GC_ERR_BUSY, "Buffer is queued");
+  }
+  s->announced.erase (std::remove (s->announced.begin (), s->announced.end (),
+          buf), s->announced.end ());
+  if (pBuffer != NULL) {
+    *pBuffer = buf->allocated ? NULL : buf->base;
+  }
+  if (pPrivate != NULL) {
+    *pPrivate = buf->userPtr;
+  }
+  if (buf->allocated) {
+    free (buf->base);
+  }
+  buf->magic = 0;
+  delete buf;
+  return GC_ERR_SUCCESS;
+}
+
+GC_API
+DSQueueBuffer (DS_HANDLE hDataStream, BUFFER_HANDLE hBuffer)
+{
+  MockStream *s = toHandle < MockStream > (hDataStream, KIND_DS);
+  MockBuffer *buf = toHandle < MockBuffer > (hBuffer, KIND_BUF);
+  if (s == NULL || buf == NULL || buf->stream != s) {
+    return fail (GC_ERR_INVALID_HANDLE, "Invalid buffer handle");
+  }
+  std::lock_guard < std::mutex > lock (s->dev->mtx);
+  if (buf->queued || buf->acquiring) {
+    return fail (GC_ERR_INVALID_PARAMETER, "Buffer already queued");
+  }
+  buf->queued = true;
+  buf->newData = false;
+  s->input.push_back (buf);
+  s->dev->cv.notify_all ();
+  return GC_ERR_SUCCESS;
+}
+
+GC_API
+DSGetBufferInfo (DS_HANDLE hDataStream, BUFFER_HANDLE hBuffer,
+    BUFFER_INFO_CMD iInfoCmd, INFO_DATATYPE * piType, void *pBuffer,
+    size_t * piSize)
+{
+  MockStream *s = toHandle < MockStream > (hDataStream, KIND_DS);
+  MockBuffer *buf = toHandle < MockBuffer > (hBuffer, KIND_BUF);
+  if (s == NULL || buf == NULL || buf->stream != s) {
+    return fail (GC_ERR_INVALID_HANDLE, "Invalid buffer handle");
+  }
+  std::lock_guard < std::mutex > lock (s->dev->mtx);
+  switch (iInfoCmd) {
+    case BUFFER_INFO_BASE:
+      return valueInfo < void *>(INFO_DATATYPE_PTR, buf->base, piType,
+          pBuffer, piSize);
+    case BUFFER_INFO_SIZE:
+      return valueInfo < size_t > (INFO_DATATYPE_SIZET, buf->size, piType,
+          pBuffer, piSize);
+    case BUFFER_INFO_USER_PTR:
+      return valueInfo < void *>(INFO_DATATYPE_PTR, buf->userPtr, piType,
+          pBuffer, piSize);
+    case BUFFER_INFO_TIMESTAMP:
+    case BUFFER_INFO_TIMESTAMP_NS:
+      return valueInfo < uint64_t > (INFO_DATATYPE_UINT64, buf->timestampNs,
+          piType, pBuffer, piSize);
+    case BUFFER_INFO_NEW_DATA:
+      return valueInfo < bool8_t > (INFO_DATATYPE_BOOL8, buf->newData,
+          piType, pBuffer, piSize);
+    case BUFFER_INFO_IS_QUEUED:
+      return valueInfo < bool8_t > (INFO_DATATYPE_BOOL8, buf->queued, piType,
+          pBuffer, piSize);
+    case BUFFER_INFO_IS_ACQUIRING:
+      return valueInfo < bool8_t > (INFO_DATATYPE_BOOL8, buf->acquiring,
+          piType, pBuffer, piSize);
+    case BUFFER_INFO_IS_INCOMPLETE:
+      return valueInfo < bool8_t > (INFO_DATATYPE_BOOL8, buf->incomplete,
+          piType, pBuffer, piSize);
+    case BUFFER_INFO_TLTYPE:
+      return stringInfo (TLTypeCustomName, piType, pBuffer, piSize);
+    case BUFFER_INFO_SIZE_FILLED:
+      return valueInfo < size_t > (INFO_DATATYPE_SIZET, buf->sizeFilled,
+          piType, pBuffer, piSize);
+    case BUFFER_INFO_WIDTH:
+      return valueInfo < size_t > (INFO_DATATYPE_SIZET, buf->width, piType,
+          pBuffer, piSize);
+    case BUFFER_INFO_HEIGHT:
+    case BUFFER_INFO_DELIVERED_IMAGEHEIGHT:
+      return valueInfo < size_t > (INFO_DATATYPE_SIZET, buf->height, piType,
+          pBuffer, piSize);
+    case BUFFER_INFO_XOFFSET:
+    case BUFFER_INFO_YOFFSET:
+    case BUFFER_INFO_XPADDING:
+    case BUFFER_INFO_YPADDING:
+    case BUFFER_INFO_IMAGEOFFSET:
+      return valueInfo < size_t > (INFO_DATATYPE_SIZET, 0, piType, pBuffer,
+          piSize);
+    case BUFFER_INFO_FRAMEID:
+      return valueInfo < uint64_t > (INFO_DATATYPE_UINT64, buf->frameId,
+          piType, pBuffer, piSize);
+    case BUFFER_INFO_IMAGEPRESENT:
+      return valueInfo < bool8_t > (INFO_DATATYPE_BOOL8, true, piType,
+          pBuffer, piSize);
+    case BUFFER_INFO_PAYLOADTYPE:
+      return valueInfo < size_t > (INFO_DATATYPE_SIZET, PAYLOAD_TYPE_IMAGE,
+          piType, pBuffer, piSize);
+    case BUFFER_INFO_PIXELFORMAT:
+      return valueInfo < uint64_t > (INFO_DATATYPE_UINT64, buf->pixelFormat,
+          piType, pBuffer, piSize);
+    case BUFFER_INFO_PIXELFORMAT_NAMESPACE:
+      return valueInfo < uint64_t > (INFO_DATATYPE_UINT64,
+          PIXELFORMAT_NAMESPACE_PFNC_32BIT, piType, pBuffer, piSize);
+    case BUFFER_INFO_DELIVERED_CHUNKPAYLOADSIZE:
+      return valueInfo < size_t > (INFO_DATATYPE_SIZET,
+          buf->hasChunk ? MOCK_CHUNK_SIZE : 0, piType, pBuffer, piSize);
+    case BUFFER_INFO_CHUNKLAYOUTID:
+      return valueInfo < uint64_t > (INFO_DATATYPE_UINT64, 1, piType,
+          pBuffer, piSize);
+    case BUFFER_INFO_PIXEL_ENDIANNESS:
+      return valueInfo < int32_t > (INFO_DATATYPE_INT32,
+          PIXELENDIANNESS_LITTLE, piType, pBuffer, piSize);
+    case BUFFER_INFO_DATA_SIZE:
+      return valueInfo < size_t > (INFO_DATATYPE_SIZET, buf->imageSize,
+          piType, pBuffer, piSize);
+    case BUFFER_INFO_DATA_LARGER_THAN_BUFFER:
+      return valueInfo < bool8_t > (INFO_DATATYPE_BOOL8,
+          buf->imageSize < s->imageSize, piType, pBuffer, piSize);
+    case BUFFER_INFO_CONTAINS_CHUNKDATA:
+      return valueInfo < bool8_t > (INFO_DATATYPE_BOOL8, buf->hasChunk,
+          piType, pBuffer, piSize);
+    default:
+      return notAvailable ();
+  }
+}
+
+GC_API
+DSGetBufferChunkData (DS_HANDLE hDataStream, BUFFER_HANDLE hBuffer,
+    SINGLE_CHUNK_DATA * pChunkData, size_t * piNumChunks)
+{
+  MockStream *s = toHandle < MockStream > (hDataStream, KIND_DS);
+  MockBuffer *buf = toHandle < MockBuffer > (hBuffer, KIND_BUF);
+  if (s == NULL || buf == NULL || buf->stream != s) {
+    return fail (GC_ERR_INVALID_HANDLE, "Invalid buffer handle");
+  }
+  if (piNumChunks == NULL) {
+    return fail (GC_ERR_INVALID_PARAMETER, "Invalid parameter");
+  }
+  std::lock_guard < std::mutex > lock (s->dev->mtx);
+  if (!buf->hasChunk) {
+    *piNumChunks = 0;
+    return fail (GC_ERR_NO_DATA, "Buffer has no chunk data");
+  }
+  if (pChunkData == NULL) {
+    *piNumChunks = 1;
+    return GC_ERR_SUCCESS;
+  }
+  if (*piNumChunks < 1) {
+    *piNumChunks = 1;
+    return fail (GC_ERR_BUFFER_TOO_SMALL, "Buffer too small");
+  }
+  pChunkData[0].ChunkID = MOCK_CHUNK_ID;
+  pChunkData[0].ChunkOffset = static_cast < ptrdiff_t > (buf->imageSize);
+  pChunkData[0].ChunkLength = MOCK_CHUNK_SIZE;
+  *piNumChunks = 1;
+  return GC_ERR_SUCCESS;
+}
+
+GC_API
+DSGetParentDev (DS_HANDLE hDataStream, DEV_HANDLE * phDevice)
+{
+  MockStream *s = toHandle < MockStream > (hDataStream, KIND_DS);
+  if (s == NULL || phDevice == NULL) {
+    return fail (GC_ERR_INVALID_HANDLE, "Invalid stream handle");
+  }
+  *phDevice = s->dev;
+  return GC_ERR_SUCCESS;
+}
+
+GC_API
+DSGetNumBufferParts (DS_HANDLE hDataStream, BUFFER_HANDLE hBuffer,
+    uint32_t * piNumParts)
+{
+  // Single part image buffers only
+  if (piNumParts != NULL) {
+    *piNumParts = 0;
+  }
+  return fail (GC_ERR_NOT_AVAILABLE, "Buffer is not multi-part");
+}
+
+GC_API
+DSGetBufferPartInfo (DS_HANDLE hDataStream, BUFFER_HANDLE hBuffer,
+    uint32_t iPartIndex, BUFFER_PART_INFO_CMD iInfoCmd,
+    INFO_DATATYPE * piType, void *pBuffer, size_t * piSize)
+{
+  return fail (GC_ERR_NOT_AVAILABLE, "Buffer is not multi-part");
+}
+
+}
@@ -0,0 +1,623 @@
+/*
+ * GStreamer Generic Camera Plugin - mock GenTL producer
+ * Copyright (c) 2020, Intel Corporation
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice,
+ *    this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice,
+ *    this list of conditions and the following disclaimer in the documentation
+ *    and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors
+ *    may be used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO,
+ * THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+ * PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS;
+ * OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _MOCK_GENTL_XML_H_
+#define _MOCK_GENTL_XML_H_
+
+/* Register map of the mock remote device, all registers are little endian */
+#define MOCK_REG_VENDOR_NAME            0x0000  /* 32 byte string */
+#define MOCK_REG_MODEL_NAME             0x0020  /* 32 byte string */
+#define MOCK_REG_SERIAL_NUMBER          0x0040  /* 32 byte string */
+#define MOCK_REG_STRINGS_END            0x0060
+
+#define MOCK_REG_WIDTH_MAX              0x1000
+#define MOCK_REG_HEIGHT_MAX             0x1004
+#define MOCK_REG_WIDTH                  0x1008
+#define MOCK_REG_HEIGHT                 0x100C
+#define MOCK_REG_OFFSET_X               0x1010
+#define MOCK_REG_OFFSET_Y               0x1014
+#define MOCK_REG_PIXEL_FORMAT           0x1018
+#define MOCK_REG_PAYLOAD_SIZE           0x101C
+
+#define MOCK_REG_ACQUISITION_MODE       0x2000
+#define MOCK_REG_ACQUISITION_FRAMECOUNT 0x2004
+#define MOCK_REG_ACQUISITION_START      0x2008
+#define MOCK_REG_ACQUISITION_STOP       0x200C
+#define MOCK_REG_FRAMERATE_ENABLE       0x2010
+#define MOCK_REG_STATUS_SELECTOR        0x2014
+#define MOCK_REG_STATUS                 0x2018
+#define MOCK_REG_FRAMERATE              0x2020  /* 64 bit float */
+
+#define MOCK_REG_TRIGGER_SELECTOR       0x3000
+#define MOCK_REG_TRIGGER_MODE           0x3004
+#define MOCK_REG_TRIGGER_SOURCE         0x3008
+#define MOCK_REG_TRIGGER_SOFTWARE       0x300C
+
+#define MOCK_REG_CHUNK_MODE_ACTIVE      0x4000
+
+#define MOCK_REG_TL_PARAMS_LOCKED       0x5000
+#define MOCK_REG_PACKET_LOSS_RATIO      0x5008  /* 64 bit float */
+
+#define MOCK_REG_XML                    0x10000
+
+/* Chunk appended to every frame when ChunkModeActive is set, holding the
+   64 bit timestamp followed by the 64 bit frame id */
+#define MOCK_CHUNK_ID                   0x4D4F434B
+#define MOCK_CHUNK_SIZE                 16
+
+/* Enumeration values of the registers above */
+enum
+{
+  MOCK_ACQUISITION_CONTINUOUS = 0,
+  MOCK_ACQUISITION_SINGLEFRAME = 1,
+  MOCK_ACQUISITION_MULTIFRAME = 2
+};
+
+enum
+{
+  MOCK_STATUS_ACQUISITION_ACTIVE = 0,
+  MOCK_STATUS_FRAME_TRIGGER_WAIT = 1
+};
+
+enum
+{
+  MOCK_TRIGGER_SOURCE_SOFTWARE = 0,
+  MOCK_TRIGGER_SOURCE_LINE0 = 1
+};
+
+/* GenICam description of the mock remote device, read by the consumer
+   through the "Local:" URL of the device port */
+static const char mockDeviceXml[] = R"MOCKXML(<?xml version="1.0" encoding="utf-8"?>
+<RegisterDescription ModelName="MockCamera" VendorName="OpenEdgeInsights"
+    ToolTip="Software camera of the mock GenTL producer"
+    StandardNameSpace="None" SchemaMajorVersion="1" SchemaMinorVersion="1"
+    SchemaSubMinorVersion="0" MajorVersion="1" MinorVersion="0"
+    SubMinorVersion="0" ProductGuid="6f0c5d2e-8a0b-4c55-9e1f-3a7d1b2c4e01"
+    VersionGuid="6f0c5d2e-8a0b-4c55-9e1f-3a7d1b2c4e02"
+    xmlns="http://www.genicam.org/GenApi/Version_1_1"
+    xmlns:xsi="http://www.w3.org/2001/XMLSchema-instance"
+    xsi:schemaLocation="http://www.genicam.org/GenApi/Version_1_1 http://www.genicam.org/GenApi/GenApiSchema_Version_1_1.xsd">
+
+  <Category Name="Root" NameSpace="Standard">
+    <pFeature>DeviceControl</pFeature>
+    <pFeature>ImageFormatControl</pFeature>
+    <pFeature>AcquisitionControl</pFeature>
+    <pFeature>ChunkDataControl</pFeature>
+    <pFeature>TransportLayerControl</pFeature>
+    <pFeature>MockControl</pFeature>
+  </Category>
+
+  <Category Name="DeviceControl" NameSpace="Standard">
+    <pFeature>DeviceVendorName</pFeature>
+    <pFeature>DeviceModelName</pFeature>
+    <pFeature>DeviceSerialNumber</pFeature>
+  </Category>
+
+  <Category Name="ImageFormatControl" NameSpace="Standard">
+    <pFeature>WidthMax</pFeature>
+    <pFeature>HeightMax</pFeature>
+    <pFeature>Width</pFeature>
+    <pFeature>Height</pFeature>
+    <pFeature>OffsetX</pFeature>
+    <pFeature>OffsetY</pFeature>
+    <pFeature>PixelFormat</pFeature>
+  </Category>
+
+  <Category Name="AcquisitionControl" NameSpace="Standard">
+    <pFeature>AcquisitionMode</pFeature>
+    <pFeature>AcquisitionFrameCount</pFeature>
+    <pFeature>AcquisitionStart</pFeature>
+    <pFeature>AcquisitionStop</pFeature>
+    <pFeature>AcquisitionFrameRateEnable</pFeature>
+    <pFeature>AcquisitionFrameRate</pFeature>
+    <pFeature>AcquisitionStatusSelector</pFeature>
+    <pFeature>AcquisitionStatus</pFeature>
+    <pFeature>TriggerSelector</pFeature>
+    <pFeature>TriggerMode</pFeature>
+    <pFeature>TriggerSource</pFeature>
+    <pFeature>TriggerSoftware</pFeature>
+  </Category>
+
+  <Category Name="ChunkDataControl" NameSpace="Standard">
+    <pFeature>ChunkModeActive</pFeature>
+    <pFeature>ChunkTimestamp</pFeature>
+    <pFeature>ChunkFrameID</pFeature>
+  </Category>
+
+  <Category Name="TransportLayerControl" NameSpace="Standard">
+    <pFeature>PayloadSize</pFeature>
+    <pFeature>TLParamsLocked</pFeature>
+  </Category>
+
+  <Category Name="MockControl">
+    <pFeature>MockPacketLossRatio</pFeature>
+  </Category>
+
+  <!-- Device control -->
+
+  <StringReg Name="DeviceVendorName" NameSpace="Standard">
+    <Address>0x0000</Address>
+    <Length>32</Length>
+    <AccessMode>RO</AccessMode>
+    <pPort>Device</pPort>
+  </StringReg>
+
+  <StringReg Name="DeviceModelName" NameSpace="Standard">
+    <Address>0x0020</Address>
+    <Length>32</Length>
+    <AccessMode>RO</AccessMode>
+    <pPort>Device</pPort>
+  </StringReg>
+
+  <StringReg Name="DeviceSerialNumber" NameSpace="Standard">
+    <Address>0x0040</Address>
+    <Length>32</Length>
+    <AccessMode>RO</AccessMode>
+    <pPort>Device</pPort>
+  </StringReg>
+
+  <!-- Image format control -->
+
+  <IntReg Name="WidthMax" NameSpace="Standard">
+    <Address>0x1000</Address>
+    <Length>4</Length>
+    <AccessMode>RO</AccessMode>
+    <pPort>Device</pPort>
+    <Sign>Unsigned</Sign>
+    <Endianess>LittleEndian</Endianess>
+  </IntReg>
+
+  <IntReg Name="HeightMax" NameSpace="Standard">
+    <Address>0x1004</Address>
+    <Length>4</Length>
+    <AccessMode>RO</AccessMode>
+    <pPort>Device</pPort>
+    <Sign>Unsigned</Sign>
+    <Endianess>LittleEndian</Endianess>
+  </IntReg>
+
+  <Integer Name="Width" NameSpace="Standard">
+    <pIsLocked>TLParamsLocked</pIsLocked>
+    <pValue>WidthReg</pValue>
+    <Min>16</Min>
+    <pMax>WidthMax</pMax>
+  </Integer>
+
+  <IntReg Name="WidthReg">
+    <Address>0x1008</Address>
+    <Length>4</Length>
+    <AccessMode>RW</AccessMode>
+    <pPort>Device</pPort>
+    <Cachable>NoCache</Cachable>
+    <Sign>Unsigned</Sign>
+    <Endianess>LittleEndian</Endianess>
+  </IntReg>
+
+  <Integer Name="Height" NameSpace="Standard">
+    <pIsLocked>TLParamsLocked</pIsLocked>
+    <pValue>HeightReg</pValue>
+    <Min>16</Min>
+    <pMax>HeightMax</pMax>
+  </Integer>
+
+  <IntReg Name="HeightReg">
+    <Address>0x100C</Address>
+    <Length>4</Length>
+    <AccessMode>RW</AccessMode>
+    <pPort>Device</pPort>
+    <Cachable>NoCache</Cachable>
+    <Sign>Unsigned</Sign>
+    <Endianess>LittleEndian</Endianess>
+  </IntReg>
+
+  <Integer Name="OffsetX" NameSpace="Standard">
+    <pIsLocked>TLParamsLocked</pIsLocked>
+    <pValue>OffsetXReg</pValue>
+    <Min>0</Min>
+    <pMax>WidthMax</pMax>
+  </Integer>
+
+  <IntReg Name="OffsetXReg">
+    <Address>0x1010</Address>
+    <Length>4</Length>
+    <AccessMode>RW</AccessMode>
+    <pPort>Device</pPort>
+    <Cachable>NoCache</Cachable>
+    <Sign>Unsigned</Sign>
+    <Endianess>LittleEndian</Endianess>
+  </IntReg>
+
+  <Integer Name="OffsetY" NameSpace="Standard">
+    <pIsLocked>TLParamsLocked</pIsLocked>
+    <pValue>OffsetYReg</pValue>
+    <Min>0</Min>
+    <pMax>HeightMax</pMax>
+  </Integer>
+
+  <IntReg Name="OffsetYReg">
+    <Address>0x1014</Address>
+    <Length>4</Length>
+    <AccessMode>RW</AccessMode>
+    <pPort>Device</pPort>
+    <Cachable>NoCache</Cachable>
+    <Sign>Unsigned</Sign>
+    <Endianess>LittleEndian</Endianess>
+  </IntReg>
+
+  <Enumeration Name="PixelFormat" NameSpace="Standard">
+    <pIsLocked>TLParamsLocked</pIsLocked>
+    <EnumEntry Name="Mono8" NameSpace="Standard">
+      <Value>0x01080001</Value>
+    </EnumEntry>
+    <EnumEntry Name="BayerGR8" NameSpace="Standard">
+      <Value>0x01080008</Value>
+    </EnumEntry>
+    <EnumEntry Name="BayerRG8" NameSpace="Standard">
+      <Value>0x01080009</Value>
+    </EnumEntry>
+    <EnumEntry Name="BayerGB8" NameSpace="Standard">
+      <Value>0x0108000A</Value>
+    </EnumEntry>
+    <EnumEntry Name="BayerBG8" NameSpace="Standard">
+      <Value>0x0108000B</Value>
+    </EnumEntry>
+    <EnumEntry Name="RGB8" NameSpace="Standard">
+      <Value>0x02180014</Value>
+    </EnumEntry>
+    <EnumEntry Name="BGR8" NameSpace="Standard">
+      <Value>0x02180015</Value>
+    </EnumEntry>
+    <EnumEntry Name="YCbCr411_8" NameSpace="Standard">
+      <Value>0x020C005A</Value>
+    </EnumEntry>
+    <EnumEntry Name="YCbCr422_8" NameSpace="Standard">
+      <Value>0x0210003B</Value>
+    </EnumEntry>
+    <pValue>PixelFormatReg</pValue>
+  </Enumeration>
+
+  <IntReg Name="PixelFormatReg">
+    <Address>0x1018</Address>
+    <Length>4</Length>
+    <AccessMode>RW</AccessMode>
+    <pPort>Device</pPort>
+    <Cachable>NoCache</Cachable>
+    <Sign>Unsigned</Sign>
+    <Endianess>LittleEndian</Endianess>
+  </IntReg>
+
+  <!-- Acquisition control -->
+
+  <Enumeration Name="AcquisitionMode" NameSpace="Standard">
+    <EnumEntry Name="Continuous" NameSpace="Standard">
+      <Value>0</Value>
+    </EnumEntry>
+    <EnumEntry Name="SingleFrame" NameSpace="Standard">
+      <Value>1</Value>
+    </EnumEntry>
+    <EnumEntry Name="MultiFrame" NameSpace="Standard">
+      <Value>2</Value>
+    </EnumEntry>
+    <pValue>AcquisitionModeReg</pValue>
+  </Enumeration>
+
+  <IntReg Name="AcquisitionModeReg">
+    <Address>0x2000</Address>
+    <Length>4</Length>
+    <AccessMode>RW</AccessMode>
+    <pPort>Device</pPort>
+    <Cachable>NoCache</Cachable>
+    <Sign>Unsigned</Sign>
+    <Endianess>LittleEndian</Endianess>
+  </IntReg>
+
+  <Integer Name="AcquisitionFrameCount" NameSpace="Standard">
+    <pValue>AcquisitionFrameCountReg</pValue>
+    <Min>1</Min>
+    <Max>65535</Max>
+  </Integer>
+
+  <IntReg Name="AcquisitionFrameCountReg">
+    <Address>0x2004</Address>
+    <Length>4</Length>
+    <AccessMode>RW</AccessMode>
+    <pPort>Device</pPort>
+    <Cachable>NoCache</Cachable>
+    <Sign>Unsigned</Sign>
+    <Endianess>LittleEndian</Endianess>
+  </IntReg>
+
+  <Command Name="AcquisitionStart" NameSpace="Standard">
+    <pValue>AcquisitionStartReg</pValue>
+    <CommandValue>1</CommandValue>
+  </Command>
+
+  <IntReg Name="AcquisitionStartReg">
+    <Address>0x2008</Address>
+    <Length>4</Length>
+    <AccessMode>RW</AccessMode>
+    <pPort>Device</pPort>
+    <Cachable>NoCache</Cachable>
+    <Sign>Unsigned</Sign>
+    <Endianess>LittleEndian</Endianess>
+  </IntReg>
+
+  <Command Name="AcquisitionStop" NameSpace="Standard">
+    <pValue>AcquisitionStopReg</pValue>
+    <CommandValue>1</CommandValue>
+  </Command>
+
+  <IntReg Name="AcquisitionStopReg">
+    <Address>0x200C</Address>
+    <Length>4</Length>
+    <AccessMode>RW</AccessMode>
+    <pPort>Device</pPort>
+    <Cachable>NoCache</Cachable>
+    <Sign>Unsigned</Sign>
+    <Endianess>LittleEndian</Endianess>
+  </IntReg>
+
+  <Boolean Name="AcquisitionFrameRateEnable" NameSpace="Standard">
+    <pValue>AcquisitionFrameRateEnableReg</pValue>
+    <OnValue>1</OnValue>
+    <OffValue>0</OffValue>
+  </Boolean>
+
+  <IntReg Name="AcquisitionFrameRateEnableReg">
+    <Address>0x2010</Address>
+    <Length>4</Length>
+    <AccessMode>RW</AccessMode>
+    <pPort>Device</pPort>
+    <Cachable>NoCache</Cachable>
+    <Sign>Unsigned</Sign>
+    <Endianess>LittleEndian</Endianess>
+  </IntReg>
+
+  <Float Name="AcquisitionFrameRate" NameSpace="Standard">
+    <pValue>AcquisitionFrameRateReg</pValue>
+    <Min>1</Min>
+    <Max>10000</Max>
+  </Float>
+
+  <FloatReg Name="AcquisitionFrameRateReg">
+    <Address>0x2020</Address>
+    <Length>8</Length>
+    <AccessMode>RW</AccessMode>
+    <pPort>Device</pPort>
+    <Cachable>NoCache</Cachable>
+    <Endianess>LittleEndian</Endianess>
+  </FloatReg>
+
+  <Enumeration Name="AcquisitionStatusSelector" NameSpace="Standard">
+    <EnumEntry Name="AcquisitionActive" NameSpace="Standard">
+      <Value>0</Value>
+    </EnumEntry>
+    <EnumEntry Name="FrameTriggerWait" NameSpace="Standard">
+      <Value>1</Value>
+    </EnumEntry>
+    <pValue>AcquisitionStatusSelectorReg</pValue>
+  </Enumeration>
+
+  <IntReg Name="AcquisitionStatusSelectorReg">
+    <Address>0x2014</Address>
+    <Length>4</Length>
+    <AccessMode>RW</AccessMode>
+    <pPort>Device</pPort>
+    <Cachable>NoCache</Cachable>
+    <Sign>Unsigned</Sign>
+    <Endianess>LittleEndian</Endianess>
+  </IntReg>
+
+  <Boolean Name="AcquisitionStatus" NameSpace="Standard">
+    <pValue>AcquisitionStatusReg</pValue>
+    <OnValue>1</OnValue>
+    <OffValue>0</OffValue>
+  </Boolean>
+
+  <IntReg Name="AcquisitionStatusReg">
+    <Address>0x2018</Address>
+    <Length>4</Length>
+    <AccessMode>RO</AccessMode>
+    <pPort>Device</pPort>
+    <Cachable>NoCache</Cachable>
+    <Sign>Unsigned</Sign>
+    <Endianess>LittleEndian</Endianess>
+  </IntReg>
+
+  <Enumeration Name="TriggerSelector" NameSpace="Standard">
+    <EnumEntry Name="FrameStart" NameSpace="Standard">
+      <Value>0</Value>
+    </EnumEntry>
+    <pValue>TriggerSelectorReg</pValue>
+  </Enumeration>
+
+  <IntReg Name="TriggerSelectorReg">
+    <Address>0x3000</Address>
+    <Length>4</Length>
+    <AccessMode>RW</AccessMode>
+    <pPort>Device</pPort>
+    <Cachable>NoCache</Cachable>
+    <Sign>Unsigned</Sign>
+    <Endianess>LittleEndian</Endianess>
+  </IntReg>
+
+  <Enumeration Name="TriggerMode" NameSpace="Standard">
+    <EnumEntry Name="Off" NameSpace="Standard">
+      <Value>0</Value>
+    </EnumEntry>
+    <EnumEntry Name="On" NameSpace="Standard">
+      <Value>1</Value>
+    </EnumEntry>
+    <pValue>TriggerModeReg</pValue>
+  </Enumeration>
+
+  <IntReg Name="TriggerModeReg">
+    <Address>0x3004</Address>
+    <Length>4</Length>
+    <AccessMode>RW</AccessMode>
+    <pPort>Device</pPort>
+    <Cachable>NoCache</Cachable>
+    <Sign>Unsigned</Sign>
+    <Endianess>LittleEndian</Endianess>
+  </IntReg>
+
+  <Enumeration Name="TriggerSource" NameSpace="Standard">
+    <EnumEntry Name="Software" NameSpace="Standard">
+      <Value>0</Value>
+    </EnumEntry>
+    <EnumEntry Name="Line0" NameSpace="Standard">
+      <Value>1</Value>
+    </EnumEntry>
+    <pValue>TriggerSourceReg</pValue>
+  </Enumeration>
+
+  <IntReg Name="TriggerSourceReg">
+    <Address>0x3008</Address>
+    <Length>4</Length>
+    <AccessMode>RW</AccessMode>
+    <pPort>Device</pPort>
+    <Cachable>NoCache</Cachable>
+    <Sign>Unsigned</Sign>
+    <Endianess>LittleEndian</Endianess>
+  </IntReg>
+
+  <Command Name="TriggerSoftware" NameSpace="Standard">
+    <pValue>TriggerSoftwareReg</pValue>
+    <CommandValue>1</CommandValue>
+  </Command>
+
+  <IntReg Name="TriggerSoftwareReg">
+    <Address>0x300C</Address>
+    <Length>4</Length>
+    <AccessMode>RW</AccessMode>
+    <pPort>Device</pPort>
+    <Cachable>NoCache</Cachable>
+    <Sign>Unsigned</Sign>
+    <Endianess>LittleEndian</Endianess>
+  </IntReg>
+
+  <!-- Chunk data control -->
+
+  <Boolean Name="ChunkModeActive" NameSpace="Standard">
+    <pIsLocked>TLParamsLocked</pIsLocked>
+    <pValue>ChunkModeActiveReg</pValue>
+    <OnValue>1</OnValue>
+    <OffValue>0</OffValue>
+  </Boolean>
+
+  <IntReg Name="ChunkModeActiveReg">
+    <Address>0x4000</Address>
+    <Length>4</Length>
+    <AccessMode>RW</AccessMode>
+    <pPort>Device</pPort>
+    <Cachable>NoCache</Cachable>
+    <Sign>Unsigned</Sign>
+    <Endianess>LittleEndian</Endianess>
+  </IntReg>
+
+  <IntReg Name="ChunkTimestamp" NameSpace="Standard">
+    <Address>0x0</Address>
+    <Length>8</Length>
+    <AccessMode>RO</AccessMode>
+    <pPort>ChunkPort</pPort>
+    <Cachable>NoCache</Cachable>
+    <Sign>Unsigned</Sign>
+    <Endianess>LittleEndian</Endianess>
+  </IntReg>
+
+  <IntReg Name="ChunkFrameID" NameSpace="Standard">
+    <Address>0x8</Address>
+    <Length>8</Length>
+    <AccessMode>RO</AccessMode>
+    <pPort>ChunkPort</pPort>
+    <Cachable>NoCache</Cachable>
+    <Sign>Unsigned</Sign>
+    <Endianess>LittleEndian</Endianess>
+  </IntReg>
+
+  <!-- Transport layer control -->
+
+  <IntReg Name="PayloadSize" NameSpace="Standard">
+    <Address>0x101C</Address>
+    <Length>4</Length>
+    <AccessMode>RO</AccessMode>
+    <pPort>Device</pPort>
+    <Cachable>NoCache</Cachable>
+    <Sign>Unsigned</Sign>
+    <Endianess>LittleEndian</Endianess>
+  </IntReg>
+
+  <Integer Name="TLParamsLocked" NameSpace="Standard">
+    <Visibility>Invisible</Visibility>
+    <pValue>TLParamsLockedReg</pValue>
+    <Min>0</Min>
+    <Max>1</Max>
+  </Integer>
+
+  <IntReg Name="TLParamsLockedReg">
+    <Address>0x5000</Address>
+    <Length>4</Length>
+    <AccessMode>RW</AccessMode>
+    <pPort>Device</pPort>
+    <Cachable>NoCache</Cachable>
+    <Sign>Unsigned</Sign>
+    <Endianess>LittleEndian</Endianess>
+  </IntReg>
+
+  <!-- Mock specific -->
+
+  <Float Name="MockPacketLossRatio">
+    <ToolTip>Ratio of frames delivered incomplete, simulating lost packets</ToolTip>
+    <pValue>MockPacketLossRatioReg</pValue>
+    <Min>0</Min>
+    <Max>1</Max>
+  </Float>
+
+  <FloatReg Name="MockPacketLossRatioReg">
+    <Address>0x5008</Address>
+    <Length>8</Length>
+    <AccessMode>RW</AccessMode>
+    <pPort>Device</pPort>
+    <Cachable>NoCache</Cachable>
+    <Endianess>LittleEndian</Endianess>
+  </FloatReg>
+
+  <Port Name="Device" NameSpace="Standard"/>
+
+  <Port Name="ChunkPort">
+    <ChunkID>4D4F434B</ChunkID>
+  </Port>
+
+</RegisterDescription>
+)MOCKXML";
+
+#endif /* _MOCK_GENTL_XML_H_ */
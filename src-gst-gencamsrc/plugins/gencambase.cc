@@ -105,7 +105,7 @@ gencamsrc_stop (GstBaseSrc * src)
 
 
 EXTERNC bool
-gencamsrc_create (GstBuffer ** buf, GstMapInfo * mapInfo, GstBaseSrc * src)
+gencamsrc_create (GstBuffer ** buf, GstBaseSrc * src)
 {
   bool retVal = false;
   GstGencamsrc *gencamsrc = GST_GENCAMSRC (src);
@@ -113,7 +113,7 @@ gencamsrc_create (GstBuffer ** buf, GstMapInfo * mapInfo, GstBaseSrc * src)
   GST_DEBUG_OBJECT (gencamsrc, "START: %s", __func__);
 
   Genicam *genicam = (Genicam *) gencamsrc->gencam;
-  retVal = genicam->Create (buf, mapInfo);
+  retVal = genicam->Create (buf);
 
   GST_DEBUG_OBJECT (gencamsrc, "END: %s", __func__);
 
@@ -102,7 +102,10 @@ extern "C"
     float blackLevel;           /* configure overall brightness of the picture */
     float gamma;                /* Controls the gamma correction of pixel intensity */
     float balanceRatio;         /* Controls ratio of the selected color */
+    int maxOutstandingBuffers;  /* Max GenTL buffers held downstream */
     bool deviceReset;           /* Resets the device to factory state */
+    bool zeroCopy;              /* Push GenTL buffers without copying */
+    bool persistentStreaming;   /* Keep streaming across triggers */
   } GencamParams;
 
   /* Initialize generic camera base class */
@@ -115,7 +118,7 @@ extern "C"
   bool gencamsrc_stop (GstBaseSrc * src);
 
   /* Receive the frame to create output buffer */
-  bool gencamsrc_create (GstBuffer ** buf, GstMapInfo * mapInfo, GstBaseSrc *src);
+  bool gencamsrc_create (GstBuffer ** buf, GstBaseSrc *src);
 #ifdef __cplusplus
 }
 #endif
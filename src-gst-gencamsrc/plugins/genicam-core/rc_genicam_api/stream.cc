@@ -41,6 +41,7 @@
 
 #include <iostream>
 #include <algorithm>
+#include <cstdint>
 
 #ifdef _WIN32
 #undef min
@@ -62,6 +63,9 @@ Stream::Stream(const std::shared_ptr<Device> &_parent,
   stream=0;
   event=0;
   bn=0;
+  auto_requeue=true;
+  stopping=false;
+  grabbing=0;
 }
 
 Stream::~Stream()
@@ -183,11 +187,51 @@ void Stream::startStreaming(int na)
   bool err=false;
 
   bn=std::max(static_cast<size_t>(8), getBufAnnounceMin());
+
+  // if the caller owns the delivered buffers, the buffer memory is allocated
+  // here, so that it stays valid after stopStreaming() for as long as the
+  // caller keeps a reference, fall back to producer memory if the producer
+  // does not accept user allocated buffers
+
+  memory.reset();
+  uint8_t *base=0;
+  size_t stride=size;
+
+  if (!auto_requeue && size > 0)
+  {
+    size_t align=std::max(static_cast<size_t>(1), getBufAlignment());
+    stride=(size+align-1)/align*align;
+
+    std::shared_ptr<uint8_t> mem(new uint8_t[bn*stride+align],
+                                 std::default_delete<uint8_t[]>());
+
+    memory=mem;
+    base=mem.get();
+    base+=(align-reinterpret_cast<uintptr_t>(base)%align)%align;
+  }
+
   for (size_t i=0; i<bn; i++)
   {
     GenTL::BUFFER_HANDLE p=0;
 
-    if (gentl->DSAllocAndAnnounceBuffer(stream, size, 0, &p) != GenTL::GC_ERR_SUCCESS)
+    if (base != 0)
+    {
+      if (gentl->DSAnnounceBuffer(stream, base+i*stride, size, 0, &p) !=
+          GenTL::GC_ERR_SUCCESS)
+      {
+        if (i > 0)
+        {
+          err=true;
+          break;
+        }
+
+        memory.reset();
+        base=0;
+      }
+    }
+
+    if (base == 0 &&
+        gentl->DSAllocAndAnnounceBuffer(stream, size, 0, &p) != GenTL::GC_ERR_SUCCESS)
     {
       err=true;
       break;
@@ -242,6 +286,8 @@ void Stream::startStreaming(int na)
       gentl->DSRevokeBuffer(stream, p, 0, 0);
     }
 
+    memory.reset();
+
     // unlock parameters
 
     std::shared_ptr<GenApi::CNodeMapRef> nmap=parent->getRemoteNodeMap();
@@ -258,12 +304,22 @@ void Stream::startStreaming(int na)
 
 void Stream::stopStreaming()
 {
-  std::lock_guard<std::recursive_mutex> lock(mtx);
+  std::unique_lock<std::recursive_mutex> lock(mtx);
 
   if (bn > 0)
   {
     buffer.setHandle(0);
 
+    // abort a grab() that waits for a buffer without holding the lock and
+    // wait until it has returned, before the event handle is unregistered
+
+    stopping=true;
+    if (grabbing > 0)
+    {
+      gentl->EventKill(event);
+      grab_done.wait(lock, [this] { return grabbing == 0; });
+    }
+
     // do not throw exceptions as this method is also called in destructor
 
     GenApi::CCommandPtr stop=parent->getRemoteNodeMap()->_GetNode("AcquisitionStop");
@@ -286,6 +342,11 @@ void Stream::stopStreaming()
 
     event=0;
     bn=0;
+    stopping=false;
+
+    // memory of user allocated buffers is freed with the last reference
+
+    memory.reset();
 
     // unlock parameters
 
@@ -301,7 +362,7 @@ void Stream::stopStreaming()
 
 const Buffer *Stream::grab(int64_t _timeout)
 {
-  std::lock_guard<std::recursive_mutex> lock(mtx);
+  std::unique_lock<std::recursive_mutex> lock(mtx);
 
   uint64_t timeout=GENTL_INFINITE;
   if (_timeout >= 0)
@@ -316,11 +377,12 @@ const Buffer *Stream::grab(int64_t _timeout)
     throw GenTLException("Streaming::grab(): Streaming not started");
   }
 
-  // enqueue previously delivered buffer if any
+  // enqueue previously delivered buffer if any, unless the caller owns it
 
   if (buffer.getHandle() != 0)
   {
-    if (gentl->DSQueueBuffer(stream, buffer.getHandle()) != GenTL::GC_ERR_SUCCESS)
+    if (auto_requeue &&
+        gentl->DSQueueBuffer(stream, buffer.getHandle()) != GenTL::GC_ERR_SUCCESS)
     {
       buffer.setHandle(0);
       throw GenTLException("Stream::grab()", gentl);
@@ -335,7 +397,35 @@ const Buffer *Stream::grab(int64_t _timeout)
   size_t size=sizeof(GenTL::EVENT_NEW_BUFFER_DATA);
   memset(&data, 0, size);
 
-  GenTL::GC_ERROR err=gentl->EventGetData(event, &data, &size, timeout);
+  // if the caller owns the delivered buffers, they are given back from other
+  // threads via queueBuffer(), which must not be blocked while waiting here
+
+  GenTL::GC_ERROR err;
+  if (auto_requeue)
+  {
+    err=gentl->EventGetData(event, &data, &size, timeout);
+  }
+  else
+  {
+    if (stopping)
+    {
+      return 0;
+    }
+
+    void *ev=event;
+
+    grabbing++;
+    lock.unlock();
+    err=gentl->EventGetData(ev, &data, &size, timeout);
+    lock.lock();
+    grabbing--;
+    grab_done.notify_all();
+
+    if (stopping)
+    {
+      return 0;
+    }
+  }
 
   // return 0 in case of abort and timeout and throw exception in case of
   // another error
@@ -356,6 +446,40 @@ const Buffer *Stream::grab(int64_t _timeout)
   return &buffer;
 }
 
+void Stream::setAutoRequeue(bool enable)
+{
+  std::lock_guard<std::recursive_mutex> lock(mtx);
+  auto_requeue=enable;
+}
+
+bool Stream::getAutoRequeue() const
+{
+  return auto_requeue;
+}
+
+std::shared_ptr<const void> Stream::getBufferMemory()
+{
+  std::lock_guard<std::recursive_mutex> lock(mtx);
+  return memory;
+}
+
+void Stream::queueBuffer(void *handle)
+{
+  std::lock_guard<std::recursive_mutex> lock(mtx);
+
+  // buffers are revoked when streaming stops, so there is nothing to give back
+
+  if (handle == 0 || bn == 0 || stream == 0)
+  {
+    return;
+  }
+
+  if (gentl->DSQueueBuffer(stream, handle) != GenTL::GC_ERR_SUCCESS)
+  {
+    throw GenTLException("Stream::queueBuffer()", gentl);
+  }
+}
+
 namespace
 {
 
@@ -40,6 +40,7 @@
 #include "buffer.h"
 
 #include <mutex>
+#include <condition_variable>
 
 namespace rcg
 {
@@ -122,6 +123,51 @@ class Stream : public std::enable_shared_from_this<Stream>
 
     const Buffer *grab(int64_t timeout=-1);
 
+    /**
+      Enables or disables re-queueing of the previously delivered buffer on
+      the next call to grab(). Auto re-queueing is enabled by default. If it
+      is disabled, the caller takes ownership of every delivered buffer
+      handle and must give it back to the acquisition engine via
+      queueBuffer() as soon as the data is not needed anymore.
+
+      @param enable True for re-queueing the buffer in grab().
+    */
+
+    void setAutoRequeue(bool enable);
+
+    /**
+      Returns if the previously delivered buffer is re-queued in grab().
+
+      @return True if auto re-queueing is enabled.
+    */
+
+    bool getAutoRequeue() const;
+
+    /**
+      Gives a buffer that has been delivered by grab() back to the
+      acquisition engine. This is only necessary if auto re-queueing has been
+      disabled. The call is ignored if streaming has been stopped in the
+      meantime, since all buffers are revoked by stopStreaming(). This method
+      may be called from any thread.
+
+      @param handle Buffer handle as returned by Buffer::getHandle().
+    */
+
+    void queueBuffer(void *handle);
+
+    /**
+      Returns the memory of the announced buffers if auto re-queueing had been
+      disabled when streaming was started and the producer accepts buffers
+      that are allocated by the consumer. The data of all buffers that have
+      been delivered by grab() stays valid after stopStreaming() for as long
+      as a reference to the returned memory is kept.
+
+      @return Shared buffer memory or nullptr if the memory is owned by the
+              producer.
+    */
+
+    std::shared_ptr<const void> getBufferMemory();
+
     /**
       Returns some information about the stream.
 
@@ -289,6 +335,11 @@ class Stream : public std::enable_shared_from_this<Stream>
     void *stream;
     void *event;
     size_t bn;
+    bool auto_requeue;
+    bool stopping;
+    int grabbing;
+    std::condition_variable_any grab_done;
+    std::shared_ptr<uint8_t> memory;
 
     std::shared_ptr<CPort> cport;
     std::shared_ptr<GenApi::CNodeMapRef> nodemap;
@@ -41,6 +41,51 @@
 GST_DEBUG_CATEGORY_EXTERN (gst_gencamsrc_debug_category);
 #define GST_CAT_DEFAULT gst_gencamsrc_debug_category
 
+/* Shared between the Genicam object and the release notify of every buffer
+   pushed downstream without copy. Keeps the buffer memory allocated when
+   downstream still holds frames after the source has been stopped. */
+struct GenTLBufferPool
+{
+  std::mutex mtx;
+  std::shared_ptr < rcg::Stream > stream;       // Reset when streaming stops
+  std::shared_ptr < const void >memory;         // Memory of all GenTL buffers
+  guint outstanding;            // GenTL buffers held downstream
+  guint maxOutstanding;         // Frames are copied beyond this limit
+};
+
+/* Context of a single exported GenTL buffer */
+struct GenTLBufferRef
+{
+  std::shared_ptr < GenTLBufferPool > pool;
+  void *handle;
+};
+
+/* Release notify of the wrapped GstMemory, gives the GenTL buffer back to
+   the acquisition engine once downstream has dropped its last reference.
+   After the source has been stopped only the memory is released. */
+static void
+releaseGenTLBuffer (gpointer data)
+{
+  GenTLBufferRef *ref = (GenTLBufferRef *) data;
+
+  {
+    std::lock_guard < std::mutex > lock (ref->pool->mtx);
+    try {
+      if (ref->pool->stream) {
+        ref->pool->stream->queueBuffer (ref->handle);
+      }
+    }
+    catch (const std::exception & ex) {
+      GST_WARNING ("Exception: %s", ex.what ());
+    }
+    catch ( ...) {
+      GST_WARNING ("Exception: unknown");
+    }
+    ref->pool->outstanding--;
+  }
+  delete ref;
+}
+
 bool
 Genicam::Init (GencamParams * params, GstBaseSrc * src)
 {
@@ -271,12 +316,58 @@ Genicam::Start (void)
        non-continuous mode operation in "Create" */
     isAcquisitionStatusFeature = isFeature ("AcquisitionStatus\0", NULL);
 
+    /* The device stops by itself after this many frames in non-continuous
+       modes and has to be re-armed */
+    framesAcquired = 0;
+    framesPerAcquisition = 1;
+    if (acquisitionMode == "MultiFrame") {
+      int frameCount = rcg::getInteger (nodemap, "AcquisitionFrameCount",
+          NULL, NULL, false, false);
+      framesPerAcquisition = (frameCount > 0) ? frameCount : 1;
+    }
+
     stream = dev->getStreams ();
     if (stream.size () > 0) {
       // opening first stream
       stream[0]->open ();
+
+      // GenTL buffers are pushed downstream without copy unless streaming
+      // is restarted after every frame, which revokes all the buffers
+      bool zeroCopy = gencamParams->zeroCopy
+          && (acquisitionMode == "Continuous"
+          || gencamParams->persistentStreaming);
+      stream[0]->setAutoRequeue (!zeroCopy);
       stream[0]->startStreaming ();
 
+      // Frames held downstream must stay valid after the stream is closed,
+      // which needs buffer memory allocated by the plugin
+      std::shared_ptr < const void >memory = stream[0]->getBufferMemory ();
+      if (zeroCopy && !memory) {
+        GST_WARNING_OBJECT (gencamsrc,
+            "GenTL producer does not accept allocated buffers, copying frames");
+        stream[0]->setAutoRequeue (true);
+        zeroCopy = false;
+      }
+
+      if (zeroCopy) {
+        bufferPool = std::make_shared < GenTLBufferPool > ();
+        bufferPool->stream = stream[0];
+        bufferPool->memory = memory;
+        bufferPool->outstanding = 0;
+
+        // Keep at least one buffer with the acquisition engine
+        guint announced = stream[0]->getNumAnnounced ();
+        guint maxOutstanding = (gencamParams->maxOutstandingBuffers > 0) ?
+            gencamParams->maxOutstandingBuffers : announced / 2;
+        if (announced > 0 && maxOutstanding >= announced) {
+          maxOutstanding = announced - 1;
+        }
+        bufferPool->maxOutstanding = maxOutstanding;
+        GST_INFO_OBJECT (gencamsrc,
+            "Zero-copy enabled, up to %u of %u buffers held downstream",
+            maxOutstanding, announced);
+      }
+
       if (acquisitionMode != "Continuous" && triggerMode == "On") {
         if (triggerSource == "Software") {
           setTriggerSoftware ();
@@ -308,6 +399,18 @@ Genicam::Stop (void)
 {
   GST_DEBUG_OBJECT (gencamsrc, "START: %s", __func__);
   try {
+    // Buffers pushed without copy are backed by the pool memory, which is
+    // freed by the last release, so the camera is closed right away
+    if (bufferPool) {
+      std::lock_guard < std::mutex > lock (bufferPool->mtx);
+      if (bufferPool->outstanding > 0) {
+        GST_INFO_OBJECT (gencamsrc, "%u buffers still held downstream",
+            bufferPool->outstanding);
+      }
+      bufferPool->stream.reset ();
+    }
+    bufferPool.reset ();
+
     // Stop and close the streams opened
     if (stream.size () > 0) {
       stream[0]->stopStreaming ();
@@ -336,7 +439,24 @@ Genicam::Stop (void)
 }
 
 
-bool Genicam::Create (GstBuffer ** buf, GstMapInfo * mapInfo)
+GstBuffer *
+Genicam::wrapBuffer (void *handle, void *base, gsize size)
+{
+  GenTLBufferRef *ref = new GenTLBufferRef;
+  ref->pool = bufferPool;
+  ref->handle = handle;
+
+  {
+    std::lock_guard < std::mutex > lock (bufferPool->mtx);
+    bufferPool->outstanding++;
+  }
+
+  return gst_buffer_new_wrapped_full (GST_MEMORY_FLAG_READONLY, base, size, 0,
+      size, ref, releaseGenTLBuffer);
+}
+
+
+bool Genicam::Create (GstBuffer ** buf)
 {
   /* Grab the buffer, copy and release, set framenum */
   int
@@ -366,23 +486,57 @@ bool Genicam::Create (GstBuffer ** buf, GstMapInfo * mapInfo)
         globalSize = buffer->getGlobalSize ();
     guint64
         timestampNS = buffer->getTimestampNS ();
+    void *
+        globalBase = buffer->getGlobalBase ();
+    void *
+        handle = buffer->getHandle ();
+    bool
+        ownsBuffer = !stream[0]->getAutoRequeue ();
+    bool
+        wrap = false;
+
+    if (ownsBuffer) {
+      std::lock_guard < std::mutex > lock (bufferPool->mtx);
+      wrap = bufferPool->outstanding < bufferPool->maxOutstanding;
+    }
 
-    *buf = gst_buffer_new_allocate (NULL, globalSize, NULL);
-    if (*buf == NULL) {
-      GST_ERROR_OBJECT (gencamsrc, "Buffer couldn't be allocated");
-      return FALSE;
+    if (wrap) {
+      *buf = wrapBuffer (handle, globalBase, globalSize);
+    } else {
+      // Copy when zero-copy is off or downstream holds too many buffers
+      if (ownsBuffer) {
+        GST_LOG_OBJECT (gencamsrc, "Outstanding buffer limit reached, copying");
+      }
+      *buf = gst_buffer_new_allocate (NULL, globalSize, NULL);
+      if (*buf == NULL) {
+        GST_ERROR_OBJECT (gencamsrc, "Buffer couldn't be allocated");
+        if (ownsBuffer) {
+          stream[0]->queueBuffer (handle);
+        }
+        return FALSE;
+      }
+      gst_buffer_fill (*buf, 0, globalBase, globalSize);
+      if (ownsBuffer) {
+        stream[0]->queueBuffer (handle);
+      }
     }
     GST_BUFFER_PTS (*buf) = timestampNS;
-    gst_buffer_map (*buf, mapInfo, GST_MAP_WRITE);
 
-    memcpy (mapInfo->data, buffer->getGlobalBase (), mapInfo->size);
-
-    // For Non continuous modes, execute TriggerSoftware command
+    // For Non continuous modes, re-arm the acquisition and execute
+    // TriggerSoftware command
     if (acquisitionMode != "Continuous") {
-      stream[0]->stopStreaming ();
-      stream[0]->startStreaming ();
+      if (gencamParams->persistentStreaming) {
+        // Buffers stay announced and queued, only the device acquisition is
+        // started again once all of its frames have been delivered
+        if (++framesAcquired >= framesPerAcquisition) {
+          framesAcquired = 0;
+          rearmAcquisition ();
+        }
+      } else {
+        stream[0]->stopStreaming ();
+        stream[0]->startStreaming ();
+      }
 
-      // TODO handle multi frame, needs separate frame count for that
       if (triggerMode == "On" && triggerSource == "Software") {
         // If "AcquisitionStatus" feature is present, check the status
         while (!(rcg::getBoolean (nodemap, "AcquisitionStatus", false, false))
@@ -2009,6 +2163,25 @@ Genicam::setTriggerSoftware (void)
 }
 
 
+bool
+Genicam::rearmAcquisition (void)
+{
+  bool ret = false;
+
+  GST_TRACE_OBJECT (gencamsrc, "START: %s", __func__);
+  // The device usually stops on its own after the last frame, some need an
+  // explicit stop before they accept a new start
+  rcg::callCommand (nodemap, "AcquisitionStop", false);
+  ret = rcg::callCommand (nodemap, "AcquisitionStart", false);
+  if (!ret) {
+    GST_WARNING_OBJECT (gencamsrc, "AcquisitionStart: command failed.");
+  }
+
+  GST_TRACE_OBJECT (gencamsrc, "END: %s", __func__);
+  return ret;
+}
+
+
 bool
 Genicam::setTriggerSelector (void)
 {
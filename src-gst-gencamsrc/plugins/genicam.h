@@ -63,6 +63,7 @@
 #include <fstream>
 #include <iomanip>
 #include <iostream>
+#include <mutex>
 #include <thread>
 // ------------------------------------------------------------------------------
 
@@ -72,6 +73,9 @@
 #define ROUNDED_UP(  val, align)        ROUNDED_DOWN((val) + (align) - 1, (align))
 #define GRAB_DELAY 5  // In seconds
 
+/* Bookkeeping of GenTL buffers handed out downstream without copy */
+struct GenTLBufferPool;
+
 class Genicam
 {
 public:
@@ -103,14 +107,12 @@ public:
   /*
    * Creates the buffer corresponding to a frame to be pushed in the pipeline
 
-   @param buf          Double pointer GstBuffer structure to allocate the
-   buffer and copy the frame data
-   @param mapInfo      Pointer to the structure that contains buffer
-   information
+   @param buf          Double pointer GstBuffer structure to wrap the GenTL
+   buffer in, or to allocate and copy the frame data into
    @return             True after receiving the buffer containing a frame.
    False otherwise.
    */
-  bool Create (GstBuffer ** buf, GstMapInfo * mapInfo);
+  bool Create (GstBuffer ** buf);
 
 private:
   /* Pointer to gencamParams structure */
@@ -131,6 +133,12 @@ private:
   /* Shared pointer to nodemap */
     std::shared_ptr < GenApi::CNodeMapRef > nodemap;
 
+  /* GenTL buffers exported downstream, shared with their release notify */
+    std::shared_ptr < GenTLBufferPool > bufferPool;
+
+  /* Wraps the grabbed GenTL buffer into a GstBuffer without copying */
+  GstBuffer *wrapBuffer (void *handle, void *base, gsize size);
+
   /*Camera information*/
   struct camInfo_t {
       std::string vendorName; // Camera vendor name
@@ -164,6 +172,12 @@ private:
   /* For checking if Acquisition Status is a feature or not */
   bool isAcquisitionStatusFeature;
 
+  /* Frames delivered per device acquisition in non-continuous modes */
+  int framesPerAcquisition;
+
+  /* Frames delivered since the device acquisition was last started */
+  int framesAcquired;
+
   /* Device Link Throughput Limit Mode
    * This is not exposed outside and set automatically depending
    * on Device Link Throughput Limit value */
@@ -313,6 +327,9 @@ private:
   /* Sets Trigger Software */
   bool setTriggerSoftware (void);
 
+  /* Restarts the device acquisition while the stream keeps running */
+  bool rearmAcquisition (void);
+
   /* Sets the Stream Packet Size */
   bool setChannelPacketSize (void);
 
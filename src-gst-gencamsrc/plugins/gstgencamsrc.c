@@ -134,7 +134,10 @@ enum
   PROP_CHANNELPACKETSIZE,
   PROP_CHANNELPACKETDELAY,
   PROP_FRAMERATE,
-  PROP_RESET
+  PROP_RESET,
+  PROP_ZEROCOPY,
+  PROP_MAXOUTSTANDINGBUFFERS,
+  PROP_PERSISTENTSTREAMING
 };
 
 /* pad templates */
@@ -439,6 +442,24 @@ gst_gencamsrc_class_init (GstGencamsrcClass * klass)
           "Resets the device to its power up state. After reset, the device must be rediscovered. Do not use unless absolutely required.",
           false /* Default */ ,
           (GParamFlags) (G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
+
+  g_object_class_install_property (gobject_class, PROP_ZEROCOPY,
+      g_param_spec_boolean ("zero-copy", "ZeroCopy",
+          "Push the GenTL acquisition buffers downstream without copying. A buffer is given back to the acquisition engine when downstream releases it.",
+          true /* Default */ ,
+          (GParamFlags) (G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
+
+  g_object_class_install_property (gobject_class, PROP_MAXOUTSTANDINGBUFFERS,
+      g_param_spec_int ("max-outstanding-buffers", "MaxOutstandingBuffers",
+          "Maximum number of GenTL buffers held downstream in zero-copy mode. Frames beyond this limit are copied so that acquisition never runs out of buffers. 0 uses half of the announced buffers.",
+          0 /*Min */ , INT_MAX /*Max */ , 0 /*Default */ ,
+          (GParamFlags) (G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
+
+  g_object_class_install_property (gobject_class, PROP_PERSISTENTSTREAMING,
+      g_param_spec_boolean ("persistent-streaming", "PersistentStreaming",
+          "Keep the stream and its buffers set up across triggers in singleframe/multiframe acquisition modes and only restart the device acquisition. When false, streaming is stopped and started again after every frame.",
+          true /* Default */ ,
+          (GParamFlags) (G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS)));
 }
 
 static void
@@ -501,6 +522,9 @@ gst_gencamsrc_init (GstGencamsrc * gencamsrc)
   prop->acquisitionFrameRate = 0;
   prop->deviceClockSelector = NULL;
   prop->deviceReset = false;
+  prop->zeroCopy = true;
+  prop->maxOutstandingBuffers = 0;
+  prop->persistentStreaming = true;
 
   gencamsrc->prevSecTime = 0;
   gencamsrc->elapsedTime = 0;
@@ -654,6 +678,15 @@ gst_gencamsrc_set_property (GObject * object, guint property_id,
     case PROP_RESET:
       prop->deviceReset = g_value_get_boolean (value);
       break;
+    case PROP_ZEROCOPY:
+      prop->zeroCopy = g_value_get_boolean (value);
+      break;
+    case PROP_MAXOUTSTANDINGBUFFERS:
+      prop->maxOutstandingBuffers = g_value_get_int (value);
+      break;
+    case PROP_PERSISTENTSTREAMING:
+      prop->persistentStreaming = g_value_get_boolean (value);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
@@ -802,6 +835,15 @@ gst_gencamsrc_get_property (GObject * object, guint property_id,
     case PROP_RESET:
       g_value_set_boolean (value, prop->deviceReset);
       break;
+    case PROP_ZEROCOPY:
+      g_value_set_boolean (value, prop->zeroCopy);
+      break;
+    case PROP_MAXOUTSTANDINGBUFFERS:
+      g_value_set_int (value, prop->maxOutstandingBuffers);
+      break;
+    case PROP_PERSISTENTSTREAMING:
+      g_value_set_boolean (value, prop->persistentStreaming);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
       break;
@@ -1028,16 +1070,14 @@ static GstFlowReturn
 gst_gencamsrc_create (GstPushSrc * src, GstBuffer ** buf)
 {
   GstGencamsrc *gencamsrc = GST_GENCAMSRC (src);
-  GstMapInfo mapInfo;
 
   GST_DEBUG_OBJECT (gencamsrc, "create frames");
 
-  if (gencamsrc_create (buf, &mapInfo, (GstBaseSrc *) gencamsrc)) {
+  if (gencamsrc_create (buf, (GstBaseSrc *) gencamsrc)) {
     // Set DTS to none
     // PTS is set inside the create function above
     GST_BUFFER_DTS (*buf) = GST_CLOCK_TIME_NONE;
     gst_object_sync_values (GST_OBJECT (src), GST_BUFFER_PTS (*buf));
-    gst_buffer_unmap (*buf, &mapInfo);
 
     // Set frame offset
     GST_BUFFER_OFFSET (*buf) = gencamsrc->frameNumber;
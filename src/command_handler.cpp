@@ -200,6 +200,10 @@ msg_envelope_elem_body_t* CommandHandler::process_command(msg_envelope_elem_body
             cmnd = STOP_INGESTION;
         } else if (!command_name_str.compare("SNAPSHOT")) {
             cmnd = SNAPSHOT;
+        } else if (!command_name_str.compare("GET_STATS")) {
+            cmnd = GET_STATS;
+        } else if (!command_name_str.compare("DUMP_CLIP")) {
+            cmnd = DUMP_CLIP;
         }
 
         msg_envelope_elem_body_t *final_reply_payload;
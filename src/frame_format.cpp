@@ -0,0 +1,164 @@
+// Copyright (c) 2020 Intel Corporation.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM,OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+/**
+ * @file
+ * @brief Pixel format conversion and meta-data implementation
+ */
+
+#include <string.h>
+#include <eii/utils/logger.h>
+#include "eii/vi/frame_format.h"
+
+using namespace eii::vi;
+using namespace eii::udf;
+
+static const char* PIXEL_FORMAT_NAMES[] = {NULL, "BGR", "GRAY8", "NV12", "I420"};
+
+const char* eii::vi::pixel_format_name(PixelFormat format) {
+    return PIXEL_FORMAT_NAMES[format];
+}
+
+PixelFormat eii::vi::pixel_format_from_name(const char* name) {
+    for (int i = PIXEL_FORMAT_BGR; i <= PIXEL_FORMAT_I420; i++) {
+        if (strcmp(name, PIXEL_FORMAT_NAMES[i]) == 0)
+            return (PixelFormat) i;
+    }
+    return PIXEL_FORMAT_UNKNOWN;
+}
+
+bool eii::vi::is_packed_bgr(const FrameFormat& fmt) {
+    return fmt.format == PIXEL_FORMAT_BGR && fmt.offset[0] == 0 &&
+           fmt.stride[0] == fmt.width * 3;
+}
+
+void eii::vi::frame_geometry(const FrameFormat& fmt, int& width, int& height, int& channels) {
+    if (is_packed_bgr(fmt)) {
+        width = fmt.width;
+        height = fmt.height;
+        channels = 3;
+    } else if (fmt.format == PIXEL_FORMAT_GRAY8 && fmt.offset[0] == 0 &&
+               fmt.stride[0] == fmt.width) {
+        width = fmt.width;
+        height = fmt.height;
+        channels = 1;
+    } else {
+        width = fmt.stride[0];
+        height = (int) (fmt.size / fmt.stride[0]);
+        channels = 1;
+    }
+}
+
+static msg_envelope_elem_body_t* int_array(const int64_t* values, int count) {
+    msg_envelope_elem_body_t* arr = msgbus_msg_envelope_new_array();
+    if (arr == NULL)
+        return NULL;
+    for (int i = 0; i < count; i++) {
+        msg_envelope_elem_body_t* elem = msgbus_msg_envelope_new_integer(values[i]);
+        if (elem == NULL || msgbus_msg_envelope_elem_array_add(arr, elem) != MSG_SUCCESS) {
+            if (elem != NULL)
+                msgbus_msg_envelope_elem_destroy(elem);
+            msgbus_msg_envelope_elem_destroy(arr);
+            return NULL;
+        }
+    }
+    return arr;
+}
+
+static bool put_elem(msg_envelope_t* meta, const char* key, msg_envelope_elem_body_t* elem) {
+    if (elem == NULL)
+        return false;
+    if (msgbus_msg_envelope_put(meta, key, elem) != MSG_SUCCESS) {
+        msgbus_msg_envelope_elem_destroy(elem);
+        return false;
+    }
+    return true;
+}
+
+bool eii::vi::put_format_meta(Frame* frame, const FrameFormat& fmt) {
+    msg_envelope_t* meta = frame->get_meta_data();
+    if (meta == NULL)
+        return false;
+    int64_t offsets[FRAME_FORMAT_MAX_PLANES];
+    int64_t strides[FRAME_FORMAT_MAX_PLANES];
+    for (int i = 0; i < fmt.n_planes; i++) {
+        offsets[i] = fmt.offset[i];
+        strides[i] = fmt.stride[i];
+    }
+    return put_elem(meta, PIXEL_FORMAT_META,
+                    msgbus_msg_envelope_new_string(pixel_format_name(fmt.format))) &&
+           put_elem(meta, IMAGE_WIDTH_META, msgbus_msg_envelope_new_integer(fmt.width)) &&
+           put_elem(meta, IMAGE_HEIGHT_META, msgbus_msg_envelope_new_integer(fmt.height)) &&
+           put_elem(meta, PLANE_OFFSETS_META, int_array(offsets, fmt.n_planes)) &&
+           put_elem(meta, PLANE_STRIDES_META, int_array(strides, fmt.n_planes));
+}
+
+/**
+ * Plane of a buffer as a single channel Mat, without copy
+ */
+static cv::Mat plane(const void* data, const FrameFormat& fmt, int i, int rows, int cols) {
+    return cv::Mat(rows, cols, CV_8UC1, (uint8_t*) data + fmt.offset[i], fmt.stride[i]);
+}
+
+void eii::vi::convert_to_bgr(const void* data, const FrameFormat& fmt, cv::Mat& bgr) {
+    int w = fmt.width;
+    int h = fmt.height;
+    switch (fmt.format) {
+        case PIXEL_FORMAT_BGR:
+            cv::Mat(h, w, CV_8UC3, (uint8_t*) data + fmt.offset[0], fmt.stride[0]).copyTo(bgr);
+            break;
+        case PIXEL_FORMAT_GRAY8:
+            cv::cvtColor(plane(data, fmt, 0, h, w), bgr, cv::COLOR_GRAY2BGR);
+            break;
+        case PIXEL_FORMAT_NV12:
+            cv::cvtColorTwoPlane(plane(data, fmt, 0, h, w),
+                                 cv::Mat(h / 2, w / 2, CV_8UC2,
+                                         (uint8_t*) data + fmt.offset[1], fmt.stride[1]),
+                                 bgr, cv::COLOR_YUV2BGR_NV12);
+            break;
+        case PIXEL_FORMAT_I420: {
+            // The converter takes the three planes stacked without padding
+            bool packed = fmt.stride[0] == w && fmt.stride[1] == w / 2 &&
+                          fmt.stride[2] == w / 2 && fmt.offset[0] == 0 &&
+                          fmt.offset[1] == (size_t) w * h &&
+                          fmt.offset[2] == fmt.offset[1] + (size_t) w * h / 4;
+            if (packed) {
+                cv::cvtColor(cv::Mat(h * 3 / 2, w, CV_8UC1, (void*) data), bgr,
+                             cv::COLOR_YUV2BGR_I420);
+            } else {
+                cv::Mat yuv(h * 3 / 2, w, CV_8UC1);
+                cv::Mat y = yuv.rowRange(0, h);
+                cv::Mat chroma = yuv.rowRange(h, h * 3 / 2).reshape(1, h);
+                cv::Mat u = chroma.rowRange(0, h / 2);
+                cv::Mat v = chroma.rowRange(h / 2, h);
+                plane(data, fmt, 0, h, w).copyTo(y);
+                plane(data, fmt, 1, h / 2, w / 2).copyTo(u);
+                plane(data, fmt, 2, h / 2, w / 2).copyTo(v);
+                cv::cvtColor(yuv, bgr, cv::COLOR_YUV2BGR_I420);
+            }
+            break;
+        }
+        default: {
+            const char* err = "Unsupported pixel format";
+            LOG_ERROR("%s", err);
+            throw(err);
+        }
+    }
+}
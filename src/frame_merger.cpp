@@ -0,0 +1,107 @@
+// Copyright (c) 2020 Intel Corporation.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM,OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+/**
+ * @file
+ * @brief FrameMerger implementation
+ */
+
+#include "eii/vi/frame_merger.h"
+
+using namespace eii::vi;
+using namespace eii::utils;
+
+FrameMerger::FrameMerger(FrameQueue* output) :
+    m_output(output), m_pending(false), m_stop(false), m_th(NULL)
+{}
+
+FrameMerger::~FrameMerger() {
+    stop();
+    for (auto queue : m_inputs)
+        delete queue;
+}
+
+FrameQueue* FrameMerger::add_input(size_t queue_size, bool lockfree) {
+    FrameQueue* queue = new FrameQueue(queue_size, lockfree);
+    m_inputs.push_back(queue);
+    return queue;
+}
+
+const std::vector<FrameQueue*>& FrameMerger::get_inputs() const {
+    return m_inputs;
+}
+
+void FrameMerger::notify() {
+    {
+        std::lock_guard<std::mutex> lk(m_mtx);
+        m_pending = true;
+    }
+    m_cv.notify_one();
+}
+
+void FrameMerger::start() {
+    if (m_th != NULL)
+        return;
+    m_stop = false;
+    m_th = new std::thread(&FrameMerger::run, this);
+}
+
+void FrameMerger::stop() {
+    if (m_th == NULL)
+        return;
+    {
+        std::lock_guard<std::mutex> lk(m_mtx);
+        m_stop = true;
+    }
+    m_cv.notify_one();
+    m_th->join();
+    delete m_th;
+    m_th = NULL;
+}
+
+void FrameMerger::run() {
+    size_t count = m_inputs.size();
+    size_t next = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lk(m_mtx);
+            m_cv.wait(lk, [this] { return m_stop || m_pending; });
+            if (m_stop)
+                break;
+            m_pending = false;
+        }
+        // The frames pushed before the wake up are in their queues, which
+        // are served in turn until they are all empty. A frame pushed
+        // meanwhile signals again, so the frames evicted by an ingestor need
+        // no accounting. Each turn starts after the queue served last.
+        bool taken = true;
+        while (taken && !m_stop) {
+            taken = false;
+            for (size_t i = 0; i < count && !taken; i++) {
+                udf::Frame* frame = NULL;
+                if (!m_inputs[(next + i) % count]->pop_front(frame))
+                    continue;
+                next = (next + i + 1) % count;
+                m_output->push_wait(frame);
+                taken = true;
+            }
+        }
+    }
+}
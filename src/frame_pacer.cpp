@@ -0,0 +1,116 @@
+// Copyright (c) 2020 Intel Corporation.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM,OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+/**
+ * @file
+ * @brief FramePacer implementation
+ */
+
+#include <errno.h>
+#include <string.h>
+#include "eii/vi/frame_pacer.h"
+
+#define NSEC_PER_SEC 1000000000LL
+
+// Falling behind by more than this many periods restarts the schedule
+// instead of releasing a burst of frames
+#define MAX_CATCH_UP_PERIODS 10
+
+using namespace eii::vi;
+
+static int64_t now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t) ts.tv_sec * NSEC_PER_SEC + ts.tv_nsec;
+}
+
+FramePacer::FramePacer(double period_s, PacingPolicy policy) :
+    m_period_ns(0), m_policy(policy), m_next_ns(0), m_jitter_sum_ns(0), m_slept(0) {
+    memset(&m_stats, 0, sizeof(m_stats));
+    configure(period_s, policy);
+}
+
+void FramePacer::configure(double period_s, PacingPolicy policy) {
+    m_period_ns = (period_s > 0.0) ? (int64_t) (period_s * NSEC_PER_SEC) : 0;
+    m_policy = policy;
+    m_next_ns = 0;
+}
+
+void FramePacer::set_period(double period_s) {
+    configure(period_s, m_policy);
+}
+
+bool FramePacer::enabled() const {
+    return m_period_ns > 0;
+}
+
+void FramePacer::reset() {
+    m_next_ns = 0;
+}
+
+void FramePacer::wait() {
+    if (m_period_ns <= 0)
+        return;
+
+    int64_t now = now_ns();
+    if (m_next_ns == 0) {
+        m_next_ns = now + m_period_ns;
+        std::lock_guard<std::mutex> lck(m_mtx);
+        m_stats.frames++;
+        return;
+    }
+
+    if (now >= m_next_ns) {
+        // The frame took longer than its period
+        int64_t missed = (now - m_next_ns) / m_period_ns;
+        if (m_policy == PACING_SKIP || missed >= MAX_CATCH_UP_PERIODS) {
+            m_next_ns += (missed + 1) * m_period_ns;
+        } else {
+            m_next_ns += m_period_ns;
+            missed = 0;
+        }
+        std::lock_guard<std::mutex> lck(m_mtx);
+        m_stats.frames++;
+        m_stats.late_frames++;
+        m_stats.skipped_periods += missed;
+        return;
+    }
+
+    struct timespec deadline;
+    deadline.tv_sec = m_next_ns / NSEC_PER_SEC;
+    deadline.tv_nsec = m_next_ns % NSEC_PER_SEC;
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL) == EINTR) {}
+
+    int64_t jitter = now_ns() - m_next_ns;
+    m_next_ns += m_period_ns;
+
+    std::lock_guard<std::mutex> lck(m_mtx);
+    m_stats.frames++;
+    m_slept++;
+    m_jitter_sum_ns += jitter;
+    m_stats.jitter_avg_ns = m_jitter_sum_ns / m_slept;
+    if (jitter > m_stats.jitter_max_ns)
+        m_stats.jitter_max_ns = jitter;
+}
+
+PacingStats FramePacer::get_stats() {
+    std::lock_guard<std::mutex> lck(m_mtx);
+    return m_stats;
+}
@@ -0,0 +1,156 @@
+// Copyright (c) 2020 Intel Corporation.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM,OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+/**
+ * @file
+ * @brief MatPool implementation
+ */
+
+#include <stdlib.h>
+#include <unistd.h>
+#include <eii/utils/logger.h>
+#include "eii/vi/frame_pool.h"
+
+using namespace eii::vi;
+
+MatPool::MatPool(size_t capacity) :
+    m_capacity(capacity), m_closed(false), m_rows(0), m_cols(0), m_type(0) {
+    m_hits.store(0);
+    m_misses.store(0);
+    m_free.reserve(capacity);
+}
+
+MatPool::~MatPool() {
+    close();
+}
+
+void MatPool::wrap(PooledMat* pm, int rows, int cols, int type) {
+    static const size_t page_size = sysconf(_SC_PAGESIZE);
+    size_t size = (size_t) rows * cols * CV_ELEM_SIZE(type);
+    size = (size + page_size - 1) & ~(page_size - 1);
+
+    pm->mat.release();
+    free(pm->buf);
+    pm->buf = NULL;
+    if (posix_memalign(&pm->buf, page_size, size) != 0) {
+        const char* err = "Failed to allocate frame buffer";
+        LOG_ERROR("%s", err);
+        pm->buf = NULL;
+        throw(err);
+    }
+    pm->mat = cv::Mat(rows, cols, type, pm->buf);
+}
+
+void MatPool::destroy(PooledMat* pm) {
+    pm->mat.release();
+    free(pm->buf);
+    delete pm;
+}
+
+PooledMat* MatPool::acquire() {
+    PooledMat* pm = NULL;
+    int rows = 0;
+    int cols = 0;
+    int type = 0;
+    {
+        std::lock_guard<std::mutex> lck(m_mtx);
+        if (!m_free.empty()) {
+            pm = m_free.back();
+            m_free.pop_back();
+        }
+        rows = m_rows;
+        cols = m_cols;
+        type = m_type;
+    }
+
+    if (pm != NULL) {
+        m_hits++;
+    } else {
+        m_misses++;
+        pm = new PooledMat();
+        pm->buf = NULL;
+        // Before the first frame, the decoder allocates the Mat itself and
+        // the pool learns the geometry when it is returned
+        if (rows > 0)
+            wrap(pm, rows, cols, type);
+    }
+    pm->pool = shared_from_this();
+    return pm;
+}
+
+void MatPool::release(PooledMat* pm) {
+    if (pm->mat.data != pm->buf) {
+        // The decoder allocated its own buffer, first frame or new resolution
+        if (pm->mat.empty() || pm->mat.dims != 2) {
+            destroy(pm);
+            return;
+        }
+        int rows = pm->mat.rows;
+        int cols = pm->mat.cols;
+        int type = pm->mat.type();
+        wrap(pm, rows, cols, type);
+
+        std::lock_guard<std::mutex> lck(m_mtx);
+        m_rows = rows;
+        m_cols = cols;
+        m_type = type;
+    }
+
+    {
+        std::lock_guard<std::mutex> lck(m_mtx);
+        if (!m_closed && m_free.size() < m_capacity) {
+            m_free.push_back(pm);
+            return;
+        }
+    }
+    destroy(pm);
+}
+
+void MatPool::close() {
+    std::vector<PooledMat*> free_list;
+    {
+        std::lock_guard<std::mutex> lck(m_mtx);
+        m_closed = true;
+        free_list.swap(m_free);
+    }
+    for (auto pm : free_list)
+        destroy(pm);
+}
+
+uint64_t MatPool::get_hits() const {
+    return m_hits.load();
+}
+
+uint64_t MatPool::get_misses() const {
+    return m_misses.load();
+}
+
+void MatPool::free_pooled_mat(void* obj) {
+    PooledMat* pm = (PooledMat*) obj;
+    // Keeps the pool alive while the Mat is returned, the Mats in the free
+    // list do not reference the pool
+    std::shared_ptr<MatPool> pool = std::move(pm->pool);
+    try {
+        pool->release(pm);
+    } catch (const char* err) {
+        LOG_ERROR("Failed to return frame to the pool: %s", err);
+        destroy(pm);
+    }
+}
@@ -0,0 +1,173 @@
+// Copyright (c) 2020 Intel Corporation.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM,OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+/**
+ * @file
+ * @brief FramePublisher Implementation
+ */
+
+#include <chrono>
+#include "eii/vi/frame_publisher.h"
+
+using namespace eii::vi;
+using namespace eii::udf;
+
+FramePublisher::FramePublisher(config_t* msgbus_config, std::condition_variable& err_cv, FrameQueue* queue, FrameStamps* frame_stamps) :
+    m_msgbus_ctx(NULL), m_frame_stamps(frame_stamps), m_queue(queue), m_th(NULL), m_err_cv(err_cv),
+    m_startup_ns(0) {
+    m_stop.store(false);
+    m_first_frame_ns.store(0);
+    m_msgbus_ctx = msgbus_initialize(msgbus_config);
+    if (m_msgbus_ctx == NULL) {
+        const char* err = "Failed to initialize message bus for publisher";
+        LOG_ERROR("%s", err);
+        throw(err);
+    }
+}
+
+FramePublisher::FramePublisher(const FramePublisher& src) : m_err_cv(src.m_err_cv) {
+    throw "This object should not be copied";
+}
+
+FramePublisher& FramePublisher::operator=(const FramePublisher& src) {
+    return *this;
+}
+
+void FramePublisher::add_topic(const std::string& name, const std::string& topic) {
+    if (m_routes.find(name) != m_routes.end()) {
+        const char* err = "Ingestor names must be unique";
+        LOG_ERROR("%s: %s", err, name.c_str());
+        throw(err);
+    }
+    publisher_ctx_t* pub_ctx = NULL;
+    msgbus_ret_t ret = msgbus_publisher_new(m_msgbus_ctx, topic.c_str(), &pub_ctx);
+    if (ret != MSG_SUCCESS) {
+        const char* err = "Failed to initialize publisher";
+        LOG_ERROR("%s for topic %s", err, topic.c_str());
+        throw(err);
+    }
+    PublisherRoute* route = new PublisherRoute();
+    route->pub_ctx = pub_ctx;
+    m_routes[name] = route;
+    LOG_INFO("Publishing frames of ingestor %s on topic %s", name.c_str(), topic.c_str());
+}
+
+void FramePublisher::run() {
+    LOG_DEBUG_0("Frame publisher thread started");
+    auto duration = std::chrono::milliseconds(250);
+    msg_envelope_elem_body_t* name = NULL;
+    msgbus_ret_t ret;
+    int64_t pushed_ns = 0;
+
+    while (!m_stop.load()) {
+        if (!m_queue->wait_for(duration))
+            continue;
+        Frame* frame = m_queue->front();
+        m_queue->pop();
+        int64_t start_ns = latency_now_ns();
+
+        ret = msgbus_msg_envelope_get(frame->get_meta_data(), INGESTOR_NAME_META, &name);
+        auto it = (ret == MSG_SUCCESS && name->type == MSG_ENV_DT_STRING) ?
+            m_routes.find(name->body.string) : m_routes.find("");
+        if (it == m_routes.end()) {
+            LOG_ERROR_0("Dropping frame of an unknown ingestor");
+            delete frame;
+            continue;
+        }
+        PublisherRoute* route = it->second;
+        if (m_frame_stamps != NULL && m_frame_stamps->get(frame, pushed_ns))
+            route->udf_latency.record(start_ns - pushed_ns);
+
+        msg_envelope_t* msg = frame->serialize();
+        delete frame;
+        if (msg == NULL) {
+            LOG_ERROR_0("Failed to serialize frame");
+            continue;
+        }
+        ret = msgbus_publisher_publish(m_msgbus_ctx, route->pub_ctx, msg);
+        msgbus_msg_envelope_destroy(msg);
+        route->publish_latency.record(latency_now_ns() - start_ns);
+        if (ret != MSG_SUCCESS) {
+            LOG_ERROR("Failed to publish frame: %d", ret);
+            m_err_cv.notify_all();
+            break;
+        }
+        if (m_first_frame_ns.load() == 0) {
+            int64_t now_ns = latency_now_ns();
+            m_first_frame_ns.store(now_ns);
+            if (m_startup_ns != 0) {
+                LOG_INFO("First frame published %.1f ms after the startup",
+                         (now_ns - m_startup_ns) / 1e6);
+            }
+        }
+    }
+    LOG_DEBUG_0("Frame publisher thread stopped");
+}
+
+void FramePublisher::set_startup_ns(int64_t startup_ns) {
+    m_startup_ns = startup_ns;
+}
+
+int64_t FramePublisher::get_time_to_first_frame() const {
+    int64_t first_frame_ns = m_first_frame_ns.load();
+    if (first_frame_ns == 0 || m_startup_ns == 0)
+        return -1;
+    return first_frame_ns - m_startup_ns;
+}
+
+void FramePublisher::start() {
+    if (m_th != NULL)
+        return;
+    m_stop.store(false);
+    m_th = new std::thread(&FramePublisher::run, this);
+}
+
+void FramePublisher::stop() {
+    if (m_th == NULL)
+        return;
+    m_stop.store(true);
+    m_th->join();
+    delete m_th;
+    m_th = NULL;
+}
+
+FramePublisher::~FramePublisher() {
+    stop();
+    for (auto& it : m_routes) {
+        msgbus_publisher_destroy(m_msgbus_ctx, it.second->pub_ctx);
+        delete it.second;
+    }
+    if (m_msgbus_ctx != NULL)
+        msgbus_destroy(m_msgbus_ctx);
+}
+
+const LatencyHistogram* FramePublisher::get_latency(const std::string& name, LatencyStage stage) const {
+    auto it = m_routes.find(name);
+    if (it == m_routes.end())
+        return NULL;
+    switch (stage) {
+        case STAGE_UDF:
+            return &it->second->udf_latency;
+        case STAGE_PUBLISH:
+            return &it->second->publish_latency;
+        default:
+            return NULL;
+    }
+}
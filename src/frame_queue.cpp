@@ -0,0 +1,124 @@
+// Copyright (c) 2020 Intel Corporation.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM,OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+/**
+ * @file
+ * @brief FrameQueue implementation
+ */
+
+#include "eii/vi/frame_queue.h"
+
+using namespace eii::vi;
+using namespace eii::utils;
+using namespace eii::udf;
+
+FrameQueue::FrameQueue(size_t max_size, bool lockfree) :
+    ThreadSafeQueue<Frame*>(max_size), m_lockfree(NULL)
+{
+    if (lockfree)
+        m_lockfree = new LockFreeQueue<Frame*>(max_size, MULTI_PRODUCER);
+}
+
+FrameQueue::~FrameQueue() {
+    delete m_lockfree;
+}
+
+bool FrameQueue::is_lockfree() const {
+    return m_lockfree != NULL;
+}
+
+QueueRetCode FrameQueue::push(Frame* frame) {
+    if (m_lockfree == NULL)
+        return ThreadSafeQueue<Frame*>::push(frame);
+    return m_lockfree->push(frame);
+}
+
+QueueRetCode FrameQueue::push_wait(Frame* frame) {
+    if (m_lockfree == NULL)
+        return ThreadSafeQueue<Frame*>::push_wait(frame);
+    return m_lockfree->push_wait(frame);
+}
+
+Frame* FrameQueue::front() {
+    if (m_lockfree == NULL)
+        return ThreadSafeQueue<Frame*>::front();
+    Frame* frame = NULL;
+    m_lockfree->peek(frame);
+    return frame;
+}
+
+void FrameQueue::pop() {
+    if (m_lockfree == NULL) {
+        ThreadSafeQueue<Frame*>::pop();
+        return;
+    }
+    Frame* frame = NULL;
+    m_lockfree->pop(frame);
+}
+
+bool FrameQueue::empty() {
+    if (m_lockfree == NULL)
+        return ThreadSafeQueue<Frame*>::empty();
+    // A pushing thread may have claimed the head slot without filling it
+    // yet, so the size alone does not tell
+    Frame* frame = NULL;
+    return !m_lockfree->peek(frame);
+}
+
+size_t FrameQueue::size() {
+    if (m_lockfree == NULL)
+        return ThreadSafeQueue<Frame*>::size();
+    return m_lockfree->size();
+}
+
+bool FrameQueue::pop_head(Frame*& frame) {
+    if (m_lockfree != NULL)
+        return m_lockfree->pop(frame);
+    if (ThreadSafeQueue<Frame*>::empty())
+        return false;
+    frame = ThreadSafeQueue<Frame*>::front();
+    ThreadSafeQueue<Frame*>::pop();
+    return true;
+}
+
+bool FrameQueue::push_evict(Frame* frame, std::vector<Frame*>& evicted) {
+    std::lock_guard<std::mutex> lk(m_evict_mtx);
+    while (push(frame) != QueueRetCode::SUCCESS) {
+        Frame* oldest = NULL;
+        if (!pop_head(oldest)) {
+            // The head of a lock-free queue is still being filled
+            evicted.push_back(frame);
+            return false;
+        }
+        evicted.push_back(oldest);
+    }
+    return true;
+}
+
+bool FrameQueue::pop_front(Frame*& frame) {
+    std::lock_guard<std::mutex> lk(m_evict_mtx);
+    return pop_head(frame);
+}
+
+bool FrameQueue::wait_for(std::chrono::milliseconds timeout) {
+    if (m_lockfree == NULL)
+        return ThreadSafeQueue<Frame*>::wait_for(timeout);
+    return m_lockfree->wait_for(timeout);
+}
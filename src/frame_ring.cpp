@@ -0,0 +1,88 @@
+// Copyright (c) 2020 Intel Corporation.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM,OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+/**
+ * @file
+ * @brief FrameRing implementation
+ */
+
+#include "eii/vi/frame_ring.h"
+
+using namespace eii::vi;
+
+FrameRing::FrameRing(double seconds, size_t max_bytes) :
+    m_max_ns((int64_t) (seconds * 1e9)), m_max_bytes(max_bytes),
+    m_bytes(0), m_evicted(0)
+{}
+
+void FrameRing::push(const ClipFrame& frame) {
+    // Releasing a frame can be slow, the evicted ones are released
+    // outside of the lock
+    std::vector<ClipFrame> evicted;
+    {
+        std::lock_guard<std::mutex> lk(m_mtx);
+        m_frames.push_back(frame);
+        m_bytes += frame.size;
+        while (m_frames.size() > 1) {
+            const ClipFrame& oldest = m_frames.front();
+            bool too_old = m_max_ns > 0 && frame.time_ns - oldest.time_ns > m_max_ns;
+            bool too_big = m_max_bytes > 0 && m_bytes > m_max_bytes;
+            if (!too_old && !too_big)
+                break;
+            m_bytes -= oldest.size;
+            evicted.push_back(std::move(m_frames.front()));
+            m_frames.pop_front();
+            m_evicted++;
+        }
+    }
+}
+
+size_t FrameRing::get_window(int64_t start_ns, int64_t end_ns, std::vector<ClipFrame>& frames) {
+    std::lock_guard<std::mutex> lk(m_mtx);
+    size_t count = 0;
+    for (auto& frame : m_frames) {
+        if (frame.time_ns < start_ns)
+            continue;
+        if (frame.time_ns > end_ns)
+            break;
+        frames.push_back(frame);
+        count++;
+    }
+    return count;
+}
+
+void FrameRing::clear() {
+    // Released once the lock is dropped
+    std::deque<ClipFrame> frames;
+    std::lock_guard<std::mutex> lk(m_mtx);
+    frames.swap(m_frames);
+    m_bytes = 0;
+}
+
+ClipStats FrameRing::get_stats() {
+    std::lock_guard<std::mutex> lk(m_mtx);
+    ClipStats stats;
+    stats.frames = m_frames.size();
+    stats.bytes = m_bytes;
+    stats.seconds = m_frames.empty() ? 0.0 :
+        (m_frames.back().time_ns - m_frames.front().time_ns) / 1e9;
+    stats.evicted = m_evicted;
+    return stats;
+}
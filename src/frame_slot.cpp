@@ -0,0 +1,80 @@
+// Copyright (c) 2020 Intel Corporation.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM,OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+/**
+ * @file
+ * @brief LatestFrameSlot implementation
+ */
+
+#include <chrono>
+#include "eii/vi/frame_slot.h"
+
+using namespace eii::vi;
+
+LatestFrameSlot::LatestFrameSlot() :
+    m_frame(NULL), m_capture_ns(0), m_overwritten(0)
+{}
+
+LatestFrameSlot::~LatestFrameSlot() {
+    clear();
+}
+
+void LatestFrameSlot::put(udf::Frame* frame, int64_t capture_ns) {
+    udf::Frame* old = NULL;
+    {
+        std::lock_guard<std::mutex> lk(m_mtx);
+        old = m_frame;
+        m_frame = frame;
+        m_capture_ns = capture_ns;
+        if (old != NULL)
+            m_overwritten++;
+    }
+    m_cv.notify_all();
+    // Releasing a frame can be slow, it is done outside of the lock
+    delete old;
+}
+
+eii::udf::Frame* LatestFrameSlot::take(int64_t after_ns, int64_t timeout_ns, int64_t& capture_ns) {
+    std::unique_lock<std::mutex> lk(m_mtx);
+    bool ready = m_cv.wait_for(lk, std::chrono::nanoseconds(timeout_ns), [this, after_ns]() {
+        return m_frame != NULL && m_capture_ns > after_ns;
+    });
+    if (!ready)
+        return NULL;
+    udf::Frame* frame = m_frame;
+    capture_ns = m_capture_ns;
+    m_frame = NULL;
+    return frame;
+}
+
+void LatestFrameSlot::clear() {
+    udf::Frame* old = NULL;
+    {
+        std::lock_guard<std::mutex> lk(m_mtx);
+        old = m_frame;
+        m_frame = NULL;
+    }
+    delete old;
+}
+
+uint64_t LatestFrameSlot::get_overwritten() {
+    std::lock_guard<std::mutex> lk(m_mtx);
+    return m_overwritten;
+}
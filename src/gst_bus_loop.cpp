@@ -0,0 +1,118 @@
+// Copyright (c) 2020 Intel Corporation.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM,OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+/**
+ * @file
+ * @brief GLib main loop shared by the GStreamer ingestors implementation
+ */
+
+#include <mutex>
+#include <condition_variable>
+#include "eii/utils/logger.h"
+#include "eii/vi/gst_bus_loop.h"
+
+using namespace eii::vi;
+
+/**
+ * Watch removal handed over to the loop thread
+ */
+struct WatchRemoval {
+    GSource* watch;
+    std::mutex mtx;
+    std::condition_variable cv;
+    bool done;
+};
+
+static gboolean remove_watch_cb(gpointer data) {
+    WatchRemoval* removal = (WatchRemoval*) data;
+    g_source_destroy(removal->watch);
+    std::lock_guard<std::mutex> lk(removal->mtx);
+    removal->done = true;
+    removal->cv.notify_all();
+    return G_SOURCE_REMOVE;
+}
+
+static gboolean quit_cb(gpointer data) {
+    g_main_loop_quit((GMainLoop*) data);
+    return G_SOURCE_REMOVE;
+}
+
+GstBusLoop::GstBusLoop() {
+    static std::once_flag gst_init_flag;
+    std::call_once(gst_init_flag, []() { gst_init(NULL, NULL); });
+
+    m_ctx = g_main_context_new();
+    m_loop = g_main_loop_new(m_ctx, FALSE);
+    m_th = std::thread(&GstBusLoop::run, this);
+}
+
+GstBusLoop::~GstBusLoop() {
+    // Quitting from here could happen before the thread enters the loop,
+    // which would then run forever. The quit is dispatched by the loop.
+    g_main_context_invoke(m_ctx, quit_cb, m_loop);
+    m_th.join();
+    g_main_loop_unref(m_loop);
+    g_main_context_unref(m_ctx);
+    LOG_DEBUG_0("GStreamer bus loop stopped");
+}
+
+std::shared_ptr<GstBusLoop> GstBusLoop::get() {
+    static std::mutex mtx;
+    static std::weak_ptr<GstBusLoop> instance;
+
+    std::lock_guard<std::mutex> lk(mtx);
+    std::shared_ptr<GstBusLoop> loop = instance.lock();
+    if (!loop) {
+        loop = std::shared_ptr<GstBusLoop>(new GstBusLoop());
+        instance = loop;
+    }
+    return loop;
+}
+
+void GstBusLoop::run() {
+    LOG_DEBUG_0("GStreamer bus loop started");
+    g_main_context_push_thread_default(m_ctx);
+    g_main_loop_run(m_loop);
+    g_main_context_pop_thread_default(m_ctx);
+}
+
+GSource* GstBusLoop::add_watch(GstBus* bus, GstBusFunc func, gpointer data) {
+    GSource* watch = gst_bus_create_watch(bus);
+    if (watch == NULL)
+        return NULL;
+    g_source_set_callback(watch, (GSourceFunc) func, data, NULL);
+    g_source_attach(watch, m_ctx);
+    return watch;
+}
+
+void GstBusLoop::remove_watch(GSource* watch) {
+    if (watch == NULL)
+        return;
+    // Sources are dispatched one at a time by the loop thread, once the
+    // removal runs there the callback of the watch is not running either
+    WatchRemoval removal;
+    removal.watch = watch;
+    removal.done = false;
+    g_main_context_invoke(m_ctx, remove_watch_cb, &removal);
+    std::unique_lock<std::mutex> lk(removal.mtx);
+    removal.cv.wait(lk, [&removal]() { return removal.done; });
+    lk.unlock();
+    g_source_unref(watch);
+}
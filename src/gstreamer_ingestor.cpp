@@ -23,11 +23,12 @@
  * @brief Gstreamer Ingestor implementation
  */
 
-#ifdef WITH_PROFILE
-#include <chrono>
-#endif
-
 #include "eii/vi/gstreamer_ingestor.h"
+#include <gst/app/gstappsink.h>
+#include <gst/video/video.h>
+#include <memory>
+#include <chrono>
+#include <algorithm>
 #include <eii/udf/frame.h>
 #include <eii/utils/thread_safe_queue.h>
 #include <safe_lib.h>
@@ -36,27 +37,126 @@
 #include <random>
 #include <cstring>
 #include "eii/utils/logger.h"
-#include "eii/vi/gva_roi_meta.h"
+#include "eii/vi/gva_roi_codec.h"
 
 #define UUID_LENGTH 5
 #define PIPELINE "pipeline"
+#define APPSINK_MAX_BUFFERS "appsink_max_buffers"
+#define APPSINK_DROP "appsink_drop"
+#define APPSINK_SYNC "appsink_sync"
+#define DEFAULT_APPSINK_MAX_BUFFERS 2
+#define GVA_META_FORMAT "gva_meta_format"
+#define GVA_TENSOR_DATA "gva_tensor_data"
+#define APPSINKS "appsinks"
+#define RECONNECT "reconnect"
+#define RECONNECT_MIN_DELAY "reconnect_min_delay"
+#define RECONNECT_MAX_DELAY "reconnect_max_delay"
+#define STALL_FRAMES "stall_frames"
+#define CONNECT_TIMEOUT "connect_timeout"
+#define DEFAULT_RECONNECT_MIN_DELAY 0.5
+#define DEFAULT_RECONNECT_MAX_DELAY 30.0
+#define DEFAULT_STALL_FRAMES 10
+#define DEFAULT_CONNECT_TIMEOUT 10.0
+#define DEFAULT_SINK_NAME "sink"
+#define QUEUE_SIZE "queue_size"
+#define DEFAULT_QUEUE_SIZE 10
+
+// Timeout of the waits for samples, the appsink callbacks and stop() wake
+// the ingestor thread up before
+#define PULL_TIMEOUT std::chrono::milliseconds(100)
 
 using namespace eii::vi;
 using namespace eii::udf;
 
-static EncodeType g_enc_type;
-static bool g_first_frame = true;
-static int g_enc_lvl;
-// Prototypes
-static gboolean bus_call(GstBus* bus, GstMessage* msg, gpointer data);
+/**
+ * Optional boolean config value
+ * @return -1 if the key is missing, 0 or 1 otherwise
+ */
+static int get_bool(config_t* config, const char* key) {
+    config_value_t* cvt = config->get_config_value(config->cfg, key);
+    if (cvt == NULL)
+        return -1;
+    if (cvt->type != CVT_BOOLEAN) {
+        const char* err = "JSON value must be a boolean";
+        LOG_ERROR("%s for \'%s\'", err, key);
+        config_value_destroy(cvt);
+        throw(err);
+    }
+    int value = cvt->body.boolean ? 1 : 0;
+    config_value_destroy(cvt);
+    return value;
+}
+
+/**
+ * Optional non-negative number config value
+ * @return default_value if the key is missing
+ */
+static double get_number(config_t* config, const char* key, double default_value) {
+    config_value_t* cvt = config->get_config_value(config->cfg, key);
+    if (cvt == NULL)
+        return default_value;
+    double value = -1.0;
+    if (cvt->type == CVT_INTEGER)
+        value = (double) cvt->body.integer;
+    else if (cvt->type == CVT_FLOATING)
+        value = cvt->body.floating;
+    config_value_destroy(cvt);
+    if (value < 0) {
+        const char* err = "JSON value must be a non-negative number";
+        LOG_ERROR("%s for \'%s\'", err, key);
+        throw(err);
+    }
+    return value;
+}
+
+/**
+ * Optional encoding of an appsink
+ */
+static void parse_encoding(config_value_t* cvt_encoding, EncodeType& enc_type, int& enc_lvl) {
+    if (cvt_encoding->type != CVT_OBJECT) {
+        const char* err = "appsink \"encoding\" value has to be an object";
+        throw(err);
+    }
+    config_value_t* cvt_type = config_value_object_get(cvt_encoding, "type");
+    if (cvt_type == NULL || cvt_type->type != CVT_STRING) {
+        const char* err = "appsink encoding \"type\" has to be a string";
+        if (cvt_type != NULL)
+            config_value_destroy(cvt_type);
+        throw(err);
+    }
+    EncodeType type;
+    if (strcmp(cvt_type->body.string, "jpeg") == 0) {
+        type = EncodeType::JPEG;
+    } else if (strcmp(cvt_type->body.string, "png") == 0) {
+        type = EncodeType::PNG;
+    } else if (strcmp(cvt_type->body.string, "none") == 0) {
+        type = EncodeType::NONE;
+    } else {
+        const char* err = "appsink encoding \"type\" must be jpeg, png or none";
+        config_value_destroy(cvt_type);
+        throw(err);
+    }
+    config_value_destroy(cvt_type);
+
+    int level = 0;
+    config_value_t* cvt_level = config_value_object_get(cvt_encoding, "level");
+    if (cvt_level != NULL) {
+        if (cvt_level->type != CVT_INTEGER) {
+            const char* err = "appsink encoding \"level\" has to be an integer";
+                config_value_destroy(cvt_level);
+            throw(err);
+        }
+        level = (int) cvt_level->body.integer;
+        config_value_destroy(cvt_level);
+    }
+    enc_type = type;
+    enc_lvl = level;
+}
 
 GstreamerIngestor::GstreamerIngestor(config_t* config, FrameQueue* frame_queue,
                                      std::string service_name, std::condition_variable& snapshot_cv,
                                      EncodeType enc_type, int enc_lvl):
     Ingestor(config, frame_queue, service_name, snapshot_cv, enc_type, enc_lvl) {
-    g_enc_type = enc_type;
-    g_enc_lvl = enc_lvl;
-
     config_value_t* cvt_pipeline = config->get_config_value(config->cfg, PIPELINE);
     LOG_INFO("cvt_pipeline initialized");
     if (cvt_pipeline == NULL) {
@@ -69,50 +169,230 @@ GstreamerIngestor::GstreamerIngestor(config_t* config, FrameQueue* frame_queue,
         throw(err);
     }
     m_pipeline = std::string(cvt_pipeline->body.string);
-    m_pipeline.append(" name=\"sink\"");
-    LOG_INFO("Pipeline: %s", m_pipeline.c_str());
     config_value_destroy(cvt_pipeline);
+    parse_branches(config);
+    LOG_INFO("Pipeline: %s", m_pipeline.c_str());
+
+    // -1 keeps the value set in the pipeline
+    m_max_buffers = -1;
+    config_value_t* cvt_max_buffers = config->get_config_value(config->cfg, APPSINK_MAX_BUFFERS);
+    if (cvt_max_buffers != NULL) {
+        if (cvt_max_buffers->type != CVT_INTEGER || cvt_max_buffers->body.integer < 0) {
+            const char* err = "JSON value must be a non-negative integer";
+            LOG_ERROR("%s for \'%s\'", err, APPSINK_MAX_BUFFERS);
+            config_value_destroy(cvt_max_buffers);
+            throw(err);
+        }
+        m_max_buffers = (int) cvt_max_buffers->body.integer;
+        config_value_destroy(cvt_max_buffers);
+    }
+    m_drop = get_bool(config, APPSINK_DROP);
+    m_sync = get_bool(config, APPSINK_SYNC);
+
+    m_gva_meta_format = GVA_META_FORMAT_JSON;
+    m_roi_size = 0;
+    config_value_t* cvt_gva_meta_format = config->get_config_value(config->cfg, GVA_META_FORMAT);
+    if (cvt_gva_meta_format != NULL) {
+        const char* format = (cvt_gva_meta_format->type == CVT_STRING) ?
+            cvt_gva_meta_format->body.string : "";
+        if (strcmp(format, "json") == 0) {
+            m_gva_meta_format = GVA_META_FORMAT_JSON;
+        } else if (strcmp(format, "binary") == 0) {
+            m_gva_meta_format = GVA_META_FORMAT_BINARY;
+        } else if (strcmp(format, "both") == 0) {
+            m_gva_meta_format = GVA_META_FORMAT_BOTH;
+        } else {
+            const char* err = "gva_meta_format must be json, binary or both";
+            LOG_ERROR("%s", err);
+            config_value_destroy(cvt_gva_meta_format);
+            throw(err);
+        }
+        config_value_destroy(cvt_gva_meta_format);
+    }
+
+    m_gva_tensor_data = (get_bool(config, GVA_TENSOR_DATA) == 1);
+
+    m_reconnect = (get_bool(config, RECONNECT) == 1);
+    m_reconnect_min_delay = get_number(config, RECONNECT_MIN_DELAY, DEFAULT_RECONNECT_MIN_DELAY);
+    m_reconnect_max_delay = get_number(config, RECONNECT_MAX_DELAY, DEFAULT_RECONNECT_MAX_DELAY);
+    if (m_reconnect_max_delay < m_reconnect_min_delay)
+        m_reconnect_max_delay = m_reconnect_min_delay;
+    m_stall_frames = (int64_t) get_number(config, STALL_FRAMES, DEFAULT_STALL_FRAMES);
+    m_connect_timeout = get_number(config, CONNECT_TIMEOUT, DEFAULT_CONNECT_TIMEOUT);
+    m_reconnects.store(0);
+    m_stalls.store(0);
+    m_downtime_ns.store(0);
+    m_down_since_ns.store(0);
+
+    // Frames in flight are bounded by the UDF input and output queues, plus
+    // the frames being converted and published
+    size_t queue_size = DEFAULT_QUEUE_SIZE;
+    config_value_t* cvt_queue_size = config->get_config_value(config->cfg, QUEUE_SIZE);
+    if (cvt_queue_size != NULL) {
+        if (cvt_queue_size->type == CVT_INTEGER && cvt_queue_size->body.integer > 0)
+            queue_size = cvt_queue_size->body.integer;
+        config_value_destroy(cvt_queue_size);
+    }
+    m_pool = std::make_shared<MatPool>(2 * queue_size + 2);
 
-    m_frame_count = 0;
-    m_bus_watch_id = 0;
+    m_pipeline_done.store(false);
+    m_samples_pending = false;
 
-    int argc = 1;
-    m_loop = NULL;
+    // Initializes GStreamer on first use
+    m_bus_loop = GstBusLoop::get();
+    m_bus_watch = NULL;
     m_gst_pipeline = NULL;
-    m_sink = NULL;
     m_snapshot = false;
-    char** argv = new char*[1];
-    gst_init(&argc, &argv);
 }
 
 GstreamerIngestor::~GstreamerIngestor() {
-    if (m_gst_pipeline != NULL)
-        gst_object_unref(GST_OBJECT(m_gst_pipeline));
-    if (m_bus_watch_id != 0)
-        g_source_remove(m_bus_watch_id);
-    if (m_loop != NULL)
-        g_main_loop_unref(m_loop);
-    // TODO: What about the m_sink? TO BE VERIFIED...
+    stop();
+    gstreamer_release();
+    m_pool->close();
+    for (auto branch : m_branches) {
+        if (branch->caps != NULL)
+            gst_caps_unref(branch->caps);
+        delete branch;
+    }
+}
+
+/**
+ * Branch of an appsink, with the encoding of the ingestor
+ */
+static AppsinkBranch* new_branch(const std::string& sink_name, EncodeType enc_type, int enc_lvl) {
+    AppsinkBranch* branch = new AppsinkBranch();
+    branch->sink_name = sink_name;
+    branch->sink = NULL;
+    branch->enc_type = enc_type;
+    branch->enc_lvl = enc_lvl;
+    branch->caps = NULL;
+    branch->frame_period_ns = 0;
+    branch->pool = NULL;
+    branch->pool_bounded = false;
+    branch->frame_count = 0;
+    branch->frames.store(0);
+    return branch;
+}
+
+void GstreamerIngestor::parse_branches(config_t* config) {
+    config_value_t* cvt_appsinks = config->get_config_value(config->cfg, APPSINKS);
+    if (cvt_appsinks == NULL) {
+        // Single appsink ending the pipeline, named by the ingestor
+        m_pipeline.append(" name=\"" DEFAULT_SINK_NAME "\"");
+        AppsinkBranch* branch = new_branch(DEFAULT_SINK_NAME, m_enc_type, m_enc_lvl);
+        branch->route = get_name();
+        m_branches.push_back(branch);
+        return;
+    }
+    if (cvt_appsinks->type != CVT_ARRAY || config_value_array_len(cvt_appsinks) == 0) {
+        const char* err = "\"appsinks\" value has to be a non-empty array";
+        LOG_ERROR("%s", err);
+        config_value_destroy(cvt_appsinks);
+        throw(err);
+    }
+    size_t len = config_value_array_len(cvt_appsinks);
+    for (size_t i = 0; i < len; i++) {
+        config_value_t* cvt_appsink = config_value_array_get(cvt_appsinks, i);
+        config_value_t* cvt_name = (cvt_appsink != NULL && cvt_appsink->type == CVT_OBJECT) ?
+            config_value_object_get(cvt_appsink, "name") : NULL;
+        if (cvt_name == NULL || cvt_name->type != CVT_STRING) {
+            const char* err = "\"name\" key is required for every appsink";
+            LOG_ERROR("%s", err);
+            if (cvt_name != NULL)
+                config_value_destroy(cvt_name);
+            if (cvt_appsink != NULL)
+                config_value_destroy(cvt_appsink);
+            config_value_destroy(cvt_appsinks);
+            throw(err);
+        }
+        AppsinkBranch* branch = new_branch(cvt_name->body.string, m_enc_type, m_enc_lvl);
+        config_value_destroy(cvt_name);
+        m_branches.push_back(branch);
+
+        // The first appsink is the main output of the ingestor, the others
+        // are routed by "<ingestor name>/<appsink name>"
+        if (i == 0) {
+            branch->route = get_name();
+        } else if (get_name().empty()) {
+            branch->route = branch->sink_name;
+        } else {
+            branch->route = get_name() + "/" + branch->sink_name;
+        }
+
+        const char* err = NULL;
+        config_value_t* cvt_topic = config_value_object_get(cvt_appsink, "topic");
+        if (cvt_topic != NULL) {
+            if (i == 0)
+                err = "the first appsink is published on the ingestor topic";
+            else if (cvt_topic->type != CVT_STRING)
+                err = "appsink \"topic\" value has to be a string";
+            else
+                branch->topic = cvt_topic->body.string;
+            config_value_destroy(cvt_topic);
+        } else if (i > 0) {
+            err = "\"topic\" key is required for every appsink but the first one";
+        }
+        config_value_t* cvt_encoding = (err == NULL) ?
+            config_value_object_get(cvt_appsink, "encoding") : NULL;
+        if (cvt_encoding != NULL) {
+            try {
+                parse_encoding(cvt_encoding, branch->enc_type, branch->enc_lvl);
+            } catch(const char* ex) {
+                err = ex;
+            }
+            config_value_destroy(cvt_encoding);
+        }
+        config_value_destroy(cvt_appsink);
+        if (err != NULL) {
+            LOG_ERROR("%s for appsink \'%s\'", err, branch->sink_name.c_str());
+            config_value_destroy(cvt_appsinks);
+            throw(err);
+        }
+    }
+    config_value_destroy(cvt_appsinks);
 }
 
 void GstreamerIngestor::gstreamer_init(bool snapshot_mode) {
     m_snapshot = snapshot_mode;
-    // Initialize Glib loop
-    m_loop = g_main_loop_new(NULL, FALSE);
-    // TODO: Verify correctly initialized
     // Load Gstreamer pipeline
     m_gst_pipeline = gst_parse_launch((char*)&m_pipeline[0], NULL);
-    // TODO: Verify correctly loaded
-    // Get and configure the sink element
-    m_sink = gst_bin_get_by_name(GST_BIN(m_gst_pipeline), "sink");
-    // TODO: Check that the sink was correctly found
-    g_object_set(m_sink, "emit-signals", TRUE, NULL);
-    gulong ret = g_signal_connect(m_sink, "new-sample", G_CALLBACK(this->new_sample), this);
-    if (!ret) {
-        const char* err = "Connection to GCallback not successfull";
+    if (m_gst_pipeline == NULL) {
+        const char* err = "Failed to load the pipeline";
         LOG_ERROR("%s", err);
         throw err;
     }
+    // Get and configure the sink elements
+    GstAppSinkCallbacks callbacks = {};
+    callbacks.eos = samples_pending;
+    callbacks.new_sample = new_sample;
+    for (auto branch : m_branches) {
+        branch->sink = gst_bin_get_by_name(GST_BIN(m_gst_pipeline), branch->sink_name.c_str());
+        if (branch->sink == NULL || !GST_IS_APP_SINK(branch->sink)) {
+            const char* err = (m_branches.size() == 1) ?
+                "Pipeline must end with an appsink" :
+                "Every appsinks entry must name an appsink of the pipeline";
+            LOG_ERROR("%s, \'%s\' not found", err, branch->sink_name.c_str());
+            throw err;
+        }
+        // Samples are pulled by the ingestor thread, the appsink queue
+        // decouples the streaming thread from the ingestor queue
+        GstAppSink* appsink = GST_APP_SINK(branch->sink);
+        gst_app_sink_set_emit_signals(appsink, FALSE);
+        gst_app_sink_set_callbacks(appsink, &callbacks, this, NULL);
+        if (m_max_buffers >= 0) {
+            gst_app_sink_set_max_buffers(appsink, (guint) m_max_buffers);
+        } else if (gst_app_sink_get_max_buffers(appsink) == 0) {
+            // Unbounded by default, bound it so a blocked ingestor queue
+            // still holds back the streaming thread
+            gst_app_sink_set_max_buffers(appsink, DEFAULT_APPSINK_MAX_BUFFERS);
+        }
+        if (m_drop >= 0)
+            gst_app_sink_set_drop(appsink, m_drop);
+        if (m_sync >= 0)
+            g_object_set(branch->sink, "sync", m_sync, NULL);
+        LOG_INFO("appsink %s max-buffers: %u, drop: %d", branch->sink_name.c_str(),
+                 gst_app_sink_get_max_buffers(appsink), gst_app_sink_get_drop(appsink));
+    }
     // Get the GST bus
     GstBus* bus = gst_pipeline_get_bus(GST_PIPELINE(m_gst_pipeline));
     if (bus == NULL) {
@@ -120,63 +400,287 @@ void GstreamerIngestor::gstreamer_init(bool snapshot_mode) {
         LOG_ERROR("%s", err);
         throw err;
     }
-    m_bus_watch_id = gst_bus_add_watch(bus, bus_call, m_loop);
+    m_pipeline_done.store(false);
+    m_bus_watch = m_bus_loop->add_watch(bus, bus_call, this);
     gst_object_unref(bus);
-    // TODO: Verify bus actions happened correctly
+    if (m_bus_watch == NULL) {
+        const char* err = "Failed to watch the GST bus";
+        LOG_ERROR("%s", err);
+        throw err;
+    }
 }
 
-void GstreamerIngestor::stop() {
-    if (m_loop != NULL)
-        g_main_loop_quit(m_loop);
-    // TODO: Should there be a wait here???
+void GstreamerIngestor::gstreamer_release() {
+    // No bus message reaches this ingestor once the watch is removed
+    m_bus_loop->remove_watch(m_bus_watch);
+    m_bus_watch = NULL;
+    // The appsink callbacks are not called anymore once the pipeline is
+    // stopped
     if (m_gst_pipeline != NULL)
         gst_element_set_state(m_gst_pipeline, GST_STATE_NULL);
+    for (auto branch : m_branches) {
+        if (branch->sink != NULL) {
+            gst_object_unref(branch->sink);
+            branch->sink = NULL;
+        }
+    }
+    if (m_gst_pipeline != NULL) {
+        gst_object_unref(GST_OBJECT(m_gst_pipeline));
+        m_gst_pipeline = NULL;
+    }
+}
+
+void GstreamerIngestor::gstreamer_pause() {
+    // Live sources stop producing in PAUSED but keep their device or
+    // connection open, so PLAYING resumes them without renegotiation
+    if (gst_element_set_state(m_gst_pipeline, GST_STATE_PAUSED) == GST_STATE_CHANGE_FAILURE) {
+        LOG_ERROR_0("Failed to pause the pipeline, releasing it");
+        gstreamer_release();
+        return;
+    }
+    // Samples queued before the stop would be stale on resume
+    for (auto branch : m_branches) {
+        GstSample* sample = NULL;
+        while ((sample = gst_app_sink_try_pull_sample(GST_APP_SINK(branch->sink), 0)) != NULL)
+            gst_sample_unref(sample);
+    }
+    LOG_INFO_0("Gstreamer pipeline paused");
+}
+
+void GstreamerIngestor::samples_pending(GstAppSink* sink, gpointer data) {
+    GstreamerIngestor* ingestor = (GstreamerIngestor*) data;
+    std::lock_guard<std::mutex> lk(ingestor->m_pull_mtx);
+    ingestor->m_samples_pending = true;
+    ingestor->m_pull_cv.notify_one();
+}
+
+GstFlowReturn GstreamerIngestor::new_sample(GstAppSink* sink, gpointer data) {
+    // The sample stays queued in the appsink until the ingestor pulls it
+    samples_pending(sink, data);
+    return GST_FLOW_OK;
+}
+
+void GstreamerIngestor::stop() {
+    if (!m_stop.load()) {
+        {
+            std::lock_guard<std::mutex> lk(m_pull_mtx);
+            m_stop.store(true);
+            m_pull_cv.notify_one();
+        }
+        // wait for the ingestor thread function run() to release the pipeline
+        if (m_th != NULL) {
+            if (m_th->joinable())
+                m_th->join();
+            delete m_th;
+            m_th = NULL;
+        }
+    }
+    m_running.store(false);
+    m_stop.store(false);
+}
+
+bool GstreamerIngestor::get_reconnect_stats(ReconnectStats& stats) const {
+    if (!m_reconnect)
+        return false;
+    int64_t down_since = m_down_since_ns.load();
+    int64_t downtime = m_downtime_ns.load();
+    if (down_since != 0)
+        downtime += latency_now_ns() - down_since;
+    stats.reconnects = m_reconnects.load();
+    stats.stalls = m_stalls.load();
+    stats.downtime = downtime / 1e9;
+    stats.connected = (down_since == 0);
+    return true;
+}
+
+bool GstreamerIngestor::get_pool_stats(PoolStats& stats) const {
+    stats.hits = m_pool->get_hits();
+    stats.misses = m_pool->get_misses();
+    return true;
+}
+
+std::vector<IngestorOutput> GstreamerIngestor::get_outputs() const {
+    std::vector<IngestorOutput> outputs;
+    if (m_branches.size() < 2)
+        return outputs;
+    for (auto branch : m_branches) {
+        IngestorOutput output;
+        output.name = branch->sink_name;
+        output.route = branch->route;
+        output.topic = branch->topic;
+        output.frames = branch->frames.load();
+        outputs.push_back(output);
+    }
+    return outputs;
 }
 
 // This method does nothing in this implementation since the frames are
-// retrieved via an async call from GStreamer
+// pulled from the appsink by run()
 void GstreamerIngestor::read(Frame*& frame) {}
 
+bool GstreamerIngestor::is_capture_open() const {
+    return m_gst_pipeline != NULL && !m_pipeline_done.load();
+}
+
 void GstreamerIngestor::run(bool snapshot_mode) {
 #ifdef WITH_PROFILE
     auto start = std::chrono::system_clock::now();
 #endif
     if (snapshot_mode) {
-        m_frame_count = 0;
+        for (auto branch : m_branches)
+            branch->frame_count = 0;
     }
-    LOG_INFO_0("Initializing Gstreamer pipeline");
-    gstreamer_init(snapshot_mode);
+    m_running.store(true);
     LOG_INFO_0("Gstreamer ingestor thread started");
-    gst_element_set_state(m_gst_pipeline, GST_STATE_PLAYING);
-    g_main_loop_run(m_loop);
+
+    // Supervisor, the UDFs and the publisher keep running while the
+    // pipeline is rebuilt
+    static const char* const END_NAMES[] = {"stopped", "ended", "failed", "stalled"};
+    double delay = m_reconnect_min_delay;
+    while (true) {
+        if (is_capture_open()) {
+            // Paused in warm standby by the previous run
+            LOG_INFO_0("Resuming Gstreamer pipeline");
+            m_snapshot = snapshot_mode;
+        } else {
+            // A pipeline failing while paused is rebuilt
+            gstreamer_release();
+            LOG_INFO_0("Initializing Gstreamer pipeline");
+            gstreamer_init(snapshot_mode);
+        }
+        int64_t last_sample_ns = 0;
+        PipelineEnd end = PIPELINE_ERROR;
+        if (gst_element_set_state(m_gst_pipeline, GST_STATE_PLAYING) != GST_STATE_CHANGE_FAILURE) {
+            end = pull_samples(last_sample_ns);
+        } else {
+            LOG_ERROR_0("Failed to start the pipeline");
+        }
+        if (m_warm_standby && end == PIPELINE_STOPPED) {
+            gstreamer_pause();
+            break;
+        }
+        gstreamer_release();
+
+        if (!m_reconnect || snapshot_mode || end == PIPELINE_STOPPED || m_stop.load())
+            break;
+
+        // The outage started with the last sample
+        if (m_down_since_ns.load() == 0)
+            m_down_since_ns.store(last_sample_ns > 0 ? last_sample_ns : latency_now_ns());
+        if (last_sample_ns > 0)
+            delay = m_reconnect_min_delay;
+        if (end == PIPELINE_STALLED)
+            m_stalls++;
+        LOG_WARN("Pipeline %s, restarting it in %.1f s", END_NAMES[end], delay);
+        {
+            std::unique_lock<std::mutex> lk(m_pull_mtx);
+            m_pull_cv.wait_for(lk, std::chrono::duration<double>(delay), [this]() {
+                return m_stop.load();
+            });
+        }
+        if (m_stop.load())
+            break;
+        delay = std::min(delay * 2, m_reconnect_max_delay);
+        m_reconnects++;
+    }
+
+    m_running.store(false);
     LOG_INFO_0("Gstreamer ingestor thread stopped");
 
 #ifdef WITH_PROFILE
-    // This code block will execute only when g_main_loop ends
+    // This code block will execute only when the pipeline ends
     // and it can be triggered by stopping the ingestor source
     auto end = std::chrono::system_clock::now();
+    int64_t frame_count = 0;
+    for (auto branch : m_branches)
+        frame_count += branch->frame_count;
     int elapsed = std::chrono::duration_cast<std::chrono::seconds>(
             end - start).count();
-    LOG_INFO("GStreamer FPS: %d", m_frame_count / elapsed);
+    LOG_INFO("GStreamer FPS: %ld", frame_count / elapsed);
     char* str_app_name = NULL;
     str_app_name = getenv("AppName");
     std::ofstream fps_file;
     fps_file.open("/var/tmp/fps.txt", std::ofstream::app);
-    fps_file << str_app_name << " FPS : " << (m_frame_count / elapsed) << std::endl;
+    fps_file << str_app_name << " FPS : " << (frame_count / elapsed) << std::endl;
     fps_file.close();
 #endif
 }
 
-/**
- * Gstreamer bus event callback
- */
-static gboolean bus_call(GstBus* bus, GstMessage* msg, gpointer data) {
-    GMainLoop *loop = (GMainLoop *) data;
+PipelineEnd GstreamerIngestor::pull_samples(int64_t& last_sample_ns) {
+    int64_t stall_check_ns = latency_now_ns();
+
+    // One thread pulls all the appsinks, so the frames of every branch go
+    // through the same overflow policy and statistics
+    while (!m_stop.load()) {
+        if (m_pipeline_done.load())
+            return PIPELINE_ERROR;
+        bool pulled = false;
+        bool eos = true;
+        for (auto branch : m_branches) {
+            GstAppSink* sink = GST_APP_SINK(branch->sink);
+            GstSample* sample = gst_app_sink_try_pull_sample(sink, 0);
+            if (sample != NULL) {
+                pulled = true;
+                eos = false;
+                last_sample_ns = latency_now_ns();
+                int64_t down_since = m_down_since_ns.exchange(0);
+                if (down_since != 0) {
+                    m_downtime_ns += last_sample_ns - down_since;
+                    LOG_INFO("Pipeline recovered after %.1f s",
+                             (last_sample_ns - down_since) / 1e9);
+                }
+                GstFlowReturn ret = process_sample(branch, sample);
+                // A snapshot ends the run once its frame is enqueued
+                if (ret == GST_FLOW_EOS)
+                    return m_snapshot ? PIPELINE_STOPPED : PIPELINE_EOS;
+                if (ret != GST_FLOW_OK)
+                    return PIPELINE_ERROR;
+            } else if (!gst_app_sink_is_eos(sink)) {
+                eos = false;
+            }
+        }
+        // End of stream is logged by the bus watch
+        if (eos)
+            return PIPELINE_EOS;
+        if (pulled) {
+            stall_check_ns = last_sample_ns;
+            continue;
+        }
+
+        if (m_reconnect && m_stall_frames > 0) {
+            // A stall is declared after m_stall_frames periods of the
+            // slowest appsink without any sample
+            int64_t timeout_ns = (int64_t) (m_connect_timeout * 1e9);
+            if (last_sample_ns > 0) {
+                int64_t period_ns = 0;
+                for (auto branch : m_branches)
+                    period_ns = std::max(period_ns, branch->frame_period_ns);
+                if (period_ns > 0)
+                    timeout_ns = m_stall_frames * period_ns;
+            }
+            if (latency_now_ns() - stall_check_ns > timeout_ns) {
+                LOG_WARN("No sample for %.1f s", timeout_ns / 1e9);
+                return PIPELINE_STALLED;
+            }
+        }
+
+        std::unique_lock<std::mutex> lk(m_pull_mtx);
+        m_pull_cv.wait_for(lk, PULL_TIMEOUT, [this]() {
+            return m_samples_pending || m_stop.load() || m_pipeline_done.load();
+        });
+        m_samples_pending = false;
+    }
+    return PIPELINE_STOPPED;
+}
+
+gboolean GstreamerIngestor::bus_call(GstBus* bus, GstMessage* msg, gpointer data) {
+    GstreamerIngestor* ingestor = (GstreamerIngestor*) data;
 
     switch (GST_MESSAGE_TYPE(msg)) {
         case GST_MESSAGE_EOS:
+            // The samples still queued in the appsinks are pulled until
+            // they report the end of stream
             LOG_INFO_0("End of stream");
-            g_main_loop_quit(loop);
             break;
         case GST_MESSAGE_ERROR: {
             gchar  *debug;
@@ -188,7 +692,11 @@ static gboolean bus_call(GstBus* bus, GstMessage* msg, gpointer data) {
             LOG_ERROR("Gst Bus Error: %s", error->message);
             g_error_free(error);
 
-            g_main_loop_quit(loop);
+            {
+                std::lock_guard<std::mutex> lk(ingestor->m_pull_mtx);
+                ingestor->m_pipeline_done.store(true);
+                ingestor->m_pull_cv.notify_one();
+            }
             break;
         }
         default:
@@ -213,6 +721,7 @@ public:
     ~GstreamerFrame() {
         gst_buffer_unmap(buf, info);
         gst_sample_unref(sample);
+        free(info);
     }
 };
 
@@ -225,314 +734,312 @@ void free_gst_frame(void* obj) {
 }
 
 /**
- * A new sample has been received in the appsink
+ * Method to release the sample referenced by a tensor blob
  */
-GstFlowReturn GstreamerIngestor::new_sample(GstElement *sink,
-GstreamerIngestor* ctx) {
-    GstSample* sample;
-    g_signal_emit_by_name(sink, "pull-sample", &sample);
+static void free_gst_sample(void* obj) {
+    gst_sample_unref((GstSample*) obj);
+}
+
+bool GstreamerIngestor::add_tensor_blobs(Frame* frame, GstSample* sample, GstBuffer* buf) {
+    gva_tensor_data(buf, m_tensors);
+    if (m_tensors.empty())
+        return true;
+
+    msg_envelope_elem_body_t* tensor_arr = msgbus_msg_envelope_new_array();
+    if (tensor_arr == NULL) {
+        LOG_ERROR_0("Failed to initialize gva tensors metadata");
+        return false;
+    }
+    for (const GvaTensorData& tensor : m_tensors) {
+        int blob = frame->get_number_of_frames();
+        msg_envelope_elem_body_t* tensor_obj = gva_tensor_to_envelope(tensor, blob);
+        if (tensor_obj == NULL) {
+            msgbus_msg_envelope_elem_destroy(tensor_arr);
+            return false;
+        }
+        if (msgbus_msg_envelope_elem_array_add(tensor_arr, tensor_obj) != MSG_SUCCESS) {
+            LOG_ERROR_0("Failed to add gva tensor metadata");
+            msgbus_msg_envelope_elem_destroy(tensor_obj);
+            msgbus_msg_envelope_elem_destroy(tensor_arr);
+            return false;
+        }
+        // The tensor data lives in the buffer meta-data, each blob holds
+        // the sample until it is published
+        frame->add_frame(
+                (void*) gst_sample_ref(sample), free_gst_sample,
+                (void*) tensor.data, (int) tensor.size, 1, 1);
+    }
+    msg_envelope_t* meta_data = frame->get_meta_data();
+    if (msgbus_msg_envelope_put(meta_data, GVA_TENSORS, tensor_arr) != MSG_SUCCESS) {
+        LOG_ERROR_0("Failed to put gva tensors metadata");
+        msgbus_msg_envelope_elem_destroy(tensor_arr);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Method to free the binary GVA meta-data of a frame blob
+ */
+static void free_roi_blob(void* obj) {
+    delete (std::vector<uint8_t>*) obj;
+}
+
+bool GstreamerIngestor::add_roi_blob(Frame* frame, GstBuffer* buf) {
+    // The encoding is published with the frame, so each frame has its own
+    // buffer, sized after the previous one to encode without reallocating
+    std::vector<uint8_t>* roi = new std::vector<uint8_t>();
+    roi->reserve(m_roi_size);
+    gva_roi_encode(buf, *roi);
+    m_roi_size = roi->size();
+
+    int blob = frame->get_number_of_frames();
+    msg_envelope_elem_body_t* gva_meta_bin = msgbus_msg_envelope_new_integer(blob);
+    if (gva_meta_bin == NULL) {
+        LOG_ERROR_0("Failed to initialize binary gva metadata");
+        delete roi;
+        return false;
+    }
+    if (msgbus_msg_envelope_put(frame->get_meta_data(), GVA_META_BIN, gva_meta_bin) != MSG_SUCCESS) {
+        LOG_ERROR_0("Failed to put binary gva metadata");
+        msgbus_msg_envelope_elem_destroy(gva_meta_bin);
+        delete roi;
+        return false;
+    }
+    frame->add_frame((void*) roi, free_roi_blob, (void*) roi->data(), (int) roi->size(), 1, 1);
+    return true;
+}
+
+bool GstreamerIngestor::update_format(AppsinkBranch* branch, GstCaps* caps) {
+    GstVideoInfo info;
+    if (!gst_video_info_from_caps(&info, caps)) {
+        LOG_ERROR_0("Failed to read the frame format from the caps");
+        return false;
+    }
+    const gchar* name = gst_video_format_to_string(GST_VIDEO_INFO_FORMAT(&info));
+    PixelFormat format = pixel_format_from_name(name);
+    if (format == PIXEL_FORMAT_UNKNOWN) {
+        LOG_ERROR("%s image format is not supported please use BGR, GRAY8, NV12 or I420", name);
+        return false;
+    }
+    branch->format.format = format;
+    branch->format.width = GST_VIDEO_INFO_WIDTH(&info);
+    branch->format.height = GST_VIDEO_INFO_HEIGHT(&info);
+    branch->format.n_planes = GST_VIDEO_INFO_N_PLANES(&info);
+    for (int i = 0; i < branch->format.n_planes; i++) {
+        branch->format.offset[i] = GST_VIDEO_INFO_PLANE_OFFSET(&info, i);
+        branch->format.stride[i] = GST_VIDEO_INFO_PLANE_STRIDE(&info, i);
+    }
+    branch->format.size = GST_VIDEO_INFO_SIZE(&info);
+    if (GST_VIDEO_INFO_FPS_N(&info) > 0) {
+        branch->frame_period_ns = (int64_t) 1000000000LL *
+            GST_VIDEO_INFO_FPS_D(&info) / GST_VIDEO_INFO_FPS_N(&info);
+    } else {
+        branch->frame_period_ns = 0;
+    }
+    LOG_INFO("%s format: %s, Size: %dx%d", branch->sink_name.c_str(), name,
+             branch->format.width, branch->format.height);
+
+    if (branch->caps != NULL)
+        gst_caps_unref(branch->caps);
+    branch->caps = gst_caps_ref(caps);
+    // New caps come with a new buffer pool
+    branch->pool = NULL;
+    return true;
+}
+
+/**
+ * Whether the buffers of a branch come from a pool with a maximum number of
+ * buffers, whose element stalls once they are all held downstream
+ */
+static bool is_pool_bounded(AppsinkBranch* branch, GstBuffer* buf) {
+    if (buf->pool == NULL)
+        return false;
+    if (buf->pool != branch->pool) {
+        guint min_buffers = 0;
+        guint max_buffers = 0;
+        GstStructure* config = gst_buffer_pool_get_config(buf->pool);
+        branch->pool = buf->pool;
+        branch->pool_bounded = gst_buffer_pool_config_get_params(
+                config, NULL, NULL, &min_buffers, &max_buffers) && max_buffers > 0;
+        gst_structure_free(config);
+    }
+    return branch->pool_bounded;
+}
+
+/**
+ * A new sample has been pulled from the appsink
+ */
+GstFlowReturn GstreamerIngestor::process_sample(AppsinkBranch* branch, GstSample* sample) {
+    int64_t capture_ns = latency_now_ns();
     if (sample) {
         GstBuffer* buf = gst_sample_get_buffer(sample);  // no lifetime transfer
         if (buf) {
             // GstMapInfo info = {};
             GstMapInfo* info = (GstMapInfo*) malloc(sizeof(GstMapInfo));
             if (info == NULL) {
-                throw "Failed to allocate memory for GstMapInfo";
+                LOG_ERROR_0("Failed to allocate memory for GstMapInfo");
+                gst_sample_unref(sample);
+                return GST_FLOW_ERROR;
             }
             if (!gst_buffer_map(buf, info, GST_MAP_READ)) {
                 // Taken from OpenCV ???
                 LOG_ERROR_0("Failed to map GStreamer buffer to system memory");
+                free(info);
+                gst_sample_unref(sample);
             } else {
                 // LOG_INFO("Got frame of size: %ld", info.size);
-                GstCaps * frame_caps = gst_sample_get_caps(sample);
-                GstStructure* structure = gst_caps_get_structure(frame_caps, 0);  // no lifetime transfer
-                gint width;
-                gint height;
-                gst_structure_get_int(structure, "width", &width);
-                gst_structure_get_int(structure, "height", &height);
-                // Check for image format is done for the first frame
-                // The only accepted image format is BGR
-                if (g_first_frame) {
-                    g_first_frame = false;  // first frame has been recieved
-                    const gchar* format = gst_structure_get_string(structure, "format");
-                    if (format != NULL) {
-                        LOG_INFO("Format: %s, Size: %dx%d", format, width, height);
-                        int ind_bgr = 0;
-                        strcmp_s(format, strlen(format), "BGR", &ind_bgr);
-                        if (ind_bgr != 0) {
-                            LOG_ERROR("%s image format is not supported please use BGR", format);
-                            return GST_FLOW_ERROR;
-                        }
-                    } else {
-                        LOG_ERROR_0("Failed to read image format");
+                GstCaps* frame_caps = gst_sample_get_caps(sample);
+                if (frame_caps != branch->caps && !update_format(branch, frame_caps)) {
+                    gst_buffer_unmap(buf, info);
+                    free(info);
+                    gst_sample_unref(sample);
+                    return GST_FLOW_ERROR;
+                }
+                // Buffers with padding describe their own layout
+                FrameFormat fmt = branch->format;
+                GstVideoMeta* vmeta = gst_buffer_get_video_meta(buf);
+                if (vmeta != NULL) {
+                    for (int i = 0; i < fmt.n_planes; i++) {
+                        fmt.offset[i] = vmeta->offset[i];
+                        fmt.stride[i] = vmeta->stride[i];
                     }
                 }
 
                 GstreamerFrame* gst_frame = new GstreamerFrame(
                         sample, buf, info);
 
-                Frame* frame = new Frame(
-                        (void*) gst_frame, free_gst_frame, (void*) info->data,
-                        (int) width, (int) height, 3);
-
-                // Get the GVA metadata from the GST buffer
-                GVA::RegionOfInterestList roi_list(buf);
-
-                msgbus_ret_t ret = MSG_SUCCESS;
-
-                msg_envelope_elem_body_t* gva_meta_arr = msgbus_msg_envelope_new_array();
-		        if (gva_meta_arr == NULL) {
-                    LOG_ERROR_0("Failed to initialize gva metadata");
-                    delete frame;
-                    return GST_FLOW_ERROR;
-                }
-
-                for (GVA::RegionOfInterest& roi : roi_list) {
-                    GstVideoRegionOfInterestMeta* meta = roi.meta();
-
-                    LOG_DEBUG("Object Bounding Box: [%d, %d] [%d, %d]",
-                            meta->x, meta->y, meta->w, meta->h)
-
-                    msg_envelope_elem_body_t* roi_obj = msgbus_msg_envelope_new_object();
-                    if (roi_obj == NULL) {
-                        LOG_ERROR_0("Failed to initialize roi metadata");
-                        delete frame;
-                        return GST_FLOW_ERROR;
-                    }
-
-                    msg_envelope_elem_body_t* x = msgbus_msg_envelope_new_integer(meta->x);
-                    if (x == NULL) {
-                        LOG_ERROR_0("Failed to initialize horizontal offset metadata");
-                        delete frame;
-                        return GST_FLOW_ERROR;
-                    }
-
-                    msg_envelope_elem_body_t* y = msgbus_msg_envelope_new_integer(meta->y);
-                    if (y == NULL) {
-                        LOG_ERROR_0("Failed to initialize vertical offset metadata");
-                        delete frame;
-                        return GST_FLOW_ERROR;
-                    }
-
-
-                    msg_envelope_elem_body_t* w = msgbus_msg_envelope_new_integer(meta->w);
-                    if (w == NULL) {
-                        LOG_ERROR_0("Failed to initialize width metadata");
-                        delete frame;
-                        return GST_FLOW_ERROR;
-                    }
-
-                    msg_envelope_elem_body_t* h = msgbus_msg_envelope_new_integer(meta->h);
-                    if (h == NULL) {
-                        LOG_ERROR_0("Failed to initialize height metadata");
-                        delete frame;
-                        return GST_FLOW_ERROR;
-                    }
-
-                    ret = msgbus_msg_envelope_elem_object_put(roi_obj, "x", x);
-                    if (ret != MSG_SUCCESS) {
-                        LOG_ERROR_0("Failed to put horizontal offset metadata");
-                        delete frame;
-                        return GST_FLOW_ERROR;
-                    }
-
-                    ret = msgbus_msg_envelope_elem_object_put(roi_obj, "y", y);
-                    if (ret != MSG_SUCCESS) {
-                        LOG_ERROR_0("Failed to put vertical offset metadata");
-                        delete frame;
-                        return GST_FLOW_ERROR;
-                    }
-
-                    ret = msgbus_msg_envelope_elem_object_put(roi_obj, "width", w);
-                    if (ret != MSG_SUCCESS) {
-                        LOG_ERROR_0("Failed to put width metadata");
-                        delete frame;
+                // Encoders take packed BGR only
+                Frame* frame = NULL;
+                std::unique_ptr<GstreamerFrame> converted_src;
+                if (!is_packed_bgr(fmt) &&
+                        (m_convert_to_bgr.load() || branch->enc_type != EncodeType::NONE)) {
+                    PooledMat* pooled = m_pool->acquire();
+                    try {
+                        convert_to_bgr(info->data, fmt, pooled->mat);
+                    } catch(...) {
+                        LOG_ERROR("Failed to convert %s frame to BGR",
+                                  pixel_format_name(fmt.format));
+                        MatPool::free_pooled_mat(pooled);
+                        delete gst_frame;
                         return GST_FLOW_ERROR;
                     }
-
-                    ret = msgbus_msg_envelope_elem_object_put(roi_obj, "height", h);
-                    if (ret != MSG_SUCCESS) {
-                        LOG_ERROR_0("Failed to put height metadata");
-                        delete frame;
-                        return GST_FLOW_ERROR;
+                    frame = new_frame(
+                            (void*) pooled, MatPool::free_pooled_mat,
+                            (void*) pooled->mat.data, fmt.width, fmt.height, 3);
+                    // The sample is kept until the GVA metadata is read
+                    converted_src.reset(gst_frame);
+                } else {
+                    int width;
+                    int height;
+                    int channels;
+                    frame_geometry(fmt, width, height, channels);
+                    if (m_clip_ring != NULL && is_pool_bounded(branch, buf)) {
+                        // The pre-trigger ring holds the frames for seconds,
+                        // longer than the pool of the buffer can spare them
+                        PooledMat* pooled = m_pool->acquire();
+                        pooled->mat.create(1, (int) info->size, CV_8UC1);
+                        memcpy(pooled->mat.data, info->data, info->size);
+                        frame = new_frame(
+                                (void*) pooled, MatPool::free_pooled_mat,
+                                (void*) pooled->mat.data, width, height, channels,
+                                is_packed_bgr(fmt) ? NULL : &fmt);
+                        converted_src.reset(gst_frame);
+                    } else {
+                        frame = new_frame(
+                                (void*) gst_frame, free_gst_frame, (void*) info->data,
+                                width, height, channels,
+                                is_packed_bgr(fmt) ? NULL : &fmt);
                     }
-
-                    msg_envelope_elem_body_t* tensor_arr = msgbus_msg_envelope_new_array();
-                    if (tensor_arr == NULL) {
-                        LOG_ERROR_0("Failed to initialize tensor metadata");
-                        delete frame;
+                    if (!is_packed_bgr(fmt) && !put_format_meta(frame, fmt)) {
+                        LOG_ERROR_0("Failed to put pixel format meta-data");
+                        delete_frame(frame);
                         return GST_FLOW_ERROR;
                     }
+                }
 
-                    for (GVA::Tensor& tensor : roi) {
-                        LOG_DEBUG("Attribute: %s, Label: %s, Confidence: %f Label_id:%d",
-                                tensor.name().c_str(), tensor.label().c_str(),
-                                tensor.confidence(), tensor.label_id());
-
-                        msg_envelope_elem_body_t* tensor_obj = msgbus_msg_envelope_new_object();
-                        if (tensor_obj == NULL) {
-                            LOG_ERROR_0("Failed to initialize tensor metadata for each roi");
-                            delete frame;
-                            return GST_FLOW_ERROR;
-                        }
-
-                        msg_envelope_elem_body_t* attribute = msgbus_msg_envelope_new_string(tensor.name().c_str());
-                        if (attribute == NULL) {
-                            LOG_ERROR_0("Failed to initialize attribute metadata");
-                            delete frame;
-                            return GST_FLOW_ERROR;
-                        }
-
-                        msg_envelope_elem_body_t* label = msgbus_msg_envelope_new_string(tensor.label().c_str());
-                        if (label == NULL) {
-                            LOG_ERROR_0("Failed to initialize label metadata");
-                            delete frame;
-                            return GST_FLOW_ERROR;
-                        }
-
-                        msg_envelope_elem_body_t* confidence = msgbus_msg_envelope_new_floating(tensor.confidence());
-                        if (confidence == NULL) {
-                            LOG_ERROR_0("Failed to initialize confidence metadata");
-                            delete frame;
-                            return GST_FLOW_ERROR;
-                        }
-
-                        msg_envelope_elem_body_t* label_id = msgbus_msg_envelope_new_integer(tensor.label_id());
-                        if (label_id == NULL) {
-                            LOG_ERROR_0("Failed to initialize label_id metadata");
-                            delete frame;
-                            return GST_FLOW_ERROR;
-                        }
-
-                        ret = msgbus_msg_envelope_elem_object_put(tensor_obj, "attribute", attribute);
-                        if (ret != MSG_SUCCESS) {
-                            LOG_ERROR_0("Failed to put attribute metadata");
-                            delete frame;
-                            return GST_FLOW_ERROR;
-                        }
-
-                        ret = msgbus_msg_envelope_elem_object_put(tensor_obj, "label", label);
-                        if (ret != MSG_SUCCESS) {
-                            LOG_ERROR_0("Failed to put label metadata");
-                            delete frame;
-                            return GST_FLOW_ERROR;
-                        }
-
-                        ret = msgbus_msg_envelope_elem_object_put(tensor_obj, "confidence", confidence);
-                        if (ret != MSG_SUCCESS) {
-                            LOG_ERROR_0("Failed to put confidence metadata");
-                            delete frame;
-                            return GST_FLOW_ERROR;
-                        }
-
-                        ret = msgbus_msg_envelope_elem_object_put(tensor_obj, "label_id", label_id);
-                        if (ret != MSG_SUCCESS) {
-                            LOG_ERROR_0("Failed to put label_id metadata");
-                            delete frame;
-                            return GST_FLOW_ERROR;
-                        }
-
-                        ret = msgbus_msg_envelope_elem_array_add(tensor_arr, tensor_obj);
-                        if (ret != MSG_SUCCESS) {
-                            LOG_ERROR_0("Failed to add tensor object to tensor array metadata");
-                            delete frame;
-                            return GST_FLOW_ERROR;
-                        }
-                    }
+                msg_envelope_t* gva_meta_data = frame->get_meta_data();
+                if (gva_meta_data == NULL) {
+                    LOG_ERROR_0("Failed to initialize frame metadata");
+                    delete_frame(frame);
+                    return GST_FLOW_ERROR;
+                }
 
-                    ret = msgbus_msg_envelope_elem_object_put(roi_obj, "tensor", tensor_arr);
-                    if (ret != MSG_SUCCESS) {
-                        LOG_ERROR_0("Failed to put tensor array to roi object metadata");
-                        delete frame;
+                // Get the GVA metadata from the GST buffer
+                msgbus_ret_t ret = MSG_SUCCESS;
+                if (m_gva_meta_format != GVA_META_FORMAT_BINARY) {
+                    msg_envelope_elem_body_t* gva_meta_arr = gva_roi_to_envelope(buf);
+                    if (gva_meta_arr == NULL) {
+                        delete_frame(frame);
                         return GST_FLOW_ERROR;
                     }
-
-                    ret = msgbus_msg_envelope_elem_array_add(gva_meta_arr, roi_obj);
+                    ret = msgbus_msg_envelope_put(gva_meta_data, GVA_META, gva_meta_arr);
                     if (ret != MSG_SUCCESS) {
-                        LOG_ERROR_0("Failed to add roi object to gva metadata");
-                        delete frame;
+                        LOG_ERROR_0("Failed to put gva metadata");
+                        msgbus_msg_envelope_elem_destroy(gva_meta_arr);
+                        delete_frame(frame);
                         return GST_FLOW_ERROR;
                     }
                 }
-
-                msg_envelope_t* gva_meta_data = frame->get_meta_data();
-                if (gva_meta_data == NULL) {
-                    LOG_ERROR_0("Failed to initialize frame metadata");
-                    delete frame;
+                if (m_gva_meta_format != GVA_META_FORMAT_JSON && !add_roi_blob(frame, buf)) {
+                    delete_frame(frame);
                     return GST_FLOW_ERROR;
                 }
 
-                ret = msgbus_msg_envelope_put(gva_meta_data, "gva_meta", gva_meta_arr);
-                if (ret != MSG_SUCCESS) {
-                    LOG_ERROR_0("Failed to put gva metadata");
-                    delete frame;
+                if (m_gva_tensor_data && !add_tensor_blobs(frame, sample, buf)) {
+                    delete_frame(frame);
                     return GST_FLOW_ERROR;
                 }
 
                 msg_envelope_elem_body_t* elem = NULL;
-                if (ctx->m_frame_count == INT64_MAX) {
+                if (branch->frame_count == INT64_MAX) {
                     LOG_WARN_0("frame count has reached INT64_MAX, so resetting \
                                 it back to zero");
-                    ctx->m_frame_count = 0;
+                    branch->frame_count = 0;
                 }
-                ctx->m_frame_count++;
+                branch->frame_count++;
 
                 // Deleting subsequent frames in snapshot mode if GST_FLOW_EOS
                 // takes time/doesn't stop gstreamer loop with video source
-                if (ctx->m_snapshot) {
-                    if (ctx->m_frame_count > 1) {
-                      delete frame;
+                if (m_snapshot) {
+                    if (branch->frame_count > 1) {
+                      delete_frame(frame);
                       return GST_FLOW_EOS;
                      }
                 }
-                elem = msgbus_msg_envelope_new_integer(ctx->m_frame_count);
+                elem = msgbus_msg_envelope_new_integer(branch->frame_count);
                 if (elem == NULL) {
                     LOG_ERROR_0("Failed to create frame_number element");
-                    delete frame;
+                    delete_frame(frame);
                     return GST_FLOW_ERROR;
                 }
                 ret = msgbus_msg_envelope_put(gva_meta_data, "frame_number", elem);
                 if (ret != MSG_SUCCESS) {
                     LOG_ERROR_0("Failed to put frame_number meta-data");
-                    delete frame;
+                    delete_frame(frame);
                     return GST_FLOW_ERROR;
                 }
-                LOG_DEBUG("Frame number: %ld", ctx->m_frame_count);
-
-                // Adding image handle to frame
-                msg_envelope_t* meta_data = frame->get_meta_data();
-                // Profiling start
-                DO_PROFILING(ctx->m_profile, meta_data, "ts_Ingestor_entry");
-
-                // Profiling start
-                DO_PROFILING(ctx->m_profile, meta_data, "ts_filterQ_entry");
-                // Profiling end
+                LOG_DEBUG("Frame number: %ld", branch->frame_count);
 
                 try {
-                    frame->set_encoding(g_enc_type, g_enc_lvl);
+                    frame->set_encoding(branch->enc_type, branch->enc_lvl);
                 } catch(const char *err) {
                     LOG_ERROR("Exception: %s", err);
                 } catch(...) {
                     LOG_ERROR("Exception occurred in set_encoding()");
                 }
 
-                QueueRetCode ret_queue = ctx->m_udf_input_queue->push(frame);
-                if (ret_queue == QueueRetCode::QUEUE_FULL) {
-                    if (ctx->m_udf_input_queue->push_wait(frame) != QueueRetCode::SUCCESS) {
-                        LOG_ERROR_0("Failed to enqueue message, "
-                                    "message dropped");
-                    }
-                    // Add timestamp which acts as a marker if queue if blocked
-                    DO_PROFILING(ctx->m_profile, meta_data, ctx->m_ingestor_block_key.c_str());
-                }
+                enqueue_output_frame(frame, branch->route, m_snapshot, capture_ns);
+                branch->frames.fetch_add(1);
             }
         } else {
             LOG_ERROR_0("Failed to get GstBuffer");
+            gst_sample_unref(sample);
         }
 
-        if (ctx->m_snapshot) {
-            ctx->m_frame_count = 1;
-            ctx->m_snapshot_cv.notify_all();
+        if (m_snapshot) {
+            branch->frame_count = 1;
+            snapshot_done();
             return GST_FLOW_EOS;
         }
         return GST_FLOW_OK;
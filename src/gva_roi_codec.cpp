@@ -0,0 +1,406 @@
+// Copyright (c) 2020 Intel Corporation.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM,OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+/**
+ * @file
+ * @brief GVA regions of interest serialization implementation
+ */
+
+#include <string.h>
+#include <eii/utils/logger.h>
+#include "eii/vi/gva_roi_meta.h"
+#include "eii/vi/gva_roi_codec.h"
+
+#define HEADER_SIZE 16
+
+using namespace eii::vi;
+
+/**
+ * Put a named element in an object, destroying it on failure
+ */
+static bool object_put(msg_envelope_elem_body_t* obj, const char* key, msg_envelope_elem_body_t* elem) {
+    if (elem == NULL)
+        return false;
+    if (msgbus_msg_envelope_elem_object_put(obj, key, elem) != MSG_SUCCESS) {
+        msgbus_msg_envelope_elem_destroy(elem);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Add an element to an array, destroying it on failure
+ */
+static bool array_add(msg_envelope_elem_body_t* arr, msg_envelope_elem_body_t* elem) {
+    if (elem == NULL)
+        return false;
+    if (msgbus_msg_envelope_elem_array_add(arr, elem) != MSG_SUCCESS) {
+        msgbus_msg_envelope_elem_destroy(elem);
+        return false;
+    }
+    return true;
+}
+
+static msg_envelope_elem_body_t* tensor_to_envelope(GVA::Tensor& tensor) {
+    LOG_DEBUG("Attribute: %s, Label: %s, Confidence: %f Label_id:%d",
+              tensor.name().c_str(), tensor.label().c_str(),
+              tensor.confidence(), tensor.label_id());
+
+    msg_envelope_elem_body_t* tensor_obj = msgbus_msg_envelope_new_object();
+    if (tensor_obj == NULL) {
+        LOG_ERROR_0("Failed to initialize tensor metadata for each roi");
+        return NULL;
+    }
+    if (!object_put(tensor_obj, "attribute", msgbus_msg_envelope_new_string(tensor.name().c_str())) ||
+            !object_put(tensor_obj, "label", msgbus_msg_envelope_new_string(tensor.label().c_str())) ||
+            !object_put(tensor_obj, "confidence", msgbus_msg_envelope_new_floating(tensor.confidence())) ||
+            !object_put(tensor_obj, "label_id", msgbus_msg_envelope_new_integer(tensor.label_id()))) {
+        LOG_ERROR_0("Failed to put tensor metadata");
+        msgbus_msg_envelope_elem_destroy(tensor_obj);
+        return NULL;
+    }
+    return tensor_obj;
+}
+
+static msg_envelope_elem_body_t* roi_to_envelope(GVA::RegionOfInterest& roi) {
+    GstVideoRegionOfInterestMeta* meta = roi.meta();
+
+    LOG_DEBUG("Object Bounding Box: [%d, %d] [%d, %d]",
+              meta->x, meta->y, meta->w, meta->h)
+
+    msg_envelope_elem_body_t* roi_obj = msgbus_msg_envelope_new_object();
+    if (roi_obj == NULL) {
+        LOG_ERROR_0("Failed to initialize roi metadata");
+        return NULL;
+    }
+    if (!object_put(roi_obj, "x", msgbus_msg_envelope_new_integer(meta->x)) ||
+            !object_put(roi_obj, "y", msgbus_msg_envelope_new_integer(meta->y)) ||
+            !object_put(roi_obj, "width", msgbus_msg_envelope_new_integer(meta->w)) ||
+            !object_put(roi_obj, "height", msgbus_msg_envelope_new_integer(meta->h))) {
+        LOG_ERROR_0("Failed to put bounding box metadata");
+        msgbus_msg_envelope_elem_destroy(roi_obj);
+        return NULL;
+    }
+
+    msg_envelope_elem_body_t* tensor_arr = msgbus_msg_envelope_new_array();
+    if (tensor_arr == NULL) {
+        LOG_ERROR_0("Failed to initialize tensor metadata");
+        msgbus_msg_envelope_elem_destroy(roi_obj);
+        return NULL;
+    }
+    for (GVA::Tensor& tensor : roi) {
+        if (!array_add(tensor_arr, tensor_to_envelope(tensor))) {
+            LOG_ERROR_0("Failed to add tensor object to tensor array metadata");
+            msgbus_msg_envelope_elem_destroy(tensor_arr);
+            msgbus_msg_envelope_elem_destroy(roi_obj);
+            return NULL;
+        }
+    }
+    if (!object_put(roi_obj, "tensor", tensor_arr)) {
+        LOG_ERROR_0("Failed to put tensor array to roi object metadata");
+        msgbus_msg_envelope_elem_destroy(roi_obj);
+        return NULL;
+    }
+    return roi_obj;
+}
+
+msg_envelope_elem_body_t* eii::vi::gva_roi_to_envelope(GstBuffer* buf) {
+    GVA::RegionOfInterestList roi_list(buf);
+
+    msg_envelope_elem_body_t* gva_meta_arr = msgbus_msg_envelope_new_array();
+    if (gva_meta_arr == NULL) {
+        LOG_ERROR_0("Failed to initialize gva metadata");
+        return NULL;
+    }
+    for (GVA::RegionOfInterest& roi : roi_list) {
+        if (!array_add(gva_meta_arr, roi_to_envelope(roi))) {
+            LOG_ERROR_0("Failed to add roi object to gva metadata");
+            msgbus_msg_envelope_elem_destroy(gva_meta_arr);
+            return NULL;
+        }
+    }
+    return gva_meta_arr;
+}
+
+template <typename T>
+static void append(std::vector<uint8_t>& arena, T value) {
+    size_t pos = arena.size();
+    arena.resize(pos + sizeof(T));
+    memcpy(&arena[pos], &value, sizeof(T));
+}
+
+static void append_string(std::vector<uint8_t>& arena, const char* str, uint16_t len) {
+    arena.insert(arena.end(), (const uint8_t*) str, (const uint8_t*) str + len);
+}
+
+template <typename T>
+static void patch(std::vector<uint8_t>& arena, size_t pos, T value) {
+    memcpy(&arena[pos], &value, sizeof(T));
+}
+
+void eii::vi::gva_roi_encode(GstBuffer* buf, std::vector<uint8_t>& arena) {
+    arena.clear();
+    append<uint32_t>(arena, GVA_ROI_MAGIC);
+    append<uint16_t>(arena, GVA_ROI_VERSION);
+    append<uint16_t>(arena, HEADER_SIZE);
+    append<uint32_t>(arena, 0);
+    append<uint32_t>(arena, 0);
+
+    // Walks the buffer meta-data directly, GVA::RegionOfInterestList would
+    // allocate vectors and strings
+    uint32_t roi_count = 0;
+    gpointer state = NULL;
+    GstVideoRegionOfInterestMeta* meta = NULL;
+    while ((meta = GST_VIDEO_REGION_OF_INTEREST_META_ITERATE(buf, &state))) {
+        append<uint32_t>(arena, meta->x);
+        append<uint32_t>(arena, meta->y);
+        append<uint32_t>(arena, meta->w);
+        append<uint32_t>(arena, meta->h);
+        size_t count_pos = arena.size();
+        append<uint32_t>(arena, 0);
+
+        uint32_t tensor_count = 0;
+        for (GList* l = meta->params; l; l = g_list_next(l)) {
+            GstStructure* s = (GstStructure*) l->data;
+            const gchar* attribute = gst_structure_get_name(s);
+            const gchar* label = gst_structure_get_string(s, "label");
+            gdouble confidence = 0;
+            gint label_id = 0;
+            gst_structure_get_double(s, "confidence", &confidence);
+            gst_structure_get_int(s, "label_id", &label_id);
+            size_t attribute_len = (attribute) ? strnlen(attribute, UINT16_MAX) : 0;
+            size_t label_len = (label) ? strnlen(label, UINT16_MAX) : 0;
+
+            append<double>(arena, confidence);
+            append<int32_t>(arena, label_id);
+            append<uint16_t>(arena, (uint16_t) attribute_len);
+            append<uint16_t>(arena, (uint16_t) label_len);
+            append_string(arena, attribute, attribute_len);
+            append_string(arena, label, label_len);
+            tensor_count++;
+        }
+        patch<uint32_t>(arena, count_pos, tensor_count);
+        roi_count++;
+    }
+    patch<uint32_t>(arena, 8, roi_count);
+    patch<uint32_t>(arena, 12, (uint32_t) arena.size());
+}
+
+namespace {
+
+/**
+ * Bounds checked reader of an encoding
+ */
+class Reader {
+    private:
+        const uint8_t* m_data;
+        size_t m_len;
+        size_t m_pos;
+
+    public:
+        Reader(const uint8_t* data, size_t len) : m_data(data), m_len(len), m_pos(0) {}
+
+        template <typename T>
+        bool read(T& value) {
+            if (m_len - m_pos < sizeof(T))
+                return false;
+            memcpy(&value, m_data + m_pos, sizeof(T));
+            m_pos += sizeof(T);
+            return true;
+        }
+
+        bool read_string(size_t len, const char*& str) {
+            if (m_len - m_pos < len)
+                return false;
+            str = (const char*) m_data + m_pos;
+            m_pos += len;
+            return true;
+        }
+
+        bool seek(size_t pos) {
+            if (pos > m_len)
+                return false;
+            m_pos = pos;
+            return true;
+        }
+};
+
+}
+
+static void append_json_string(std::string& json, const char* str, size_t len) {
+    static const char hex[] = "0123456789abcdef";
+    json += '"';
+    for (size_t i = 0; i < len; i++) {
+        unsigned char c = str[i];
+        if (c == '"' || c == '\\') {
+            json += '\\';
+            json += c;
+        } else if (c < 0x20) {
+            json += "\\u00";
+            json += hex[c >> 4];
+            json += hex[c & 0xf];
+        } else {
+            json += c;
+        }
+    }
+    json += '"';
+}
+
+bool eii::vi::gva_roi_to_json(const uint8_t* data, size_t len, std::string& json) {
+    Reader reader(data, len);
+    uint32_t magic = 0;
+    uint16_t version = 0;
+    uint16_t header_size = 0;
+    uint32_t roi_count = 0;
+    uint32_t total_size = 0;
+    if (!reader.read(magic) || magic != GVA_ROI_MAGIC ||
+            !reader.read(version) || version > GVA_ROI_VERSION ||
+            !reader.read(header_size) || !reader.read(roi_count) ||
+            !reader.read(total_size) || total_size > len ||
+            !reader.seek(header_size)) {
+        return false;
+    }
+
+    char num[64];
+    json.clear();
+    json += '[';
+    for (uint32_t i = 0; i < roi_count; i++) {
+        uint32_t x, y, w, h, tensor_count;
+        if (!reader.read(x) || !reader.read(y) || !reader.read(w) ||
+                !reader.read(h) || !reader.read(tensor_count)) {
+            return false;
+        }
+        snprintf(num, sizeof(num), "{\"x\": %u, \"y\": %u, \"width\": %u, \"height\": %u, ",
+                 x, y, w, h);
+        json += (i > 0) ? ", " : "";
+        json += num;
+        json += "\"tensor\": [";
+        for (uint32_t j = 0; j < tensor_count; j++) {
+            double confidence;
+            int32_t label_id;
+            uint16_t attribute_len, label_len;
+            const char* attribute;
+            const char* label;
+            if (!reader.read(confidence) || !reader.read(label_id) ||
+                    !reader.read(attribute_len) || !reader.read(label_len) ||
+                    !reader.read_string(attribute_len, attribute) ||
+                    !reader.read_string(label_len, label)) {
+                return false;
+            }
+            json += (j > 0) ? ", {\"attribute\": " : "{\"attribute\": ";
+            append_json_string(json, attribute, attribute_len);
+            json += ", \"label\": ";
+            append_json_string(json, label, label_len);
+            snprintf(num, sizeof(num), ", \"confidence\": %.17g, \"label_id\": %d}",
+                     confidence, label_id);
+            json += num;
+        }
+        json += "]}";
+    }
+    json += ']';
+    return true;
+}
+
+void eii::vi::gva_tensor_data(GstBuffer* buf, std::vector<GvaTensorData>& tensors) {
+    tensors.clear();
+    int roi = 0;
+    gpointer state = NULL;
+    GstVideoRegionOfInterestMeta* meta = NULL;
+    while ((meta = GST_VIDEO_REGION_OF_INTEREST_META_ITERATE(buf, &state))) {
+        int tensor = 0;
+        for (GList* l = meta->params; l; l = g_list_next(l)) {
+            GstStructure* s = (GstStructure*) l->data;
+            gsize size = 0;
+            const void* data = gva_get_tensor_data(s, &size);
+            if (data != NULL && size > 0) {
+                GvaTensorData t;
+                t.roi = roi;
+                t.tensor = tensor;
+                t.s = s;
+                t.data = data;
+                t.size = size;
+                tensors.push_back(t);
+            }
+            tensor++;
+        }
+        roi++;
+    }
+}
+
+/**
+ * Name of a tensor layout, GVA::Tensor::layout_as_string() misses NC
+ */
+static const char* layout_name(GVA::Tensor::Layout layout) {
+    switch (layout) {
+        case GVA::Tensor::Layout::NCHW: return "NCHW";
+        case GVA::Tensor::Layout::NHWC: return "NHWC";
+        case GVA::Tensor::Layout::NC:   return "NC";
+        default:                        return "ANY";
+    }
+}
+
+msg_envelope_elem_body_t* eii::vi::gva_tensor_to_envelope(const GvaTensorData& tensor, int blob) {
+    GVA::Tensor t(tensor.s);
+
+    msg_envelope_elem_body_t* dims_arr = msgbus_msg_envelope_new_array();
+    if (dims_arr == NULL) {
+        LOG_ERROR_0("Failed to initialize tensor dims metadata");
+        return NULL;
+    }
+    // gvainference stores the dims as a GstValueArray of guint
+    const GValue* dims = gst_structure_get_value(tensor.s, "dims");
+    if (dims != NULL && GST_VALUE_HOLDS_ARRAY(dims)) {
+        guint n_dims = gst_value_array_get_size(dims);
+        for (guint i = 0; i < n_dims; i++) {
+            const GValue* dim = gst_value_array_get_value(dims, i);
+            if (!G_VALUE_HOLDS_UINT(dim))
+                continue;
+            if (!array_add(dims_arr, msgbus_msg_envelope_new_integer(g_value_get_uint(dim)))) {
+                LOG_ERROR_0("Failed to add tensor dim metadata");
+                msgbus_msg_envelope_elem_destroy(dims_arr);
+                return NULL;
+            }
+        }
+    }
+
+    msg_envelope_elem_body_t* tensor_obj = msgbus_msg_envelope_new_object();
+    if (tensor_obj == NULL) {
+        LOG_ERROR_0("Failed to initialize tensor data metadata");
+        msgbus_msg_envelope_elem_destroy(dims_arr);
+        return NULL;
+    }
+    if (!object_put(tensor_obj, "dims", dims_arr)) {
+        LOG_ERROR_0("Failed to put tensor dims metadata");
+        msgbus_msg_envelope_elem_destroy(tensor_obj);
+        return NULL;
+    }
+    if (!object_put(tensor_obj, "roi", msgbus_msg_envelope_new_integer(tensor.roi)) ||
+            !object_put(tensor_obj, "tensor", msgbus_msg_envelope_new_integer(tensor.tensor)) ||
+            !object_put(tensor_obj, "attribute", msgbus_msg_envelope_new_string(t.name().c_str())) ||
+            !object_put(tensor_obj, "precision", msgbus_msg_envelope_new_string(t.precision_as_string().c_str())) ||
+            !object_put(tensor_obj, "layout", msgbus_msg_envelope_new_string(layout_name(t.layout()))) ||
+            !object_put(tensor_obj, "size", msgbus_msg_envelope_new_integer((int64_t) tensor.size)) ||
+            !object_put(tensor_obj, "blob", msgbus_msg_envelope_new_integer(blob))) {
+        LOG_ERROR_0("Failed to put tensor data metadata");
+        msgbus_msg_envelope_elem_destroy(tensor_obj);
+        return NULL;
+    }
+    return tensor_obj;
+}
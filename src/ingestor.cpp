@@ -33,9 +33,11 @@
 #include <string>
 
 #include "eii/vi/ingestor.h"
+#include "eii/vi/frame_merger.h"
 #include "eii/vi/opencv_ingestor.h"
 #include "eii/vi/gstreamer_ingestor.h"
 #include "eii/vi/realsense_ingestor.h"
+#include "eii/vi/synthetic_ingestor.h"
 
 using namespace eii::vi;
 using namespace eii::utils;
@@ -50,7 +52,23 @@ Ingestor::Ingestor(config_t* config, FrameQueue* frame_queue,
 
         // Initializing snapshot variable
         m_snapshot = false;
-        m_ingestor_block_key = m_service_name + "_ingestor_blocked_ts";
+        m_overflow_policy = OVERFLOW_BLOCK;
+        m_keep_every_nth = 2;
+        m_overflow_count = 0;
+        m_dropped_frames.store(0);
+        m_frame_stamps = NULL;
+        m_frame_merger = NULL;
+        m_convert_to_bgr.store(false);
+        m_warm_standby = false;
+        m_start_ns.store(0);
+        m_start_warm = false;
+        m_last_frame_ns = 0;
+        m_snapshot_standby = false;
+        m_standby.store(false);
+        m_snapshot_count = 0;
+        m_clip_ring = NULL;
+        m_clip_frame = NULL;
+        m_buffers_in_use.store(0);
         config_value_t* cvt_poll_interval = config->get_config_value(config->cfg, POLL_INTERVAL);
         if (cvt_poll_interval != NULL) {
             if (cvt_poll_interval->type != CVT_FLOATING && cvt_poll_interval->type != CVT_INTEGER) {
@@ -71,8 +89,152 @@ Ingestor::Ingestor(config_t* config, FrameQueue* frame_queue,
         }
         LOG_INFO("Poll interval: %lf", m_poll_interval);
 
+        PacingPolicy pacing_policy = PACING_CATCH_UP;
+        config_value_t* cvt_pacing = config->get_config_value(config->cfg, PACING_POLICY);
+        if (cvt_pacing != NULL) {
+            if (cvt_pacing->type != CVT_STRING) {
+                const char* err = "Pacing policy must be a string";
+                LOG_ERROR("%s for \'%s\'", err, PACING_POLICY);
+                config_value_destroy(cvt_pacing);
+                throw(err);
+            }
+            std::string policy = cvt_pacing->body.string;
+            config_value_destroy(cvt_pacing);
+            if (policy == "catch_up") {
+                pacing_policy = PACING_CATCH_UP;
+            } else if (policy == "skip") {
+                pacing_policy = PACING_SKIP;
+            } else {
+                const char* err = "Unknown pacing policy";
+                LOG_ERROR("%s: %s", err, policy.c_str());
+                throw(err);
+            }
+        }
+        m_pacer.configure(m_poll_interval, pacing_policy);
+
+        config_value_t* cvt_name = config->get_config_value(config->cfg, INGESTOR_NAME);
+        if (cvt_name != NULL) {
+            if (cvt_name->type != CVT_STRING) {
+                const char* err = "Ingestor name must be a string";
+                LOG_ERROR("%s", err);
+                config_value_destroy(cvt_name);
+                throw(err);
+            }
+            m_name = cvt_name->body.string;
+            config_value_destroy(cvt_name);
+        }
+
+        config_value_t* cvt_overflow = config->get_config_value(config->cfg, OVERFLOW_POLICY);
+        if (cvt_overflow != NULL) {
+            if (cvt_overflow->type != CVT_STRING) {
+                const char* err = "Overflow policy must be a string";
+                LOG_ERROR("%s for \'%s\'", err, OVERFLOW_POLICY);
+                config_value_destroy(cvt_overflow);
+                throw(err);
+            }
+            std::string policy = cvt_overflow->body.string;
+            config_value_destroy(cvt_overflow);
+            if (policy == "block") {
+                m_overflow_policy = OVERFLOW_BLOCK;
+            } else if (policy == "drop_newest") {
+                m_overflow_policy = OVERFLOW_DROP_NEWEST;
+            } else if (policy == "drop_oldest") {
+                m_overflow_policy = OVERFLOW_DROP_OLDEST;
+            } else if (policy == "keep_every_nth") {
+                m_overflow_policy = OVERFLOW_KEEP_EVERY_NTH;
+            } else {
+                const char* err = "Unknown overflow policy";
+                LOG_ERROR("%s: %s", err, policy.c_str());
+                throw(err);
+            }
+            LOG_INFO("Overflow policy: %s", policy.c_str());
+        }
+
+        config_value_t* cvt_keep_every_nth = config->get_config_value(config->cfg, KEEP_EVERY_NTH);
+        if (cvt_keep_every_nth != NULL) {
+            if (cvt_keep_every_nth->type != CVT_INTEGER || cvt_keep_every_nth->body.integer < 1) {
+                const char* err = "keep_every_nth must be a positive integer";
+                LOG_ERROR("%s", err);
+                config_value_destroy(cvt_keep_every_nth);
+                throw(err);
+            }
+            m_keep_every_nth = cvt_keep_every_nth->body.integer;
+            config_value_destroy(cvt_keep_every_nth);
+        }
+
+        config_value_t* cvt_warm_standby = config->get_config_value(config->cfg, WARM_STANDBY);
+        if (cvt_warm_standby != NULL) {
+            if (cvt_warm_standby->type != CVT_BOOLEAN) {
+                const char* err = "warm_standby must be a boolean";
+                LOG_ERROR("%s", err);
+                config_value_destroy(cvt_warm_standby);
+                throw(err);
+            }
+            m_warm_standby = cvt_warm_standby->body.boolean;
+            config_value_destroy(cvt_warm_standby);
+            LOG_INFO("Warm standby: %s", m_warm_standby ? "true" : "false");
+        }
+
+        config_value_t* cvt_snapshot_standby = config->get_config_value(config->cfg, SNAPSHOT_STANDBY);
+        if (cvt_snapshot_standby != NULL) {
+            if (cvt_snapshot_standby->type != CVT_BOOLEAN) {
+                const char* err = "snapshot_standby must be a boolean";
+                LOG_ERROR("%s", err);
+                config_value_destroy(cvt_snapshot_standby);
+                throw(err);
+            }
+            m_snapshot_standby = cvt_snapshot_standby->body.boolean;
+            config_value_destroy(cvt_snapshot_standby);
+            LOG_INFO("Snapshot standby: %s", m_snapshot_standby ? "true" : "false");
+        }
+
+        double clip_seconds = 0.0;
+        config_value_t* cvt_clip_seconds = config->get_config_value(config->cfg, CLIP_BUFFER_SECONDS);
+        if (cvt_clip_seconds != NULL) {
+            if (cvt_clip_seconds->type == CVT_FLOATING) {
+                clip_seconds = cvt_clip_seconds->body.floating;
+            } else if (cvt_clip_seconds->type == CVT_INTEGER) {
+                clip_seconds = (double) cvt_clip_seconds->body.integer;
+            } else {
+                clip_seconds = -1.0;
+            }
+            config_value_destroy(cvt_clip_seconds);
+            if (clip_seconds < 0.0) {
+                const char* err = "clip_buffer_seconds must be a positive number";
+                LOG_ERROR("%s", err);
+                throw(err);
+            }
+        }
+        int64_t clip_bytes = 0;
+        config_value_t* cvt_clip_bytes = config->get_config_value(config->cfg, CLIP_BUFFER_BYTES);
+        if (cvt_clip_bytes != NULL) {
+            if (cvt_clip_bytes->type != CVT_INTEGER || cvt_clip_bytes->body.integer < 0) {
+                const char* err = "clip_buffer_bytes must be a positive integer";
+                LOG_ERROR("%s", err);
+                config_value_destroy(cvt_clip_bytes);
+                throw(err);
+            }
+            clip_bytes = cvt_clip_bytes->body.integer;
+            config_value_destroy(cvt_clip_bytes);
+        }
+        if (clip_seconds > 0.0 || clip_bytes > 0) {
+            m_clip_ring = new FrameRing(clip_seconds, (size_t) clip_bytes);
+            LOG_INFO("Clip buffer: %.1f s, %ld bytes", clip_seconds, clip_bytes);
+        }
+
+        config_value_t* cvt_clip_topic = config->get_config_value(config->cfg, CLIP_TOPIC);
+        if (cvt_clip_topic != NULL) {
+            if (cvt_clip_topic->type != CVT_STRING) {
+                const char* err = "clip_topic must be a string";
+                LOG_ERROR("%s", err);
+                config_value_destroy(cvt_clip_topic);
+                throw(err);
+            }
+            m_clip_topic = cvt_clip_topic->body.string;
+            config_value_destroy(cvt_clip_topic);
+        }
+
         m_running.store(false);
-        this->m_profile = new Profiling();
 }
 
 Ingestor& Ingestor::operator=(const Ingestor& src) {
@@ -81,11 +243,10 @@ Ingestor& Ingestor::operator=(const Ingestor& src) {
 
 Ingestor::~Ingestor() {
     LOG_DEBUG_0("Ingestor destructor");
+    delete m_clip_ring;
     if (m_initialized.load()) {
         // Delete the thread
         delete m_th;
-        // Delete profiling variable
-        delete m_profile;
     }
 }
 
@@ -98,16 +259,447 @@ IngestRetCode Ingestor::start(bool snapshot_mode) {
     else if (m_running.load())
         return IngestRetCode::ALREAD_RUNNING;
 
+    m_overflow_count = 0;
+    m_pacer.reset();
+
+    m_start_warm = is_capture_open();
+    m_start_ns.store(latency_now_ns());
+    m_last_frame_ns = 0;
+
     m_th = new std::thread(&Ingestor::run, this, snapshot_mode);
 
     return IngestRetCode::SUCCESS;
 }
 
-Ingestor* eii::vi::get_ingestor(config_t* config, FrameQueue* frame_queue, const char* type, std::string service_name, std::condition_variable& snapshot_cv, EncodeType enc_type, int enc_lvl) {
+void Ingestor::run(bool snapshot_mode) {
+    // indicate that the run() function corresponding to the m_th thread has started
+    m_running.store(true);
+    LOG_INFO_0("Ingestor thread running publishing on stream");
+
+    Frame* frame = NULL;
+
+    int64_t frame_count = 0;
+
+    msg_envelope_elem_body_t* elem = NULL;
+
+    try {
+        while (!m_stop.load()) {
+            this->read(frame);
+            int64_t capture_ns = latency_now_ns();
+            msg_envelope_t* meta_data = frame->get_meta_data();
+
+            msgbus_ret_t ret;
+            if (frame_count == INT64_MAX) {
+                LOG_WARN_0("frame count has reached INT64_MAX, so resetting \
+                            it back to zero");
+                frame_count = 0;
+            }
+            frame_count++;
+
+            elem = msgbus_msg_envelope_new_integer(frame_count);
+            if (elem == NULL) {
+                delete_frame(frame);
+                frame = NULL;
+                const char* err = "Failed to create frame_number element";
+                LOG_ERROR("%s", err);
+                throw err;
+            }
+            ret = msgbus_msg_envelope_put(meta_data, "frame_number", elem);
+            if (ret != MSG_SUCCESS) {
+                delete_frame(frame);
+                frame = NULL;
+                const char* err = "Failed to put frame_number in meta-data";
+                LOG_ERROR("%s", err);
+                throw err;
+            }
+            elem = NULL;
+            LOG_DEBUG("Frame number: %ld", frame_count);
+
+            // Set encding type and level
+            try {
+                frame->set_encoding(m_enc_type, m_enc_lvl);
+            } catch(const char *err) {
+                LOG_ERROR("Exception: %s", err);
+            } catch(...) {
+                LOG_ERROR("Exception occurred in set_encoding()");
+            }
+
+            enqueue_frame(frame, snapshot_mode, capture_ns);
+
+            frame = NULL;
+
+            if (snapshot_mode) {
+                m_stop.store(true);
+                snapshot_done();
+            }
+        }
+    } catch(const char* err) {
+        LOG_ERROR("Exception: %s", err);
+        if (elem != NULL)
+            msgbus_msg_envelope_elem_destroy(elem);
+        if (frame != NULL)
+            delete_frame(frame);
+        throw err;
+    } catch(...) {
+        LOG_ERROR("Exception occured in ingestor run()");
+        if (elem != NULL)
+            msgbus_msg_envelope_elem_destroy(elem);
+        if (frame != NULL)
+            delete_frame(frame);
+        throw;
+    }
+    if (elem != NULL)
+        msgbus_msg_envelope_elem_destroy(elem);
+    if (frame != NULL)
+        delete_frame(frame);
+    LOG_INFO_0("Ingestor thread stopped");
+    if (snapshot_mode)
+        m_running.store(false);
+}
+
+void Ingestor::delete_frame(udf::Frame* frame) {
+    if (frame == m_clip_frame) {
+        m_clip_pending.buffer.reset();
+        m_clip_frame = NULL;
+    }
+    delete frame;
+}
+
+void Ingestor::drop_frame(udf::Frame* frame) {
+    delete_frame(frame);
+    uint64_t dropped = m_dropped_frames.fetch_add(1) + 1;
+    if (dropped == 1 || dropped % 100 == 0) {
+        LOG_WARN("UDF input queue full, %lu frames dropped so far", dropped);
+    }
+}
+
+void Ingestor::snapshot_done() {
+    std::lock_guard<std::mutex> lk(m_snapshot_mtx);
+    m_snapshot_count++;
+    m_snapshot_cv.notify_all();
+}
+
+QueueRetCode Ingestor::push_frame(udf::Frame* frame, bool wait) {
+    // Stamped before the push, the frame can be published and deleted as
+    // soon as it is in the queue
+    if (m_frame_stamps != NULL)
+        m_frame_stamps->put(frame, latency_now_ns());
+    QueueRetCode ret = wait ? m_udf_input_queue->push_wait(frame) : m_udf_input_queue->push(frame);
+    if (ret == QueueRetCode::SUCCESS && m_frame_merger != NULL)
+        m_frame_merger->notify();
+    return ret;
+}
+
+void Ingestor::enqueue_frame(udf::Frame* frame, bool snapshot_mode, int64_t capture_ns) {
+    enqueue_output_frame(frame, m_name, snapshot_mode, capture_ns);
+}
+
+void Ingestor::enqueue_output_frame(udf::Frame* frame, const std::string& route, bool snapshot_mode, int64_t capture_ns) {
+    int64_t start_ns = m_start_ns.exchange(0);
+    if (start_ns != 0) {
+        int64_t first_frame_ns = latency_now_ns() - start_ns;
+        if (m_start_warm)
+            m_first_frame_warm_latency.record(first_frame_ns);
+        else
+            m_first_frame_cold_latency.record(first_frame_ns);
+        LOG_INFO("First frame %.1f ms after the start (%s)",
+                 first_frame_ns / 1e6, m_start_warm ? "warm" : "cold");
+    }
+
+    if (route == m_name && !snapshot_mode) {
+        int64_t now_ns = latency_now_ns();
+        if (m_last_frame_ns != 0)
+            m_inter_frame_latency.record(now_ns - m_last_frame_ns);
+        m_last_frame_ns = now_ns;
+    }
+
+    if (!route.empty()) {
+        // Lets the publisher route the frame to the topic of this ingestor
+        msg_envelope_elem_body_t* elem = msgbus_msg_envelope_new_string(route.c_str());
+        if (elem == NULL ||
+                msgbus_msg_envelope_put(frame->get_meta_data(), INGESTOR_NAME_META, elem) != MSG_SUCCESS) {
+            LOG_ERROR_0("Failed to put ingestor_name in meta-data");
+            if (elem != NULL)
+                msgbus_msg_envelope_elem_destroy(elem);
+            drop_frame(frame);
+            return;
+        }
+    }
+
+    if (frame == m_clip_frame) {
+        // Only the main output goes to the pre-trigger ring
+        if (route == m_name) {
+            int64_t mono_ns = latency_now_ns();
+            int64_t wall_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::system_clock::now().time_since_epoch()).count();
+            m_clip_pending.time_ns = wall_ns - (mono_ns - ((capture_ns != 0) ? capture_ns : mono_ns));
+            m_clip_ring->push(m_clip_pending);
+        }
+        m_clip_pending.buffer.reset();
+        m_clip_frame = NULL;
+    }
+
+    if (m_standby.load() && !snapshot_mode) {
+        // Only the main output is kept for the snapshots
+        if (route == m_name)
+            m_latest_frame.put(frame, (capture_ns != 0) ? capture_ns : latency_now_ns());
+        else
+            delete frame;
+        return;
+    }
+
+    // Snapshots are requested explicitly and must not get lost
+    OverflowPolicy policy = snapshot_mode ? OVERFLOW_BLOCK : m_overflow_policy;
+
+    if (policy == OVERFLOW_DROP_OLDEST && m_frame_merger != NULL) {
+        // The frame merger pops under the queue lock, so the oldest frames
+        // can be evicted to make room for the new one
+        if (m_frame_stamps != NULL)
+            m_frame_stamps->put(frame, latency_now_ns());
+        std::vector<udf::Frame*> evicted;
+        bool pushed = m_udf_input_queue->push_evict(frame, evicted);
+        if (pushed)
+            m_frame_merger->notify();
+        for (auto old_frame : evicted)
+            drop_frame(old_frame);
+        if (pushed) {
+            m_overflow_count = 0;
+            m_queue_wait_latency.record(0);
+            if (capture_ns > 0)
+                m_capture_latency.record(latency_now_ns() - capture_ns);
+        }
+        return;
+    }
+
+    if (push_frame(frame, false) == QueueRetCode::SUCCESS) {
+        m_overflow_count = 0;
+        m_queue_wait_latency.record(0);
+        if (capture_ns > 0)
+            m_capture_latency.record(latency_now_ns() - capture_ns);
+        return;
+    }
+
+    bool wait = false;
+    switch (policy) {
+        case OVERFLOW_BLOCK:
+            wait = true;
+            break;
+        case OVERFLOW_DROP_NEWEST:
+            break;
+        case OVERFLOW_DROP_OLDEST:
+            // Only evicted from the queues of the frame merger, the queue
+            // read by the UDFs is not locked by its consumer
+            break;
+        case OVERFLOW_KEEP_EVERY_NTH:
+            wait = (++m_overflow_count % m_keep_every_nth) == 0;
+            break;
+    }
+
+    if (!wait) {
+        drop_frame(frame);
+        return;
+    }
+
+    int64_t wait_start = latency_now_ns();
+    if (push_frame(frame, true) != QueueRetCode::SUCCESS) {
+        LOG_ERROR_0("Failed to enqueue message, message dropped");
+        drop_frame(frame);
+        return;
+    }
+    int64_t pushed = latency_now_ns();
+    m_queue_wait_latency.record(pushed - wait_start);
+    if (capture_ns > 0)
+        m_capture_latency.record(pushed - capture_ns);
+}
+
+uint64_t Ingestor::get_dropped_frames() const {
+    return m_dropped_frames.load();
+}
+
+std::string Ingestor::get_name() const {
+    return m_name;
+}
+
+std::vector<IngestorOutput> Ingestor::get_outputs() const {
+    return std::vector<IngestorOutput>();
+}
+
+bool Ingestor::get_reconnect_stats(ReconnectStats& stats) const {
+    return false;
+}
+
+bool Ingestor::get_pool_stats(PoolStats& stats) const {
+    return false;
+}
+
+/**
+ * Buffer of a frame counted in the buffers in use of its ingestor
+ */
+struct CountedBuffer {
+    void* obj;
+    void (*free_frame)(void*);
+    std::atomic<uint64_t>* in_use;
+};
+
+/**
+ * Frame free callback releasing a counted buffer
+ */
+static void free_counted_buffer(void* obj) {
+    CountedBuffer* buf = (CountedBuffer*) obj;
+    std::atomic<uint64_t>* in_use = buf->in_use;
+    buf->free_frame(buf->obj);
+    delete buf;
+    // The ingestor may be deleted from here on
+    in_use->fetch_sub(1);
+}
+
+/**
+ * Frame free callback releasing a buffer shared with the pre-trigger ring
+ */
+static void free_shared_buffer(void* obj) {
+    delete (std::shared_ptr<void>*) obj;
+}
+
+Frame* Ingestor::new_frame(void* obj, void (*free_frame)(void*), void* data, int width, int height, int channels, const FrameFormat* fmt) {
+    m_buffers_in_use.fetch_add(1);
+    obj = new CountedBuffer{obj, free_frame, &m_buffers_in_use};
+    free_frame = free_counted_buffer;
+
+    if (m_clip_ring == NULL)
+        return new udf::Frame(obj, free_frame, data, width, height, channels);
+
+    // The frame and the ring each hold a reference on the buffer
+    std::shared_ptr<void> buffer(obj, free_frame);
+    udf::Frame* frame = new udf::Frame(
+            (void*) new std::shared_ptr<void>(buffer), free_shared_buffer,
+            data, width, height, channels);
+    m_clip_frame = frame;
+    m_clip_pending.buffer = std::move(buffer);
+    m_clip_pending.data = data;
+    m_clip_pending.width = width;
+    m_clip_pending.height = height;
+    m_clip_pending.channels = channels;
+    m_clip_pending.has_format = (fmt != NULL);
+    if (fmt != NULL)
+        m_clip_pending.format = *fmt;
+    m_clip_pending.size = (fmt != NULL) ? fmt->size : (size_t) width * height * channels;
+    return frame;
+}
+
+void Ingestor::release_frames() {
+    m_latest_frame.clear();
+    m_clip_pending.buffer.reset();
+    m_clip_frame = NULL;
+    if (m_clip_ring != NULL)
+        m_clip_ring->clear();
+}
+
+uint64_t Ingestor::get_buffers_in_use() const {
+    return m_buffers_in_use.load();
+}
+
+bool Ingestor::get_clip(int64_t start_ns, int64_t end_ns, std::vector<ClipFrame>& frames) {
+    if (m_clip_ring == NULL)
+        return false;
+    m_clip_ring->get_window(start_ns, end_ns, frames);
+    return true;
+}
+
+bool Ingestor::get_clip_stats(ClipStats& stats) const {
+    if (m_clip_ring == NULL)
+        return false;
+    stats = m_clip_ring->get_stats();
+    return true;
+}
+
+std::string Ingestor::get_clip_route() const {
+    if (m_clip_topic.empty())
+        return m_name;
+    return m_name.empty() ? "clip" : m_name + "/clip";
+}
+
+std::string Ingestor::get_clip_topic() const {
+    return m_clip_topic;
+}
+
+bool Ingestor::get_snapshot_standby() const {
+    return m_snapshot_standby;
+}
+
+void Ingestor::set_standby(bool standby) {
+    m_standby.store(standby);
+    // The frame kept back would be stale by the next standby
+    if (!standby)
+        m_latest_frame.clear();
+}
+
+bool Ingestor::take_snapshot(int64_t after_ns, int64_t timeout_ns, int64_t& capture_ns) {
+    udf::Frame* frame = m_latest_frame.take(after_ns, timeout_ns, capture_ns);
+    if (frame == NULL)
+        return false;
+    // Snapshots wait for space in the queue like in snapshot mode
+    if (push_frame(frame, true) != QueueRetCode::SUCCESS)
+        drop_frame(frame);
+    return true;
+}
+
+uint64_t Ingestor::get_snapshot_count() {
+    std::lock_guard<std::mutex> lk(m_snapshot_mtx);
+    return m_snapshot_count;
+}
+
+bool Ingestor::wait_snapshot(uint64_t count, int64_t timeout_ns) {
+    std::unique_lock<std::mutex> lk(m_snapshot_mtx);
+    return m_snapshot_cv.wait_for(lk, std::chrono::nanoseconds(timeout_ns), [this, count]() {
+        return m_snapshot_count > count;
+    });
+}
+
+bool Ingestor::is_capture_open() const {
+    return false;
+}
+
+bool Ingestor::get_pacing_stats(PacingStats& stats) {
+    if (!m_pacer.enabled())
+        return false;
+    stats = m_pacer.get_stats();
+    return true;
+}
+
+const LatencyHistogram* Ingestor::get_latency(LatencyStage stage) const {
+    switch (stage) {
+        case STAGE_CAPTURE_TO_ENQUEUE:
+            return &m_capture_latency;
+        case STAGE_QUEUE_WAIT:
+            return &m_queue_wait_latency;
+        case STAGE_FIRST_FRAME_COLD:
+            return &m_first_frame_cold_latency;
+        case STAGE_FIRST_FRAME_WARM:
+            return &m_first_frame_warm_latency;
+        case STAGE_INTER_FRAME:
+            return &m_inter_frame_latency;
+        default:
+            return NULL;
+    }
+}
+
+void Ingestor::set_frame_stamps(FrameStamps* frame_stamps) {
+    m_frame_stamps = frame_stamps;
+}
+
+void Ingestor::set_frame_merger(FrameMerger* frame_merger) {
+    m_frame_merger = frame_merger;
+}
+
+void Ingestor::set_convert_to_bgr(bool convert) {
+    m_convert_to_bgr.store(convert);
+}
+
+Ingestor* eii::vi::get_ingestor(config_t* config, FrameQueue* frame_queue, const char* type, std::string service_name, std::condition_variable& snapshot_cv, EncodeType enc_type, int enc_lvl, bool pipeline_from_env) {
     Ingestor* ingestor = NULL;
 
     // Get pipleine environment variable if it exists
-    const char* pipeline_env_var = getenv("PIPELINE");
+    const char* pipeline_env_var = pipeline_from_env ? getenv("PIPELINE") : NULL;
 
     if (pipeline_env_var != NULL && strlen(pipeline_env_var) > 0) {
         LOG_DEBUG("PIPELINE environment variable = %s", pipeline_env_var);
@@ -129,6 +721,8 @@ Ingestor* eii::vi::get_ingestor(config_t* config, FrameQueue* frame_queue, const
         ingestor = new GstreamerIngestor(config, frame_queue, service_name, snapshot_cv, enc_type, enc_lvl);
     } else if (!strcmp(type, "realsense")) {
         ingestor = new RealSenseIngestor(config, frame_queue, service_name, snapshot_cv, enc_type, enc_lvl);
+    } else if (!strcmp(type, "synthetic")) {
+        ingestor = new SyntheticIngestor(config, frame_queue, service_name, snapshot_cv, enc_type, enc_lvl);
     } else {
         throw("Unknown ingestor");
     }
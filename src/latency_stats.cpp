@@ -0,0 +1,153 @@
+// Copyright (c) 2020 Intel Corporation.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM,OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+/**
+ * @file
+ * @brief LatencyHistogram and FrameStamps implementation
+ */
+
+#include <algorithm>
+#include "eii/vi/latency_stats.h"
+
+using namespace eii::vi;
+
+const char* const eii::vi::LATENCY_STAGE_NAMES[STAGE_COUNT] = {
+    "capture_to_enqueue",
+    "queue_wait",
+    "udf",
+    "publish",
+    "first_frame_cold",
+    "first_frame_warm",
+    "inter_frame",
+};
+
+LatencyHistogram::LatencyHistogram() {
+    for (int i = 0; i < BUCKETS; i++)
+        m_buckets[i].store(0, std::memory_order_relaxed);
+    m_count.store(0, std::memory_order_relaxed);
+    m_sum.store(0, std::memory_order_relaxed);
+    m_max.store(0, std::memory_order_relaxed);
+}
+
+int LatencyHistogram::bucket_index(int64_t ns) {
+    if (ns < SUB_BUCKETS)
+        return (int) ns;
+    int exponent = 63 - __builtin_clzll((uint64_t) ns);
+    if (exponent > MAX_EXPONENT)
+        return BUCKETS - 1;
+    int sub = (int) (ns >> (exponent - SUB_BUCKET_BITS)) - SUB_BUCKETS;
+    return SUB_BUCKETS * (exponent - SUB_BUCKET_BITS + 1) + sub;
+}
+
+int64_t LatencyHistogram::bucket_value(int index) {
+    if (index < SUB_BUCKETS)
+        return index;
+    int exponent = index / SUB_BUCKETS + SUB_BUCKET_BITS - 1;
+    int sub = index % SUB_BUCKETS;
+    int shift = exponent - SUB_BUCKET_BITS;
+    // Middle of the bucket
+    return ((int64_t) (SUB_BUCKETS + sub) << shift) + (((int64_t) 1 << shift) >> 1);
+}
+
+void LatencyHistogram::record(int64_t ns) {
+    if (ns < 0)
+        ns = 0;
+    // Single writer, plain load and store are enough
+    std::atomic<uint64_t>& bucket = m_buckets[bucket_index(ns)];
+    bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    m_sum.store(m_sum.load(std::memory_order_relaxed) + ns, std::memory_order_relaxed);
+    if (ns > m_max.load(std::memory_order_relaxed))
+        m_max.store(ns, std::memory_order_relaxed);
+    m_count.store(m_count.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+LatencySummary LatencyHistogram::summarize(const std::vector<const LatencyHistogram*>& histograms) {
+    LatencySummary summary = {0, 0, 0, 0, 0, 0};
+    std::vector<uint64_t> buckets(BUCKETS, 0);
+    int64_t sum = 0;
+
+    for (auto h : histograms) {
+        if (h->m_count.load(std::memory_order_acquire) == 0)
+            continue;
+        for (int i = 0; i < BUCKETS; i++) {
+            uint64_t n = h->m_buckets[i].load(std::memory_order_relaxed);
+            buckets[i] += n;
+            summary.count += n;
+        }
+        sum += h->m_sum.load(std::memory_order_relaxed);
+        summary.max = std::max(summary.max, h->m_max.load(std::memory_order_relaxed));
+    }
+    if (summary.count == 0)
+        return summary;
+    summary.mean = sum / (int64_t) summary.count;
+
+    // Ranks of the percentiles, rounded up
+    const double quantiles[] = {0.5, 0.99, 0.999};
+    int64_t* values[] = {&summary.p50, &summary.p99, &summary.p999};
+    uint64_t seen = 0;
+    int q = 0;
+    for (int i = 0; i < BUCKETS && q < 3; i++) {
+        seen += buckets[i];
+        while (q < 3 && seen > 0 &&
+                seen >= (uint64_t) (quantiles[q] * summary.count + 0.999999)) {
+            *values[q] = std::min(bucket_value(i), summary.max);
+            q++;
+        }
+    }
+    return summary;
+}
+
+FrameStamps::FrameStamps() {
+    for (int i = 0; i < SLOTS; i++) {
+        m_slots[i].seq.store(0, std::memory_order_relaxed);
+        m_slots[i].key.store(0, std::memory_order_relaxed);
+        m_slots[i].ns.store(0, std::memory_order_relaxed);
+    }
+}
+
+int FrameStamps::slot_index(const void* frame) {
+    uint64_t key = (uint64_t) (uintptr_t) frame;
+    return (int) ((key * 0x9E3779B97F4A7C15ULL) >> (64 - SLOT_BITS));
+}
+
+void FrameStamps::put(const void* frame, int64_t ns) {
+    Slot& slot = m_slots[slot_index(frame)];
+    uint32_t seq = slot.seq.load(std::memory_order_relaxed);
+    // Another writer owns the slot, the sample is lost
+    if ((seq & 1) || !slot.seq.compare_exchange_strong(seq, seq + 1, std::memory_order_acquire))
+        return;
+    slot.key.store((uintptr_t) frame, std::memory_order_relaxed);
+    slot.ns.store(ns, std::memory_order_relaxed);
+    slot.seq.store(seq + 2, std::memory_order_release);
+}
+
+bool FrameStamps::get(const void* frame, int64_t& ns) {
+    Slot& slot = m_slots[slot_index(frame)];
+    uint32_t seq = slot.seq.load(std::memory_order_acquire);
+    if (seq & 1)
+        return false;
+    uintptr_t key = slot.key.load(std::memory_order_relaxed);
+    int64_t value = slot.ns.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (slot.seq.load(std::memory_order_relaxed) != seq || key != (uintptr_t) frame)
+        return false;
+    ns = value;
+    return true;
+}
@@ -24,18 +24,22 @@
  */
 
 #include <unistd.h>
+#include <pthread.h>
 #include <condition_variable>
 #include <safe_lib.h>
 #include <stdbool.h>
 #include <eii/utils/json_validator.h>
 #include <mutex>
 #include <atomic>
+#include <thread>
+#include <chrono>
 #include <csignal>
 #include <fstream>
 #include <iostream>
 #include "eii/vi/video_ingestion.h"
 
 #define MAX_CONFIG_KEY_LENGTH 250
+#define SCHEMA_PATH "./VideoIngestion/schema.json"
 
 using namespace eii::vi;
 using namespace eii::ch;
@@ -48,35 +52,47 @@ static char* g_vi_config = NULL;
 static std::condition_variable g_err_cv;
 static ConfigMgr* g_cfg_mgr = NULL;
 static std::atomic<bool> g_cfg_change;
+static std::atomic<bool> g_exit;
+// Protects the config handed over by the watch callback
+static std::mutex g_mtx;
+static char* g_new_config = NULL;
 
 void usage(const char* name) {
     printf("Usage: %s \n", name);
 }
 
-void signal_callback_handler(int signum) {
+void signal_run(sigset_t sigset) {
+    // The teardown is left to the main thread, deleting VideoIngestion from
+    // a signal handler could interrupt a thread it joins
+    int signum = 0;
+    if (sigwait(&sigset, &signum) != 0) {
+        LOG_ERROR_0("Failed to wait for the signals");
+        return;
+    }
     if (signum == SIGTERM) {
         LOG_INFO("Received SIGTERM signal, terminating Video Ingestion");
-    } else if (signum == SIGABRT) {
-        LOG_INFO("Received SIGABRT signal, terminating Video Ingestion");
     } else if (signum == SIGINT) {
         LOG_INFO("Received Ctrl-C, terminating Video Ingestion");
     }
-
-    if (g_vi) {
-        delete g_vi;
+    {
+        std::lock_guard<std::mutex> lk(g_mtx);
+        g_exit.store(true);
     }
-    exit(0);
+    g_err_cv.notify_all();
 }
 
 void clean_up() {
     if (g_ch) {
         delete g_ch;
+        g_ch = NULL;
     }
     if (g_vi) {
         delete g_vi;
+        g_vi = NULL;
     }
     if (g_cfg_mgr) {
         delete g_cfg_mgr;
+        g_cfg_mgr = NULL;
     }
 }
 
@@ -119,34 +135,73 @@ void vi_initialize(char* vi_config, std::string app_name) {
     }
 }
 
+void apply_config(char* vi_config, std::string app_name) {
+    if (!strcmp(g_vi_config, vi_config)) {
+        free(vi_config);
+        return;
+    }
+    if (!validate_json_file_buffer(SCHEMA_PATH, vi_config)) {
+        LOG_ERROR_0("Schema validation failed, keeping the current config");
+        free(vi_config);
+        return;
+    }
+
+    // Only the changed components are rebuilt, a change of the publisher
+    // restarts the whole pipeline
+    auto start = std::chrono::steady_clock::now();
+    bool done = false;
+    if (g_vi) {
+        try {
+            done = g_vi->reconfigure(vi_config);
+        } catch(const char *err) {
+            LOG_ERROR("Reconfiguration failed: %s", err);
+        } catch(const std::exception& ex) {
+            LOG_ERROR("Reconfiguration failed: %s", ex.what());
+        } catch(...) {
+            LOG_ERROR_0("Reconfiguration failed");
+        }
+    }
+    if (!done) {
+        vi_initialize(vi_config, app_name);
+    }
+    free(g_vi_config);
+    g_vi_config = vi_config;
+    double ms = std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - start).count();
+    LOG_INFO("Configuration applied in %.1f ms (%s)", ms,
+             done ? "reconfigured" : "restarted");
+}
+
 void on_change_config_callback(const char* key, config_t* value,
                                void* user_data) {
     LOG_INFO("Callback triggered for key %s", key);
     char* vi_config = configt_to_char(value);
-    if (strcmp(g_vi_config, vi_config)) {
-	// Deleting of g_vi, g_vi_config was hanging with gstreamer ingestor.
-	// Making a forceful exit until this is fixed.
-	// This shouldnt cause memory leaks as the application process is
-	// exiting and re-spawned by docker clearing all process allocated
-	// memory.
-        _Exit(-1);
-        /*if(g_vi) {
-            delete g_vi;
-            g_vi = NULL;
+    if (vi_config == NULL) {
+        LOG_ERROR_0("Unable to fetch app config string");
+        return;
+    }
+    // Applied by the main thread, a newer config replaces a pending one
+    {
+        std::lock_guard<std::mutex> lk(g_mtx);
+        if (g_new_config != NULL) {
+            free(g_new_config);
         }
-        delete g_vi_config;*/
-        // TODO: Uncomment the below logic once the dynamic cfg fix works as
-        // expected
-        // g_vi_config = vi_config;
-        // g_cfg_change.store(true);
-        // g_err_cv.notify_one();
+        g_new_config = vi_config;
+        g_cfg_change.store(true);
     }
+    g_err_cv.notify_all();
 }
 
 int main(int argc, char** argv) {
-    signal(SIGINT, signal_callback_handler);
-    signal(SIGABRT, signal_callback_handler);
-    signal(SIGTERM, signal_callback_handler);
+    // Blocked before any thread is created, so that they are only
+    // delivered to the signal thread
+    sigset_t sigset;
+    sigemptyset(&sigset);
+    sigaddset(&sigset, SIGINT);
+    sigaddset(&sigset, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &sigset, NULL);
+    std::thread signal_th(signal_run, sigset);
+    signal_th.detach();
 
     try {
         if (argc >= 2) {
@@ -173,8 +228,7 @@ int main(int argc, char** argv) {
         LOG_DEBUG("App config: %s", g_vi_config);
 
         // Validating config against schema
-        if (!validate_json_file_buffer(
-                    "./VideoIngestion/schema.json", g_vi_config)) {
+        if (!validate_json_file_buffer(SCHEMA_PATH, g_vi_config)) {
             LOG_ERROR_0("Schema validation failed");
             return -1;
         }
@@ -208,20 +262,25 @@ int main(int argc, char** argv) {
 
         vi_initialize(g_vi_config, app_name);
 
-        std::mutex mtx;
-
-        while (true) {
-            std::unique_lock<std::mutex> lk(mtx);
-            g_err_cv.wait(lk);
-            if (g_cfg_change.load()) {
-                vi_initialize(g_vi_config, app_name);
-                g_cfg_change.store(false);
-            } else {
+        while (g_vi != NULL) {
+            std::unique_lock<std::mutex> lk(g_mtx);
+            if (!g_cfg_change.load() && !g_exit.load()) {
+                g_err_cv.wait(lk);
+            }
+            if (g_exit.load() || !g_cfg_change.load()) {
                 break;
             }
+            char* vi_config = g_new_config;
+            g_new_config = NULL;
+            g_cfg_change.store(false);
+            lk.unlock();
+            apply_config(vi_config, app_name);
         }
 
         clean_up();
+        if (g_exit.load()) {
+            return 0;
+        }
     } catch(const char *err) {
         LOG_ERROR("Exception occurred: %s", err);
         clean_up();
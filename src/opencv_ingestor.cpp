@@ -45,6 +45,14 @@ using namespace eii::udf;
 #define PIPELINE "pipeline"
 #define LOOP_VIDEO "loop_video"
 #define UUID_LENGTH 5
+#define QUEUE_SIZE "queue_size"
+#define DEFAULT_QUEUE_SIZE 10
+#define READ_AHEAD "read_ahead"
+#define BATCH_DECODE "batch_decode"
+#define BATCH_WINDOW "batch_window"
+#define DEFAULT_BATCH_WINDOW 256
+// Stop check period once the video or the images have ended
+#define END_OF_INPUT_POLL std::chrono::milliseconds(100)
 
 
 OpenCvIngestor::OpenCvIngestor(config_t* config, FrameQueue* frame_queue, std::string service_name, std::condition_variable& snapshot_cv, EncodeType enc_type, int enc_lvl):
@@ -57,6 +65,14 @@ OpenCvIngestor::OpenCvIngestor(config_t* config, FrameQueue* frame_queue, std::s
     m_double_frames = false;
     m_initialized.store(true);
     m_img_flag = false;
+    m_read_ahead = 0;
+    m_decode_th = NULL;
+    m_prefetch = NULL;
+    m_decode_stop.store(false);
+    m_decode_end.store(false);
+    m_batch_threads = 0;
+    m_batch = NULL;
+    m_batch_running = false;
 
 
     config_value_t* cvt_double = config_get(config, "double_frames");
@@ -99,6 +115,78 @@ OpenCvIngestor::OpenCvIngestor(config_t* config, FrameQueue* frame_queue, std::s
     LOG_INFO("Pipeline: %s", m_pipeline.c_str());
     config_value_destroy(cvt_pipeline);
 
+    // Frames in flight are bounded by the UDF input and output queues, plus
+    // the frames being decoded and published
+    size_t queue_size = DEFAULT_QUEUE_SIZE;
+    config_value_t* cvt_queue_size = config->get_config_value(config->cfg, QUEUE_SIZE);
+    if (cvt_queue_size != NULL) {
+        if (cvt_queue_size->type == CVT_INTEGER && cvt_queue_size->body.integer > 0)
+            queue_size = cvt_queue_size->body.integer;
+        config_value_destroy(cvt_queue_size);
+    }
+    config_value_t* cvt_read_ahead = config->get_config_value(config->cfg, READ_AHEAD);
+    if (cvt_read_ahead != NULL) {
+        if (cvt_read_ahead->type != CVT_INTEGER || cvt_read_ahead->body.integer < 0) {
+            config_value_destroy(cvt_read_ahead);
+            const char* err = "read_ahead must be a non-negative integer";
+            LOG_ERROR("%s", err);
+            throw(err);
+        }
+        m_read_ahead = cvt_read_ahead->body.integer;
+        config_value_destroy(cvt_read_ahead);
+    }
+    config_value_t* cvt_batch = config->get_config_value(config->cfg, BATCH_DECODE);
+    if (cvt_batch != NULL) {
+        if (cvt_batch->type != CVT_INTEGER || cvt_batch->body.integer < 0) {
+            config_value_destroy(cvt_batch);
+            const char* err = "batch_decode must be a non-negative integer";
+            LOG_ERROR("%s", err);
+            throw(err);
+        }
+        m_batch_threads = cvt_batch->body.integer;
+        config_value_destroy(cvt_batch);
+    }
+    size_t batch_window = DEFAULT_BATCH_WINDOW;
+    config_value_t* cvt_batch_window = config->get_config_value(config->cfg, BATCH_WINDOW);
+    if (cvt_batch_window != NULL) {
+        if (cvt_batch_window->type != CVT_INTEGER || cvt_batch_window->body.integer < 1) {
+            config_value_destroy(cvt_batch_window);
+            const char* err = "batch_window must be a positive integer";
+            LOG_ERROR("%s", err);
+            throw(err);
+        }
+        batch_window = cvt_batch_window->body.integer;
+        config_value_destroy(cvt_batch_window);
+    }
+    size_t pool_capacity = 2 * queue_size + 2;
+    if (m_batch_threads > 0) {
+        if (m_read_ahead > 0) {
+            LOG_WARN_0("read_ahead is ignored with batch_decode");
+            m_read_ahead = 0;
+        }
+        // Reprocessing a file goes as fast as the UDFs and must not lose
+        // frames
+        m_pacer.set_period(0.0);
+        if (m_overflow_policy != OVERFLOW_BLOCK) {
+            LOG_WARN_0("overflow_policy is ignored with batch_decode, a full "
+                       "UDF input queue blocks the decoders");
+            m_overflow_policy = OVERFLOW_BLOCK;
+        }
+        // Frames held back in the window, and a frame per decoder waiting
+        // for its place in it
+        pool_capacity += batch_window + m_batch_threads;
+        LOG_INFO("Batch decode: %zu threads, window of %zu frames",
+                 m_batch_threads, batch_window);
+    }
+    if (m_read_ahead > 0) {
+        m_prefetch = new LockFreeQueue<PooledMat*>(m_read_ahead, SINGLE_PRODUCER);
+        // The queue capacity is a power of two
+        m_read_ahead = m_prefetch->capacity();
+    }
+    m_pool = std::make_shared<MatPool>(pool_capacity + m_read_ahead);
+    if (m_batch_threads > 0)
+        m_batch = new SegmentDecoder(m_pipeline, m_batch_threads, batch_window, m_pool);
+
     config_value_t* cvt_loop_video = config->get_config_value(
             config->cfg, LOOP_VIDEO);
     if (cvt_loop_video != NULL) {
@@ -132,6 +220,13 @@ OpenCvIngestor::~OpenCvIngestor() {
         m_cap->release();
         LOG_DEBUG_0("Cap deleted");
     }
+    stop_decoder();
+    if (m_batch != NULL)
+        delete m_batch;
+    if (m_prefetch != NULL)
+        delete m_prefetch;
+    // Frames still in flight free their buffers instead of recycling them
+    m_pool->close();
 }
 
 void free_cv_frame(void* obj) {
@@ -151,6 +246,20 @@ void OpenCvIngestor::run(bool snapshot_mode) {
 
     msg_envelope_elem_body_t* elem = NULL;
 
+    // Video frames are decoded ahead on a thread of their own, so that the
+    // decode stalls do not delay the frames, a snapshot only needs one
+    if (m_read_ahead > 0 && !m_img_flag && !snapshot_mode) {
+        m_decode_stop.store(false);
+        m_decode_end.store(false);
+        m_decode_th = new std::thread(&OpenCvIngestor::decode_run, this);
+    }
+    // The batch decoder starts over from the first frame of the file
+    if (m_batch != NULL && !m_img_flag && !snapshot_mode) {
+        if (!m_batch->start())
+            LOG_ERROR("Failed to start the batch decode of %s", m_pipeline.c_str());
+        m_batch_running = true;
+    }
+
     try {
         while (!m_stop.load()) {
 
@@ -159,11 +268,11 @@ void OpenCvIngestor::run(bool snapshot_mode) {
             } else {
                 this->read(frame);
             }
+            // No frame when the input ended and the ingestor is stopped
+            if (frame == NULL)
+                continue;
+            int64_t capture_ns = latency_now_ns();
             msg_envelope_t* meta_data = frame->get_meta_data();
-            // Profiling start
-            DO_PROFILING(this->m_profile, meta_data, "ts_Ingestor_entry")
-
-            // Profiling end
 
             msgbus_ret_t ret;
             if (frame_count == INT64_MAX) {
@@ -175,14 +284,14 @@ void OpenCvIngestor::run(bool snapshot_mode) {
 
             elem = msgbus_msg_envelope_new_integer(frame_count);
             if (elem == NULL) {
-                delete frame;
+                delete_frame(frame);
                 const char* err = "Failed to create frame_number element";
                 LOG_ERROR("%s", err);
                 throw err;
             }
             ret = msgbus_msg_envelope_put(meta_data, "frame_number", elem);
             if (ret != MSG_SUCCESS) {
-                delete frame;
+                delete_frame(frame);
                 const char* err = "Failed to put frame_number in meta-data";
                 LOG_ERROR("%s", err);
                 throw err;
@@ -190,10 +299,6 @@ void OpenCvIngestor::run(bool snapshot_mode) {
             elem = NULL;
             LOG_DEBUG("Frame number: %ld", frame_count);
 
-            // Profiling start
-            DO_PROFILING(this->m_profile, meta_data, "ts_filterQ_entry")
-            // Profiling end
-
             // Set encding type and level
             try {
                 frame->set_encoding(m_enc_type, m_enc_lvl);
@@ -203,21 +308,13 @@ void OpenCvIngestor::run(bool snapshot_mode) {
                 LOG_ERROR("Exception occurred in set_encoding()");
             }
 
-            QueueRetCode ret_queue = m_udf_input_queue->push(frame);
-            if (ret_queue == QueueRetCode::QUEUE_FULL) {
-                if (m_udf_input_queue->push_wait(frame) != QueueRetCode::SUCCESS) {
-                    LOG_ERROR_0("Failed to enqueue message, "
-                                "message dropped");
-                }
-                // Add timestamp which acts as a marker if queue if blocked
-                DO_PROFILING(this->m_profile, meta_data, m_ingestor_block_key.c_str());
-            }
+            enqueue_frame(frame, snapshot_mode, capture_ns);
 
             frame = NULL;
 
             if (snapshot_mode) {
                 m_stop.store(true);
-                m_snapshot_cv.notify_all();
+                snapshot_done();
             }
         }
     } catch(const char* err) {
@@ -225,30 +322,29 @@ void OpenCvIngestor::run(bool snapshot_mode) {
         if (elem != NULL)
             msgbus_msg_envelope_elem_destroy(elem);
         if (frame != NULL)
-            delete frame;
+            delete_frame(frame);
+        stop_decoder();
         throw err;
     } catch(...) {
         LOG_ERROR("Exception occured in opencv ingestor run()");
         if (elem != NULL)
             msgbus_msg_envelope_elem_destroy(elem);
         if (frame != NULL)
-            delete frame;
+            delete_frame(frame);
+        stop_decoder();
         throw;
     }
+    stop_decoder();
     if (elem != NULL)
         msgbus_msg_envelope_elem_destroy(elem);
     if (frame != NULL)
-        delete frame;
+        delete_frame(frame);
     LOG_INFO_0("Ingestor thread stopped");
     if (snapshot_mode)
         m_running.store(false);
 }
 
-void OpenCvIngestor::read(Frame*& frame) {
-
-    cv::Mat* cv_frame = new cv::Mat();
-    cv::Mat* frame_copy = NULL;
-
+bool OpenCvIngestor::decode(cv::Mat* cv_frame) {
     if (m_cap == NULL) {
         m_cap = new cv::VideoCapture(m_pipeline);
         if (!m_cap->isOpened()) {
@@ -268,10 +364,7 @@ void OpenCvIngestor::read(Frame*& frame) {
             } else {
                 const char* err = "Video ended...";
                 LOG_WARN("%s", err);
-                // Sleeping indefinitely to avoid restart
-                while (true) {
-                    std::this_thread::sleep_for(std::chrono::seconds(5));
-                }
+                return false;
             }
             m_cap->read(*cv_frame);
         } else {
@@ -280,11 +373,107 @@ void OpenCvIngestor::read(Frame*& frame) {
             LOG_ERROR("%s", err);
         }
     }
+    return true;
+}
+
+void OpenCvIngestor::decode_run() {
+    LOG_DEBUG_0("Decoder thread started");
+    while (!m_decode_stop.load()) {
+        // Decode into a recycled buffer, VideoCapture::read() keeps it as
+        // long as the frame geometry does not change
+        PooledMat* pooled = m_pool->acquire();
+        if (!decode(&pooled->mat)) {
+            MatPool::free_pooled_mat(pooled);
+            m_decode_end.store(true);
+            break;
+        }
+        // The stop flag is not notified, it is polled while the queue is
+        // full
+        while (m_prefetch->push_wait(pooled, END_OF_INPUT_POLL) != QueueRetCode::SUCCESS) {
+            if (m_decode_stop.load()) {
+                MatPool::free_pooled_mat(pooled);
+                break;
+            }
+        }
+    }
+    LOG_DEBUG_0("Decoder thread stopped");
+}
+
+PooledMat* OpenCvIngestor::next_decoded() {
+    PooledMat* pooled = NULL;
+    // The stop flag is not notified, it is polled
+    while (!m_stop.load()) {
+        if (m_prefetch->pop_wait(pooled, END_OF_INPUT_POLL))
+            return pooled;
+        // The last frames are pushed before the end is flagged
+        if (m_decode_end.load())
+            return m_prefetch->pop(pooled) ? pooled : NULL;
+    }
+    return NULL;
+}
+
+PooledMat* OpenCvIngestor::next_batch() {
+    PooledMat* pooled = m_batch->next(m_stop);
+    if (pooled != NULL || m_stop.load())
+        return pooled;
+    LOG_INFO("Batch decode: %lu frames in %zu segments, %.1f fps",
+             m_batch->get_frames(), m_batch->get_segments(), m_batch->get_fps());
+    if (!m_loop_video) {
+        LOG_WARN_0("Video ended...");
+        return NULL;
+    }
+    LOG_WARN_0("Video ended. Looping...");
+    if (!m_batch->start())
+        return NULL;
+    return m_batch->next(m_stop);
+}
+
+void OpenCvIngestor::stop_decoder() {
+    if (m_batch_running) {
+        m_batch->stop();
+        m_batch_running = false;
+    }
+    if (m_decode_th == NULL)
+        return;
+    m_decode_stop.store(true);
+    m_decode_th->join();
+    delete m_decode_th;
+    m_decode_th = NULL;
+    // The frames decoded ahead go back to the pool, the capture may be
+    // released or reopened before the next start
+    PooledMat* pooled = NULL;
+    while (m_prefetch->pop(pooled))
+        MatPool::free_pooled_mat(pooled);
+}
+
+void OpenCvIngestor::read(Frame*& frame) {
+    PooledMat* pooled = NULL;
+    if (m_batch_running) {
+        pooled = next_batch();
+    } else if (m_decode_th != NULL) {
+        pooled = next_decoded();
+    } else {
+        pooled = m_pool->acquire();
+        if (!decode(&pooled->mat)) {
+            MatPool::free_pooled_mat(pooled);
+            pooled = NULL;
+        }
+    }
+    if (pooled == NULL) {
+        // Sleeping until stopped to avoid restart
+        while (!m_stop.load()) {
+            std::this_thread::sleep_for(END_OF_INPUT_POLL);
+        }
+        frame = NULL;
+        return;
+    }
+    cv::Mat* cv_frame = &pooled->mat;
+    cv::Mat* frame_copy = NULL;
 
     LOG_DEBUG_0("Frame read successfully");
 
-    frame = new Frame(
-            (void*) cv_frame, free_cv_frame, (void*) cv_frame->data,
+    frame = new_frame(
+            (void*) pooled, MatPool::free_pooled_mat, (void*) cv_frame->data,
             cv_frame->cols, cv_frame->rows, cv_frame->channels());
 
     if (m_double_frames) {
@@ -296,9 +485,7 @@ void OpenCvIngestor::read(Frame*& frame) {
             EncodeType::NONE, 0);
     }
 
-    if (m_poll_interval > 0) {
-        usleep(m_poll_interval * 1000 * 1000);
-    }
+    m_pacer.wait();
 }
 
 void OpenCvIngestor::imread(Frame*& frame) {
@@ -364,10 +551,13 @@ void OpenCvIngestor::imread(Frame*& frame) {
                 } else {
                     const char* err = "Images ended...";
                     LOG_WARN("%s", err);
-                    // Sleeping indefinitely to avoid restart
-                    while (true) {
-                        std::this_thread::sleep_for(std::chrono::seconds(5));
+                    // Sleeping until stopped to avoid restart
+                    while (!m_stop.load()) {
+                        std::this_thread::sleep_for(END_OF_INPUT_POLL);
                     }
+                    delete cv_frame;
+                    frame = NULL;
+                    return;
 	        }
             } else {
 		// proceed to the next image format
@@ -397,13 +587,11 @@ void OpenCvIngestor::imread(Frame*& frame) {
 
     LOG_DEBUG_0("Image read successfully");
 
-    frame = new Frame(
+    frame = new_frame(
             (void*) cv_frame, free_cv_frame, (void*) cv_frame->data,
             cv_frame->cols, cv_frame->rows, cv_frame->channels());
 
-    if (m_poll_interval > 0) {
-        usleep(m_poll_interval * 1000 * 1000);
-    }
+    m_pacer.wait();
 }
 
 void OpenCvIngestor::stop() {
@@ -419,8 +607,20 @@ void OpenCvIngestor::stop() {
     // so that the ingestor is ready for the next ingestion.
     m_running.store(false);
     m_stop.store(false);
-    LOG_INFO_0("Releasing video capture object");
-    if (m_cap != NULL) {
+    LOG_INFO("Frame pool: %lu hits, %lu misses", m_pool->get_hits(), m_pool->get_misses());
+    if (m_pacer.enabled()) {
+        PacingStats stats = m_pacer.get_stats();
+        LOG_INFO("Frame pacing: %lu frames, %lu late, %lu periods skipped, "
+                 "jitter avg %ld us max %ld us", stats.frames, stats.late_frames,
+                 stats.skipped_periods, stats.jitter_avg_ns / 1000,
+                 stats.jitter_max_ns / 1000);
+    }
+    if (m_warm_standby && is_capture_open()) {
+        // Reopening a camera or a stream takes far longer than a frame
+        // period, the next start() resumes reading from it
+        LOG_INFO_0("Keeping the video capture object open");
+    } else if (m_cap != NULL) {
+        LOG_INFO_0("Releasing video capture object");
         m_cap->release();
         delete m_cap;
         m_cap = NULL;
@@ -428,3 +628,13 @@ void OpenCvIngestor::stop() {
     }
     }
 }
+
+bool OpenCvIngestor::is_capture_open() const {
+    return m_cap != NULL && m_cap->isOpened();
+}
+
+bool OpenCvIngestor::get_pool_stats(PoolStats& stats) const {
+    stats.hits = m_pool->get_hits();
+    stats.misses = m_pool->get_misses();
+    return true;
+}
@@ -182,11 +182,8 @@ void RealSenseIngestor::run(bool snapshot_mode) {
         while (!m_stop.load()) {
             this->read(frame);
 
+            int64_t capture_ns = latency_now_ns();
             msg_envelope_t* meta_data = frame->get_meta_data();
-            // Profiling start
-            DO_PROFILING(this->m_profile, meta_data, "ts_Ingestor_entry")
-
-            // Profiling end
 
             msgbus_ret_t ret;
             if (frame_count == INT64_MAX) {
@@ -198,14 +195,14 @@ void RealSenseIngestor::run(bool snapshot_mode) {
 
             elem = msgbus_msg_envelope_new_integer(frame_count);
             if (elem == NULL) {
-                delete frame;
+                delete_frame(frame);
                 const char* err = "Failed to create frame_number element";
                 LOG_ERROR("%s", err);
                 throw err;
             }
             ret = msgbus_msg_envelope_put(meta_data, "frame_number", elem);
             if (ret != MSG_SUCCESS) {
-                delete frame;
+                delete_frame(frame);
                 const char* err = "Failed to put frame_number in meta-data";
                 LOG_ERROR("%s", err);
                 throw err;
@@ -213,10 +210,6 @@ void RealSenseIngestor::run(bool snapshot_mode) {
             elem = NULL;
             LOG_DEBUG("Frame number: %ld", frame_count);
 
-            // Profiling start
-            DO_PROFILING(this->m_profile, meta_data, "ts_filterQ_entry")
-            // Profiling end
-
             // Set encding type and level
             try {
                 frame->set_encoding(m_enc_type, m_enc_lvl);
@@ -226,21 +219,13 @@ void RealSenseIngestor::run(bool snapshot_mode) {
                 LOG_ERROR("Exception occurred in set_encoding()");
             }
 
-            QueueRetCode ret_queue = m_udf_input_queue->push(frame);
-            if (ret_queue == QueueRetCode::QUEUE_FULL) {
-                if (m_udf_input_queue->push_wait(frame) != QueueRetCode::SUCCESS) {
-                    LOG_ERROR_0("Failed to enqueue message, "
-                                "message dropped");
-                }
-                // Add timestamp which acts as a marker if queue if blocked
-                DO_PROFILING(this->m_profile, meta_data, m_ingestor_block_key.c_str());
-            }
+            enqueue_frame(frame, snapshot_mode, capture_ns);
 
             frame = NULL;
 
             if (snapshot_mode) {
                 m_stop.store(true);
-                m_snapshot_cv.notify_all();
+                snapshot_done();
             }
         }
     } catch(const char* e) {
@@ -248,7 +233,7 @@ void RealSenseIngestor::run(bool snapshot_mode) {
         if (elem != NULL)
             msgbus_msg_envelope_elem_destroy(elem);
         if (frame != NULL)
-            delete frame;
+            delete_frame(frame);
         throw e;
     } catch (const rs2::error & e) {
         LOG_ERROR("RealSense error calling %s( %s ): %s",
@@ -257,7 +242,7 @@ void RealSenseIngestor::run(bool snapshot_mode) {
         if (elem != NULL)
             msgbus_msg_envelope_elem_destroy(elem);
         if (frame != NULL)
-            delete frame;
+            delete_frame(frame);
         throw e;
     }
     catch (const std::exception& e) {
@@ -265,20 +250,20 @@ void RealSenseIngestor::run(bool snapshot_mode) {
         if (elem != NULL)
             msgbus_msg_envelope_elem_destroy(elem);
         if (frame != NULL)
-            delete frame;
+            delete_frame(frame);
         throw e;
     } catch(...) {
         LOG_ERROR("Exception occured in opencv ingestor run()");
         if (elem != NULL)
             msgbus_msg_envelope_elem_destroy(elem);
         if (frame != NULL)
-            delete frame;
+            delete_frame(frame);
         throw;
     }
     if (elem != NULL)
         msgbus_msg_envelope_elem_destroy(elem);
     if (frame != NULL)
-        delete frame;
+        delete_frame(frame);
     LOG_INFO_0("Ingestor thread stopped");
     if (snapshot_mode)
         m_running.store(false);
@@ -303,7 +288,7 @@ void RealSenseIngestor::read(Frame*& frame) {
     const int depth_width = depth.get_width();
     const int depth_height = depth.get_height();
 
-    frame = new Frame(
+    frame = new_frame(
             (void*) color.get(), free_rs2_frame, (void*) color.get_data(),
             color_width , color_height, 3);
     frame->add_frame((void*) depth.get(), free_rs2_frame, (void*) depth.get_data(),
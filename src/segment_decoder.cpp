@@ -0,0 +1,293 @@
+// Copyright (c) 2020 Intel Corporation.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM,OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+/**
+ * @file
+ * @brief SegmentDecoder implementation
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <opencv2/opencv.hpp>
+#include <eii/utils/logger.h>
+#include "eii/vi/segment_decoder.h"
+#include "eii/vi/latency_stats.h"
+
+using namespace eii::vi;
+
+// Cancel check period of next()
+#define CANCEL_POLL std::chrono::milliseconds(100)
+
+// OpenCV reports the key frames of the packets read without decoding them
+// since 4.5.2
+#if CV_VERSION_MAJOR > 4 || (CV_VERSION_MAJOR == 4 && (CV_VERSION_MINOR > 5 || \
+        (CV_VERSION_MINOR == 5 && CV_VERSION_REVISION >= 2)))
+#define HAVE_KEY_FRAME_PROP
+#endif
+
+/**
+ * Find the key frames of a video file, reading its packets without
+ * decoding them.
+ * @return int64_t - Number of frames in the file, -1 if the key frames are
+ *                   unknown
+ */
+static int64_t scan_key_frames(const std::string& pipeline, std::vector<int64_t>& key_frames) {
+#ifdef HAVE_KEY_FRAME_PROP
+    cv::VideoCapture cap(pipeline, cv::CAP_FFMPEG);
+    if (!cap.isOpened() || !cap.set(cv::CAP_PROP_FORMAT, -1))
+        return -1;
+    int64_t frames = 0;
+    while (cap.grab()) {
+        if (cap.get(cv::CAP_PROP_LRF_HAS_KEY_FRAME) != 0)
+            key_frames.push_back(frames);
+        frames++;
+    }
+    cap.release();
+    if (key_frames.empty())
+        return -1;
+    // Frames before the first key frame are decoded with the first segment
+    key_frames[0] = 0;
+    return frames;
+#else
+    (void) pipeline;
+    (void) key_frames;
+    return -1;
+#endif
+}
+
+SegmentDecoder::SegmentDecoder(const std::string& pipeline, size_t threads, size_t window,
+                               std::shared_ptr<MatPool> pool) :
+    m_pipeline(pipeline), m_threads(std::max<size_t>(threads, 1)),
+    m_window(std::max<size_t>(window, 1)), m_pool(pool), m_next_segment(0),
+    m_head(0), m_head_pos(0), m_stop(false), m_key_frames(false), m_frames(0),
+    m_start_ns(0), m_end_ns(0)
+{}
+
+SegmentDecoder::~SegmentDecoder() {
+    stop();
+}
+
+bool SegmentDecoder::plan() {
+    // Shorter segments are merged with the next one, the window holds a
+    // segment per thread
+    int64_t min_length = std::max<int64_t>(m_window / m_threads, 1);
+    std::vector<int64_t> key_frames;
+    std::vector<int64_t> starts;
+
+    int64_t frames = scan_key_frames(m_pipeline, key_frames);
+    m_key_frames = frames > 0;
+    if (m_key_frames) {
+        for (auto key_frame : key_frames) {
+            if (starts.empty() || key_frame - starts.back() >= min_length)
+                starts.push_back(key_frame);
+        }
+    } else {
+        cv::VideoCapture cap(m_pipeline);
+        if (!cap.isOpened()) {
+            LOG_ERROR("Failed to open video file: %s", m_pipeline.c_str());
+            return false;
+        }
+        // Seeking to a frame decodes from the key frame before it, the
+        // decoders waste part of a GOP per segment
+        frames = (int64_t) cap.get(cv::CAP_PROP_FRAME_COUNT);
+        cap.release();
+        for (int64_t start = 0; start == 0 || start < frames; start += min_length)
+            starts.push_back(start);
+        LOG_WARN("Key frames of %s unknown, splitting it every %ld frames",
+                 m_pipeline.c_str(), min_length);
+    }
+
+    m_segments.clear();
+    m_segments.resize(starts.size());
+    for (size_t i = 0; i < starts.size(); i++) {
+        m_segments[i].start = starts[i];
+        // The last segment goes to the end of the file, the frame count of
+        // the container is an estimate
+        m_segments[i].count = (i + 1 < starts.size()) ? starts[i + 1] - starts[i] : -1;
+        m_segments[i].done = false;
+    }
+
+    int64_t avg_length = std::max<int64_t>(frames, 0) / (int64_t) m_segments.size();
+    LOG_INFO("Decoding %s: %ld frames in %zu segments on %zu threads",
+             m_pipeline.c_str(), frames, m_segments.size(), m_threads);
+    if (m_segments.size() > 1 && avg_length * (int64_t) m_threads > (int64_t) m_window) {
+        LOG_WARN("Segments of %ld frames on average, a window of %zu frames "
+                 "does not let %zu threads decode at once", avg_length,
+                 m_window, m_threads);
+    }
+    return true;
+}
+
+bool SegmentDecoder::start() {
+    stop();
+    m_stop = false;
+    m_next_segment = 0;
+    m_head = 0;
+    m_head_pos = 0;
+    m_frames = 0;
+    m_start_ns = latency_now_ns();
+    m_end_ns = 0;
+    if (!plan()) {
+        m_segments.clear();
+        return false;
+    }
+    size_t threads = std::min(m_threads, m_segments.size());
+    for (size_t i = 0; i < threads; i++)
+        m_decoders.push_back(new std::thread(&SegmentDecoder::decode_run, this));
+    return true;
+}
+
+void SegmentDecoder::decode_run() {
+    cv::VideoCapture* cap = NULL;
+    // Frame the capture reads next, -1 if unknown
+    int64_t cap_pos = -1;
+
+    std::unique_lock<std::mutex> lk(m_mtx);
+    while (!m_stop && m_next_segment < m_segments.size()) {
+        size_t s = m_next_segment++;
+        int64_t start = m_segments[s].start;
+        int64_t count = m_segments[s].count;
+        lk.unlock();
+
+        if (cap == NULL) {
+            cap = new cv::VideoCapture(m_pipeline);
+            if (!cap->isOpened())
+                LOG_ERROR("Failed to open video file: %s", m_pipeline.c_str());
+        }
+        // Consecutive segments are decoded without seeking
+        if (cap_pos != start && !cap->set(cv::CAP_PROP_POS_FRAMES, (double) start))
+            LOG_ERROR("Failed to seek %s to frame %ld", m_pipeline.c_str(), start);
+
+        int64_t decoded = 0;
+        bool stopped = false;
+        while (count < 0 || decoded < count) {
+            PooledMat* pooled = m_pool->acquire();
+            if (!cap->read(pooled->mat)) {
+                MatPool::free_pooled_mat(pooled);
+                break;
+            }
+            lk.lock();
+            m_cv.wait(lk, [this, start, decoded] {
+                return m_stop || start + decoded < m_head_pos + (int64_t) m_window;
+            });
+            if (m_stop) {
+                lk.unlock();
+                MatPool::free_pooled_mat(pooled);
+                stopped = true;
+                break;
+            }
+            m_segments[s].frames.push_back(pooled);
+            lk.unlock();
+            m_cv.notify_all();
+            decoded++;
+        }
+        cap_pos = (decoded == count) ? start + decoded : -1;
+
+        lk.lock();
+        if (count >= 0 && decoded < count && !stopped) {
+            LOG_WARN("Segment %zu of %s ended after %ld of %ld frames", s,
+                     m_pipeline.c_str(), decoded, count);
+        }
+        m_segments[s].done = true;
+        m_cv.notify_all();
+    }
+    lk.unlock();
+
+    if (cap != NULL) {
+        cap->release();
+        delete cap;
+    }
+}
+
+PooledMat* SegmentDecoder::next(const std::atomic<bool>& cancel) {
+    std::unique_lock<std::mutex> lk(m_mtx);
+    while (m_head < m_segments.size()) {
+        Segment& seg = m_segments[m_head];
+        if (!seg.frames.empty()) {
+            PooledMat* pooled = seg.frames.front();
+            seg.frames.pop_front();
+            m_head_pos++;
+            m_frames++;
+            lk.unlock();
+            // Frees a place in the window
+            m_cv.notify_all();
+            return pooled;
+        }
+        if (seg.done) {
+            // Frames missing from a segment are skipped
+            m_head++;
+            if (m_head < m_segments.size())
+                m_head_pos = m_segments[m_head].start;
+            m_cv.notify_all();
+            continue;
+        }
+        if (m_stop || cancel.load())
+            return NULL;
+        // The cancel flag is not notified, it is polled
+        m_cv.wait_for(lk, CANCEL_POLL);
+    }
+    if (m_end_ns == 0)
+        m_end_ns = latency_now_ns();
+    return NULL;
+}
+
+void SegmentDecoder::stop() {
+    {
+        std::lock_guard<std::mutex> lk(m_mtx);
+        m_stop = true;
+    }
+    m_cv.notify_all();
+    for (auto decoder : m_decoders) {
+        decoder->join();
+        delete decoder;
+    }
+    m_decoders.clear();
+    std::lock_guard<std::mutex> lk(m_mtx);
+    for (auto& seg : m_segments) {
+        for (auto pooled : seg.frames)
+            MatPool::free_pooled_mat(pooled);
+        seg.frames.clear();
+    }
+}
+
+size_t SegmentDecoder::get_segments() {
+    std::lock_guard<std::mutex> lk(m_mtx);
+    return m_segments.size();
+}
+
+bool SegmentDecoder::get_key_frames() {
+    std::lock_guard<std::mutex> lk(m_mtx);
+    return m_key_frames;
+}
+
+uint64_t SegmentDecoder::get_frames() {
+    std::lock_guard<std::mutex> lk(m_mtx);
+    return m_frames;
+}
+
+double SegmentDecoder::get_fps() {
+    std::lock_guard<std::mutex> lk(m_mtx);
+    if (m_start_ns == 0)
+        return 0.0;
+    int64_t end_ns = (m_end_ns != 0) ? m_end_ns : latency_now_ns();
+    if (end_ns <= m_start_ns)
+        return 0.0;
+    return m_frames * 1e9 / (end_ns - m_start_ns);
+}
@@ -0,0 +1,219 @@
+// Copyright (c) 2020 Intel Corporation.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to
+// deal in the Software without restriction, including without limitation the
+// rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+// sell copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM,OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+// IN THE SOFTWARE.
+
+/**
+ * @file
+ * @brief Synthetic frame source ingestor implementation
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <eii/utils/logger.h>
+#include "eii/vi/synthetic_ingestor.h"
+
+#define WIDTH "width"
+#define HEIGHT "height"
+#define PIXEL_FORMAT "pixel_format"
+#define PATTERN "pattern"
+#define FPS "fps"
+
+#define DEFAULT_WIDTH 1920
+#define DEFAULT_HEIGHT 1080
+
+// Distinct frames of the moving patterns and pixels they move by per frame
+#define PATTERN_FRAMES 64
+#define PATTERN_STEP 16
+
+using namespace eii::vi;
+using namespace eii::udf;
+
+SyntheticFrames::SyntheticFrames(int width, int height, int channels, SyntheticPattern pattern) :
+    m_pixels(NULL) {
+    m_refs.store(1);
+    m_frames = (pattern == PATTERN_STATIC) ? 1 : PATTERN_FRAMES;
+    m_frame_offset = (size_t) PATTERN_STEP * channels;
+
+    // Consecutive frames start PATTERN_STEP pixels apart in the same pixels,
+    // which moves the content without rendering every frame
+    size_t frame_size = (size_t) width * height * channels;
+    size_t size = frame_size + (m_frames - 1) * m_frame_offset;
+    if (posix_memalign((void**) &m_pixels, 4096, size) != 0) {
+        const char* err = "Failed to allocate synthetic frames";
+        LOG_ERROR("%s", err);
+        throw(err);
+    }
+
+    uint64_t seed = 0x9E3779B97F4A7C15ULL;
+    size_t row = (size_t) width * channels;
+    for (size_t i = 0; i < size; i++) {
+        switch (pattern) {
+            case PATTERN_STATIC:
+                // Vertical bars, one shade per channel
+                m_pixels[i] = (uint8_t) (((i % row) / channels * 8 / width) * 32 + (i % channels) * 64);
+                break;
+            case PATTERN_NOISE:
+                // xorshift64
+                seed ^= seed << 13;
+                seed ^= seed >> 7;
+                seed ^= seed << 17;
+                m_pixels[i] = (uint8_t) seed;
+                break;
+            case PATTERN_GRADIENT:
+                m_pixels[i] = (uint8_t) ((i % row) / channels + i / row + (i % channels) * 85);
+                break;
+        }
+    }
+}
+
+SyntheticFrames::~SyntheticFrames() {
+    free(m_pixels);
+}
+
+void* SyntheticFrames::acquire(int64_t index) {
+    m_refs.fetch_add(1, std::memory_order_relaxed);
+    return m_pixels + (index % m_frames) * m_frame_offset;
+}
+
+void SyntheticFrames::release() {
+    if (m_refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        delete this;
+}
+
+void SyntheticFrames::free_frame(void* obj) {
+    ((SyntheticFrames*) obj)->release();
+}
+
+static int get_int(config_t* config, const char* key, int def) {
+    config_value_t* cvt = config->get_config_value(config->cfg, key);
+    if (cvt == NULL)
+        return def;
+    if (cvt->type != CVT_INTEGER || cvt->body.integer <= 0) {
+        const char* err = "JSON value must be a positive integer";
+        LOG_ERROR("%s for \'%s\'", err, key);
+        config_value_destroy(cvt);
+        throw(err);
+    }
+    int value = (int) cvt->body.integer;
+    config_value_destroy(cvt);
+    return value;
+}
+
+static std::string get_string(config_t* config, const char* key, const char* def) {
+    config_value_t* cvt = config->get_config_value(config->cfg, key);
+    if (cvt == NULL)
+        return def;
+    if (cvt->type != CVT_STRING) {
+        const char* err = "JSON value must be a string";
+        LOG_ERROR("%s for \'%s\'", err, key);
+        config_value_destroy(cvt);
+        throw(err);
+    }
+    std::string value = cvt->body.string;
+    config_value_destroy(cvt);
+    return value;
+}
+
+SyntheticIngestor::SyntheticIngestor(config_t* config, FrameQueue* frame_queue, std::string service_name, std::condition_variable& snapshot_cv, EncodeType enc_type, int enc_lvl):
+    Ingestor(config, frame_queue, service_name, snapshot_cv, enc_type, enc_lvl),
+    m_frames(NULL), m_index(0) {
+    m_width = get_int(config, WIDTH, DEFAULT_WIDTH);
+    m_height = get_int(config, HEIGHT, DEFAULT_HEIGHT);
+
+    std::string format = get_string(config, PIXEL_FORMAT, "bgr");
+    if (format == "bgr") {
+        m_channels = 3;
+    } else if (format == "gray") {
+        m_channels = 1;
+    } else {
+        const char* err = "Unsupported pixel format";
+        LOG_ERROR("%s: %s", err, format.c_str());
+        throw(err);
+    }
+
+    std::string pattern_name = get_string(config, PATTERN, "gradient");
+    SyntheticPattern pattern;
+    if (pattern_name == "static") {
+        pattern = PATTERN_STATIC;
+    } else if (pattern_name == "noise") {
+        pattern = PATTERN_NOISE;
+    } else if (pattern_name == "gradient") {
+        pattern = PATTERN_GRADIENT;
+    } else {
+        const char* err = "Unsupported pattern";
+        LOG_ERROR("%s: %s", err, pattern_name.c_str());
+        throw(err);
+    }
+
+    // fps takes precedence over poll_interval, without either frames are
+    // generated as fast as the pipeline takes them
+    config_value_t* cvt_fps = config->get_config_value(config->cfg, FPS);
+    if (cvt_fps != NULL) {
+        double fps = 0.0;
+        if (cvt_fps->type == CVT_INTEGER) {
+            fps = (double) cvt_fps->body.integer;
+        } else if (cvt_fps->type == CVT_FLOATING) {
+            fps = cvt_fps->body.floating;
+        }
+        config_value_destroy(cvt_fps);
+        if (fps <= 0.0) {
+            const char* err = "fps must be a positive number";
+            LOG_ERROR("%s", err);
+            throw(err);
+        }
+        m_pacer.set_period(1.0 / fps);
+    }
+
+    m_frames = new SyntheticFrames(m_width, m_height, m_channels, pattern);
+    LOG_INFO("Synthetic source: %dx%d %s, %s pattern", m_width, m_height,
+             format.c_str(), pattern_name.c_str());
+    m_initialized.store(true);
+}
+
+SyntheticIngestor::~SyntheticIngestor() {
+    LOG_DEBUG_0("Synthetic ingestor destructor");
+    stop();
+    // Frames still in flight keep the pixels alive
+    if (m_frames != NULL)
+        m_frames->release();
+}
+
+void SyntheticIngestor::read(Frame*& frame) {
+    void* pixels = m_frames->acquire(m_index++);
+    frame = new_frame(
+            (void*) m_frames, SyntheticFrames::free_frame, pixels,
+            m_width, m_height, m_channels);
+    m_pacer.wait();
+}
+
+void SyntheticIngestor::stop() {
+    if (m_initialized.load()) {
+        if (!m_stop.load()) {
+            m_stop.store(true);
+            // wait for the ingestor thread function run() to finish its execution.
+            if (m_th != NULL) {
+                m_th->join();
+            }
+        }
+        // After run() has been stopped m_stop flag is reset, so that the
+        // ingestor is ready for the next ingestion.
+        m_running.store(false);
+        m_stop.store(false);
+    }
+}
@@ -26,9 +26,15 @@
 #include <safe_lib.h>
 #include <mutex>
 #include <iostream>
+#include <algorithm>
+#include <future>
+#include <memory>
+#include <exception>
+#include <cjson/cJSON.h>
 #include "eii/vi/video_ingestion.h"
 #include "eii/vi/ingestor.h"
 #include "eii/vi/gstreamer_ingestor.h"
+#include "eii/vi/frame_format.h"
 
 
 #define INTEL_VENDOR "GenuineIntel"
@@ -37,6 +43,30 @@
 #define PUB "pub"
 #define SW_TRIGGER "sw_trigger"
 #define ARGUMENTS "arguments"
+#define STATS_INTERVAL "stats_interval"
+#define QUEUE_TYPE "queue_type"
+#define UDF_INPUT_FORMAT "input_format"
+#define PUBLISH_FORMAT "frame_format"
+#define DEFAULT_INGESTOR_NAME "default"
+#define SNAPSHOT_COUNT "count"
+#define SNAPSHOT_INTERVAL "interval"
+#define SNAPSHOT_FRESH "fresh"
+#define SNAPSHOT_TIMEOUT_NS 30000000000LL
+// Bounds of a snapshot burst, which keeps a command thread busy
+#define SNAPSHOT_MAX_COUNT 1000
+#define SNAPSHOT_MAX_BURST_S 600.0
+#define CLIP_START "start"
+#define CLIP_END "end"
+#define CLIP_ID_META "clip_id"
+#define CLIP_FRAME_META "clip_frame"
+#define CLIP_FRAMES_META "clip_frames"
+#define CLIP_TIME_META "capture_time_ns"
+// Period of the stop checks of a thread deleting the frames of a queue
+#define DRAIN_POLL std::chrono::milliseconds(250)
+// Wait of a reconfiguration for the frames of the ingestors it replaced,
+// and period of the checks
+#define RETIRE_TIMEOUT_NS 1000000000LL
+#define RETIRE_POLL std::chrono::milliseconds(10)
 
 using namespace eii::vi;
 using namespace eii::utils;
@@ -46,66 +76,164 @@ using namespace eii::udf;
 VideoIngestion::VideoIngestion(
         std::string app_name, std::condition_variable& err_cv, char* vi_config,
         ConfigMgr* ctx, CommandHandler* commandhandler) :
-    m_app_name(app_name), m_commandhandler(commandhandler), m_err_cv(err_cv),
-    m_enc_type(EncodeType::NONE), m_enc_lvl(0) {
+    m_app_name(app_name), m_cmd_stop(false), m_snapshot_bursts(0),
+    m_commandhandler(commandhandler), m_frame_publisher(NULL),
+    m_stats_interval(0.0), m_stats_th(NULL), m_stats_stop(false), m_clip_th(NULL),
+    m_clip_stop(false), m_clip_id(0), m_startup_ns(0), m_startup_done(false),
+    m_udf_manager(NULL), m_udf_th(NULL), m_udf_owned(NULL), m_udf_input_queue(NULL),
+    m_frame_merger(NULL), m_udf_output_queue(NULL), m_err_cv(err_cv), m_enc_type(EncodeType::NONE), m_enc_lvl(0),
+    m_publish_bgr(false), m_udf_bgr(false) {
 
-    // Parse the configuration
-    config_t* config = json_config_new_from_buffer(vi_config);
-    if (config == NULL) {
-        const char* err = "Failed to initialize configuration object";
+    PublisherCfg* pub_ctx = ctx->getPublisherByIndex(0);
+    if (pub_ctx == NULL) {
+        const char* err = "pub_ctx initialization failed";
         LOG_ERROR("%s", err);
         throw(err);
     }
-    config_value_t* encoding_value = config->get_config_value(config->cfg,
-                                                              "encoding");
-    if (encoding_value == NULL) {
-        const char* err = "\"encoding\" key is missing";
-        LOG_WARN("%s", err);
-    } else {
-        config_value_t* encoding_type_cvt = config_value_object_get(encoding_value,
-                                                                    "type");
-        if ( encoding_type_cvt == NULL ) {
-            const char* err = "encoding \"type\" key missing";
-            LOG_ERROR("%s", err);
-            config_destroy(config);
-            throw(err);
-        }
-        if (encoding_type_cvt->type != CVT_STRING) {
-            const char* err = "encoding \"type\" value has to be of string type";
-            LOG_ERROR("%s", err);
-            config_destroy(config);
-            config_value_destroy(encoding_type_cvt);
-            throw(err);
-        }
-        char* enc_type = encoding_type_cvt->body.string;
-        if (strcmp(enc_type, "jpeg") == 0) {
-            m_enc_type = EncodeType::JPEG;
-            LOG_DEBUG_0("Encoding type is jpeg");
-        } else if (strcmp(enc_type, "png") == 0) {
-            m_enc_type = EncodeType::PNG;
-            LOG_DEBUG_0("Encoding type is png");
-        } else {
-            throw "Encoding type is not supported";
+    config_t* pub_config = pub_ctx->getMsgBusConfig();
+    if (pub_config == NULL) {
+        const char* err = "Failed to fetch msgbus config for Publisher";
+        LOG_ERROR("%s", err);
+        throw(err);
+    }
+    std::vector<std::string> topics = pub_ctx->getTopics();
+    LOG_DEBUG_0("Publisher Config received...");
+
+    // Subscribers which cannot read the GRAY8, NV12 and I420 frames ask
+    // for BGR in the publisher interface
+    config_value_t* frame_format = pub_ctx->getInterfaceValue(PUBLISH_FORMAT);
+    if (frame_format != NULL) {
+        m_publish_bgr = (frame_format->type == CVT_STRING &&
+                         strcmp(frame_format->body.string, "BGR") == 0);
+        config_value_destroy(frame_format);
+    }
+
+    init(vi_config, pub_config, topics);
+    config_destroy(pub_config);
+}
+
+VideoIngestion::VideoIngestion(
+        std::string app_name, std::condition_variable& err_cv, char* vi_config,
+        config_t* pub_config, const std::vector<std::string>& topics,
+        CommandHandler* commandhandler) :
+    m_app_name(app_name), m_cmd_stop(false), m_snapshot_bursts(0),
+    m_commandhandler(commandhandler), m_frame_publisher(NULL),
+    m_stats_interval(0.0), m_stats_th(NULL), m_stats_stop(false), m_clip_th(NULL),
+    m_clip_stop(false), m_clip_id(0), m_startup_ns(0), m_startup_done(false),
+    m_udf_manager(NULL), m_udf_th(NULL), m_udf_owned(NULL), m_udf_input_queue(NULL),
+    m_frame_merger(NULL), m_udf_output_queue(NULL), m_err_cv(err_cv), m_enc_type(EncodeType::NONE), m_enc_lvl(0),
+    m_publish_bgr(false), m_udf_bgr(false) {
+    init(vi_config, pub_config, topics);
+}
+
+/**
+ * Whether the "queue_type" key selects the lock-free queues, the mutex based
+ * ones are the default
+ */
+static bool parse_queue_type(config_t* config) {
+    config_value_t* queue_type_cvt = config->get_config_value(config->cfg, QUEUE_TYPE);
+    if (queue_type_cvt == NULL)
+        return false;
+    if (queue_type_cvt->type != CVT_STRING ||
+            (strcmp(queue_type_cvt->body.string, "lockfree") != 0 &&
+             strcmp(queue_type_cvt->body.string, "mutex") != 0)) {
+        const char* err = "\"queue_type\" value has to be \"mutex\" or \"lockfree\"";
+        LOG_ERROR("%s", err);
+        config_value_destroy(queue_type_cvt);
+        throw(err);
+    }
+    bool lockfree = strcmp(queue_type_cvt->body.string, "lockfree") == 0;
+    config_value_destroy(queue_type_cvt);
+    return lockfree;
+}
+
+/**
+ * Whether one of the UDFs takes BGR frames, with the "input_format" key
+ */
+static bool parse_udf_bgr(config_value_t* udf_value) {
+    if (udf_value == NULL || udf_value->type != CVT_ARRAY)
+        return false;
+    bool bgr = false;
+    size_t len = config_value_array_len(udf_value);
+    for (size_t i = 0; i < len && !bgr; i++) {
+        config_value_t* udf = config_value_array_get(udf_value, i);
+        if (udf == NULL)
+            continue;
+        config_value_t* format = config_value_object_get(udf, UDF_INPUT_FORMAT);
+        if (format != NULL) {
+            bgr = (format->type == CVT_STRING && strcmp(format->body.string, "BGR") == 0);
+            config_value_destroy(format);
         }
+        config_value_destroy(udf);
+    }
+    return bgr;
+}
 
-        config_value_t* encoding_level_cvt = config_value_object_get(encoding_value,
-                                                                    "level");
-        if (encoding_level_cvt == NULL) {
-            const char* err = "encoding \"level\" key missing";
+/**
+ * Period of the statistics dump, 0 if the "stats_interval" key is missing
+ */
+static double parse_stats_interval(config_t* config) {
+    double stats_interval = 0.0;
+    config_value_t* stats_interval_cvt = config->get_config_value(config->cfg,
+                                                                  STATS_INTERVAL);
+    if (stats_interval_cvt != NULL) {
+        if (stats_interval_cvt->type == CVT_INTEGER) {
+            stats_interval = (double) stats_interval_cvt->body.integer;
+        } else if (stats_interval_cvt->type == CVT_FLOATING) {
+            stats_interval = stats_interval_cvt->body.floating;
+        } else {
+            const char* err = "\"stats_interval\" value has to be a number";
             LOG_ERROR("%s", err);
-            config_destroy(config);
+            config_value_destroy(stats_interval_cvt);
             throw(err);
         }
-        if (encoding_level_cvt->type != CVT_INTEGER) {
-            const char* err = "encoding \"level\" value has to be of string type";
-            LOG_ERROR("%s", err);
+        config_value_destroy(stats_interval_cvt);
+    }
+    return stats_interval;
+}
+
+void VideoIngestion::init(char* vi_config, config_t* pub_config, const std::vector<std::string>& topics) {
+    m_startup_ns = latency_now_ns();
+
+    // Kept to find the changed components on a reconfiguration
+    m_config = vi_config;
+
+    // Parse the configuration
+    config_t* config = json_config_new_from_buffer(vi_config);
+    if (config == NULL) {
+        const char* err = "Failed to initialize configuration object";
+        LOG_ERROR("%s", err);
+        throw(err);
+    }
+
+    // Frees the configuration on return, and the state built so far if
+    // init() throws
+    struct InitGuard {
+        VideoIngestion* vi;
+        config_t* config;
+        config_value_t* udf_value;
+        std::vector<std::future<Ingestor*>> ingestor_futures;
+        bool done;
+
+        ~InitGuard() {
+            if (udf_value != NULL)
+                config_value_destroy(udf_value);
             config_destroy(config);
-            config_value_destroy(encoding_level_cvt);
-            throw(err);
+            if (done)
+                return;
+            // Ingestors still being created are kept to be deleted
+            for (size_t i = 0; i < ingestor_futures.size(); i++) {
+                if (!ingestor_futures[i].valid())
+                    continue;
+                try {
+                    vi->m_ingestors[i]->ingestor = ingestor_futures[i].get();
+                } catch(...) {}
+            }
+            vi->free_init_state();
         }
-        m_enc_lvl = encoding_level_cvt->body.integer;
-        LOG_DEBUG("Encoding value is %d", m_enc_lvl);
-    }
+    } guard = {this, config, NULL, {}, false};
+
+    parse_encoding(config, m_enc_type, m_enc_lvl);
 
     config_value_t* ingestor_value = config->get_config_value(config->cfg,
                                                               "ingestor");
@@ -114,52 +242,80 @@ VideoIngestion::VideoIngestion(
         LOG_ERROR("%s", err);
         throw(err);
     }
-    config_value_t* ingestor_type_cvt = config_value_object_get(ingestor_value,
-                                                                "type");
-    if (ingestor_type_cvt == NULL) {
-        const char* err = "\"type\" key missing";
-        LOG_ERROR("%s", err);
-        config_destroy(config);
-        throw(err);
-    }
-    if (ingestor_type_cvt->type != CVT_STRING) {
-        const char* err = "\"type\" value has to be of string type";
-        LOG_ERROR("%s", err);
-        config_destroy(config);
-        config_value_destroy(ingestor_type_cvt);
-        throw(err);
-    }
-
-    m_ingestor_type = std::string(ingestor_type_cvt->body.string);
 
-    config_value_t* ingestor_queue_cvt = config_value_object_get(ingestor_value,
-                                                                    "queue_size");
-    size_t queue_size = DEFAULT_QUEUE_SIZE;
-    if (ingestor_queue_cvt == NULL) {
-        LOG_INFO("\"queue_size\" key missing, so using default queue size: \
-                    %ld", queue_size);
-    } else {
-        if (ingestor_queue_cvt->type != CVT_INTEGER) {
-            const char* err = "\"queue_size\" value has to be of integer type";
+    // Several ingestors share the UDF workers, each one publishing on its
+    // own topic
+    bool multi_ingestor = (ingestor_value->type == CVT_ARRAY);
+    size_t queue_size = 0;
+    if (multi_ingestor) {
+        size_t len = config_value_array_len(ingestor_value);
+        if (len == 0) {
+            const char* err = "\"ingestor\" array cannot be empty";
             LOG_ERROR("%s", err);
-            config_destroy(config);
-            config_value_destroy(ingestor_queue_cvt);
+            config_value_destroy(ingestor_value);
             throw(err);
         }
-        queue_size = ingestor_queue_cvt->body.integer;
+        for (size_t i = 0; i < len; i++) {
+            config_value_t* entry = config_value_array_get(ingestor_value, i);
+            IngestorCtx* ictx = NULL;
+            try {
+                ictx = parse_ingestor(entry, queue_size);
+            } catch(...) {
+                config_value_destroy(entry);
+                config_value_destroy(ingestor_value);
+                throw;
+            }
+            config_value_destroy(entry);
+            m_ingestors.push_back(ictx);
+            if (ictx->name.empty()) {
+                const char* err = "\"name\" key is required for every ingestor of the array";
+                LOG_ERROR("%s", err);
+                config_value_destroy(ingestor_value);
+                throw(err);
+            }
+        }
+    } else {
+        try {
+            m_ingestors.push_back(parse_ingestor(ingestor_value, queue_size));
+        } catch(...) {
+            config_value_destroy(ingestor_value);
+            throw;
+        }
     }
+    config_value_destroy(ingestor_value);
 
-    m_udf_input_queue = new FrameQueue(queue_size);
+    // The drop_oldest policy evicts from the queue of the ingestor, which
+    // only the frame merger pops under the queue lock
+    bool drop_oldest = false;
+    for (auto ictx : m_ingestors)
+        drop_oldest = drop_oldest || ictx->drop_oldest;
 
-    config_value_object_t* ingestor_cvt = ingestor_value->body.object;
-    m_ingestor_cfg = config_new(ingestor_cvt->object, free, get_config_value, NULL);
-    if (m_ingestor_cfg == NULL) {
-        const char* err = "Unable to get ingestor config";
-        LOG_ERROR("%s", err);
-        config_destroy(config);
-        throw(err);
+    // The UDF manager pops and pushes the EII queue directly, so only the
+    // queues it does not see can be lock-free: the queues of the cameras
+    // and, without UDFs, the queue of the publisher
+    bool lockfree = parse_queue_type(config);
+    config_value_t* udf_value = config->get_config_value(config->cfg, "udfs");
+    bool udfs = (udf_value != NULL);
+    if (udf_value != NULL)
+        config_value_destroy(udf_value);
+    if (lockfree && udfs && m_ingestors.size() == 1 && !drop_oldest)
+        LOG_INFO_0("\"queue_type\" is ignored for a single ingestor with UDFs");
+
+    if (m_ingestors.size() > 1 || drop_oldest) {
+        // Each camera has its own queue, so that its overflow policy only
+        // applies to its own frames, and the UDF input queue only has to
+        // hand a frame of each over to the UDFs
+        m_udf_input_queue = new FrameQueue(m_ingestors.size(), lockfree && !udfs);
+        m_frame_merger = new FrameMerger(m_udf_input_queue);
+        for (auto ictx : m_ingestors)
+            ictx->queue = m_frame_merger->add_input(ictx->queue_size, lockfree);
+    } else {
+        m_udf_input_queue = new FrameQueue(queue_size, lockfree && !udfs);
+        m_ingestors[0]->queue = m_udf_input_queue;
     }
 
+    m_stats_interval = parse_stats_interval(config);
+
     // get config SW_Trigger logic start
     config_value_t* sw_trigger = config->get_config_value(config->cfg,
                                                             SW_TRIGGER);
@@ -171,19 +327,12 @@ VideoIngestion::VideoIngestion(
         LOG_INFO("Software Trigger feature is enabled");
         m_sw_trgr_en = true;
 
-        if (m_commandhandler != NULL) {
-            m_commandhandler->register_callback((int)START_INGESTION, std::bind(&VideoIngestion::process_start_ingestion, this, std::placeholders::_1));
-            m_commandhandler->register_callback((int)STOP_INGESTION, std::bind(&VideoIngestion::process_stop_ingestion, this, std::placeholders::_1));
-            m_commandhandler->register_callback((int)SNAPSHOT, std::bind(&VideoIngestion::process_snapshot, this, std::placeholders::_1));
-        }
-
         // Read config from config_mgr
         config_value_t* sw_trigger_init_state_cvt = config_value_object_get(sw_trigger,
                                                                 "init_state");
         if (sw_trigger_init_state_cvt == NULL) {
             const char* err = "\"init_state\" key missing";
             LOG_ERROR("%s", err);
-            config_destroy(config);
             throw(err);
         }
 
@@ -201,202 +350,1601 @@ VideoIngestion::VideoIngestion(
             throw(err);
         }
 
-        // Ingestion is not going ON by default when VideoIngestion constructor is called. Even if
-        // init_state=start, the ingestion will start when start() is called
-        m_ingestion_running.store(false);
     }
 
-    config_value_t* udf_value = config->get_config_value(config->cfg,
-                                                            "udfs");
-    if (udf_value == NULL) {
+    if (topics.empty()) {
+        const char* err = "Topics list cannot be empty";
+        LOG_ERROR("%s", err);
+        throw(err);
+    }
+    startup_phase("config", m_startup_ns);
+
+    // The UDFs load their models while the cameras are opened and the
+    // message bus is bound, start() waits for them
+    guard.udf_value = config->get_config_value(config->cfg, "udfs");
+    m_udf_bgr = parse_udf_bgr(guard.udf_value);
+    if (guard.udf_value == NULL) {
         LOG_INFO("\"udfs\" key doesn't exist, so udf output queue is same as \
                 udf input queue!!")
         m_udf_output_queue = m_udf_input_queue;
-        m_udf_manager = NULL;
     } else {
         m_udf_output_queue = new FrameQueue(queue_size);
-        m_udf_manager = new UdfManager(config, m_udf_input_queue, m_udf_output_queue, m_app_name,
-                                        m_enc_type, m_enc_lvl);
+        std::promise<UdfManager*> created;
+        m_udf_future = created.get_future();
+        m_udf_th = new std::thread(&VideoIngestion::run_udf_manager, this, std::move(created),
+                                   m_udf_release.get_future());
     }
 
-    // Get ingestor
-    m_ingestor = get_ingestor(m_ingestor_cfg, m_udf_input_queue, m_ingestor_type.c_str(),
-                              m_app_name, m_snapshot_cv, m_enc_type, m_enc_lvl);
-
-    PublisherCfg* pub_ctx = ctx->getPublisherByIndex(0);
-    if (pub_ctx == NULL) {
-        const char* err = "pub_ctx initialization failed";
-        LOG_ERROR("%s", err);
-        throw(err);
+    // Get ingestors, one thread each, the PIPELINE environment variable can
+    // only apply to a single one
+    for (auto ictx : m_ingestors) {
+        guard.ingestor_futures.push_back(std::async(std::launch::async, [this, ictx, multi_ingestor]() {
+            int64_t start_ns = latency_now_ns();
+            Ingestor* ingestor = get_ingestor(ictx->cfg, ictx->queue, ictx->type.c_str(),
+                                              m_app_name, ictx->snapshot_cv, m_enc_type, m_enc_lvl,
+                                              !multi_ingestor);
+            startup_phase("ingestor" + (ictx->name.empty() ? "" : " " + ictx->name), start_ns);
+            return ingestor;
+        }));
     }
-    config_t* pub_config = pub_ctx->getMsgBusConfig();
-    if (pub_config == NULL) {
-        const char* err = "Failed to fetch msgbus config for Publisher";
-        LOG_ERROR("%s", err);
-        throw(err);
+
+    // Ingestors without a "topic" key get the publisher topic at their own
+    // index
+    int64_t publisher_ns = latency_now_ns();
+    m_frame_publisher = new FramePublisher(pub_config, m_err_cv, m_udf_output_queue,
+                                           &m_frame_stamps);
+    m_frame_publisher->set_startup_ns(m_startup_ns);
+    startup_phase("publisher", publisher_ns);
+
+    std::exception_ptr ingestor_err;
+    for (size_t i = 0; i < m_ingestors.size(); i++) {
+        try {
+            m_ingestors[i]->ingestor = guard.ingestor_futures[i].get();
+            m_ingestors[i]->ingestor->set_frame_stamps(&m_frame_stamps);
+            if (m_frame_merger != NULL)
+                m_ingestors[i]->ingestor->set_frame_merger(m_frame_merger);
+            m_ingestors[i]->ingestor->set_convert_to_bgr(m_publish_bgr || m_udf_bgr);
+        } catch(...) {
+            if (!ingestor_err)
+                ingestor_err = std::current_exception();
+        }
     }
-    std::vector<std::string> topics = pub_ctx->getTopics();
-    if (topics.empty()) {
-        const char* err = "Topics list cannot be empty";
-        LOG_ERROR("%s", err);
-        throw(err);
+    if (ingestor_err)
+        std::rethrow_exception(ingestor_err);
+
+    for (size_t i = 0; i < m_ingestors.size(); i++) {
+        IngestorCtx* ictx = m_ingestors[i];
+        if (ictx->topic.empty()) {
+            if (i >= topics.size()) {
+                const char* err = "Not enough publisher topics for the ingestors";
+                LOG_ERROR("%s", err);
+                throw(err);
+            }
+            ictx->topic = topics[i];
+        }
+        m_frame_publisher->add_topic(ictx->name, ictx->topic);
+        if (!ictx->ingestor->get_clip_topic().empty())
+            m_frame_publisher->add_topic(ictx->ingestor->get_clip_route(), ictx->ingestor->get_clip_topic());
+        // Outputs other than the main one have their own topic
+        for (auto& output : ictx->ingestor->get_outputs()) {
+            if (!output.topic.empty())
+                m_frame_publisher->add_topic(output.route, output.topic);
+        }
     }
-    LOG_DEBUG_0("Publisher Config received...");
 
-    m_publisher = new PublisherThread(
-            pub_config, m_err_cv, topics[0], (MessageQueue*) m_udf_output_queue, m_app_name);
+    // The commands are only registered once nothing can fail anymore, they
+    // would otherwise call into a freed object
+    if (m_commandhandler != NULL) {
+        m_commandhandler->register_callback((int)GET_STATS, std::bind(&VideoIngestion::process_get_stats, this, std::placeholders::_1));
+        m_commandhandler->register_callback((int)DUMP_CLIP, std::bind(&VideoIngestion::process_dump_clip, this, std::placeholders::_1));
+        if (m_sw_trgr_en) {
+            m_commandhandler->register_callback((int)START_INGESTION, std::bind(&VideoIngestion::process_start_ingestion, this, std::placeholders::_1));
+            m_commandhandler->register_callback((int)STOP_INGESTION, std::bind(&VideoIngestion::process_stop_ingestion, this, std::placeholders::_1));
+            m_commandhandler->register_callback((int)SNAPSHOT, std::bind(&VideoIngestion::process_snapshot, this, std::placeholders::_1));
+        }
+    }
 
-    config_destroy(config);
-    config_value_destroy(ingestor_type_cvt);
-    config_value_destroy(ingestor_queue_cvt);
-    config_value_destroy(encoding_value);
-    config_value_destroy(udf_value);
+    guard.done = true;
 }
 
-msg_envelope_elem_body_t* VideoIngestion::process_start_ingestion(msg_envelope_elem_body_t *arg_payload) {
+void VideoIngestion::free_init_state() {
     try {
-            LOG_INFO_0("START INGESTION request received from client");
-            if (m_ingestion_running.load()) {
-                std::string err = "Ingestion already running";
-                return m_commandhandler->form_reply_payload((int)REQ_ALREADY_RUNNING, err, NULL);
-            }
-            IngestRetCode ret = m_ingestor->start();
-            if (ret != IngestRetCode::SUCCESS) {
-                LOG_ERROR("Failed to start ingestor thread: %d", ret);
-                std::string err = "Failed to start ingestor thread";
-                return m_commandhandler->form_reply_payload((int)REQ_NOT_HONORED, err, NULL);
-            } else {
-                LOG_INFO("Ingestor thread started...");
-                m_ingestion_running.store(true);
-                // acknowledging back to client that ingestion has actually started
-                return m_commandhandler->form_reply_payload((int)REQ_HONORED, "SUCCESS", NULL);
-            }
-    } catch(std::exception& ex) {
-        std::string err = "exception occurred request not honored";
-        LOG_ERROR("%s %s", ex.what(), err.c_str());
-        return m_commandhandler->form_reply_payload((int)REQ_NOT_HONORED, err, NULL);
+        wait_udf_manager();
+    } catch(...) {}
+    delete_udf_manager(m_udf_manager);
+    m_udf_manager = NULL;
+    for (auto ictx : m_ingestors) {
+        delete ictx->ingestor;
+        delete ictx;
     }
+    m_ingestors.clear();
+    delete m_frame_publisher;
+    m_frame_publisher = NULL;
+    // The merger owns the queues of the ingestors
+    delete m_frame_merger;
+    m_frame_merger = NULL;
+    if (m_udf_output_queue != m_udf_input_queue)
+        delete m_udf_output_queue;
+    delete m_udf_input_queue;
+    m_udf_output_queue = NULL;
+    m_udf_input_queue = NULL;
 }
 
-msg_envelope_elem_body_t* VideoIngestion::process_stop_ingestion(msg_envelope_elem_body_t *arg_payload) {
+UdfManager* VideoIngestion::create_udf_manager() {
+    int64_t start_ns = latency_now_ns();
+    // The config parsed by init() may be gone by the time the models are
+    // loaded
+    config_t* config = json_config_new_from_buffer(m_config.c_str());
+    if (config == NULL) {
+        const char* err = "Failed to initialize configuration object";
+        LOG_ERROR("%s", err);
+        throw(err);
+    }
+    UdfManager* udf_manager = NULL;
     try {
-            LOG_INFO_0("STOP INGESTION request received from client");
-
-            if (!m_ingestion_running.load()) {
-                // form a JSON reply buffer
-                std::string err = "Ingestion already stopped";
-                return m_commandhandler->form_reply_payload((int)REQ_ALREADY_STOPPED, err, NULL);
-            }
-            // stop the ingestor
-            if (m_ingestor) {
-                m_ingestor->stop();
-            }
-
-            m_ingestion_running.store(false);
-
-            // form a JSON reply buffer
-            return m_commandhandler->form_reply_payload((int)REQ_HONORED, "SUCCESS", NULL);
-    } catch(std::exception& ex) {
-        std::string err = "exception occurred request not honored";
-        LOG_ERROR("%s %s", ex.what(), err.c_str());
-        return m_commandhandler->form_reply_payload((int)REQ_NOT_HONORED, err, NULL);
+        udf_manager = new UdfManager(config, m_udf_input_queue, m_udf_output_queue, m_app_name,
+                                     m_enc_type, m_enc_lvl);
+    } catch(...) {
+        config_destroy(config);
+        throw;
     }
+    config_destroy(config);
+    startup_phase("udfs", start_ns);
+    return udf_manager;
 }
 
-msg_envelope_elem_body_t* VideoIngestion::process_snapshot(msg_envelope_elem_body_t *arg_payload) {
+void VideoIngestion::run_udf_manager(std::promise<UdfManager*> created,
+                                     std::future<void> release) {
+    UdfManager* udf_manager = NULL;
     try {
-            LOG_INFO_0("SNAPSHOT request received from client");
-
-            if (m_ingestion_running.load()) {
-                std::string err = "Ingestion already running";
-                return m_commandhandler->form_reply_payload((int)REQ_ALREADY_RUNNING, err, NULL);
-            }
-
-            IngestRetCode ret = IngestRetCode::NOT_INITIALIZED;
-            if (m_ingestor) {
-                ret = m_ingestor->start(true);
-            }
-            if (ret != IngestRetCode::SUCCESS) {
-                LOG_ERROR("Failed to start ingestor thread: %d", ret);
-                std::string err = "Failed to start ingestor thread";
-                return m_commandhandler->form_reply_payload((int)REQ_NOT_HONORED, err, NULL);
-            }
-            LOG_DEBUG_0("Ingestor thread snapshot started");
-            std::mutex mtx;
-            std::unique_lock<std::mutex> lck(mtx);
-            m_snapshot_cv.wait(lck);
-            lck.unlock();
-            LOG_DEBUG_0("Stopping ingestor thread");
-            if (m_ingestor) {
-                m_ingestor->stop();
-            }
-            m_ingestion_running.store(false);
-            return m_commandhandler->form_reply_payload((int)REQ_HONORED, "SUCCESS", NULL);
-    } catch(std::exception& ex) {
-        std::string err = "exception occurred request not honored";
-        LOG_ERROR("%s %s", ex.what(), err.c_str());
-        return m_commandhandler->form_reply_payload((int)REQ_NOT_HONORED,
-                                                    err, NULL);
+        udf_manager = create_udf_manager();
+    } catch(...) {
+        created.set_exception(std::current_exception());
+        return;
     }
+    created.set_value(udf_manager);
+    release.wait();
+    delete udf_manager;
 }
 
-VideoIngestion& VideoIngestion::operator=(const VideoIngestion& src) {
-    return *this;
+void VideoIngestion::wait_udf_manager() {
+    if (!m_udf_future.valid())
+        return;
+    try {
+        m_udf_manager = m_udf_owned = m_udf_future.get();
+    } catch(...) {
+        m_udf_th->join();
+        delete m_udf_th;
+        m_udf_th = NULL;
+        throw;
+    }
 }
 
-void VideoIngestion::start() {
-    if (m_publisher) {
-        m_publisher->start();
-        LOG_INFO("Publisher thread started...");
-    }
-    if (m_udf_manager) {
-        m_udf_manager->start();
-        LOG_INFO("Started udf manager");
+void VideoIngestion::delete_udf_manager(UdfManager* udf_manager) {
+    if (udf_manager == NULL)
+        return;
+    if (udf_manager != m_udf_owned) {
+        delete udf_manager;
+        return;
     }
+    m_udf_release.set_value();
+    m_udf_th->join();
+    delete m_udf_th;
+    m_udf_th = NULL;
+    m_udf_owned = NULL;
+}
 
-    // if SW trigger is disabled OR (if sw trigger is enabled && init_state = running)
-    // then start ingestion
-    if (!m_sw_trgr_en || (m_sw_trgr_en && m_init_state_start)) {
-        IngestRetCode ret = m_ingestor->start();
-        if (ret != IngestRetCode::SUCCESS) {
-            LOG_ERROR_0("Failed to start ingestor thread");
-        } else {
-            LOG_INFO("Ingestor thread started...");
-            m_ingestion_running.store((m_sw_trgr_en) ? true : false);
-        }
-    }
+void VideoIngestion::startup_phase(const std::string& name, int64_t start_ns) {
+    int64_t end_ns = latency_now_ns();
+    StartupPhase phase = {name, (start_ns - m_startup_ns) / 1e6, (end_ns - start_ns) / 1e6};
+    std::lock_guard<std::mutex> lck(m_startup_mtx);
+    m_startup_phases.push_back(phase);
 }
 
-void VideoIngestion::stop() {
-    if (m_ingestor) {
-        m_ingestor->stop();
-    }
-    if (m_udf_manager) {
-        m_udf_manager->stop();
-    }
-    if (m_publisher) {
-        m_publisher->stop();
-    }
+std::vector<StartupPhase> VideoIngestion::get_startup_phases() {
+    std::lock_guard<std::mutex> lck(m_startup_mtx);
+    return m_startup_phases;
 }
 
-VideoIngestion::~VideoIngestion() {
-    // Stop the thread (if it is running)
-    if (m_ingestor) {
-        m_ingestor->stop();
-    }
-    if (m_ingestor) {
-        delete m_ingestor;
-    }
-    if (m_udf_manager) {
-        delete m_udf_manager;
+int64_t VideoIngestion::get_time_to_first_frame() const {
+    return (m_frame_publisher != NULL) ? m_frame_publisher->get_time_to_first_frame() : -1;
+}
+
+void VideoIngestion::parse_encoding(config_t* config, EncodeType& enc_type, int& enc_lvl) {
+    enc_type = EncodeType::NONE;
+    enc_lvl = 0;
+    config_value_t* encoding_value = config->get_config_value(config->cfg,
+                                                              "encoding");
+    if (encoding_value == NULL) {
+        const char* err = "\"encoding\" key is missing";
+        LOG_WARN("%s", err);
+    } else {
+        config_value_t* encoding_type_cvt = config_value_object_get(encoding_value,
+                                                                    "type");
+        if ( encoding_type_cvt == NULL ) {
+            const char* err = "encoding \"type\" key missing";
+            LOG_ERROR("%s", err);
+            config_value_destroy(encoding_value);
+            throw(err);
+        }
+        if (encoding_type_cvt->type != CVT_STRING) {
+            const char* err = "encoding \"type\" value has to be of string type";
+            LOG_ERROR("%s", err);
+            config_value_destroy(encoding_type_cvt);
+            config_value_destroy(encoding_value);
+            throw(err);
+        }
+        char* type = encoding_type_cvt->body.string;
+        if (strcmp(type, "jpeg") == 0) {
+            enc_type = EncodeType::JPEG;
+            LOG_DEBUG_0("Encoding type is jpeg");
+        } else if (strcmp(type, "png") == 0) {
+            enc_type = EncodeType::PNG;
+            LOG_DEBUG_0("Encoding type is png");
+        } else {
+            config_value_destroy(encoding_type_cvt);
+            config_value_destroy(encoding_value);
+            throw "Encoding type is not supported";
+        }
+
+        config_value_t* encoding_level_cvt = config_value_object_get(encoding_value,
+                                                                    "level");
+        if (encoding_level_cvt == NULL) {
+            const char* err = "encoding \"level\" key missing";
+            LOG_ERROR("%s", err);
+            config_value_destroy(encoding_value);
+            throw(err);
+        }
+        if (encoding_level_cvt->type != CVT_INTEGER) {
+            const char* err = "encoding \"level\" value has to be of string type";
+            LOG_ERROR("%s", err);
+            config_value_destroy(encoding_level_cvt);
+            config_value_destroy(encoding_value);
+            throw(err);
+        }
+        enc_lvl = encoding_level_cvt->body.integer;
+        LOG_DEBUG("Encoding value is %d", enc_lvl);
+    }
+    config_value_destroy(encoding_value);
+}
+
+/**
+ * Free callback of an ingestor config
+ */
+static void free_json(void* obj) {
+    cJSON_Delete((cJSON*) obj);
+}
+
+IngestorCtx* VideoIngestion::parse_ingestor(config_value_t* ingestor_value, size_t& queue_size) {
+    if (ingestor_value == NULL || ingestor_value->type != CVT_OBJECT) {
+        const char* err = "\"ingestor\" value has to be an object or an array of objects";
+        LOG_ERROR("%s", err);
+        throw(err);
+    }
+    config_value_t* ingestor_type_cvt = config_value_object_get(ingestor_value,
+                                                                "type");
+    if (ingestor_type_cvt == NULL) {
+        const char* err = "\"type\" key missing";
+        LOG_ERROR("%s", err);
+        throw(err);
+    }
+    if (ingestor_type_cvt->type != CVT_STRING) {
+        const char* err = "\"type\" value has to be of string type";
+        LOG_ERROR("%s", err);
+        config_value_destroy(ingestor_type_cvt);
+        throw(err);
+    }
+
+    IngestorCtx* ictx = new IngestorCtx();
+    ictx->type = std::string(ingestor_type_cvt->body.string);
+    config_value_destroy(ingestor_type_cvt);
+
+    config_value_t* ingestor_queue_cvt = config_value_object_get(ingestor_value,
+                                                                    "queue_size");
+    if (ingestor_queue_cvt == NULL) {
+        LOG_INFO("\"queue_size\" key missing, so using default queue size: \
+                    %d", DEFAULT_QUEUE_SIZE);
+        ictx->queue_size = DEFAULT_QUEUE_SIZE;
+    } else {
+        if (ingestor_queue_cvt->type != CVT_INTEGER) {
+            const char* err = "\"queue_size\" value has to be of integer type";
+            LOG_ERROR("%s", err);
+            config_value_destroy(ingestor_queue_cvt);
+            delete ictx;
+            throw(err);
+        }
+        ictx->queue_size = ingestor_queue_cvt->body.integer;
+        config_value_destroy(ingestor_queue_cvt);
+    }
+    queue_size += ictx->queue_size;
+
+    config_value_t* name_cvt = config_value_object_get(ingestor_value, INGESTOR_NAME);
+    if (name_cvt != NULL) {
+        if (name_cvt->type == CVT_STRING)
+            ictx->name = std::string(name_cvt->body.string);
+        config_value_destroy(name_cvt);
+    }
+    config_value_t* topic_cvt = config_value_object_get(ingestor_value, "topic");
+    if (topic_cvt != NULL) {
+        if (topic_cvt->type == CVT_STRING)
+            ictx->topic = std::string(topic_cvt->body.string);
+        config_value_destroy(topic_cvt);
+    }
+    config_value_t* overflow_cvt = config_value_object_get(ingestor_value, OVERFLOW_POLICY);
+    if (overflow_cvt != NULL) {
+        ictx->drop_oldest = (overflow_cvt->type == CVT_STRING &&
+                             strcmp(overflow_cvt->body.string, "drop_oldest") == 0);
+        config_value_destroy(overflow_cvt);
+    }
+
+    // The ingestor config is a copy, it outlives the config it comes from
+    config_value_object_t* ingestor_cvt = ingestor_value->body.object;
+    cJSON* ingestor_json = cJSON_Duplicate((cJSON*) ingestor_cvt->object, 1);
+    if (ingestor_json != NULL)
+        ictx->cfg = config_new(ingestor_json, free_json, get_config_value, NULL);
+    if (ictx->cfg == NULL) {
+        const char* err = "Unable to get ingestor config";
+        LOG_ERROR("%s", err);
+        cJSON_Delete(ingestor_json);
+        delete ictx;
+        throw(err);
+    }
+    return ictx;
+}
+
+/**
+ * Compare two JSON values, a missing value only equals another missing one
+ */
+static bool json_equal(const cJSON* a, const cJSON* b) {
+    if (a == NULL || b == NULL)
+        return a == b;
+    return cJSON_Compare(a, b, true);
+}
+
+/**
+ * Entry of the "ingestor" value, a single object or an array of them
+ */
+static cJSON* ingestor_entry(cJSON* ingestor, int i) {
+    return cJSON_IsArray(ingestor) ? cJSON_GetArrayItem(ingestor, i) : ingestor;
+}
+
+/**
+ * Whether an ingestor entry evicts the oldest queued frames on overflow
+ */
+static bool is_drop_oldest(cJSON* entry) {
+    cJSON* policy = cJSON_GetObjectItemCaseSensitive(entry, OVERFLOW_POLICY);
+    return cJSON_IsString(policy) && strcmp(policy->valuestring, "drop_oldest") == 0;
+}
+
+bool VideoIngestion::reconfigure(char* vi_config) {
+    // Keys of the components rebuilt in place, any other change needs a
+    // new publisher or new queues
+    static const char* hot_keys[] = {"ingestor", "udfs", "max_workers", STATS_INTERVAL, "encoding"};
+    // Keys of an ingestor entry routing its frames or sizing the queues
+    static const char* route_keys[] = {INGESTOR_NAME, "topic", "queue_size", "appsinks", CLIP_TOPIC};
+
+    std::lock_guard<std::mutex> cmd_lck(m_cmd_mtx);
+    int64_t start_ns = latency_now_ns();
+    wait_udf_manager();
+
+    cJSON* json[2] = {cJSON_Parse(m_config.c_str()), cJSON_Parse(vi_config)};
+    if (json[0] == NULL || json[1] == NULL) {
+        LOG_ERROR_0("Failed to parse the configuration");
+        cJSON_Delete(json[0]);
+        cJSON_Delete(json[1]);
+        return false;
+    }
+
+    bool restart = false;
+    for (int i = 0; i < 2 && !restart; i++) {
+        cJSON* item = NULL;
+        cJSON_ArrayForEach(item, json[i]) {
+            bool hot = false;
+            for (auto key : hot_keys)
+                hot = hot || strcmp(item->string, key) == 0;
+            if (!hot && !json_equal(cJSON_GetObjectItemCaseSensitive(json[0], item->string),
+                                    cJSON_GetObjectItemCaseSensitive(json[1], item->string))) {
+                LOG_INFO("\"%s\" changed", item->string);
+                restart = true;
+                break;
+            }
+        }
+    }
+
+    cJSON* old_udfs = cJSON_GetObjectItemCaseSensitive(json[0], "udfs");
+    cJSON* new_udfs = cJSON_GetObjectItemCaseSensitive(json[1], "udfs");
+    if ((old_udfs == NULL) != (new_udfs == NULL))
+        restart = true;
+    bool encoding_changed = !json_equal(cJSON_GetObjectItemCaseSensitive(json[0], "encoding"),
+                                        cJSON_GetObjectItemCaseSensitive(json[1], "encoding"));
+    bool udfs_changed = encoding_changed || !json_equal(old_udfs, new_udfs) ||
+        !json_equal(cJSON_GetObjectItemCaseSensitive(json[0], "max_workers"),
+                    cJSON_GetObjectItemCaseSensitive(json[1], "max_workers"));
+    bool stats_changed = !json_equal(cJSON_GetObjectItemCaseSensitive(json[0], STATS_INTERVAL),
+                                     cJSON_GetObjectItemCaseSensitive(json[1], STATS_INTERVAL));
+
+    // The ingestors keep their place, only their capture settings change
+    cJSON* old_ingestor = cJSON_GetObjectItemCaseSensitive(json[0], "ingestor");
+    cJSON* new_ingestor = cJSON_GetObjectItemCaseSensitive(json[1], "ingestor");
+    int count = (int) m_ingestors.size();
+    if (new_ingestor == NULL || cJSON_IsArray(old_ingestor) != cJSON_IsArray(new_ingestor) ||
+            (cJSON_IsArray(new_ingestor) && cJSON_GetArraySize(new_ingestor) != count))
+        restart = true;
+    std::vector<bool> rebuild(count, false);
+    for (int i = 0; i < count && !restart; i++) {
+        cJSON* old_entry = ingestor_entry(old_ingestor, i);
+        cJSON* new_entry = ingestor_entry(new_ingestor, i);
+        for (auto key : route_keys) {
+            if (!json_equal(cJSON_GetObjectItemCaseSensitive(old_entry, key),
+                            cJSON_GetObjectItemCaseSensitive(new_entry, key)))
+                restart = true;
+        }
+        // Only the queues of the frame merger can evict their oldest frames
+        if (m_frame_merger == NULL && is_drop_oldest(new_entry))
+            restart = true;
+        rebuild[i] = encoding_changed || !json_equal(old_entry, new_entry);
+    }
+    cJSON_Delete(json[0]);
+    cJSON_Delete(json[1]);
+
+    if (restart) {
+        LOG_INFO_0("Configuration change needs a restart of the publisher");
+        return false;
+    }
+
+    config_t* config = json_config_new_from_buffer(vi_config);
+    if (config == NULL) {
+        LOG_ERROR_0("Failed to initialize configuration object");
+        return false;
+    }
+
+    std::vector<IngestorCtx*> parsed(count, NULL);
+    std::string rebuilt;
+    try {
+        EncodeType enc_type;
+        int enc_lvl;
+        parse_encoding(config, enc_type, enc_lvl);
+        double stats_interval = parse_stats_interval(config);
+        config_value_t* udf_value = config->get_config_value(config->cfg, "udfs");
+        bool udf_bgr = parse_udf_bgr(udf_value);
+        if (udf_value != NULL)
+            config_value_destroy(udf_value);
+
+        config_value_t* ingestor_value = config->get_config_value(config->cfg, "ingestor");
+        bool multi_ingestor = (ingestor_value->type == CVT_ARRAY);
+        size_t queue_size = 0;
+        try {
+            for (int i = 0; i < count; i++) {
+                if (!rebuild[i])
+                    continue;
+                config_value_t* entry = multi_ingestor ?
+                        config_value_array_get(ingestor_value, i) : ingestor_value;
+                try {
+                    parsed[i] = parse_ingestor(entry, queue_size);
+                } catch(...) {
+                    if (entry != ingestor_value)
+                        config_value_destroy(entry);
+                    throw;
+                }
+                if (entry != ingestor_value)
+                    config_value_destroy(entry);
+            }
+        } catch(...) {
+            config_value_destroy(ingestor_value);
+            throw;
+        }
+        config_value_destroy(ingestor_value);
+
+        // The new components are built before any running one is replaced,
+        // so that a failure leaves the running ones as they were
+        EncodeType new_enc_type = encoding_changed ? enc_type : m_enc_type;
+        int new_enc_lvl = encoding_changed ? enc_lvl : m_enc_lvl;
+        UdfManager* udf_manager = NULL;
+        if (udfs_changed && m_udf_manager != NULL) {
+            udf_manager = new UdfManager(config, m_udf_input_queue, m_udf_output_queue, m_app_name,
+                                         new_enc_type, new_enc_lvl);
+        }
+
+        // The old captures are released first, the new ones may open the
+        // same devices
+        std::vector<Ingestor*> ingestors(count, NULL);
+        std::vector<bool> stopped(count, false);
+        try {
+            for (int i = 0; i < count; i++) {
+                if (!rebuild[i])
+                    continue;
+                m_ingestors[i]->ingestor->stop();
+                stopped[i] = true;
+                ingestors[i] = get_ingestor(parsed[i]->cfg, m_ingestors[i]->queue,
+                                            parsed[i]->type.c_str(), m_app_name,
+                                            m_ingestors[i]->snapshot_cv, new_enc_type,
+                                            new_enc_lvl, !multi_ingestor);
+                ingestors[i]->set_frame_stamps(&m_frame_stamps);
+                if (m_frame_merger != NULL)
+                    ingestors[i]->set_frame_merger(m_frame_merger);
+                ingestors[i]->set_convert_to_bgr(m_publish_bgr || udf_bgr);
+            }
+        } catch(...) {
+            // The new ingestors never ran, the old ones resume
+            for (int i = 0; i < count; i++) {
+                delete ingestors[i];
+                if (stopped[i])
+                    resume_ingestor(m_ingestors[i]);
+            }
+            delete udf_manager;
+            throw;
+        }
+
+        if (encoding_changed) {
+            std::lock_guard<std::mutex> lck(m_clip_mtx);
+            m_enc_type = enc_type;
+            m_enc_lvl = enc_lvl;
+        }
+
+        // The frames queued meanwhile keep the format of the old UDFs
+        if (udf_bgr != m_udf_bgr) {
+            m_udf_bgr = udf_bgr;
+            for (auto ictx : m_ingestors)
+                ictx->ingestor->set_convert_to_bgr(m_publish_bgr || m_udf_bgr);
+        }
+
+        // The ingestors keep filling the UDF input queue meanwhile
+        if (udf_manager != NULL) {
+            m_udf_manager->stop();
+            delete_udf_manager(m_udf_manager);
+            m_udf_manager = udf_manager;
+            m_udf_manager->start();
+            rebuilt += " udfs";
+        }
+
+        for (int i = 0; i < count; i++) {
+            if (!rebuild[i])
+                continue;
+            IngestorCtx* ictx = m_ingestors[i];
+            Ingestor* old = ictx->ingestor;
+            old->release_frames();
+            {
+                // The statistics and the clip threads read the ingestor
+                std::lock_guard<std::mutex> stats_lck(m_stats_mtx);
+                std::lock_guard<std::mutex> clip_lck(m_clip_mtx);
+                ictx->ingestor = ingestors[i];
+                ictx->type = parsed[i]->type;
+                ictx->drop_oldest = parsed[i]->drop_oldest;
+                std::swap(ictx->cfg, parsed[i]->cfg);
+            }
+            // Its frames may still be in the queues or in the UDFs
+            m_retired_ingestors.push_back(old);
+            resume_ingestor(ictx);
+            rebuilt += " ingestor";
+            if (!ictx->name.empty())
+                rebuilt += " " + ictx->name;
+        }
+
+        if (stats_changed) {
+            stop_stats();
+            m_stats_interval = stats_interval;
+            if (m_stats_interval > 0) {
+                m_stats_stop = false;
+                m_stats_th = new std::thread(&VideoIngestion::stats_dump_run, this);
+            }
+            rebuilt += " stats";
+        }
+    } catch(...) {
+        for (auto ictx : parsed)
+            delete ictx;
+        config_destroy(config);
+        throw;
+    }
+
+    ClipStats clip;
+    if (m_clip_th == NULL && get_clip_stats(clip)) {
+        m_clip_stop.store(false);
+        m_clip_th = new std::thread(&VideoIngestion::clip_run, this);
+    }
+    for (auto ictx : parsed)
+        delete ictx;
+    config_destroy(config);
+    m_config = vi_config;
+
+    double ms = (latency_now_ns() - start_ns) / 1e6;
+    if (rebuilt.empty()) {
+        LOG_INFO("Configuration unchanged, checked in %.1f ms", ms);
+    } else {
+        LOG_INFO("Reconfigured%s in %.1f ms", rebuilt.c_str(), ms);
+    }
+    // The new ingestors are running meanwhile, the frames of the old ones
+    // drain through the queues
+    reap_ingestors(RETIRE_TIMEOUT_NS);
+    return true;
+}
+
+void VideoIngestion::resume_ingestor(IngestorCtx* ictx) {
+    Ingestor* ingestor = ictx->ingestor;
+    if (!m_sw_trgr_en || ictx->running.load()) {
+        if (ingestor->start() != IngestRetCode::SUCCESS)
+            LOG_ERROR("Failed to start ingestor thread %s", ictx->name.c_str());
+    } else if (ingestor->get_snapshot_standby()) {
+        ingestor->set_standby(true);
+        if (ingestor->start() != IngestRetCode::SUCCESS)
+            LOG_ERROR("Failed to start ingestor thread %s", ictx->name.c_str());
+    }
+}
+
+bool VideoIngestion::select_ingestors(msg_envelope_elem_body_t* arg_payload, std::vector<IngestorCtx*>& selected) {
+    msg_envelope_elem_body_t* name = NULL;
+    if (arg_payload != NULL && arg_payload->type == MSG_ENV_DT_OBJECT) {
+        name = msgbus_msg_envelope_elem_object_get(arg_payload, INGESTOR_NAME);
+    }
+    // Commands without an ingestor name apply to all the ingestors
+    if (name == NULL) {
+        selected = m_ingestors;
+        return true;
+    }
+    if (name->type != MSG_ENV_DT_STRING) {
+        return false;
+    }
+    for (auto ictx : m_ingestors) {
+        if (ictx->name == name->body.string) {
+            selected.push_back(ictx);
+            return true;
+        }
+    }
+    return false;
+}
+
+msg_envelope_elem_body_t* VideoIngestion::process_start_ingestion(msg_envelope_elem_body_t *arg_payload) {
+    try {
+            std::lock_guard<std::mutex> cmd_lck(m_cmd_mtx);
+            LOG_INFO_0("START INGESTION request received from client");
+            std::vector<IngestorCtx*> selected;
+            if (!select_ingestors(arg_payload, selected)) {
+                std::string err = "Unknown ingestor name";
+                return m_commandhandler->form_reply_payload((int)REQ_NOT_HONORED, err, NULL);
+            }
+            bool started = false;
+            for (auto ictx : selected) {
+                if (ictx->running.load()) {
+                    continue;
+                }
+                // An ingestor in snapshot standby is already running and
+                // only has to publish its frames again
+                ictx->ingestor->set_standby(false);
+                IngestRetCode ret = ictx->ingestor->start();
+                if (ret != IngestRetCode::SUCCESS &&
+                        !(ret == IngestRetCode::ALREAD_RUNNING && ictx->ingestor->get_snapshot_standby())) {
+                    LOG_ERROR("Failed to start ingestor thread: %d", ret);
+                    std::string err = "Failed to start ingestor thread";
+                    return m_commandhandler->form_reply_payload((int)REQ_NOT_HONORED, err, NULL);
+                }
+                LOG_INFO("Ingestor thread %s started...", ictx->name.c_str());
+                ictx->running.store(true);
+                started = true;
+            }
+            if (!started) {
+                std::string err = "Ingestion already running";
+                return m_commandhandler->form_reply_payload((int)REQ_ALREADY_RUNNING, err, NULL);
+            }
+            // acknowledging back to client that ingestion has actually started
+            return m_commandhandler->form_reply_payload((int)REQ_HONORED, "SUCCESS", NULL);
+    } catch(std::exception& ex) {
+        std::string err = "exception occurred request not honored";
+        LOG_ERROR("%s %s", ex.what(), err.c_str());
+        return m_commandhandler->form_reply_payload((int)REQ_NOT_HONORED, err, NULL);
+    }
+}
+
+msg_envelope_elem_body_t* VideoIngestion::process_stop_ingestion(msg_envelope_elem_body_t *arg_payload) {
+    try {
+            std::lock_guard<std::mutex> cmd_lck(m_cmd_mtx);
+            LOG_INFO_0("STOP INGESTION request received from client");
+            std::vector<IngestorCtx*> selected;
+            if (!select_ingestors(arg_payload, selected)) {
+                std::string err = "Unknown ingestor name";
+                return m_commandhandler->form_reply_payload((int)REQ_NOT_HONORED, err, NULL);
+            }
+            bool stopped = false;
+            for (auto ictx : selected) {
+                if (!ictx->running.load()) {
+                    continue;
+                }
+                if (ictx->ingestor->get_snapshot_standby()) {
+                    // Keep the ingestor running for the snapshots
+                    ictx->ingestor->set_standby(true);
+                } else {
+                    // stop the ingestor
+                    ictx->ingestor->stop();
+                }
+                ictx->running.store(false);
+                stopped = true;
+            }
+            if (!stopped) {
+                // form a JSON reply buffer
+                std::string err = "Ingestion already stopped";
+                return m_commandhandler->form_reply_payload((int)REQ_ALREADY_STOPPED, err, NULL);
+            }
+
+            // form a JSON reply buffer
+            return m_commandhandler->form_reply_payload((int)REQ_HONORED, "SUCCESS", NULL);
+    } catch(std::exception& ex) {
+        std::string err = "exception occurred request not honored";
+        LOG_ERROR("%s %s", ex.what(), err.c_str());
+        return m_commandhandler->form_reply_payload((int)REQ_NOT_HONORED, err, NULL);
+    }
+}
+
+/**
+ * Argument of a command, NULL if it is not set
+ */
+static msg_envelope_elem_body_t* command_argument(msg_envelope_elem_body_t* arg_payload, const char* key) {
+    if (arg_payload == NULL || arg_payload->type != MSG_ENV_DT_OBJECT)
+        return NULL;
+    return msgbus_msg_envelope_elem_object_get(arg_payload, key);
+}
+
+msg_envelope_elem_body_t* VideoIngestion::process_snapshot(msg_envelope_elem_body_t *arg_payload) {
+    try {
+            // The lock is taken for every shot of a burst and released
+            // between them, so the other commands and the reconfigurations
+            // are not held up for the duration of the burst
+            std::unique_lock<std::mutex> cmd_lck(m_cmd_mtx);
+            LOG_INFO_0("SNAPSHOT request received from client");
+            int64_t request_ns = latency_now_ns();
+            std::vector<IngestorCtx*> selected;
+            if (!select_ingestors(arg_payload, selected)) {
+                std::string err = "Unknown ingestor name";
+                return m_commandhandler->form_reply_payload((int)REQ_NOT_HONORED, err, NULL);
+            }
+
+            // Burst of count snapshots, interval seconds apart
+            int64_t count = 1;
+            double interval = 0.0;
+            bool fresh = false;
+            bool valid = true;
+            msg_envelope_elem_body_t* arg = command_argument(arg_payload, SNAPSHOT_COUNT);
+            if (arg != NULL) {
+                valid = (arg->type == MSG_ENV_DT_INT && arg->body.integer >= 1 &&
+                         arg->body.integer <= SNAPSHOT_MAX_COUNT);
+                if (valid)
+                    count = arg->body.integer;
+            }
+            arg = command_argument(arg_payload, SNAPSHOT_INTERVAL);
+            if (valid && arg != NULL) {
+                if (arg->type == MSG_ENV_DT_INT)
+                    interval = (double) arg->body.integer;
+                else if (arg->type == MSG_ENV_DT_FLOATING)
+                    interval = arg->body.floating;
+                else
+                    valid = false;
+                valid = valid && interval >= 0.0 &&
+                        (count - 1) * interval <= SNAPSHOT_MAX_BURST_S;
+            }
+            arg = command_argument(arg_payload, SNAPSHOT_FRESH);
+            if (valid && arg != NULL) {
+                valid = (arg->type == MSG_ENV_DT_BOOLEAN);
+                if (valid)
+                    fresh = arg->body.boolean;
+            }
+            if (!valid) {
+                std::string err = "Invalid snapshot arguments";
+                return m_commandhandler->form_reply_payload((int)REQ_NOT_HONORED, err, NULL);
+            }
+
+            std::vector<int64_t> last_ns(selected.size(), 0);
+            int64_t interval_ns = (int64_t) (interval * 1e9);
+            // Counts the burst until it returns, under the command lock
+            struct BurstCount {
+                VideoIngestion* vi;
+                explicit BurstCount(VideoIngestion* v) : vi(v) { vi->m_snapshot_bursts++; }
+                ~BurstCount() { vi->m_snapshot_bursts--; vi->m_cmd_cv.notify_all(); }
+            } burst(this);
+            std::string err;
+            int code = (int)REQ_HONORED;
+            for (int64_t i = 0; i < count && err.empty(); i++) {
+                int64_t target_ns = request_ns + i * interval_ns;
+                int64_t wait_ns = target_ns - latency_now_ns();
+                if (wait_ns > 0) {
+                    m_cmd_cv.wait_for(cmd_lck, std::chrono::nanoseconds(wait_ns),
+                                      [this] { return m_cmd_stop; });
+                }
+                if (m_cmd_stop) {
+                    err = "VideoIngestion is shutting down";
+                    code = (int)REQ_NOT_HONORED;
+                    break;
+                }
+                // The ingestors may have been rebuilt since the last shot
+                if (i > 0) {
+                    selected.clear();
+                    if (!select_ingestors(arg_payload, selected))
+                        selected.clear();
+                }
+                if (selected.size() != last_ns.size()) {
+                    err = "Ingestors changed during the snapshot burst";
+                    code = (int)REQ_NOT_HONORED;
+                    break;
+                }
+                for (auto ictx : selected) {
+                    if (ictx->running.load()) {
+                        err = "Ingestion already running";
+                        code = (int)REQ_ALREADY_RUNNING;
+                        break;
+                    }
+                }
+                for (size_t j = 0; j < selected.size() && err.empty(); j++) {
+                    if (!snapshot(selected[j], fresh ? target_ns : 0, last_ns[j])) {
+                        err = "Failed to take the snapshot";
+                        code = (int)REQ_NOT_HONORED;
+                    }
+                }
+            }
+            if (!err.empty())
+                return m_commandhandler->form_reply_payload(code, err, NULL);
+            return m_commandhandler->form_reply_payload((int)REQ_HONORED, "SUCCESS", NULL);
+    } catch(std::exception& ex) {
+        std::string err = "exception occurred request not honored";
+        LOG_ERROR("%s %s", ex.what(), err.c_str());
+        return m_commandhandler->form_reply_payload((int)REQ_NOT_HONORED,
+                                                    err, NULL);
+    }
+}
+
+bool VideoIngestion::snapshot(IngestorCtx* ictx, int64_t after_ns, int64_t& last_ns) {
+    Ingestor* ingestor = ictx->ingestor;
+    if (ingestor->get_snapshot_standby()) {
+        // A burst never takes the same frame twice
+        if (!ingestor->take_snapshot(std::max(after_ns, last_ns), SNAPSHOT_TIMEOUT_NS, last_ns)) {
+            LOG_ERROR("No frame from ingestor %s for the snapshot", ictx->name.c_str());
+            return false;
+        }
+        return true;
+    }
+
+    // The ingestor runs until its first frame is enqueued
+    uint64_t count = ingestor->get_snapshot_count();
+    IngestRetCode ret = ingestor->start(true);
+    if (ret != IngestRetCode::SUCCESS) {
+        LOG_ERROR("Failed to start ingestor thread: %d", ret);
+        return false;
+    }
+    LOG_DEBUG("Ingestor thread %s snapshot started", ictx->name.c_str());
+    bool done = ingestor->wait_snapshot(count, SNAPSHOT_TIMEOUT_NS);
+    if (!done)
+        LOG_ERROR("No frame from ingestor %s for the snapshot", ictx->name.c_str());
+    LOG_DEBUG_0("Stopping ingestor thread");
+    ingestor->stop();
+    return done;
+}
+
+LatencySummary VideoIngestion::get_latency_summary(IngestorCtx* ictx, LatencyStage stage) {
+    std::vector<const LatencyHistogram*> histograms;
+    for (auto it : m_ingestors) {
+        if (ictx != NULL && it != ictx)
+            continue;
+        const LatencyHistogram* h = it->ingestor->get_latency(stage);
+        if (h == NULL && m_frame_publisher != NULL) {
+            h = m_frame_publisher->get_latency(it->name, stage);
+            for (auto& output : it->ingestor->get_outputs()) {
+                const LatencyHistogram* oh = NULL;
+                if (output.route != it->name)
+                    oh = m_frame_publisher->get_latency(output.route, stage);
+                if (oh != NULL)
+                    histograms.push_back(oh);
+            }
+        }
+        if (h != NULL)
+            histograms.push_back(h);
+    }
+    return LatencyHistogram::summarize(histograms);
+}
+
+LatencySummary VideoIngestion::get_latency(LatencyStage stage) {
+    return get_latency_summary(NULL, stage);
+}
+
+bool VideoIngestion::get_clip_stats(ClipStats& stats) {
+    bool enabled = false;
+    stats = ClipStats();
+    for (auto ictx : m_ingestors) {
+        ClipStats clip;
+        if (!ictx->ingestor->get_clip_stats(clip))
+            continue;
+        stats.frames += clip.frames;
+        stats.bytes += clip.bytes;
+        stats.seconds = std::max(stats.seconds, clip.seconds);
+        stats.evicted += clip.evicted;
+        enabled = true;
+    }
+    return enabled;
+}
+
+/**
+ * Frame counters of the outputs of an ingestor
+ */
+static msg_envelope_elem_body_t* outputs_object(const std::vector<IngestorOutput>& outputs, FramePublisher* publisher) {
+    msg_envelope_elem_body_t* obj = msgbus_msg_envelope_new_object();
+    if (obj == NULL) {
+        throw "Error creating the message envelope object";
+    }
+    for (auto& output : outputs) {
+        msg_envelope_elem_body_t* output_obj = msgbus_msg_envelope_new_object();
+        if (output_obj == NULL) {
+            msgbus_msg_envelope_elem_destroy(obj);
+            throw "Error creating the message envelope object";
+        }
+        msgbus_msg_envelope_elem_object_put(output_obj, "frames",
+                msgbus_msg_envelope_new_integer(output.frames));
+        const LatencyHistogram* h = publisher->get_latency(output.route, STAGE_PUBLISH);
+        uint64_t published = (h != NULL) ? LatencyHistogram::summarize({h}).count : 0;
+        msgbus_msg_envelope_elem_object_put(output_obj, "published_frames",
+                msgbus_msg_envelope_new_integer(published));
+        msgbus_msg_envelope_elem_object_put(obj, output.name.c_str(), output_obj);
+    }
+    return obj;
+}
+
+/**
+ * Reconnection statistics of an ingestor
+ */
+static msg_envelope_elem_body_t* reconnect_object(const ReconnectStats& stats) {
+    msg_envelope_elem_body_t* obj = msgbus_msg_envelope_new_object();
+    if (obj == NULL) {
+        throw "Error creating the message envelope object";
+    }
+    msgbus_msg_envelope_elem_object_put(obj, "reconnects",
+            msgbus_msg_envelope_new_integer(stats.reconnects));
+    msgbus_msg_envelope_elem_object_put(obj, "stalls",
+            msgbus_msg_envelope_new_integer(stats.stalls));
+    msgbus_msg_envelope_elem_object_put(obj, "downtime_s",
+            msgbus_msg_envelope_new_floating(stats.downtime));
+    msgbus_msg_envelope_elem_object_put(obj, "connected",
+            msgbus_msg_envelope_new_bool(stats.connected));
+    return obj;
+}
+
+/**
+ * Recycled frame buffers of an ingestor
+ */
+static msg_envelope_elem_body_t* pool_object(const PoolStats& stats) {
+    msg_envelope_elem_body_t* obj = msgbus_msg_envelope_new_object();
+    if (obj == NULL) {
+        throw "Error creating the message envelope object";
+    }
+    msgbus_msg_envelope_elem_object_put(obj, "hits",
+            msgbus_msg_envelope_new_integer(stats.hits));
+    msgbus_msg_envelope_elem_object_put(obj, "misses",
+            msgbus_msg_envelope_new_integer(stats.misses));
+    return obj;
+}
+
+/**
+ * Frame pacing of an ingestor
+ */
+static msg_envelope_elem_body_t* pacing_object(const PacingStats& stats) {
+    msg_envelope_elem_body_t* obj = msgbus_msg_envelope_new_object();
+    if (obj == NULL) {
+        throw "Error creating the message envelope object";
+    }
+    msgbus_msg_envelope_elem_object_put(obj, "frames",
+            msgbus_msg_envelope_new_integer(stats.frames));
+    msgbus_msg_envelope_elem_object_put(obj, "late_frames",
+            msgbus_msg_envelope_new_integer(stats.late_frames));
+    msgbus_msg_envelope_elem_object_put(obj, "skipped_periods",
+            msgbus_msg_envelope_new_integer(stats.skipped_periods));
+    msgbus_msg_envelope_elem_object_put(obj, "jitter_avg_us",
+            msgbus_msg_envelope_new_floating(stats.jitter_avg_ns / 1000.0));
+    msgbus_msg_envelope_elem_object_put(obj, "jitter_max_us",
+            msgbus_msg_envelope_new_floating(stats.jitter_max_ns / 1000.0));
+    return obj;
+}
+
+/**
+ * Memory footprint of a pre-trigger ring
+ */
+static msg_envelope_elem_body_t* clip_object(const ClipStats& stats) {
+    msg_envelope_elem_body_t* obj = msgbus_msg_envelope_new_object();
+    if (obj == NULL) {
+        throw "Error creating the message envelope object";
+    }
+    msgbus_msg_envelope_elem_object_put(obj, "frames",
+            msgbus_msg_envelope_new_integer(stats.frames));
+    msgbus_msg_envelope_elem_object_put(obj, "bytes",
+            msgbus_msg_envelope_new_integer(stats.bytes));
+    msgbus_msg_envelope_elem_object_put(obj, "seconds",
+            msgbus_msg_envelope_new_floating(stats.seconds));
+    msgbus_msg_envelope_elem_object_put(obj, "evicted",
+            msgbus_msg_envelope_new_integer(stats.evicted));
+    return obj;
+}
+
+/**
+ * Duration of the startup phases in milliseconds, and the time from the
+ * startup to the first published frame once there is one
+ */
+static msg_envelope_elem_body_t* startup_object(const std::vector<StartupPhase>& phases,
+                                                int64_t first_frame_ns) {
+    msg_envelope_elem_body_t* obj = msgbus_msg_envelope_new_object();
+    if (obj == NULL) {
+        throw "Error creating the message envelope object";
+    }
+    for (auto& phase : phases) {
+        msgbus_msg_envelope_elem_object_put(obj, (phase.name + "_ms").c_str(),
+                msgbus_msg_envelope_new_floating(phase.duration_ms));
+    }
+    if (first_frame_ns >= 0) {
+        msgbus_msg_envelope_elem_object_put(obj, "time_to_first_frame_ms",
+                msgbus_msg_envelope_new_floating(first_frame_ns / 1e6));
+    }
+    return obj;
+}
+
+static msg_envelope_elem_body_t* latency_summary_object(const LatencySummary& summary) {
+    msg_envelope_elem_body_t* obj = msgbus_msg_envelope_new_object();
+    if (obj == NULL) {
+        throw "Error creating the message envelope object";
+    }
+    const char* keys[] = {"mean_us", "p50_us", "p99_us", "p999_us", "max_us"};
+    int64_t values[] = {summary.mean, summary.p50, summary.p99, summary.p999, summary.max};
+    msgbus_msg_envelope_elem_object_put(obj, "count",
+            msgbus_msg_envelope_new_integer(summary.count));
+    for (int i = 0; i < 5; i++) {
+        msgbus_msg_envelope_elem_object_put(obj, keys[i],
+                msgbus_msg_envelope_new_floating(values[i] / 1000.0));
+    }
+    return obj;
+}
+
+/**
+ * Wall clock time, in nanoseconds since the epoch
+ */
+static int64_t wall_now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+msg_envelope_elem_body_t* VideoIngestion::process_dump_clip(msg_envelope_elem_body_t *arg_payload) {
+    try {
+            std::lock_guard<std::mutex> cmd_lck(m_cmd_mtx);
+            LOG_INFO_0("DUMP_CLIP request received from client");
+            int64_t request_ns = wall_now_ns();
+            std::vector<IngestorCtx*> selected;
+            if (!select_ingestors(arg_payload, selected)) {
+                std::string err = "Unknown ingestor name";
+                return m_commandhandler->form_reply_payload((int)REQ_NOT_HONORED, err, NULL);
+            }
+
+            // Seconds since the epoch, or relative to the request when not
+            // positive. The whole ring up to now by default.
+            int64_t window_ns[2] = {INT64_MIN, request_ns};
+            const char* keys[2] = {CLIP_START, CLIP_END};
+            for (int i = 0; i < 2; i++) {
+                msg_envelope_elem_body_t* arg = command_argument(arg_payload, keys[i]);
+                if (arg == NULL)
+                    continue;
+                double value = 0.0;
+                if (arg->type == MSG_ENV_DT_INT) {
+                    value = (double) arg->body.integer;
+                } else if (arg->type == MSG_ENV_DT_FLOATING) {
+                    value = arg->body.floating;
+                } else {
+                    std::string err = "Invalid clip arguments";
+                    return m_commandhandler->form_reply_payload((int)REQ_NOT_HONORED, err, NULL);
+                }
+                window_ns[i] = (value > 0.0) ? (int64_t) (value * 1e9) :
+                    request_ns + (int64_t) (value * 1e9);
+            }
+            if (window_ns[0] > window_ns[1]) {
+                std::string err = "Invalid clip arguments";
+                return m_commandhandler->form_reply_payload((int)REQ_NOT_HONORED, err, NULL);
+            }
+
+            for (auto ictx : selected) {
+                ClipStats clip;
+                if (!ictx->ingestor->get_clip_stats(clip)) {
+                    std::string err = "Clip buffer not enabled";
+                    return m_commandhandler->form_reply_payload((int)REQ_NOT_HONORED, err, NULL);
+                }
+            }
+
+            // The frames are published by the clip thread
+            msg_envelope_elem_body_t* ids = msgbus_msg_envelope_new_array();
+            if (ids == NULL) {
+                std::string err = "Error creating the message envelope object";
+                return m_commandhandler->form_reply_payload((int)REQ_NOT_HONORED, err, NULL);
+            }
+            {
+                std::lock_guard<std::mutex> lck(m_clip_mtx);
+                for (auto ictx : selected) {
+                    ClipJob job = {++m_clip_id, ictx, window_ns[0], window_ns[1]};
+                    m_clip_jobs.push_back(job);
+                    msgbus_msg_envelope_elem_array_add(ids, msgbus_msg_envelope_new_integer(job.id));
+                }
+            }
+            m_clip_cv.notify_all();
+
+            msg_envelope_elem_body_t* clips = msgbus_msg_envelope_new_object();
+            if (clips == NULL) {
+                msgbus_msg_envelope_elem_destroy(ids);
+                std::string err = "Error creating the message envelope object";
+                return m_commandhandler->form_reply_payload((int)REQ_NOT_HONORED, err, NULL);
+            }
+            msgbus_msg_envelope_elem_object_put(clips, "clip_ids", ids);
+            return m_commandhandler->form_reply_payload((int)REQ_HONORED, "SUCCESS", clips);
+    } catch(std::exception& ex) {
+        std::string err = "exception occurred request not honored";
+        LOG_ERROR("%s %s", ex.what(), err.c_str());
+        return m_commandhandler->form_reply_payload((int)REQ_NOT_HONORED, err, NULL);
+    }
+}
+
+void VideoIngestion::clip_run() {
+    std::unique_lock<std::mutex> lck(m_clip_mtx);
+    while (true) {
+        m_clip_cv.wait(lck, [this] { return m_clip_stop.load() || !m_clip_jobs.empty(); });
+        if (m_clip_stop.load())
+            break;
+        // A window ending in the future waits for its last frames
+        ClipJob job = m_clip_jobs.front();
+        int64_t wait_ns = job.end_ns - wall_now_ns();
+        if (wait_ns > 0 && m_clip_cv.wait_for(lck, std::chrono::nanoseconds(wait_ns),
+                                              [this] { return m_clip_stop.load(); }))
+            break;
+        m_clip_jobs.pop_front();
+        // The ingestor can be rebuilt by a reconfiguration once unlocked
+        std::vector<ClipFrame> frames;
+        job.ictx->ingestor->get_clip(job.start_ns, job.end_ns, frames);
+        std::string route = job.ictx->ingestor->get_clip_route();
+        EncodeType enc_type = m_enc_type;
+        int enc_lvl = m_enc_lvl;
+        lck.unlock();
+        publish_clip(job, frames, route, enc_type, enc_lvl);
+        lck.lock();
+    }
+}
+
+/**
+ * Frame free callback releasing a buffer of the pre-trigger ring
+ */
+static void free_clip_buffer(void* obj) {
+    delete (std::shared_ptr<void>*) obj;
+}
+
+/**
+ * Put an integer in the meta-data of a frame
+ */
+static bool put_integer_meta(Frame* frame, const char* key, int64_t value) {
+    msg_envelope_elem_body_t* elem = msgbus_msg_envelope_new_integer(value);
+    if (elem == NULL)
+        return false;
+    if (msgbus_msg_envelope_put(frame->get_meta_data(), key, elem) != MSG_SUCCESS) {
+        msgbus_msg_envelope_elem_destroy(elem);
+        return false;
+    }
+    return true;
+}
+
+void VideoIngestion::publish_clip(const ClipJob& job, std::vector<ClipFrame>& frames,
+                                  const std::string& route, EncodeType enc_type, int enc_lvl) {
+    LOG_INFO("Publishing clip %lu of %s: %lu frames", job.id,
+             job.ictx->name.empty() ? DEFAULT_INGESTOR_NAME : job.ictx->name.c_str(),
+             frames.size());
+
+    for (size_t i = 0; i < frames.size(); i++) {
+        ClipFrame& clip_frame = frames[i];
+        // The pixels are shared with the ring, not copied
+        Frame* frame = new Frame(
+                (void*) new std::shared_ptr<void>(std::move(clip_frame.buffer)), free_clip_buffer,
+                clip_frame.data, clip_frame.width, clip_frame.height, clip_frame.channels);
+        bool ok = put_integer_meta(frame, CLIP_ID_META, (int64_t) job.id) &&
+            put_integer_meta(frame, CLIP_FRAME_META, (int64_t) i) &&
+            put_integer_meta(frame, CLIP_FRAMES_META, (int64_t) frames.size()) &&
+            put_integer_meta(frame, CLIP_TIME_META, clip_frame.time_ns);
+        if (ok && clip_frame.has_format)
+            ok = put_format_meta(frame, clip_frame.format);
+        if (ok && !route.empty()) {
+            msg_envelope_elem_body_t* elem = msgbus_msg_envelope_new_string(route.c_str());
+            ok = (elem != NULL &&
+                  msgbus_msg_envelope_put(frame->get_meta_data(), INGESTOR_NAME_META, elem) == MSG_SUCCESS);
+            if (!ok && elem != NULL)
+                msgbus_msg_envelope_elem_destroy(elem);
+        }
+        if (!ok) {
+            LOG_ERROR("Failed to put the meta-data of clip %lu", job.id);
+            delete frame;
+            return;
+        }
+        // Encoders take packed BGR only
+        if (enc_type != EncodeType::NONE && !clip_frame.has_format) {
+            try {
+                frame->set_encoding(enc_type, enc_lvl);
+            } catch(const char *err) {
+                LOG_ERROR("Exception: %s", err);
+            }
+        }
+
+        // The clip bypasses the UDFs, it waits for space in the publisher
+        // queue on its own thread instead of holding back the live frames
+        if (m_clip_stop.load()) {
+            delete frame;
+            return;
+        }
+        m_udf_output_queue->push_wait(frame);
+    }
+}
+
+msg_envelope_elem_body_t* VideoIngestion::process_get_stats(msg_envelope_elem_body_t *arg_payload) {
+    try {
+            std::lock_guard<std::mutex> cmd_lck(m_cmd_mtx);
+            LOG_DEBUG_0("GET_STATS request received from client");
+            std::vector<IngestorCtx*> selected;
+            if (!select_ingestors(arg_payload, selected)) {
+                std::string err = "Unknown ingestor name";
+                return m_commandhandler->form_reply_payload((int)REQ_NOT_HONORED, err, NULL);
+            }
+
+            // One object per ingestor, plus "all" merging them when the
+            // request does not name an ingestor
+            msg_envelope_elem_body_t* stats = msgbus_msg_envelope_new_object();
+            if (stats == NULL) {
+                std::string err = "Error creating the message envelope object";
+                return m_commandhandler->form_reply_payload((int)REQ_NOT_HONORED, err, NULL);
+            }
+            if (selected.size() > 1) {
+                selected.push_back(NULL);
+            }
+            for (auto ictx : selected) {
+                msg_envelope_elem_body_t* obj = msgbus_msg_envelope_new_object();
+                if (ictx != NULL) {
+                    msgbus_msg_envelope_elem_object_put(obj, "dropped_frames",
+                            msgbus_msg_envelope_new_integer(ictx->ingestor->get_dropped_frames()));
+                    PoolStats pool;
+                    if (ictx->ingestor->get_pool_stats(pool))
+                        msgbus_msg_envelope_elem_object_put(obj, "frame_pool", pool_object(pool));
+                    PacingStats pacing;
+                    if (ictx->ingestor->get_pacing_stats(pacing))
+                        msgbus_msg_envelope_elem_object_put(obj, "pacing", pacing_object(pacing));
+                    std::vector<IngestorOutput> outputs = ictx->ingestor->get_outputs();
+                    if (!outputs.empty())
+                        msgbus_msg_envelope_elem_object_put(obj, "outputs", outputs_object(outputs, m_frame_publisher));
+                    ReconnectStats reconnect;
+                    if (ictx->ingestor->get_reconnect_stats(reconnect))
+                        msgbus_msg_envelope_elem_object_put(obj, "reconnect", reconnect_object(reconnect));
+                    ClipStats clip;
+                    if (ictx->ingestor->get_clip_stats(clip))
+                        msgbus_msg_envelope_elem_object_put(obj, "clip_buffer", clip_object(clip));
+                }
+                for (int stage = 0; stage < STAGE_COUNT; stage++) {
+                    LatencySummary summary = get_latency_summary(ictx, (LatencyStage) stage);
+                    msgbus_msg_envelope_elem_object_put(obj, LATENCY_STAGE_NAMES[stage],
+                                                        latency_summary_object(summary));
+                }
+                std::string key = (ictx == NULL) ? "all" :
+                    (ictx->name.empty() ? DEFAULT_INGESTOR_NAME : ictx->name);
+                msgbus_msg_envelope_elem_object_put(stats, key.c_str(), obj);
+            }
+            msgbus_msg_envelope_elem_object_put(stats, "startup",
+                    startup_object(get_startup_phases(), get_time_to_first_frame()));
+            return m_commandhandler->form_reply_payload((int)REQ_HONORED, "SUCCESS", stats);
+    } catch(const char* ex) {
+        std::string err = "exception occurred request not honored";
+        LOG_ERROR("%s %s", ex, err.c_str());
+        return m_commandhandler->form_reply_payload((int)REQ_NOT_HONORED, err, NULL);
+    } catch(std::exception& ex) {
+        std::string err = "exception occurred request not honored";
+        LOG_ERROR("%s %s", ex.what(), err.c_str());
+        return m_commandhandler->form_reply_payload((int)REQ_NOT_HONORED, err, NULL);
+    }
+}
+
+void VideoIngestion::stats_dump_run() {
+    auto interval = std::chrono::duration<double>(m_stats_interval);
+    std::unique_lock<std::mutex> lck(m_stats_mtx);
+    while (!m_stats_cv.wait_for(lck, interval, [this] { return m_stats_stop; })) {
+        for (auto ictx : m_ingestors) {
+            const char* name = ictx->name.empty() ? DEFAULT_INGESTOR_NAME : ictx->name.c_str();
+            for (int stage = 0; stage < STAGE_COUNT; stage++) {
+                LatencySummary s = get_latency_summary(ictx, (LatencyStage) stage);
+                LOG_INFO("Latency %s %s: count %lu, p50 %.1f us, p99 %.1f us, "
+                         "p999 %.1f us, max %.1f us", name, LATENCY_STAGE_NAMES[stage],
+                         s.count, s.p50 / 1000.0, s.p99 / 1000.0, s.p999 / 1000.0,
+                         s.max / 1000.0);
+            }
+            LOG_INFO("Dropped frames %s: %lu", name, ictx->ingestor->get_dropped_frames());
+            PoolStats pool;
+            if (ictx->ingestor->get_pool_stats(pool)) {
+                LOG_INFO("Frame pool %s: %lu hits, %lu misses", name, pool.hits,
+                         pool.misses);
+            }
+            PacingStats pacing;
+            if (ictx->ingestor->get_pacing_stats(pacing)) {
+                LOG_INFO("Frame pacing %s: %lu frames, %lu late, %lu periods skipped, "
+                         "jitter avg %.1f us max %.1f us", name, pacing.frames,
+                         pacing.late_frames, pacing.skipped_periods,
+                         pacing.jitter_avg_ns / 1000.0, pacing.jitter_max_ns / 1000.0);
+            }
+            ReconnectStats reconnect;
+            if (ictx->ingestor->get_reconnect_stats(reconnect)) {
+                LOG_INFO("Reconnects %s: %lu, %lu stalls, downtime %.1f s%s", name,
+                         reconnect.reconnects, reconnect.stalls, reconnect.downtime,
+                         reconnect.connected ? "" : ", disconnected");
+            }
+            ClipStats clip;
+            if (ictx->ingestor->get_clip_stats(clip)) {
+                LOG_INFO("Clip buffer %s: %lu frames, %lu bytes, %.1f s, %lu evicted", name,
+                         clip.frames, clip.bytes, clip.seconds, clip.evicted);
+            }
+        }
+    }
+}
+
+VideoIngestion& VideoIngestion::operator=(const VideoIngestion& src) {
+    return *this;
+}
+
+void VideoIngestion::stop_stats() {
+    if (m_stats_th) {
+        {
+            std::lock_guard<std::mutex> lck(m_stats_mtx);
+            m_stats_stop = true;
+        }
+        m_stats_cv.notify_all();
+        m_stats_th->join();
+        delete m_stats_th;
+        m_stats_th = NULL;
+    }
+}
+
+void VideoIngestion::start() {
+    int64_t start_ns = latency_now_ns();
+    if (m_frame_publisher) {
+        m_frame_publisher->start();
+        LOG_INFO("Publisher thread started...");
+    }
+    if (m_frame_merger) {
+        m_frame_merger->start();
+    }
+    if (m_stats_interval > 0 && m_stats_th == NULL) {
+        m_stats_stop = false;
+        m_stats_th = new std::thread(&VideoIngestion::stats_dump_run, this);
+    }
+    ClipStats clip;
+    if (m_clip_th == NULL && get_clip_stats(clip)) {
+        m_clip_stop.store(false);
+        m_clip_th = new std::thread(&VideoIngestion::clip_run, this);
+    }
+
+    // The ingestors open their capture while the UDFs may still be loading,
+    // the first frames wait in the UDF input queue meanwhile
+
+    // if SW trigger is disabled OR (if sw trigger is enabled && init_state = running)
+    // then start ingestion
+    if (!m_sw_trgr_en || (m_sw_trgr_en && m_init_state_start)) {
+        for (auto ictx : m_ingestors) {
+            IngestRetCode ret = ictx->ingestor->start();
+            if (ret != IngestRetCode::SUCCESS) {
+                LOG_ERROR("Failed to start ingestor thread %s", ictx->name.c_str());
+            } else {
+                LOG_INFO("Ingestor thread %s started...", ictx->name.c_str());
+                ictx->running.store((m_sw_trgr_en) ? true : false);
+            }
+        }
+    } else {
+        // Ingestors in snapshot standby run while the ingestion is stopped
+        for (auto ictx : m_ingestors) {
+            if (!ictx->ingestor->get_snapshot_standby())
+                continue;
+            ictx->ingestor->set_standby(true);
+            IngestRetCode ret = ictx->ingestor->start();
+            if (ret != IngestRetCode::SUCCESS) {
+                LOG_ERROR("Failed to start ingestor thread %s", ictx->name.c_str());
+            } else {
+                LOG_INFO("Ingestor thread %s started in snapshot standby...", ictx->name.c_str());
+            }
+        }
+    }
+
+    wait_udf_manager();
+    if (m_udf_manager) {
+        m_udf_manager->start();
+        LOG_INFO("Started udf manager");
+    }
+
+    if (!m_startup_done) {
+        m_startup_done = true;
+        startup_phase("start", start_ns);
+        LOG_INFO("Startup timeline, %.1f ms in total:",
+                 (latency_now_ns() - m_startup_ns) / 1e6);
+        for (auto& phase : get_startup_phases()) {
+            LOG_INFO("  %s: at %.1f ms, %.1f ms", phase.name.c_str(), phase.start_ms,
+                     phase.duration_ms);
+        }
+    }
+}
+
+void VideoIngestion::stop() {
+    // The clip thread pushes frames of the ingestors to the publisher
+    if (m_clip_th) {
+        {
+            std::lock_guard<std::mutex> lck(m_clip_mtx);
+            m_clip_stop.store(true);
+            m_clip_jobs.clear();
+        }
+        m_clip_cv.notify_all();
+        m_clip_th->join();
+        delete m_clip_th;
+        m_clip_th = NULL;
+    }
+    for (auto ictx : m_ingestors) {
+        if (ictx->ingestor) {
+            ictx->ingestor->stop();
+        }
+    }
+    if (m_frame_merger) {
+        m_frame_merger->stop();
+    }
+    if (m_udf_manager) {
+        m_udf_manager->stop();
+    }
+    if (m_frame_publisher) {
+        m_frame_publisher->stop();
+    }
+    stop_stats();
+}
+
+void VideoIngestion::reap_ingestors(int64_t timeout_ns) {
+    int64_t deadline_ns = latency_now_ns() + timeout_ns;
+    while (true) {
+        std::vector<Ingestor*> busy;
+        for (auto ingestor : m_retired_ingestors) {
+            if (ingestor->get_buffers_in_use() == 0)
+                delete ingestor;
+            else
+                busy.push_back(ingestor);
+        }
+        m_retired_ingestors.swap(busy);
+        if (m_retired_ingestors.empty() || latency_now_ns() >= deadline_ns)
+            break;
+        std::this_thread::sleep_for(RETIRE_POLL);
+    }
+    if (!m_retired_ingestors.empty()) {
+        LOG_WARN("%zu replaced ingestors still have frames in flight",
+                 m_retired_ingestors.size());
+    }
+}
+
+/**
+ * Delete the frames left in a queue
+ */
+static void drain_queue(eii::vi::FrameQueue* queue) {
+    if (queue == NULL)
+        return;
+    Frame* frame = NULL;
+    while (queue->pop_front(frame))
+        delete frame;
+}
+
+/**
+ * Deletes the frames of a queue whose consumer is stopped, so that the
+ * threads blocked on the queue while it is full return
+ */
+class QueueDrainer {
+    private:
+        eii::vi::FrameQueue* m_queue;
+        std::atomic<bool> m_stop;
+        std::thread* m_th;
+
+        void run() {
+            while (!m_stop.load()) {
+                Frame* frame = NULL;
+                if (!m_queue->wait_for(DRAIN_POLL))
+                    continue;
+                if (m_queue->pop_front(frame))
+                    delete frame;
+            }
+        }
+
+    public:
+        /**
+         * Constructor
+         * @param queue - Queue to drain, NULL for none
+         */
+        QueueDrainer(eii::vi::FrameQueue* queue) : m_queue(queue), m_stop(false), m_th(NULL) {
+            if (m_queue != NULL)
+                m_th = new std::thread(&QueueDrainer::run, this);
+        }
+
+        ~QueueDrainer() {
+            if (m_th == NULL)
+                return;
+            m_stop.store(true);
+            m_th->join();
+            delete m_th;
+        }
+};
+
+VideoIngestion::~VideoIngestion() {
+    // UDFs still loading if start() was not called
+    try {
+        wait_udf_manager();
+    } catch(...) {
+        LOG_ERROR_0("Failed to load the UDFs");
+    }
+    {
+        // The consumers are stopped first, from the publisher to the UDFs
+        // and the merger of the ingestor queues, and their queues drained
+        // meanwhile, so that the threads pushing to
+        // a full queue return: the UDFs, the clip thread, the ingestors and
+        // the commands stopping them
+        if (m_frame_publisher) {
+            m_frame_publisher->stop();
+        }
+        QueueDrainer output_drainer(m_udf_output_queue);
+        if (m_udf_manager) {
+            m_udf_manager->stop();
+        }
+        QueueDrainer input_drainer((m_udf_input_queue != m_udf_output_queue) ?
+                                   m_udf_input_queue : NULL);
+        std::vector<std::unique_ptr<QueueDrainer>> ingestor_drainers;
+        if (m_frame_merger) {
+            m_frame_merger->stop();
+            for (auto queue : m_frame_merger->get_inputs())
+                ingestor_drainers.emplace_back(new QueueDrainer(queue));
+        }
+
+        // Snapshot bursts sleep without the command lock, they return before
+        // the ingestors go away
+        {
+            std::unique_lock<std::mutex> cmd_lck(m_cmd_mtx);
+            m_cmd_stop = true;
+            m_cmd_cv.notify_all();
+            m_cmd_cv.wait(cmd_lck, [this] { return m_snapshot_bursts == 0; });
+        }
+        // The clip thread pushes frames of the ingestors to the publisher
+        if (m_clip_th) {
+            {
+                std::lock_guard<std::mutex> lck(m_clip_mtx);
+                m_clip_stop.store(true);
+                m_clip_jobs.clear();
+            }
+            m_clip_cv.notify_all();
+            m_clip_th->join();
+            delete m_clip_th;
+            m_clip_th = NULL;
+        }
+        stop_stats();
+        for (auto ictx : m_ingestors) {
+            if (ictx->ingestor) {
+                ictx->ingestor->stop();
+            }
+        }
+    }
+    // The frames held by the UDF workers and left in the queues may hold
+    // buffers of the ingestors, they are released before the ingestors
+    delete_udf_manager(m_udf_manager);
+    m_udf_manager = NULL;
+    drain_queue(m_udf_output_queue);
+    if (m_udf_input_queue != m_udf_output_queue)
+        drain_queue(m_udf_input_queue);
+    if (m_frame_merger) {
+        for (auto queue : m_frame_merger->get_inputs())
+            drain_queue(queue);
+    }
+    for (auto ictx : m_ingestors) {
+        if (ictx->ingestor) {
+            delete ictx->ingestor;
+        }
+        delete ictx;
+    }
+    for (auto ingestor : m_retired_ingestors)
+        delete ingestor;
+    if (m_frame_publisher) {
+        delete m_frame_publisher;
     }
-    if (m_publisher) {
-        delete m_publisher;
+    if (m_frame_merger) {
+        delete m_frame_merger;
     }
     if (m_udf_input_queue) {
         delete m_udf_input_queue;
     }
-    if (m_udf_output_queue) {
+    if (m_udf_output_queue && m_udf_output_queue != m_udf_input_queue) {
         delete m_udf_output_queue;
     }
 }